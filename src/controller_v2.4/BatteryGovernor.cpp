@@ -0,0 +1,167 @@
+/**
+ * @file BatteryGovernor.cpp
+ * @brief Implementation of the BatteryGovernor class.
+ */
+
+#include "BatteryGovernor.h"
+
+/**
+ * @brief Constructs a BatteryGovernor object.
+ */
+BatteryGovernor::BatteryGovernor()
+  : enabled(false), state(BatteryState::NORMAL), nominal_voltage(0), weak_voltage(0), critical_voltage(0),
+    voltage(0), speed_limit(100) {}
+
+/**
+ * @brief Destructs the BatteryGovernor object.
+ */
+BatteryGovernor::~BatteryGovernor() {}
+
+/**
+ * @brief Starts governing with the voltages of the battery.
+ *
+ * Until the first measurement, the battery is assumed to be at its nominal voltage.
+ *
+ * @param nominal_voltage The voltage the speeds are tuned at, at which a speed of 100 takes
+ * the full duty cycle.
+ * @param weak_voltage The voltage below which the battery is reported as weak.
+ * @param critical_voltage The voltage below which the battery is reported as critical.
+ */
+void BatteryGovernor::begin(uint8_t nominal_voltage, uint8_t weak_voltage, uint8_t critical_voltage) {
+  this->nominal_voltage = max(nominal_voltage, uint8_t(1));
+  this->weak_voltage = weak_voltage;
+  this->critical_voltage = critical_voltage;
+  this->voltage = this->nominal_voltage;
+  this->state = BatteryState::NORMAL;
+  this->filter.begin();
+  this->enabled = true;
+  this->beginSection();
+}
+
+/**
+ * @brief Stops governing, the speeds are passed on unchanged.
+ */
+void BatteryGovernor::end() {
+  this->enabled = false;
+  this->filter.end();
+}
+
+/**
+ * @brief Filters a new measurement of the battery voltage.
+ *
+ * The measurement is smoothed by an exponential moving average, so the short dips of the
+ * voltage while the motor accelerates neither limit the speed nor change the state. A
+ * critical battery tightens the speed limit right away, without waiting for the next section.
+ *
+ * @param voltage The measured voltage, 0 if the battery is not connected.
+ */
+void BatteryGovernor::update(uint8_t voltage) {
+  if (!this->enabled || !voltage)
+    return;
+
+  this->filter.add(voltage);
+  this->voltage = this->filter.readExponentialAverage(GOVERNOR_SMOOTHING);
+  this->updateState();
+
+  if (this->state == BatteryState::CRITICAL)
+    this->speed_limit = min(this->speed_limit, this->readHeadroomLimit());
+}
+
+/**
+ * @brief Fixes the speed limit for the section that is about to begin.
+ *
+ * The limit is the headroom of the battery less the reserve of the controllers, so the
+ * controllers can still correct the speed on top of the limit without saturating the duty
+ * cycle.
+ */
+void BatteryGovernor::beginSection() {
+  if (!this->enabled)
+    return;
+
+  this->speed_limit = this->readHeadroomLimit();
+}
+
+/**
+ * @brief Limits a motor speed to what the battery can provide in the current section.
+ *
+ * @param speed The motor speed, ranging from -100 to 100.
+ * @return The limited motor speed, the speed itself if the governor is disabled.
+ */
+int8_t BatteryGovernor::limitSpeed(int8_t speed) {
+  if (!this->enabled)
+    return speed;
+
+  return constrain(speed, -int8_t(this->speed_limit), int8_t(this->speed_limit));
+}
+
+/**
+ * @brief Reads the voltage the speeds are tuned at.
+ *
+ * @return The nominal voltage.
+ */
+uint8_t BatteryGovernor::getNominalVoltage() {
+  return this->nominal_voltage;
+}
+
+/**
+ * @brief Reads the filtered battery voltage.
+ *
+ * @return The filtered voltage, the nominal voltage until the first measurement.
+ */
+uint8_t BatteryGovernor::readVoltage() {
+  return this->voltage;
+}
+
+/**
+ * @brief Reads the highest speed the battery can provide at full duty cycle.
+ *
+ * @return The speed, ranging from 0 to 100.
+ */
+uint8_t BatteryGovernor::readHeadroom() {
+  return min(uint16_t(this->voltage * 100 / this->nominal_voltage), uint16_t(100));
+}
+
+/**
+ * @brief Reads the speed limit of the current section.
+ *
+ * @return The speed limit, ranging from 0 to 100.
+ */
+uint8_t BatteryGovernor::readSpeedLimit() {
+  return this->speed_limit;
+}
+
+/**
+ * @brief Reads the state of charge of the battery.
+ *
+ * @return The state of the battery.
+ */
+BatteryState BatteryGovernor::readState() {
+  return this->state;
+}
+
+/**
+ * @brief Classifies the filtered voltage by the thresholds of the battery.
+ *
+ * A state is only left once the voltage has recovered by GOVERNOR_HYSTERESIS above its
+ * threshold, so a voltage close to a threshold does not toggle the state.
+ */
+void BatteryGovernor::updateState() {
+  BatteryState state = BatteryState::NORMAL;
+  if (this->voltage <= this->weak_voltage
+      || (this->state != BatteryState::NORMAL && this->voltage < this->weak_voltage + GOVERNOR_HYSTERESIS))
+    state = BatteryState::WEAK;
+  if (this->voltage <= this->critical_voltage
+      || (this->state == BatteryState::CRITICAL && this->voltage < this->critical_voltage + GOVERNOR_HYSTERESIS))
+    state = BatteryState::CRITICAL;
+
+  this->state = state;
+}
+
+/**
+ * @brief Calculates the speed limit from the headroom of the battery.
+ *
+ * @return The headroom less the reserve of the controllers, ranging from 0 to 100.
+ */
+uint8_t BatteryGovernor::readHeadroomLimit() {
+  return max(int16_t(this->readHeadroom()) - GOVERNOR_DUTY_RESERVE, 0);
+}
@@ -0,0 +1,81 @@
+/**
+ * @file BatteryGovernor.h
+ * @brief Header file for the BatteryGovernor class, adapting the speed of the robot to its battery.
+ *
+ * The BatteryGovernor class filters the measured battery voltage and estimates how much of the
+ * duty cycle is left as headroom. The speeds of the robot are tuned at a nominal voltage, and
+ * the motor driver scales its duty cycle by the ratio of the nominal to the filtered voltage, so
+ * a speed takes the same motor voltage on a full and on a sagging battery. Once the battery can
+ * no longer provide a speed at full duty, the speed is limited to what it can provide, with a
+ * reserve left for the controllers. The limit is fixed for a section, so the robot drives each
+ * section at a constant speed, and only tightened within a section if the battery turns
+ * critical. A weak and a critical battery are reported, so they can be shown before a
+ * brown-out resets the robot.
+ * Voltages are given in the scale of the voltage measurement, from 0 to 100.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef BATTERYGOVERNOR_H
+#define BATTERYGOVERNOR_H
+
+#include <inttypes.h>
+#include "MovingAverage.h"
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#define GOVERNOR_SMOOTHING 0.05   // Weight of a new measurement, about 0.2 s at 100 Hz.
+#define GOVERNOR_DUTY_RESERVE 10  // Duty cycle in percent kept free for the controllers.
+#define GOVERNOR_HYSTERESIS 2     // Voltage above a threshold at which its state is left again.
+
+/**
+ * @enum BatteryState
+ * @brief Enumerates the states of charge the governor distinguishes.
+ *
+ * WEAK batteries still provide every speed within the limit, but should be replaced before
+ * the next run. CRITICAL batteries are about to let the supply of the controller brown out
+ * under load.
+ */
+enum class BatteryState : uint8_t {
+  NORMAL,
+  WEAK,
+  CRITICAL
+};
+
+class BatteryGovernor {
+public:
+  BatteryGovernor();
+  ~BatteryGovernor();
+
+  void begin(uint8_t nominal_voltage, uint8_t weak_voltage, uint8_t critical_voltage);
+  void end();
+  void update(uint8_t voltage);
+  void beginSection();
+  int8_t limitSpeed(int8_t speed);
+  uint8_t getNominalVoltage();
+  uint8_t readVoltage();
+  uint8_t readHeadroom();
+  uint8_t readSpeedLimit();
+  BatteryState readState();
+
+private:
+  void updateState();
+  uint8_t readHeadroomLimit();
+
+  MovingAverage<uint8_t, uint8_t, 1> filter;
+  bool enabled;
+  BatteryState state;
+  uint8_t nominal_voltage;
+  uint8_t weak_voltage;
+  uint8_t critical_voltage;
+  uint8_t voltage;
+  uint8_t speed_limit;
+};
+
+#endif  // BATTERYGOVERNOR_H
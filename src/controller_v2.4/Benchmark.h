@@ -0,0 +1,266 @@
+/**
+ * @file Benchmark.h
+ * @brief Header file for the Benchmark structure, measuring the cost of the control code per call.
+ *
+ * The Benchmark structure runs a fixed suite of the hot paths of the control code and prints
+ * the cycles they take per call as a comma-separated table: the moving averages at several
+ * window sizes, getOutput() of every controller, Display::format() and the classification of
+ * camera blocks. On the Uno R4 the cycles are taken from the DWT cycle counter through the
+ * Profiler, which makes the numbers reproducible from one build to the next, so a change to one
+ * of these headers shows up as a change in the table.
+ *
+ * Each benchmark calls its function BENCHMARK_ITERATIONS times in a row and keeps the fastest
+ * of BENCHMARK_RUNS batches, so batches that were interrupted by a timer do not count. The
+ * cost of the loop itself is measured first and subtracted from all other rows. The inputs are
+ * taken from a fixed table, so the compiler can neither fold the calls nor hoist them out of
+ * the loop.
+ *
+ * The same suite is run on the host by tools/bench, with a clock of the host as the counter.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <inttypes.h>
+#include "MovingAverage.h"
+#include "Controlling.h"
+#include "Display.h"
+#include "Camera.h"
+
+#define BENCHMARK_ITERATIONS 256
+#define BENCHMARK_RUNS 8
+#define BENCHMARK_NUM_INPUTS 16
+
+// Inputs of the benchmarks, spread over the range of the distances and angles of the robot.
+const int16_t BENCHMARK_INPUTS[BENCHMARK_NUM_INPUTS] = {
+  12, 287, -45, 130, 3, -910, 64, 1750, -7, 99, 400, -180, 25, 2, -1337, 76
+};
+
+struct Benchmark {
+  Print *output;                 // Stream the table is printed to.
+  uint32_t (*read_cycles)();     // Counter the run times are measured with.
+  uint32_t clock_rate;           // Frequency of the counter in Hz.
+  uint32_t loop_cycles;          // Cost of a batch of empty iterations.
+  volatile int32_t sink;         // Receives the results, so no call is optimized away.
+
+  /**
+   * @brief Initializes the benchmark with the counter to measure with.
+   *
+   * @param output The stream the table is printed to, such as Serial.
+   * @param read_cycles The function reading the counter.
+   * @param clock_rate The frequency of the counter in Hz.
+   */
+  void begin(Print &output, uint32_t (*read_cycles)(), uint32_t clock_rate) {
+    this->output = &output;
+    this->read_cycles = read_cycles;
+    this->clock_rate = clock_rate;
+    this->loop_cycles = 0;
+    this->sink = 0;
+  }
+
+  /**
+   * @brief Runs the whole suite and prints one row per benchmark.
+   *
+   * The table is preceded by a row with the frequency of the counter. Each row holds the name
+   * of the benchmark, the amount of calls per batch, and the cycles and nanoseconds per call.
+   */
+  void run() {
+    this->output->print("clock_hz,");
+    this->output->println(this->clock_rate);
+    this->output->println("benchmark,iterations,cycles_per_call,ns_per_call");
+
+    this->loop_cycles = this->measure([this](uint8_t i) {
+      this->sink = BENCHMARK_INPUTS[i];
+    });
+    this->report("loop", this->loop_cycles);
+
+    this->runAverages<4>("MovingAverage<4>");
+    this->runAverages<16>("MovingAverage<16>");
+    this->runAverages<64>("MovingAverage<64>");
+    this->runControllers();
+    this->runDisplay();
+    this->runCamera();
+  }
+
+  /**
+   * @brief Measures add() followed by each of the averages of a moving average filter.
+   *
+   * @tparam WINDOW_SIZE The size of the data window.
+   * @param name The prefix of the names of the rows.
+   */
+  template<uint8_t WINDOW_SIZE>
+  void runAverages(const char *name) {
+    MovingAverage<int16_t, int16_t, WINDOW_SIZE> filter;
+
+    filter.begin();
+    this->report(name, "::SMA", this->measure([&](uint8_t i) {
+      filter.add(BENCHMARK_INPUTS[i]);
+      this->sink = filter.readAverage();
+    }));
+
+    filter.begin();
+    this->report(name, "::CA", this->measure([&](uint8_t i) {
+      filter.add(BENCHMARK_INPUTS[i]);
+      this->sink = filter.readCumulativeAverage();
+    }));
+
+    filter.begin();
+    this->report(name, "::WMA", this->measure([&](uint8_t i) {
+      filter.add(BENCHMARK_INPUTS[i]);
+      this->sink = filter.readWeightedAverage();
+    }));
+
+    filter.begin();
+    this->report(name, "::EMA", this->measure([&](uint8_t i) {
+      filter.add(BENCHMARK_INPUTS[i]);
+      this->sink = filter.readExponentialAverage(0.2);
+    }));
+  }
+
+  /**
+   * @brief Measures getOutput() of every controller, configured like the steering controllers.
+   *
+   * The sample time of the PID controllers is cleared, so they compute on every call. The double setpoint and the bang-bang
+   * controller only switch once per millisecond and return their last output in between,
+   * which is what most of their calls cost in the race as well.
+   */
+  void runControllers() {
+    PIDController pid(ControllerDirection::DIRECT);
+    pid.begin();
+    pid.setSampleTime(0);
+    pid.tune(1.2, 0.4, 0.05);
+    pid.setLimits(Constants::MAX_LEFT, Constants::MAX_RIGHT);
+    pid.setFeedForward(Constants::STRAIGHT);
+    pid.setSetpoint(0);
+    this->report("PIDController::getOutput", this->measure([&](uint8_t i) {
+      this->sink = pid.getOutput(BENCHMARK_INPUTS[i]);
+    }));
+
+    DoubleSetpointController double_setpoint(ControllerDirection::DIRECT);
+    double_setpoint.begin();
+    double_setpoint.setSetpoint(100);
+    double_setpoint.setHysteresis(10);
+    double_setpoint.setStates(-1, 0, 1);
+    this->report("DoubleSetpointController::getOutput", this->measure([&](uint8_t i) {
+      this->sink = double_setpoint.getOutput(BENCHMARK_INPUTS[i]);
+    }));
+
+    BangBangController bang_bang(ControllerDirection::DIRECT);
+    bang_bang.begin();
+    bang_bang.setSetpoint(100);
+    bang_bang.setHysteresis(10);
+    bang_bang.setStates(0, 1);
+    this->report("BangBangController::getOutput", this->measure([&](uint8_t i) {
+      this->sink = bang_bang.getOutput(BENCHMARK_INPUTS[i]);
+    }));
+
+    PIDController outer(ControllerDirection::DIRECT);
+    PIDController inner(ControllerDirection::DIRECT);
+    CascadeController cascade(outer, inner);
+    outer.begin();
+    inner.begin();
+    cascade.begin();
+    outer.setSampleTime(0);
+    inner.setSampleTime(0);
+    outer.tune(0.5, 0, 0);
+    inner.tune(1.2, 0.4, 0.05);
+    inner.setLimits(Constants::MAX_LEFT, Constants::MAX_RIGHT);
+    inner.setFeedForward(Constants::STRAIGHT);
+    cascade.setSetpoint(50);
+    this->report("CascadeController::getOutput", this->measure([&](uint8_t i) {
+      this->sink = cascade.getOutput(BENCHMARK_INPUTS[i], BENCHMARK_INPUTS[(i + 1) % BENCHMARK_NUM_INPUTS]);
+    }));
+  }
+
+  /**
+   * @brief Measures Display::format() with the widest field the display uses.
+   */
+  void runDisplay() {
+    Display formatter;
+    char buffer[DISPLAY_MAX_DIGITS + 2];
+
+    this->report("Display::format", this->measure([&](uint8_t i) {
+      formatter.format(buffer, BENCHMARK_INPUTS[i], DISPLAY_MAX_DIGITS, true);
+      this->sink = buffer[1];
+    }));
+  }
+
+  /**
+   * @brief Measures the classification of a block signature and the search for the nearest block.
+   *
+   * The search runs on a full array of blocks with the relevant block at its end, which is the
+   * longest search a frame can cause.
+   */
+  void runCamera() {
+    Camera classifier;
+
+    this->report("Camera::classify", this->measure([&](uint8_t i) {
+      this->sink = uint8_t(classifier.classify(BENCHMARK_INPUTS[i] & 7));
+    }));
+
+    classifier.num_blocks = MAX_CAMERA_BLOCKS;
+    for (uint8_t i = 0; i < MAX_CAMERA_BLOCKS; i++) {
+      classifier.blocks[i] = { (i < MAX_CAMERA_BLOCKS - 1) ? Colour::RED : Colour::MAGENTA, 158, 104, 20, 40, 1, i };
+    }
+    this->report("Camera::findNearest", this->measure([&](uint8_t i) {
+      this->sink = classifier.readX(true) + i;
+    }));
+  }
+
+  /**
+   * @brief Measures the cost of a batch of calls of a function.
+   *
+   * @param function The function to call, with the index of its input in BENCHMARK_INPUTS.
+   * @return The cycles of the fastest batch, without the cost of the loop.
+   */
+  template<typename F>
+  uint32_t measure(F function) {
+    uint32_t fastest_cycles = UINT32_MAX;
+
+    for (uint8_t run = 0; run < BENCHMARK_RUNS; run++) {
+      uint32_t start_cycles = this->read_cycles();
+      for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        function(i % BENCHMARK_NUM_INPUTS);
+      }
+      fastest_cycles = min(fastest_cycles, uint32_t(this->read_cycles() - start_cycles));
+    }
+
+    return (fastest_cycles > this->loop_cycles) ? fastest_cycles - this->loop_cycles : 0;
+  }
+
+  /**
+   * @brief Prints the row of a benchmark.
+   *
+   * @param name The name of the benchmark.
+   * @param cycles The cycles of a batch.
+   */
+  void report(const char *name, uint32_t cycles) {
+    this->report(name, "", cycles);
+  }
+
+  /**
+   * @brief Prints the row of a benchmark whose name is made of a prefix and a suffix.
+   *
+   * @param prefix The first part of the name of the benchmark.
+   * @param suffix The second part of the name of the benchmark.
+   * @param cycles The cycles of a batch.
+   */
+  void report(const char *prefix, const char *suffix, uint32_t cycles) {
+    float cycles_per_call = float(cycles) / BENCHMARK_ITERATIONS;
+
+    this->output->print(prefix);
+    this->output->print(suffix);
+    this->output->print(",");
+    this->output->print(BENCHMARK_ITERATIONS);
+    this->output->print(",");
+    this->output->print(cycles_per_call, 1);
+    this->output->print(",");
+    this->output->println(cycles_per_call * 1e9f / this->clock_rate, 1);
+  }
+};
+
+#endif  // BENCHMARK_H
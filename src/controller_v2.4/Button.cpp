@@ -77,7 +77,7 @@ bool Button::readState() {
   if (!this->enabled)
     return 0;
 
-  if (this->updating_location != LOCATION_B && this->updating_location != LOCATION_C && this->updating_location != LOCATION_D) {
+  if (this->updating_location != LOCATION_B && this->updating_location != LOCATION_C && this->updating_location != LOCATION_D && this->updating_location != LOCATION_E) {
     this->updating_location = LOCATION_A;
   }
 
@@ -94,6 +94,10 @@ bool Button::readState() {
 
   // Update the steady state after the debounce delay has passed.
   if (millis() - last_debounce_time > this->debounce_delay) {
+    // Remember when the button went down to measure how long it is held.
+    if (this->last_steady_state == HIGH && this->current_state == LOW) {
+      this->pressed_millis = millis();
+    }
     this->last_steady_state = this->current_state;
   }
 
@@ -138,7 +142,7 @@ bool Button::isPressed() {
   if (!this->enabled)
     return 0;
 
-  if (this->updating_location != LOCATION_A && this->updating_location != LOCATION_C && this->updating_location != LOCATION_D) {
+  if (this->updating_location != LOCATION_A && this->updating_location != LOCATION_C && this->updating_location != LOCATION_D && this->updating_location != LOCATION_E) {
     this->updating_location = LOCATION_B;
     this->readState();
   }
@@ -163,10 +167,38 @@ bool Button::isReleased() {
   if (!this->enabled)
     return 0;
 
-  if (this->updating_location != LOCATION_A && this->updating_location != LOCATION_B && this->updating_location != LOCATION_D) {
+  if (this->updating_location != LOCATION_A && this->updating_location != LOCATION_B && this->updating_location != LOCATION_D && this->updating_location != LOCATION_E) {
     this->updating_location = LOCATION_C;
     this->readState();
   }
+
+  if (this->last_steady_state == LOW && this->current_state == HIGH)
+    return true;
+  else
+    return false;
+}
+
+/**
+ * @brief Determines if the button has been held down for a specified duration.
+ *
+ * This method checks whether the debounced button state has stayed pressed for at least the
+ * given duration since it went down. It is useful for long-press gestures that should not be
+ * confused with a regular press. The method ensures that the button's state is up-to-date by
+ * invoking `readState()` before making the determination.
+ *
+ * @param duration The time in milliseconds the button must be held down.
+ * @return True if the button has been held down for the duration, false otherwise.
+ */
+bool Button::isHeld(unsigned long duration) {
+  if (!this->enabled)
+    return 0;
+
+  if (this->updating_location != LOCATION_A && this->updating_location != LOCATION_B && this->updating_location != LOCATION_C && this->updating_location != LOCATION_D) {
+    this->updating_location = LOCATION_E;
+    this->readState();
+  }
+
+  return this->last_steady_state == LOW && millis() - this->pressed_millis >= duration;
 }
 
 /**
@@ -186,7 +218,7 @@ uint8_t Button::readCount(uint8_t counting_mode) {
 
   this->counting_mode = counting_mode;
 
-  if (this->updating_location != LOCATION_A && this->updating_location != LOCATION_B && this->updating_location != LOCATION_C) {
+  if (this->updating_location != LOCATION_A && this->updating_location != LOCATION_B && this->updating_location != LOCATION_C && this->updating_location != LOCATION_E) {
     this->updating_location = LOCATION_D;
     this->readState();
   }
@@ -204,5 +236,5 @@ uint8_t Button::readCount(uint8_t counting_mode) {
  * @return The total count of button release events.
  */
 uint8_t Button::readCount() {
-  this->readCount(FALLING);
+  return this->readCount(FALLING);
 }
\ No newline at end of file
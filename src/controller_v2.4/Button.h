@@ -28,6 +28,7 @@
 #define LOCATION_B 2
 #define LOCATION_C 3
 #define LOCATION_D 4
+#define LOCATION_E 5
 
 #define DEBOUNCE_DELAY 50
 
@@ -42,6 +43,7 @@ public:
   bool readState();
   bool isPressed();
   bool isReleased();
+  bool isHeld(unsigned long duration);
   uint8_t readCount(uint8_t counting_mode);
   uint8_t readCount();
 
@@ -54,6 +56,7 @@ private:
   uint8_t debounce_delay;
   uint8_t count;
   uint8_t counting_mode;
+  unsigned long pressed_millis;
 };
 
 #endif  // BUTTON_H
\ No newline at end of file
@@ -7,6 +7,10 @@
  * of detected objects. The structure is designed to simplify the process of integrating the Pixy2
  * camera into robotics and automation projects, offering a high-level interface for object detection
  * and color recognition.
+ *
+ * Each camera frame is fetched only once and without waiting for the camera. Its blocks are
+ * classified and sorted once into a fixed-size array, which all read methods work on, so the
+ * block list of the camera is never scanned again until the next frame arrives.
  */
 
 #ifndef CAMERA_H
@@ -15,6 +19,7 @@
 #include <sys/_stdint.h>
 #include "includes/ra/fsp/src/bsp/mcu/all/bsp_arm_exceptions.h"
 #include "api/Common.h"
+#include "Config.h"
 
 #if defined(ARDUINO_ARCH_RENESAS)
 #include <Pixy2_Renesas.h>
@@ -22,22 +27,6 @@
 #include <Pixy2.h>
 #endif
 
-/**
- * @enum Colour
- * @brief Enumerates the color signatures detected by the Pixy2 camera.
- * 
- * Provides symbolic names for the different colors that can be detected by the Pixy2 camera.
- * This enumeration simplifies the process of identifying and working with various color signatures
- * in the codebase, making it easier to handle color-based logic and decision-making.
- */
-enum class Colour : const uint8_t {
-  NONE,
-  RED,
-  GREEN,
-  MAGENTA,
-  WALL
-};
-
 // Create an instance of the Pixy2 camera.
 Pixy2 pixy;
 
@@ -51,21 +40,167 @@ Pixy2 pixy;
 #define GREEN_SIG_3 6
 #define MAGENTA_SIG 7
 
+#define MAX_CAMERA_BLOCKS 8
+#define CAMERA_FRAME_TIMEOUT 100
+
+/**
+ * @struct CameraBlock
+ * @brief Struct to hold a classified block of a camera frame.
+ *
+ * Positions and sizes are given in pixels of the camera frame. The age counts the frames the
+ * camera has been tracking the block for, and the index is the tracking index of the camera.
+ */
+struct CameraBlock {
+  Colour colour;
+  uint16_t x;
+  uint8_t y;
+  uint16_t width;
+  uint8_t height;
+  uint8_t age;
+  uint8_t index;
+};
+
 struct Camera {
+  CameraBlock blocks[MAX_CAMERA_BLOCKS];  // Classified blocks of the last frame, nearest first.
+  uint8_t num_blocks;                     // Amount of valid blocks in the array.
+  unsigned long frame_millis;             // Time at which the last frame has been received.
+  bool connected;                         // The camera has answered since begin().
+
   /**
-   * @brief Initializes the Pixy2 camera and configures its lighting settings.
+   * @brief Opens the connection to the Pixy2 camera without waiting for it.
    *
-   * Sets up the Pixy2 camera for operation by initializing its connection and configuring
-   * the built-in lamp and LED to the desired state. The lamp is turned off, and the LED is
-   * set to green, indicating readiness for color detection tasks.
+   * Unlike Pixy2::init(), which polls the camera for up to 5 seconds while it boots, only the
+   * link is opened here. The camera is pinged by connect() until it answers.
    */
   void begin() {
-    pixy.init();
+    pixy.m_link.open(PIXY_DEFAULT_ARGVAL);
+
+    this->num_blocks = 0;
+    this->frame_millis = millis();
+    this->connected = false;
+  }
+
+  /**
+   * @brief Pings the camera once and configures it as soon as it answers.
+   *
+   * The LED of the camera is turned off once it is connected.
+   *
+   * @return True if the camera is connected, false while it has not answered yet.
+   */
+  bool connect() {
+    if (this->connected)
+      return true;
+
+    if (pixy.getVersion() < 0)
+      return false;
+
+    pixy.getResolution();
     pixy.setLED(0, 0, 0);
+    this->frame_millis = millis();
+    this->connected = true;
+
+    return true;
+  }
+
+  /**
+   * @brief Fetches a new frame from the camera without waiting for it.
+   *
+   * Asks the camera for the blocks of a new frame. If the camera has not finished a new frame
+   * yet, the call returns at once and the blocks of the last frame are kept. If no frame has
+   * been received for longer than CAMERA_FRAME_TIMEOUT, the blocks are discarded, so stale
+   * obstacles are not steered around. Received blocks are classified by their signature and
+   * sorted from the nearest to the farthest block. Nothing is fetched before the camera is
+   * connected.
+   *
+   * @return True if a new frame has been received, false otherwise.
+   */
+  bool update() {
+    if (!this->connected)
+      return false;
+
+    int8_t result = pixy.ccc.getBlocks(false);
+
+    if (result < 0) {
+      if (millis() - this->frame_millis > CAMERA_FRAME_TIMEOUT) {
+        this->num_blocks = 0;
+      }
+      return false;
+    }
+
+    this->frame_millis = millis();
+    this->num_blocks = 0;
+
+    for (uint8_t i = 0; i < pixy.ccc.numBlocks; i++) {
+      const Block &block = pixy.ccc.blocks[i];
+      CameraBlock entry = {
+        classify(block.m_signature), block.m_x, uint8_t(block.m_y), block.m_width,
+        uint8_t(min(block.m_height, uint16_t(UINT8_MAX))), block.m_age, block.m_index
+      };
+
+      if (entry.colour == Colour::NONE)
+        continue;
+
+      // Insert the block by its size, since a nearer block appears larger. Blocks that are
+      // smaller than all others are dropped once the array is full.
+      uint8_t j = this->num_blocks;
+      while (j > 0 && area(this->blocks[j - 1]) < area(entry)) {
+        if (j < MAX_CAMERA_BLOCKS) {
+          this->blocks[j] = this->blocks[j - 1];
+        }
+        j--;
+      }
+
+      if (j < MAX_CAMERA_BLOCKS) {
+        this->blocks[j] = entry;
+        this->num_blocks = min(uint8_t(this->num_blocks + 1), uint8_t(MAX_CAMERA_BLOCKS));
+      }
+    }
+
+    return true;
   }
 
   /**
-   * @brief Identifies the most prominent color detected by the camera.
+   * @brief Retrieves the amount of classified blocks in the last frame.
+   *
+   * @return The amount of blocks, at most MAX_CAMERA_BLOCKS.
+   */
+  uint8_t getNumBlocks() {
+    return this->num_blocks;
+  }
+
+  /**
+   * @brief Retrieves a classified block of the last frame.
+   *
+   * @param index The position of the block, with 0 being the nearest block.
+   * @return The requested block.
+   */
+  const CameraBlock &getBlock(uint8_t index) {
+    return this->blocks[constrain(index, 0, MAX_CAMERA_BLOCKS - 1)];
+  }
+
+  /**
+   * @brief Finds the nearest block that is relevant for the current part of the race.
+   *
+   * While the magenta parking lot is unlocked, only magenta blocks are considered. Otherwise
+   * only the red and green pillars are considered.
+   *
+   * @param magenta_unlocked Whether the parking lot is searched for.
+   * @return The nearest relevant block, or a null pointer if there is none.
+   */
+  const CameraBlock *findNearest(bool magenta_unlocked) {
+    for (uint8_t i = 0; i < this->num_blocks; i++) {
+      bool is_magenta = this->blocks[i].colour == Colour::MAGENTA;
+
+      if (is_magenta == magenta_unlocked) {
+        return &this->blocks[i];
+      }
+    }
+
+    return nullptr;
+  }
+
+  /**
+   * @brief Identifies the colour of the nearest relevant block.
    *
    * Analyzes the color signatures of detected objects and determines the most prominent
    * color based on predefined signatures. This method is useful for applications that need
@@ -75,65 +210,79 @@ struct Camera {
    * if no color blocks are detected.
    */
   Colour readColour(bool magenta_unlocked) {
-    if (pixy.ccc.numBlocks) {
-      if (pixy.ccc.blocks[0].m_signature == RED_SIG_1 || pixy.ccc.blocks[0].m_signature == RED_SIG_2 || pixy.ccc.blocks[0].m_signature == RED_SIG_3) {
-        return Colour::RED;
-      } else if (pixy.ccc.blocks[0].m_signature == GREEN_SIG_1 || pixy.ccc.blocks[0].m_signature == GREEN_SIG_2 || pixy.ccc.blocks[0].m_signature == GREEN_SIG_3) {
-        return Colour::GREEN;
-      } else if (magenta_unlocked && pixy.ccc.blocks[0].m_signature == MAGENTA_SIG) {
-        return Colour::MAGENTA;
-      }
-    } else {
-      return Colour::NONE;
-    }
+    const CameraBlock *block = findNearest(magenta_unlocked);
+    return block ? block->colour : Colour::NONE;
   }
 
   /**
    * @brief Retrieves the horizontal position (X-coordinate) of the detected object.
    *
-   * Captures the X-coordinate of the first detected object's position as seen by the camera.
+   * Captures the X-coordinate of the nearest relevant object's position as seen by the camera.
    * This information can be used to determine the object's location within the camera's field
    * of view or to guide movement towards or away from the object.
    *
-   * @return The X-coordinate of the first detected object, or 0 if no objects are detected.
+   * @return The X-coordinate of the nearest object, or 0 if no objects are detected.
    */
   uint16_t readX(bool magenta_unlocked) {
-    if (pixy.ccc.numBlocks && magenta_unlocked && readColour(magenta_unlocked) == Colour::MAGENTA)
-      return pixy.ccc.blocks[0].m_x;
-    else if (pixy.ccc.numBlocks && !magenta_unlocked)
-      return pixy.ccc.blocks[0].m_x;
-    else
-      return 0;
+    const CameraBlock *block = findNearest(magenta_unlocked);
+    return block ? block->x : 0;
   }
 
   /**
    * @brief Retrieves the vertical position (Y-coordinate) of the detected object.
    *
-   * Captures the Y-coordinate of the first detected object's position as seen by the camera.
+   * Captures the Y-coordinate of the nearest relevant object's position as seen by the camera.
    * This information is crucial for applications that require knowledge of an object's
    * position along the vertical axis within the camera's field of view.
    *
-   * @return The Y-coordinate of the first detected object, or 0 if no objects are detected.
+   * @return The Y-coordinate of the nearest object, or 0 if no objects are detected.
    */
   uint8_t readY(bool magenta_unlocked) {
-    if (pixy.ccc.numBlocks && magenta_unlocked && readColour(magenta_unlocked) == Colour::MAGENTA)
-      return pixy.ccc.blocks[0].m_y;
-    else if (pixy.ccc.numBlocks && !magenta_unlocked)
-      return pixy.ccc.blocks[0].m_y;
-    else
-      return 0;
+    const CameraBlock *block = findNearest(magenta_unlocked);
+    return block ? block->y : 0;
   }
 
   /**
-   *Â @brief Retrieves the index of the block.
+   * @brief Retrieves the tracking index of the nearest relevant block.
+   *
+   * @return The index of the nearest object, or 0 if no objects are detected.
    */
   uint8_t readIndex(bool magenta_unlocked) {
-    if (pixy.ccc.numBlocks && magenta_unlocked && readColour(magenta_unlocked) == Colour::MAGENTA)
-      return pixy.ccc.blocks[0].m_index;
-    else if (pixy.ccc.numBlocks && !magenta_unlocked)
-      return pixy.ccc.blocks[0].m_index;
-    else
-      return 0;
+    const CameraBlock *block = findNearest(magenta_unlocked);
+    return block ? block->index : 0;
+  }
+
+  /**
+   * @brief Maps a colour signature of the camera to a colour.
+   *
+   * @param signature The signature of a block.
+   * @return The colour of the signature, or Colour::NONE for unknown signatures.
+   */
+  Colour classify(uint16_t signature) {
+    switch (signature) {
+      case RED_SIG_1:
+      case RED_SIG_2:
+      case RED_SIG_3:
+        return Colour::RED;
+      case GREEN_SIG_1:
+      case GREEN_SIG_2:
+      case GREEN_SIG_3:
+        return Colour::GREEN;
+      case MAGENTA_SIG:
+        return Colour::MAGENTA;
+      default:
+        return Colour::NONE;
+    }
+  }
+
+  /**
+   * @brief Calculates the area of a block, which grows as the block comes closer.
+   *
+   * @param block The block to measure.
+   * @return The area of the block in square pixels.
+   */
+  uint32_t area(const CameraBlock &block) {
+    return uint32_t(block.width) * block.height;
   }
 };
 
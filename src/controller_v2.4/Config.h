@@ -51,15 +51,12 @@ enum Pins : const pin_size_t {
  */
 enum Constants : const uint8_t {
   DEFAULT_SPEED = 60,  // SAFE 60
+  STRAIGHT_SPEED = 75,  // Straights without obstacles, relies on the scheduled steering gains
   REDUCED_SPEED = 55,
   MAX_LEFT = 46,
   MAX_RIGHT = 124,
   STRAIGHT = 90,
-  MIN_DISTANCE = 15,
-  // MAX_DISTANCE = 180, // OBSTACLE RACE
-  MAX_DISTANCE = 130,
-  STOPPING_OFFSET = 15  // SAFE QUALIFYING RACE
-  // STOPPING_OFFSET = 10  // OBSTACLE RACE
+  MIN_DISTANCE = 15
 };
 
 /**
@@ -68,14 +65,63 @@ enum Constants : const uint8_t {
  * 
  * Defines the operational states of the vehicle's navigation system,
  * particularly focusing on whether certain features are enabled or disabled. It is
- * used to toggle the inclusion of obstacle detection and the activation of the parking
- * assistance feature.
+ * used to toggle the reuse of the track map stored in the previous race and the
+ * compensation of the speed of sound for the temperature measured by the gyroscope. In the
+ * benchmark mode the robot does not race, but prints the cost of its control code instead.
+ * The features of the race itself are given by its profile, see RaceProfile.
  */
 enum Mode : const bool {
-  OBSTACLES_INCLUDED = true,
-  PARKING_ENABLED = false
+  PERSISTENT_TRACK_MAP = false,
+  TEMPERATURE_COMPENSATION = true,
+  BENCHMARK_MODE = false
 };
 
+/**
+ * @enum RaceType
+ * @brief Enumerates the races the robot can be built for, indexing RACE_PROFILES.
+ *
+ * SELECTABLE builds every profile in and lets the button choose one at boot, for testing.
+ */
+enum class RaceType : const uint8_t {
+  QUALIFYING,
+  OBSTACLE,
+  PARKING,
+  SELECTABLE
+};
+
+/**
+ * @struct RaceProfile
+ * @brief Struct to describe the features and thresholds of a race.
+ *
+ * The profile of the race selected by RACE_PROFILE is a constant, so the compiler removes the
+ * code of every feature the race does not include, such as the camera polling and the
+ * obstacle steering from the qualifying build.
+ */
+struct RaceProfile {
+  const char *name;
+  bool obstacles_included;
+  bool parking_enabled;
+  uint8_t max_distance;     // Side distance in cm beyond which a gap is detected.
+  uint8_t stopping_offset;  // Distance in cm the robot stops ahead of its start position.
+};
+
+constexpr RaceProfile RACE_PROFILES[] = {
+  { "QUALIFYING", false, false, 130, 15 },
+  { "OBSTACLE", true, false, 180, 10 },
+  { "PARKING", true, true, 180, 10 }
+};
+constexpr uint8_t NUM_RACE_PROFILES = sizeof(RACE_PROFILES) / sizeof(RACE_PROFILES[0]);
+
+// Race the robot is built for, one of the RaceType enumerators. It can also be given on the
+// command line of the compiler, such as -DRACE_PROFILE=PARKING.
+#ifndef RACE_PROFILE
+#define RACE_PROFILE OBSTACLE
+#endif
+
+// Baud rate of the serial port shared by the telemetry, the profiler and the benchmark. The
+// host tools in tools/ read it from here, so they always open the port at the same rate.
+#define SERIAL_BAUD_RATE 1000000
+
 
 ///ââââââââââââââââââââââââââââââââââââââââââââââââââ
 /// @subsection Symbolic Names
@@ -122,4 +168,73 @@ enum class TurnDirection : const uint8_t {
   RIGHT
 };
 
+/**
+ * @enum Colour
+ * @brief Enumerates the color signatures detected by the Pixy2 camera.
+ * 
+ * Provides symbolic names for the different colors that can be detected by the Pixy2 camera.
+ * This enumeration simplifies the process of identifying and working with various color signatures
+ * in the codebase, making it easier to handle color-based logic and decision-making.
+ */
+enum class Colour : const uint8_t {
+  NONE,
+  RED,
+  GREEN,
+  MAGENTA,
+  WALL
+};
+
+/**
+ * @enum DeviceState
+ * @brief Enumerates the states of a device while the robot starts up.
+ *
+ * Every device is brought up in its own stage of the startup. A device that does not become
+ * ready within its timeout is marked as failed, so the startup always comes to an end.
+ */
+enum class DeviceState : const uint8_t {
+  PENDING,
+  READY,
+  FAILED
+};
+
+/**
+ * @enum RaceState
+ * @brief Enumerates the states of the race logic.
+ *
+ * The states are nested as listed in the state table of the sketch, which is indexed by this
+ * enumeration. RUN encloses all other states and is entered again to restart the run. NONE
+ * marks the end of the states.
+ */
+enum class RaceState : const uint8_t {
+  RUN,               // The robot is on a run, from its start until it is restarted.
+  DRIVING,           // The robot races along the track, on the straights and through the turns.
+  STRAIGHT,          // The robot follows the section and steers around its pillars.
+  TURN,              // The robot turns into the next section.
+  TURNING,           // The robot steers through the corner.
+  CORRECTING,        // The robot corrects its heading in reverse at the end of a swift turn.
+  PARKING,           // The robot parks in the parking lot.
+  PARK_APPROACHING,  // The robot drives on past the parking lot.
+  PARK_TURNING,      // The robot steers into the parking lot.
+  PARK_CORRECTING,   // The robot reverses into the parking lot.
+  STOPPED,           // The robot has finished the run and stands still.
+  NONE
+};
+
+/**
+ * @enum RaceEvent
+ * @brief Enumerates the events the states of the race logic react to.
+ *
+ * The same event may lead to different states, depending on the state it is received in.
+ * NONE marks the end of the events.
+ */
+enum class RaceEvent : const uint8_t {
+  RESTART,              // The button has been pressed to restart the stopped run.
+  CORNER_REACHED,       // The robot has reached the position to turn at.
+  CORRECTION_REQUIRED,  // The rest of the turn is made in reverse.
+  TURN_COMPLETED,       // The robot has reached the heading of the turn.
+  FINISH_REACHED,       // The robot has completed its laps and is back at the start.
+  PARKING_LOT_PASSED,   // The robot has passed the parking lot.
+  NONE
+};
+
 #endif  // CONFIG_H
\ No newline at end of file
@@ -21,7 +21,8 @@
  * @param direction The initial direction of control for the controller.
  */
 Controller::Controller(ControllerDirection direction)
-  : controller_direction(direction), update_delay(50) {
+  : controller_direction(direction), enabled(false), update_delay(50), input(0), output(0), setpoint(0),
+    last_millis(0) {
 }
 
 /**
@@ -139,7 +140,7 @@ int16_t Controller::getSetpoint() {
  * @param input The current input value to the controller.
  * @return The computed output value from the controller.
  */
-int16_t Controller::getOutput(int16_t input) {
+int16_t Controller::getOutput(int16_t /* input */) {
   if (!this->enabled)
     return 0;
 
@@ -160,12 +161,9 @@ int16_t Controller::getOutput(int16_t input) {
  * @param direction The initial direction of control for the PID controller.
  */
 PIDController::PIDController(ControllerDirection direction)
-  : Controller(direction) {
-  this->p_gain = 1.00;
-  this->i_gain = 1.00;
-  this->d_gain = 1.00;
-  this->min_output = 0;
-  this->max_output = 180;
+  : Controller(direction), limits_configured(false), has_sample(false), min_output(0), max_output(180),
+    feed_forward(0), last_input(0), p_gain(PID_GAIN_SCALE), i_gain(0), d_gain(0), integral(0), derivative(0),
+    scaled_output(0), last_micros(0) {
 }
 
 /**
@@ -176,30 +174,51 @@ PIDController::PIDController(ControllerDirection direction)
 PIDController::~PIDController() {
 }
 
+/**
+ * @brief Activates the PID controller.
+ *
+ * Enables the controller and clears its internal state, so the first output is computed
+ * from the proportional and feed-forward terms only.
+ */
+void PIDController::begin() {
+  Controller::begin();
+  this->reset();
+}
+
+/**
+ * @brief Clears the integral and derivative terms of the PID controller.
+ *
+ * Should be called whenever the controlled quantity changes abruptly, such as the
+ * heading error at the end of a turn, so the history of the previous manoeuvre does
+ * not leak into the next one.
+ */
+void PIDController::reset() {
+  this->has_sample = false;
+  this->integral = 0;
+  this->derivative = 0;
+}
+
 /**
  * @brief Sets the PID gains for the controller.
  *
  * Configures the proportional, integral, and derivative gains of the PID controller,
  * affecting its responsiveness and stability. Negative gains are not allowed and will
- * result in no change to the controller's configuration.
+ * result in no change to the controller's configuration. The gains are stored as
+ * fixed-point values with a resolution of 1/PID_GAIN_SCALE, so gains given as constants are
+ * converted at compile time. The integral gain is given per second and the derivative gain
+ * in seconds.
  *
  * @param proportional_gain The gain for the proportional term of the PID controller.
  * @param integral_gain The gain for the integral term of the PID controller.
  * @param derivative_gain The gain for the derivative term of the PID controller.
  */
-void PIDController::tune(float proportional_gain, float integral_gain, float derivative_gain) {
+void PIDController::tune(PIDGain proportional_gain, PIDGain integral_gain, PIDGain derivative_gain) {
   if (proportional_gain < 0 || integral_gain < 0 || derivative_gain < 0 || !this->enabled) {
     return;
   }
-  this->p_gain = proportional_gain;
-  this->i_gain = integral_gain;
-  this->d_gain = derivative_gain;
-
-  if (this->controller_direction == ControllerDirection::REVERSE) {
-    this->p_gain = -this->p_gain;
-    this->i_gain = -this->i_gain;
-    this->d_gain = -this->d_gain;
-  }
+  this->p_gain = proportional_gain.toRaw();
+  this->i_gain = integral_gain.toRaw();
+  this->d_gain = derivative_gain.toRaw();
 }
 
 /**
@@ -224,13 +243,72 @@ void PIDController::setLimits(int16_t min_output, int16_t max_output) {
   }
 }
 
+/**
+ * @brief Sets the feed-forward term of the PID controller.
+ *
+ * The feed-forward term is added to the output as is, e.g. the neutral position of a
+ * servo or the expected output at the current operating point, so the feedback terms
+ * only have to correct the remaining error.
+ *
+ * @param feed_forward The value to add to the output of the controller.
+ */
+void PIDController::setFeedForward(int16_t feed_forward) {
+  if (!this->enabled)
+    return;
+
+  this->feed_forward = feed_forward;
+}
+
+/**
+ * @brief Interpolates the PID gains from a gain schedule.
+ *
+ * Looks up the operating point in a table of gains sorted by ascending operating points
+ * and tunes the controller with the linearly interpolated gains, in steps of 1/PID_GAIN_SCALE.
+ * Beyond the first and the last entry, their gains are used. As the integral term is stored in units of the output,
+ * changing the gains does not cause a bump in the output.
+ *
+ * @param gains The table of gains, sorted by ascending operating points.
+ * @param num_gains The amount of entries in the table.
+ * @param operating_point The current operating point, e.g. the speed of the system.
+ */
+void PIDController::schedule(const PIDGains *gains, uint8_t num_gains, int16_t operating_point) {
+  if (!this->enabled || !num_gains)
+    return;
+
+  if (operating_point <= gains[0].operating_point) {
+    this->tune(gains[0].proportional_gain, gains[0].integral_gain, gains[0].derivative_gain);
+    return;
+  }
+
+  for (uint8_t i = 1; i < num_gains; i++) {
+    if (operating_point < gains[i].operating_point) {
+      const PIDGains &lower = gains[i - 1];
+      const PIDGains &upper = gains[i];
+      int32_t offset = int32_t(operating_point) - lower.operating_point;
+      int32_t span = int32_t(upper.operating_point) - lower.operating_point;
+
+      this->tune(lower.proportional_gain + (upper.proportional_gain - lower.proportional_gain) * offset / span,
+                 lower.integral_gain + (upper.integral_gain - lower.integral_gain) * offset / span,
+                 lower.derivative_gain + (upper.derivative_gain - lower.derivative_gain) * offset / span);
+      return;
+    }
+  }
+
+  const PIDGains &last = gains[num_gains - 1];
+  this->tune(last.proportional_gain, last.integral_gain, last.derivative_gain);
+}
+
 /**
  * @brief Calculates and returns the output value based on the provided input.
  *
  * This function computes the control output of a PID controller by taking the current
- * system input and applying the PID algorithm using the setpoint, gains, and previously
- * calculated error values. It ensures the output is within configured limits and updates
- * internal states for subsequent calls.
+ * system input and applying the PID algorithm using the setpoint, gains, and the time
+ * passed since the previous sample. The derivative term is computed from the change of
+ * the input and low-pass filtered, as sensor readings are quantized. The integral is
+ * only updated while the output is not saturated in the direction of the error, and it
+ * never exceeds the output range. If the controller has not been sampled for more than
+ * PID_MAX_SAMPLE_TIME milliseconds, the sample only updates its state, so a stale input
+ * does not distort the integral and derivative terms.
  *
  * @param input The current input value from the system being controlled.
  * @return The calculated control output to be applied to the system.
@@ -239,38 +317,69 @@ int16_t PIDController::getOutput(int16_t input) {
   if (!this->enabled)
     return 0;
 
-  static unsigned long last_millis;
-  static int16_t last_error_value, error_sum;
-  int16_t error_value, error_differential;
   this->input = input;
 
   // Update the values, depending on the updating interval.
-  if (millis() - last_millis > this->update_delay) {
-    last_millis = millis();
-
-    // Calculate the error, error-sum, and error-differential.
-    error_value = this->setpoint - this->input;
-    error_sum += error_value * (millis() - last_millis);
-    if (this->limits_configured) {
-      error_sum = constrain(error_sum, this->min_output, this->max_output);
-    }
-    error_differential = (error_value - last_error_value) / (millis() - last_millis);
+  unsigned long now = micros();
+  unsigned long sample_time = now - this->last_micros;
+  if (this->has_sample && sample_time < this->update_delay * 1000UL)
+    return this->output;
 
-    // Calculate the output. Constrain, if necessary.
-    this->output = this->p_gain * error_value + this->i_gain * error_sum + this->d_gain * error_differential;
-    if (this->limits_configured) {
-      this->output = constrain(this->output, this->min_output, this->max_output);
-    }
+  // The direction only affects the sign of the error, so the gains stay positive.
+  int8_t sign = (this->controller_direction == ControllerDirection::DIRECT) ? 1 : -1;
+  int32_t error_value = sign * (int32_t(this->setpoint) - this->input);
+  int32_t proportional = this->p_gain * error_value;
+  int32_t integral = this->integral;
 
-    last_error_value = error_value;
+  if (this->has_sample && sample_time <= PID_MAX_SAMPLE_TIME * 1000UL) {
+    integral += int64_t(this->i_gain) * error_value * int32_t(sample_time) / 1000000;
+
+    // Differentiate the measurement instead of the error, so setpoint changes have no effect.
+    int32_t input_rate = int64_t(-sign) * (this->input - this->last_input) * 1000000 / int32_t(sample_time);
+    this->derivative += (this->d_gain * input_rate - this->derivative) >> PID_DERIVATIVE_FILTER_SHIFT;
   }
 
-  // Return the output.
+  int32_t output = proportional + integral + this->derivative;
+  int32_t scaled_output = int32_t(this->feed_forward) * PID_GAIN_SCALE + output;
+  output = this->feed_forward + (output + (output >= 0 ? PID_GAIN_SCALE / 2 : -PID_GAIN_SCALE / 2)) / PID_GAIN_SCALE;
+
   if (this->limits_configured) {
-    return this->constrained_output;
+    // Anti-windup: keep the previous integral while the output saturates in the direction of the error.
+    bool saturated = (output > this->max_output && error_value > 0) || (output < this->min_output && error_value < 0);
+    if (!saturated) {
+      int32_t max_integral = int32_t(this->max_output - this->feed_forward) * PID_GAIN_SCALE;
+      int32_t min_integral = int32_t(this->min_output - this->feed_forward) * PID_GAIN_SCALE;
+      this->integral = constrain(integral, min_integral, max_integral);
+    }
+    output = constrain(output, this->min_output, this->max_output);
+    scaled_output = constrain(scaled_output, int32_t(this->min_output) * PID_GAIN_SCALE, int32_t(this->max_output) * PID_GAIN_SCALE);
   } else {
-    return this->output;
+    this->integral = integral;
   }
+
+  this->output = output;
+  this->scaled_output = scaled_output;
+  this->last_input = this->input;
+  this->last_micros = now;
+  this->has_sample = true;
+
+  // Return the output.
+  return this->output;
+}
+
+/**
+ * @brief Reads the last output without rounding it to whole units.
+ *
+ * Actuators with a finer resolution than the output, such as the steering servo, can follow
+ * the controller more smoothly with this value.
+ *
+ * @return The last output in units of 1/PID_GAIN_SCALE.
+ */
+int32_t PIDController::readScaledOutput() {
+  if (!this->enabled)
+    return 0;
+
+  return this->scaled_output;
 }
 
 ///ââââââââââââââââââââââââââââââââââââââââââââââââââ
@@ -366,11 +475,10 @@ int16_t DoubleSetpointController::getOutput(int16_t input) {
   if (!this->enabled)
     return 0;
 
-  static unsigned long last_millis;
   this->input = input;
 
-  if (millis() - last_millis > this->update_delay) {
-    last_millis = millis();
+  if (millis() - this->last_millis > this->update_delay) {
+    this->last_millis = millis();
 
     if (this->input >= this->setpoint - this->hysteresis && this->input <= this->setpoint + this->hysteresis) {
       this->output = this->medium_state;
@@ -452,11 +560,10 @@ int16_t BangBangController::getOutput(int16_t input) {
   if (!this->enabled)
     return 0;
 
-  static unsigned long last_millis;
   this->input = input;
 
-  if (millis() - last_millis > this->update_delay) {
-    last_millis = millis();
+  if (millis() - this->last_millis > this->update_delay) {
+    this->last_millis = millis();
 
     if (this->input < this->setpoint - this->hysteresis) {
       if (this->controller_direction == ControllerDirection::DIRECT) {
@@ -474,4 +581,123 @@ int16_t BangBangController::getOutput(int16_t input) {
   }
 
   return this->output;
+}
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @class  CascadeController
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+/**
+ * @brief Chains two PID controllers into a cascade.
+ *
+ * The outer controller computes a correction, which is added to the reference to form the
+ * setpoint of the inner controller. The output of the inner controller is the output of the
+ * cascade. Both controllers have to be started and configured on their own, so they can
+ * have different limits, directions and gains.
+ *
+ * @param outer_controller The controller of the slow outer loop.
+ * @param inner_controller The controller of the fast inner loop.
+ */
+CascadeController::CascadeController(PIDController &outer_controller, PIDController &inner_controller)
+  : outer_controller(outer_controller), inner_controller(inner_controller), enabled(false), reference(0),
+    correction(0) {
+}
+
+/**
+ * @brief Destructor for the CascadeController class.
+ *
+ * The chained controllers are owned by the caller and are not affected.
+ */
+CascadeController::~CascadeController() {
+}
+
+/**
+ * @brief Activates the cascade.
+ */
+void CascadeController::begin() {
+  this->enabled = true;
+  this->reset();
+}
+
+/**
+ * @brief Deactivates the cascade.
+ */
+void CascadeController::end() {
+  this->enabled = false;
+}
+
+/**
+ * @brief Clears the history of both chained controllers and the correction.
+ */
+void CascadeController::reset() {
+  this->outer_controller.reset();
+  this->inner_controller.reset();
+  this->correction = 0;
+}
+
+/**
+ * @brief Sets the setpoint of the outer loop.
+ *
+ * @param setpoint The target value of the outer controller.
+ */
+void CascadeController::setSetpoint(int16_t setpoint) {
+  if (!this->enabled)
+    return;
+
+  this->outer_controller.setSetpoint(setpoint);
+}
+
+/**
+ * @brief Sets the reference the correction of the outer loop is added to.
+ *
+ * @param reference The setpoint of the inner controller without correction.
+ */
+void CascadeController::setReference(int16_t reference) {
+  if (!this->enabled)
+    return;
+
+  this->reference = reference;
+}
+
+/**
+ * @brief Retrieves the last correction of the outer loop.
+ *
+ * @return The output of the outer controller.
+ */
+int16_t CascadeController::getCorrection() {
+  if (!this->enabled)
+    return 0;
+
+  return this->correction;
+}
+
+/**
+ * @brief Computes the output of the cascade.
+ *
+ * Runs the outer controller on its input, shifts the setpoint of the inner controller by its
+ * output and runs the inner controller on its input.
+ *
+ * @param outer_input The current input of the outer controller.
+ * @param inner_input The current input of the inner controller.
+ * @return The output of the inner controller.
+ */
+int16_t CascadeController::getOutput(int16_t outer_input, int16_t inner_input) {
+  if (!this->enabled)
+    return 0;
+
+  this->correction = this->outer_controller.getOutput(outer_input);
+  this->inner_controller.setSetpoint(this->reference + this->correction);
+  return this->inner_controller.getOutput(inner_input);
+}
+
+/**
+ * @brief Reads the last output of the inner controller without rounding it to whole units.
+ *
+ * @return The last output in units of 1/PID_GAIN_SCALE.
+ */
+int32_t CascadeController::readScaledOutput() {
+  if (!this->enabled)
+    return 0;
+
+  return this->inner_controller.readScaledOutput();
 }
\ No newline at end of file
@@ -1,15 +1,16 @@
 /**
  * @file Controlling.h
- * @brief Header file for the Controller, PIDController, DoubleSetpointController, and BangBangController classes.
+ * @brief Header file for the Controller, PIDController, DoubleSetpointController, BangBangController, and CascadeController classes.
  *
  * This header file defines a comprehensive suite of control classes designed for a variety of control systems. 
  * The base Controller class establishes a common interface and foundational methods for general control tasks. 
  * The PIDController class provides a sophisticated Proportional-Integral-Derivative control mechanism, suitable 
- * for systems requiring dynamic adjustments based on continuous feedback. The DoubleSetpointController class is 
- * tailored for scenarios where control actions are determined by two distinct setpoints, offering a hysteresis 
- * feature to prevent oscillation around the setpoint. The BangBangController class extends the 
- * DoubleSetpointController with a simple yet effective on-off control strategy, ideal for applications where 
- * precision is less critical, and a binary output is sufficient.
+ * for systems requiring dynamic adjustments based on continuous feedback, computed in fixed-point arithmetic. 
+ * The DoubleSetpointController class is tailored for scenarios where control actions are determined by two 
+ * distinct setpoints, offering a hysteresis feature to prevent oscillation around the setpoint. The 
+ * BangBangController class extends the DoubleSetpointController with a simple yet effective on-off control 
+ * strategy, ideal for applications where precision is less critical, and a binary output is sufficient. The 
+ * CascadeController class chains two PID controllers, the outer one shifting the setpoint of the inner one.
  *
  * The ControllerDirection enumeration simplifies the specification of control action direction, improving code 
  * clarity and maintainability. These classes are versatile and can be integrated into diverse applications, from 
@@ -29,6 +30,7 @@
 
 #include <sys/_stdint.h>
 #include <inttypes.h>
+#include "Fixed.h"
 
 #if defined(ARDUINO) && ARDUINO >= 100
 #include "Arduino.h"
@@ -36,11 +38,29 @@
 #include "WProgram.h"
 #endif
 
+#define PID_GAIN_BITS 8
+#define PID_GAIN_SCALE (1 << PID_GAIN_BITS)
+#define PID_DERIVATIVE_FILTER_SHIFT 2
+#define PID_MAX_SAMPLE_TIME 200
+
 enum class ControllerDirection : bool {
   DIRECT,
   REVERSE
 };
 
+typedef Fixed<PID_GAIN_BITS> PIDGain;
+
+/**
+ * @struct PIDGains
+ * @brief Gains of a PID controller at an operating point of a gain schedule.
+ */
+struct PIDGains {
+  int16_t operating_point;
+  PIDGain proportional_gain;
+  PIDGain integral_gain;
+  PIDGain derivative_gain;
+};
+
 class Controller {
 public:
   Controller(ControllerDirection direction);
@@ -62,6 +82,7 @@ protected:
   int16_t input;
   int16_t output;
   int16_t setpoint;
+  unsigned long last_millis;
 };
 
 class PIDController : public Controller {
@@ -69,18 +90,29 @@ public:
   PIDController(ControllerDirection direction);
   ~PIDController();
 
-  void tune(float proportional_gain, float integral_gain, float derivative_gain);
+  void begin() override;
+  void reset();
+  void tune(PIDGain proportional_gain, PIDGain integral_gain, PIDGain derivative_gain);
   void setLimits(int16_t min_output, int16_t max_output);
+  void setFeedForward(int16_t feed_forward);
+  void schedule(const PIDGains *gains, uint8_t num_gains, int16_t operating_point);
   int16_t getOutput(int16_t input) override;
+  int32_t readScaledOutput();
 
 private:
   bool limits_configured;
-  int16_t constrained_output;
+  bool has_sample;
   int16_t min_output;
   int16_t max_output;
-  float p_gain;
-  float i_gain;
-  float d_gain;
+  int16_t feed_forward;
+  int16_t last_input;
+  int32_t p_gain;
+  int32_t i_gain;
+  int32_t d_gain;
+  int32_t integral;
+  int32_t derivative;
+  int32_t scaled_output;
+  unsigned long last_micros;
 };
 
 class DoubleSetpointController : public Controller {
@@ -93,7 +125,7 @@ public:
   uint8_t getHysteresis();
   virtual int16_t getOutput(int16_t input) override;
 
-private:
+protected:
   uint8_t hysteresis;
   int16_t low_state;
   int16_t medium_state;
@@ -107,11 +139,28 @@ public:
 
   void setStates(int16_t low_state, int16_t high_state);
   int16_t getOutput(int16_t input) override;
+};
+
+class CascadeController {
+public:
+  CascadeController(PIDController &outer_controller, PIDController &inner_controller);
+  ~CascadeController();
+
+  void begin();
+  void end();
+  void reset();
+  void setSetpoint(int16_t setpoint);
+  void setReference(int16_t reference);
+  int16_t getCorrection();
+  int16_t getOutput(int16_t outer_input, int16_t inner_input);
+  int32_t readScaledOutput();
 
 private:
-  uint8_t hysteresis;
-  int16_t low_state;
-  int16_t high_state;
+  PIDController &outer_controller;
+  PIDController &inner_controller;
+  bool enabled;
+  int16_t reference;
+  int16_t correction;
 };
 
 #endif  // CONTROLLING_H
\ No newline at end of file
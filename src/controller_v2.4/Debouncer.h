@@ -0,0 +1,149 @@
+/**
+ * @file Debouncer.h
+ * @brief Header file for the Debouncer template class, filtering out flickering conditions.
+ *
+ * The Debouncer class template only accepts a new state of a condition once it has been
+ * observed for a number of consecutive samples, which is fixed at compile time. Together
+ * with the optional hysteresis between a rising and a falling threshold, single outliers
+ * of a sensor can neither trigger nor cancel a detection. Every instance keeps its own
+ * counter, so each sensor or detection owns an independent debouncer.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef DEBOUNCER_H
+#define DEBOUNCER_H
+
+#include <inttypes.h>
+
+template<uint8_t CONSECUTIVE_MATCHES>
+class Debouncer {
+  static_assert(CONSECUTIVE_MATCHES > 0, "A Debouncer needs at least one match to change its state.");
+
+public:
+  Debouncer();
+  ~Debouncer();
+
+  void reset(bool state = false);
+  bool update(bool condition);
+  template<typename T>
+  bool update(T input, T rising_threshold, T falling_threshold);
+  bool read();
+  bool rose();
+  bool fell();
+
+private:
+  bool state;
+  bool changed;
+  uint8_t matches;
+};
+
+/**
+ * @brief Constructs a new Debouncer object in the inactive state.
+ */
+template<uint8_t CONSECUTIVE_MATCHES>
+Debouncer<CONSECUTIVE_MATCHES>::Debouncer()
+  : state(false), changed(false), matches(0) {}
+
+/**
+ * @brief Destructs a constructed Debouncer object.
+ */
+template<uint8_t CONSECUTIVE_MATCHES>
+Debouncer<CONSECUTIVE_MATCHES>::~Debouncer() {}
+
+/**
+ * @brief Forces the debouncer into a given state and clears its counter.
+ *
+ * @param state The state the debouncer starts from.
+ */
+template<uint8_t CONSECUTIVE_MATCHES>
+void Debouncer<CONSECUTIVE_MATCHES>::reset(bool state) {
+  this->state = state;
+  this->changed = false;
+  this->matches = 0;
+}
+
+/**
+ * @brief Feeds a new sample of the condition into the debouncer.
+ *
+ * The state only changes once the condition has differed from it for the specified
+ * amount of samples in a row. A sample that agrees with the current state clears the
+ * counter again.
+ *
+ * @param condition The current sample of the condition.
+ * @return The debounced state of the condition.
+ */
+template<uint8_t CONSECUTIVE_MATCHES>
+bool Debouncer<CONSECUTIVE_MATCHES>::update(bool condition) {
+  this->changed = false;
+
+  if (condition != this->state) {
+    this->matches++;
+
+    if (this->matches >= CONSECUTIVE_MATCHES) {
+      this->state = condition;
+      this->changed = true;
+      this->matches = 0;
+    }
+  } else {
+    this->matches = 0;
+  }
+
+  return this->state;
+}
+
+/**
+ * @brief Feeds a new input value into the debouncer, using a hysteresis band.
+ *
+ * While inactive, the input has to reach the rising threshold to count as a match. While
+ * active, the input has to drop below the falling threshold to count as a match. Inputs
+ * in between keep the current state.
+ *
+ * @param input The current input value.
+ * @param rising_threshold The value the input must reach to activate the debouncer.
+ * @param falling_threshold The value the input must fall below to deactivate the debouncer.
+ * @return The debounced state of the condition.
+ */
+template<uint8_t CONSECUTIVE_MATCHES>
+template<typename T>
+bool Debouncer<CONSECUTIVE_MATCHES>::update(T input, T rising_threshold, T falling_threshold) {
+  if (this->state) {
+    return this->update(input >= falling_threshold);
+  } else {
+    return this->update(input >= rising_threshold);
+  }
+}
+
+/**
+ * @brief Retrieves the debounced state without feeding a new sample.
+ *
+ * @return The debounced state of the condition.
+ */
+template<uint8_t CONSECUTIVE_MATCHES>
+bool Debouncer<CONSECUTIVE_MATCHES>::read() {
+  return this->state;
+}
+
+/**
+ * @brief Indicates whether the last sample activated the debouncer.
+ *
+ * @return True if the state changed from inactive to active, false otherwise.
+ */
+template<uint8_t CONSECUTIVE_MATCHES>
+bool Debouncer<CONSECUTIVE_MATCHES>::rose() {
+  return this->changed && this->state;
+}
+
+/**
+ * @brief Indicates whether the last sample deactivated the debouncer.
+ *
+ * @return True if the state changed from active to inactive, false otherwise.
+ */
+template<uint8_t CONSECUTIVE_MATCHES>
+bool Debouncer<CONSECUTIVE_MATCHES>::fell() {
+  return this->changed && !this->state;
+}
+
+#endif  // DEBOUNCER_H
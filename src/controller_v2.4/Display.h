@@ -7,6 +7,11 @@
  * extended set of commands for controlling LiquidCrystal_I2C displays. It abstracts
  * the lower-level I2C communication, offering an intuitive API for display operations.
  *
+ * All drawing methods only write into a frame buffer in memory. The flush() method
+ * compares it with a shadow buffer of what the display currently shows and transfers
+ * only the changed characters, a few at a time. This keeps the time spent on the I2C
+ * bus per call bounded, so other devices on the bus, like the gyroscope, are not held up.
+ *
  * @author Maximilian Kautzsch
  * @copyright Copyright (c) 2024 Maximilian Kautzsch
  * Licensed under MIT License.
@@ -20,10 +25,35 @@
 
 #define COLUMNS 16
 #define ROWS 2
+#define DISPLAY_CELLS (COLUMNS * ROWS)
+#define DISPLAY_FLUSH_BYTES 4
+#define DISPLAY_MAX_DIGITS 5
+#define DISPLAY_NO_CURSOR 0xFF
 
 LiquidCrystal_I2C lcd(0x27, COLUMNS, ROWS);
 
 struct Display {
+  char frame[ROWS][COLUMNS];  // Content that should be shown on the display.
+  char shown[ROWS][COLUMNS];  // Content that is currently shown on the display.
+  uint8_t flush_index;        // Cell at which the next flush continues the comparison.
+  uint8_t cursor_index;       // Cell the display writes the next character to.
+
+  /**
+   * @brief Initializes the display and both buffers.
+   *
+   * Starts the display and marks every cell as unknown, so the first flushes transfer the
+   * whole frame to the display.
+   */
+  void begin() {
+    lcd.init();
+    lcd.backlight();
+
+    memset(this->frame, ' ', sizeof(this->frame));
+    memset(this->shown, 0, sizeof(this->shown));
+    this->flush_index = 0;
+    this->cursor_index = DISPLAY_NO_CURSOR;
+  }
+
   /**
    * @brief Formats a number into a string with a fixed number of digits and optional sign.
    *
@@ -32,91 +62,145 @@ struct Display {
    * the number is constrained within the displayable range and pads the string with spaces
    * for alignment purposes. This is useful for creating uniform and aligned numerical displays.
    *
+   * @param buffer The buffer to store the string in, with room for max_digits + 2 characters.
    * @param num The number to format.
    * @param max_digits The maximum number of digits to display, excluding the sign.
    * @param show_sign If true, includes a '+' or '-' sign before the number.
-   * @return A string formatted to the specified width with the number and optional sign.
    */
-  String format(int16_t num, uint8_t max_digits, bool show_sign) {
+  void format(char *buffer, int16_t num, uint8_t max_digits, bool show_sign) {
     // Get the absolute value of the maximum and minimum number that
     // can be displayed according to max_digits
-    uint16_t limit = pow(10, max_digits) - 1;
+    int32_t limit = 1;
+    for (uint8_t i = 0; i < max_digits; i++) {
+      limit *= 10;
+    }
+    limit -= 1;
 
-    // Convert number into string and get the sign from the number
-    String str = String(abs(constrain(num, -limit, limit)));
-    String sign = (num > 0) ? "+" : (num < 0) ? "-"
-                                              : " ";
+    int32_t value = constrain(int32_t(num), -limit, limit);
+    uint32_t magnitude = abs(value);
+    int8_t i = max_digits + (show_sign ? 1 : 0);
+    buffer[i--] = '\0';
 
-    // Add leading spaces until the string length reaches max_digits
-    if (show_sign) {
-      str = sign + str;
-    }
-    while (str.length() < max_digits + (show_sign ? 1 : 0)) {
-      str = " " + str;
+    // Write the digits from right to left, followed by the sign
+    do {
+      buffer[i--] = '0' + magnitude % 10;
+      magnitude /= 10;
+    } while (magnitude && i >= 0);
+
+    if (show_sign && i >= 0) {
+      buffer[i--] = (value > 0) ? '+' : (value < 0) ? '-'
+                                                    : ' ';
     }
 
-    return str;
+    // Add leading spaces until the string length reaches max_digits
+    while (i >= 0) {
+      buffer[i--] = ' ';
+    }
   }
 
   /**
    * @brief Updates the display with a new number at the specified location.
    *
-   * Compares the last displayed number with the current number and updates the display
-   * only if there has been a change. This minimizes unnecessary writes to the display,
-   * which can be time-consuming. The function positions the cursor and prints the formatted
-   * number, ensuring that the display shows the most up-to-date value.
+   * Formats the number into the frame buffer. The display itself is only written by
+   * flush(), and only if the formatted number differs from what is already shown.
    *
-   * @param last_num The previously displayed number.
    * @param current_num The new number to display.
    * @param cursor_x The horizontal position on the display where the number will be shown.
    * @param cursor_y The vertical position on the display where the number will be shown.
    * @param max_digits The maximum number of digits the number should occupy.
    * @param show_sign Whether to show the sign ('+' or '-') of the number.
    */
-  void update(int16_t last_num, int16_t current_num, uint8_t cursor_x, uint8_t cursor_y, uint8_t max_digits, bool show_sign) {
-    if (last_num != current_num || current_num == 0) {
-      last_num = current_num;
-      lcd.setCursor(cursor_x, cursor_y);
-      lcd.print(format(current_num, max_digits, show_sign));
+  void update(int16_t current_num, uint8_t cursor_x, uint8_t cursor_y, uint8_t max_digits, bool show_sign) {
+    char buffer[DISPLAY_MAX_DIGITS + 2];
+
+    max_digits = constrain(max_digits, 1, DISPLAY_MAX_DIGITS);
+    format(buffer, current_num, max_digits, show_sign);
+    print(buffer, cursor_x, cursor_y, max_digits + (show_sign ? 1 : 0));
+  }
+
+  /**
+   * @brief Prints a text at the specified location, padded to a fixed width.
+   *
+   * The text is cut off or filled up with spaces until it occupies exactly the given width,
+   * so a shorter text fully overwrites a longer one that was printed before. Characters
+   * beyond the end of the row are discarded.
+   *
+   * @param text The text to display.
+   * @param cursor_x The horizontal position on the display where the text will be shown.
+   * @param cursor_y The vertical position on the display where the text will be shown.
+   * @param width The amount of characters the text should occupy, or 0 for its length.
+   */
+  void print(const char *text, uint8_t cursor_x, uint8_t cursor_y, uint8_t width = 0) {
+    if (cursor_y >= ROWS)
+      return;
+
+    if (!width) {
+      width = strlen(text);
+    }
+
+    for (uint8_t i = 0; i < width && cursor_x + i < COLUMNS; i++) {
+      this->frame[cursor_y][cursor_x + i] = *text ? *text++ : ' ';
+    }
+  }
+
+  /**
+   * @brief Transfers changed characters from the frame buffer to the display.
+   *
+   * Continues the comparison of both buffers where the last call stopped and writes at most
+   * the given amount of bytes to the display. Repositioning the cursor counts as one byte,
+   * so consecutive changed characters are cheaper than scattered ones. Meant to be called
+   * periodically, so a changed frame is shown after a few calls.
+   *
+   * @param max_bytes The maximum amount of bytes written to the display in this call.
+   * @return True if the display shows the complete frame, false otherwise.
+   */
+  bool flush(uint8_t max_bytes = DISPLAY_FLUSH_BYTES) {
+    uint8_t written_bytes = 0;
+
+    for (uint8_t i = 0; i < DISPLAY_CELLS && written_bytes < max_bytes; i++) {
+      uint8_t x = this->flush_index % COLUMNS;
+      uint8_t y = this->flush_index / COLUMNS;
+
+      if (this->frame[y][x] != this->shown[y][x]) {
+        if (this->cursor_index != this->flush_index) {
+          lcd.setCursor(x, y);
+          written_bytes++;
+        }
+        lcd.write(this->frame[y][x]);
+        written_bytes++;
+
+        this->shown[y][x] = this->frame[y][x];
+
+        // The display does not wrap from the end of a row to the start of the next one.
+        this->cursor_index = (x < COLUMNS - 1) ? this->flush_index + 1 : DISPLAY_NO_CURSOR;
+      }
+
+      this->flush_index = (this->flush_index + 1) % DISPLAY_CELLS;
     }
+
+    return memcmp(this->frame, this->shown, sizeof(this->frame)) == 0;
   }
 
   /**
    * @brief Clears the entire display.
    *
-   * Iterates over every position on the display and writes a space character to it,
-   * effectively clearing the screen. This method is typically used before writing new
-   * content to ensure the display is blank.
+   * Fills the frame buffer with spaces. Only the characters that are not blank yet are
+   * transferred to the display afterwards.
    */
   void clear() {
-    for (uint8_t i = 0; i < ROWS; i++) {
-      for (uint8_t j = 0; j < COLUMNS; j++) {
-        lcd.setCursor(j, i);
-        lcd.print(" ");
-      }
-    }
+    memset(this->frame, ' ', sizeof(this->frame));
   }
 
   /**
-   * @brief Displays a bootup message with a progress bar animation.
+   * @brief Displays a bootup message.
    *
-   * Writes an "INITIALIZING" message on the display and creates a visual progress bar
-   * that fills up over time. This provides a visual indication that the system is starting
-   * up and can be used to enhance the user experience during the bootup sequence.
+   * Writes an "INITIALIZING" message into the frame buffer and leaves the second row to the
+   * status of the devices. Like every other drawing method, it does not wait for the display,
+   * so the startup is not held up by the transfer.
    */
   void bootup() {
-    lcd.setCursor(2, 0);
-    lcd.print("INITIALIZING");
-
-    // Progress bar animation
-    lcd.setCursor(2, 1);
-    lcd.print("[----------]");
-    delay(100);
-    for (uint8_t i = 3; i < 13; i++) {
-      lcd.setCursor(i, 1);
-      lcd.print("=");
-      delay(100);
-    }
+    clear();
+    print("INITIALIZING", 2, 0);
   }
 
   /**
@@ -124,14 +208,15 @@ struct Display {
    *
    * Prints a set of predefined labels at specific locations on the display. These labels
    * serve as static elements of the user interface, providing context for dynamic data
-   * that will be displayed. The labels are printed only once to avoid unnecessary updates.
+   * that will be displayed. The labels are printed only once per layout to avoid unnecessary
+   * updates, and again whenever a different layout is requested.
    *
    * @param layout_id The configuration identifier that determines the label layout.
    */
   void preset(uint8_t layout_id) {
-    static bool preset_printed;
+    static int16_t printed_layout_id = -1;
 
-    if (!preset_printed) {
+    if (printed_layout_id != layout_id) {
       // Clear the display to prepare for label printing.
       clear();
 
@@ -139,56 +224,51 @@ struct Display {
       switch (layout_id) {
         case 0:
           {
-            lcd.setCursor(0, 0);
-            lcd.print("L");
-            lcd.setCursor(4, 0);
-            lcd.print("M");
-            lcd.setCursor(8, 0);
-            lcd.print("R");
-            lcd.setCursor(0, 1);
-            lcd.print("X");
-            lcd.setCursor(5, 1);
-            lcd.print("Y");
-            lcd.setCursor(10, 1);
-            lcd.print("C");
-            lcd.setCursor(13, 1);
-            lcd.print("V");
+            print("L", 0, 0);
+            print("M", 4, 0);
+            print("R", 8, 0);
+            print("X", 0, 1);
+            print("Y", 5, 1);
+            print("C", 10, 1);
+            print("V", 13, 1);
           }
           break;
         case 1:
           {
-            lcd.setCursor(0, 0);
-            lcd.print("L");
-            lcd.setCursor(5, 0);
-            lcd.print("M");
-            lcd.setCursor(10, 0);
-            lcd.print("R");
-            lcd.setCursor(0, 1);
-            lcd.print("G");
-            lcd.setCursor(10, 1);
-            lcd.print("V");
+            print("L", 0, 0);
+            print("M", 5, 0);
+            print("R", 10, 0);
+            print("G", 0, 1);
+            print("V", 10, 1);
           }
           break;
         case 2:
           {
-            lcd.setCursor(0, 0);
-            lcd.print("L");
-            lcd.setCursor(5, 0);
-            lcd.print("M");
-            lcd.setCursor(10, 0);
-            lcd.print("R");
-            lcd.setCursor(0, 1);
-            lcd.print("G");
-            lcd.setCursor(5, 1);
-            lcd.print("X");
-            lcd.setCursor(10, 1);
-            lcd.print("Y");
+            print("L", 0, 0);
+            print("M", 5, 0);
+            print("R", 10, 0);
+            print("G", 0, 1);
+            print("X", 5, 1);
+            print("Y", 10, 1);
+          }
+          break;
+        case 3:
+          {
+            print("A", 0, 1);
+            print("M", 6, 1);
+            print("us", 12, 1);
+          }
+          break;
+        case 4:
+          {
+            print("V", 0, 1);
+            print("MAX", 7, 1);
           }
           break;
       }
 
       // Mark the preset as printed to prevent future executions.
-      preset_printed = true;
+      printed_layout_id = layout_id;
     }
   }
 
@@ -201,25 +281,24 @@ struct Display {
    */
   void shutdown() {
     clear();
-    lcd.setCursor(6, 0);
-    lcd.print("RACE");
-    lcd.setCursor(4, 1);
-    lcd.print("FINISHED");
+    print("RACE", 6, 0);
+    print("FINISHED", 4, 1);
+    while (!flush()) {}
     delay(1000);
     clear();
 
     // Countdown for power saving mode
-    lcd.setCursor(3, 0);
-    lcd.print("POWER SAVING");
-    lcd.setCursor(3, 1);
-    lcd.print("MODE IN 3.");
+    print("POWER SAVING", 3, 0);
+    print("MODE IN 3.", 3, 1);
+    while (!flush()) {}
     for (uint8_t i = 2; i > 0; i--) {
       delay(500);
-      lcd.setCursor(11, 1);
-      lcd.print(i);
+      char digit[] = { char('0' + i), '\0' };
+      print(digit, 11, 1);
+      while (!flush()) {}
     }
     delay(500);
   }
 };
 
-#endif  // DISPLAY_H
\ No newline at end of file
+#endif  // DISPLAY_H
@@ -0,0 +1,241 @@
+/**
+ * @file Fixed.h
+ * @brief Header file for the Fixed template class, implementing Q-format fixed-point numbers.
+ *
+ * The Fixed class template stores a real number as an integer scaled by 2^FRAC_BITS, so
+ * arithmetic on it compiles to integer instructions of a constant cost. Products are formed in
+ * a 64-bit intermediate and scaled back, quotients are formed by scaling the dividend first,
+ * both truncating towards zero.
+ * Arithmetic with plain integers scales the integer rather than converting it, so
+ * Q * n and Q / n cost a single multiplication or division.
+ *
+ * Values are constructed from integers or from floating-point literals. All constructors are
+ * constexpr, so a constant such as `constexpr Fixed<16> CM_PER_MICROSECOND = 1 / 29.1;` is
+ * converted by the compiler and no floating-point instruction is left in the program. Values
+ * are converted back by truncating towards zero like a cast, by rounding to the nearest
+ * integer, or into a float for printing.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <inttypes.h>
+#include <type_traits>
+
+template<uint8_t FRAC_BITS, typename T = int32_t>
+class Fixed {
+  static_assert(std::is_integral<T>::value && std::is_signed<T>::value, "A Fixed is stored in a signed integer.");
+  static_assert(FRAC_BITS < sizeof(T) * 8 - 1, "A Fixed needs at least one integer bit besides its sign.");
+
+public:
+  static constexpr T ONE = T(1) << FRAC_BITS;
+
+  constexpr Fixed();
+  constexpr Fixed(int value);
+  constexpr Fixed(double value);
+  static constexpr Fixed fromRaw(T raw);
+
+  constexpr T toRaw() const;
+  constexpr T toInt() const;
+  constexpr T round() const;
+  constexpr float toFloat() const;
+
+  constexpr Fixed operator-() const;
+  constexpr Fixed operator+(Fixed other) const;
+  constexpr Fixed operator-(Fixed other) const;
+  constexpr Fixed operator*(Fixed other) const;
+  constexpr Fixed operator/(Fixed other) const;
+  template<typename I, typename std::enable_if<std::is_integral<I>::value, int>::type = 0>
+  constexpr Fixed operator*(I factor) const;
+  template<typename I, typename std::enable_if<std::is_integral<I>::value, int>::type = 0>
+  constexpr Fixed operator/(I divisor) const;
+  Fixed &operator+=(Fixed other);
+  Fixed &operator-=(Fixed other);
+
+  constexpr bool operator==(Fixed other) const;
+  constexpr bool operator!=(Fixed other) const;
+  constexpr bool operator<(Fixed other) const;
+  constexpr bool operator<=(Fixed other) const;
+  constexpr bool operator>(Fixed other) const;
+  constexpr bool operator>=(Fixed other) const;
+
+private:
+  T raw;
+};
+
+/**
+ * @brief Constructs a Fixed object holding zero.
+ */
+template<uint8_t FRAC_BITS, typename T>
+constexpr Fixed<FRAC_BITS, T>::Fixed()
+  : raw(0) {}
+
+/**
+ * @brief Constructs a Fixed object from an integer.
+ *
+ * @param value The integer, which has to fit into the integer bits of the format.
+ */
+template<uint8_t FRAC_BITS, typename T>
+constexpr Fixed<FRAC_BITS, T>::Fixed(int value)
+  : raw(T(value) * ONE) {}
+
+/**
+ * @brief Constructs a Fixed object from a floating-point number, rounded to the nearest step.
+ *
+ * Meant for constants, which the compiler converts when they are constexpr or literals.
+ *
+ * @param value The number, which has to fit into the integer bits of the format.
+ */
+template<uint8_t FRAC_BITS, typename T>
+constexpr Fixed<FRAC_BITS, T>::Fixed(double value)
+  : raw(T(value * ONE + (value < 0 ? -0.5 : 0.5))) {}
+
+/**
+ * @brief Constructs a Fixed object from its scaled integer.
+ *
+ * @param raw The number multiplied by 2^FRAC_BITS.
+ * @return The Fixed object.
+ */
+template<uint8_t FRAC_BITS, typename T>
+constexpr Fixed<FRAC_BITS, T> Fixed<FRAC_BITS, T>::fromRaw(T raw) {
+  Fixed result;
+  result.raw = raw;
+  return result;
+}
+
+/**
+ * @brief Reads the scaled integer.
+ *
+ * @return The number multiplied by 2^FRAC_BITS.
+ */
+template<uint8_t FRAC_BITS, typename T>
+constexpr T Fixed<FRAC_BITS, T>::toRaw() const {
+  return this->raw;
+}
+
+/**
+ * @brief Converts the number into an integer, truncating towards zero like a cast.
+ *
+ * @return The integer part of the number.
+ */
+template<uint8_t FRAC_BITS, typename T>
+constexpr T Fixed<FRAC_BITS, T>::toInt() const {
+  return this->raw / ONE;
+}
+
+/**
+ * @brief Converts the number into the nearest integer, rounding halves away from zero.
+ *
+ * @return The rounded number.
+ */
+template<uint8_t FRAC_BITS, typename T>
+constexpr T Fixed<FRAC_BITS, T>::round() const {
+  return (this->raw + (this->raw < 0 ? -ONE / 2 : ONE / 2)) / ONE;
+}
+
+/**
+ * @brief Converts the number into a float, meant for printing and debugging.
+ *
+ * @return The number as a float.
+ */
+template<uint8_t FRAC_BITS, typename T>
+constexpr float Fixed<FRAC_BITS, T>::toFloat() const {
+  return float(this->raw) / ONE;
+}
+
+template<uint8_t FRAC_BITS, typename T>
+constexpr Fixed<FRAC_BITS, T> Fixed<FRAC_BITS, T>::operator-() const {
+  return fromRaw(-this->raw);
+}
+
+template<uint8_t FRAC_BITS, typename T>
+constexpr Fixed<FRAC_BITS, T> Fixed<FRAC_BITS, T>::operator+(Fixed other) const {
+  return fromRaw(this->raw + other.raw);
+}
+
+template<uint8_t FRAC_BITS, typename T>
+constexpr Fixed<FRAC_BITS, T> Fixed<FRAC_BITS, T>::operator-(Fixed other) const {
+  return fromRaw(this->raw - other.raw);
+}
+
+/**
+ * @brief Multiplies two numbers in a 64-bit intermediate, truncating the product.
+ */
+template<uint8_t FRAC_BITS, typename T>
+constexpr Fixed<FRAC_BITS, T> Fixed<FRAC_BITS, T>::operator*(Fixed other) const {
+  return fromRaw(T(int64_t(this->raw) * other.raw / ONE));
+}
+
+/**
+ * @brief Divides two numbers in a 64-bit intermediate, truncating the quotient.
+ */
+template<uint8_t FRAC_BITS, typename T>
+constexpr Fixed<FRAC_BITS, T> Fixed<FRAC_BITS, T>::operator/(Fixed other) const {
+  return fromRaw(T(int64_t(this->raw) * ONE / other.raw));
+}
+
+/**
+ * @brief Multiplies the number with an integer, without converting the integer.
+ */
+template<uint8_t FRAC_BITS, typename T>
+template<typename I, typename std::enable_if<std::is_integral<I>::value, int>::type>
+constexpr Fixed<FRAC_BITS, T> Fixed<FRAC_BITS, T>::operator*(I factor) const {
+  return fromRaw(T(this->raw * T(factor)));
+}
+
+/**
+ * @brief Divides the number by an integer, without converting the integer.
+ */
+template<uint8_t FRAC_BITS, typename T>
+template<typename I, typename std::enable_if<std::is_integral<I>::value, int>::type>
+constexpr Fixed<FRAC_BITS, T> Fixed<FRAC_BITS, T>::operator/(I divisor) const {
+  return fromRaw(T(this->raw / T(divisor)));
+}
+
+template<uint8_t FRAC_BITS, typename T>
+Fixed<FRAC_BITS, T> &Fixed<FRAC_BITS, T>::operator+=(Fixed other) {
+  this->raw += other.raw;
+  return *this;
+}
+
+template<uint8_t FRAC_BITS, typename T>
+Fixed<FRAC_BITS, T> &Fixed<FRAC_BITS, T>::operator-=(Fixed other) {
+  this->raw -= other.raw;
+  return *this;
+}
+
+template<uint8_t FRAC_BITS, typename T>
+constexpr bool Fixed<FRAC_BITS, T>::operator==(Fixed other) const {
+  return this->raw == other.raw;
+}
+
+template<uint8_t FRAC_BITS, typename T>
+constexpr bool Fixed<FRAC_BITS, T>::operator!=(Fixed other) const {
+  return this->raw != other.raw;
+}
+
+template<uint8_t FRAC_BITS, typename T>
+constexpr bool Fixed<FRAC_BITS, T>::operator<(Fixed other) const {
+  return this->raw < other.raw;
+}
+
+template<uint8_t FRAC_BITS, typename T>
+constexpr bool Fixed<FRAC_BITS, T>::operator<=(Fixed other) const {
+  return this->raw <= other.raw;
+}
+
+template<uint8_t FRAC_BITS, typename T>
+constexpr bool Fixed<FRAC_BITS, T>::operator>(Fixed other) const {
+  return this->raw > other.raw;
+}
+
+template<uint8_t FRAC_BITS, typename T>
+constexpr bool Fixed<FRAC_BITS, T>::operator>=(Fixed other) const {
+  return this->raw >= other.raw;
+}
+
+#endif  // FIXED_H
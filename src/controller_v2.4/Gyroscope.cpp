@@ -0,0 +1,344 @@
+/**
+ * @file Gyroscope.cpp
+ * @brief Implementation of the Gyroscope class.
+ */
+
+#include "Gyroscope.h"
+
+/**
+ * @brief Constructs a Gyroscope object with unity scale.
+ */
+Gyroscope::Gyroscope()
+  : enabled(false), calibrated(false), calibration_samples(0), calibrated_samples(0),
+    calibration_sum(0), bias(0), scale(GYRO_SCALE_UNITY), integrated_rate(0),
+    angular_velocity(0), temperature(0), overflows(0), sample_micros(0) {}
+
+/**
+ * @brief Destructs the Gyroscope object.
+ */
+Gyroscope::~Gyroscope() {}
+
+/**
+ * @brief Initializes the MPU6050 sensor and starts sampling into its FIFO buffer.
+ *
+ * Wakes the sensor up with the gyroscope as clock source, enables the digital low-pass
+ * filter at a sample rate of 1 kHz and a range of 500 degrees per second, and lets only the
+ * yaw rate be written to the FIFO buffer. A bias calibration is started right away.
+ *
+ * @return True if the sensor has been found and configured, false otherwise.
+ */
+bool Gyroscope::begin() {
+  Wire.begin();
+
+  uint8_t who_am_i = 0;
+  if (!this->readRegisters(MPU6050_WHO_AM_I, &who_am_i, 1) || who_am_i != MPU6050_ADDRESS)
+    return false;
+
+  bool configured = this->writeRegister(MPU6050_PWR_MGMT_1, 0x01)
+                    && this->writeRegister(MPU6050_SMPLRT_DIV, 1000 / GYRO_SAMPLE_RATE - 1)
+                    && this->writeRegister(MPU6050_CONFIG, 0x03)
+                    && this->writeRegister(MPU6050_GYRO_CONFIG, 0x08)
+                    && this->writeRegister(MPU6050_FIFO_EN, 0x10);
+  if (!configured)
+    return false;
+
+  this->resetFifo();
+  this->enabled = true;
+  this->calibrate();
+
+  return true;
+}
+
+/**
+ * @brief Stops reading the sensor.
+ *
+ * The last estimate of the yaw angle is kept.
+ */
+void Gyroscope::end() {
+  this->writeRegister(MPU6050_FIFO_EN, 0x00);
+  this->enabled = false;
+}
+
+/**
+ * @brief Reads all new samples from the FIFO buffer and integrates them.
+ *
+ * Reads the buffer in bursts of GYRO_BURST_SIZE bytes, but no more than GYRO_MAX_BURSTS per
+ * call, so the time spent on the I2C bus stays bounded. Remaining samples are read on the
+ * next call. The angular velocity is the mean of the samples read in this call. If the
+ * buffer has overflowed, it is cleared and the overflow is counted.
+ */
+void Gyroscope::update() {
+  if (!this->enabled)
+    return;
+
+  uint8_t data[GYRO_BURST_SIZE];
+  if (!this->readRegisters(MPU6050_FIFO_COUNT_H, data, 2))
+    return;
+
+  uint16_t fifo_count = uint16_t(data[0]) << 8 | data[1];
+  if (fifo_count >= 1024) {
+    this->overflows++;
+    this->resetFifo();
+    return;
+  }
+
+  // Only read complete samples of two bytes each.
+  uint16_t remaining = min(uint16_t(fifo_count & ~1), uint16_t(GYRO_BURST_SIZE * GYRO_MAX_BURSTS));
+  int32_t rate_sum = 0;
+  uint8_t num_samples = 0;
+
+  while (remaining) {
+    uint8_t length = min(remaining, uint16_t(GYRO_BURST_SIZE));
+    if (!this->readRegisters(MPU6050_FIFO_R_W, data, length))
+      break;
+
+    for (uint8_t i = 0; i < length; i += 2) {
+      int16_t raw_rate = int16_t(uint16_t(data[i]) << 8 | data[i + 1]);
+      this->integrate(raw_rate);
+      rate_sum += raw_rate;
+      num_samples++;
+    }
+    remaining -= length;
+  }
+
+  if (num_samples)
+    this->sample_micros = micros();
+
+  if (num_samples && this->calibrated) {
+    int64_t mean_rate = (int64_t(rate_sum) << 8) / num_samples - this->bias;
+    this->angular_velocity = mean_rate * 1000 * this->scale / (int64_t(GYRO_LSB_PER_DPS_X10) * 256 * GYRO_SCALE_UNITY);
+  }
+}
+
+/**
+ * @brief Starts a calibration of the bias of the sensor.
+ *
+ * The following samples are averaged to measure the bias instead of being integrated, so the
+ * robot has to stand still until isCalibrated() returns true. The yaw angle is reset to 0
+ * once the calibration is complete.
+ *
+ * @param samples The amount of samples to average, at 1 kHz.
+ */
+void Gyroscope::calibrate(uint16_t samples) {
+  this->calibration_samples = max(samples, uint16_t(1));
+  this->calibrated_samples = 0;
+  this->calibration_sum = 0;
+  this->calibrated = false;
+}
+
+/**
+ * @brief Indicates whether the bias calibration is complete.
+ *
+ * @return True if the yaw angle is being integrated, false while calibrating.
+ */
+bool Gyroscope::isCalibrated() {
+  return this->calibrated;
+}
+
+/**
+ * @brief Sets the bias of the sensor from a previous calibration.
+ *
+ * Cancels a running calibration, so the yaw angle is integrated right away, and resets the
+ * yaw angle to 0.
+ *
+ * @param bias The bias in raw units of the sensor, with 8 fractional bits.
+ */
+void Gyroscope::setBias(int32_t bias) {
+  this->bias = bias;
+  this->angular_velocity = 0;
+  this->calibrated = true;
+  this->resetAngle();
+}
+
+/**
+ * @brief Retrieves the bias of the sensor.
+ *
+ * @return The bias in raw units of the sensor, with 8 fractional bits.
+ */
+int32_t Gyroscope::getBias() {
+  return this->bias;
+}
+
+/**
+ * @brief Sets the scale correction of the sensor.
+ *
+ * Compensates the gain error of the sensor, which can only be measured by turning the robot
+ * by a known angle and not at startup.
+ *
+ * @param scale The correction in thousandths, 1000 meaning no correction.
+ */
+void Gyroscope::setScale(uint16_t scale) {
+  this->scale = scale;
+}
+
+/**
+ * @brief Sets the current yaw angle as the new zero.
+ */
+void Gyroscope::resetAngle() {
+  this->integrated_rate = 0;
+}
+
+/**
+ * @brief Reads the integrated yaw angle.
+ *
+ * @return The yaw angle in hundredths of a degree, positive anticlockwise.
+ */
+int32_t Gyroscope::readAngle() {
+  return this->integrated_rate * 1000 * this->scale
+         / (int64_t(GYRO_LSB_PER_DPS_X10) * 256 * GYRO_SAMPLE_RATE * GYRO_SCALE_UNITY);
+}
+
+/**
+ * @brief Reads the angular velocity around the vertical axis.
+ *
+ * @return The angular velocity in hundredths of a degree per second, positive anticlockwise.
+ */
+int32_t Gyroscope::readAngularVelocity() {
+  return this->angular_velocity;
+}
+
+/**
+ * @brief Predicts the yaw angle after a given time at the current angular velocity.
+ *
+ * Useful to end a turn early enough to compensate the delay of the steering.
+ *
+ * @param lead_time The time to predict ahead in milliseconds.
+ * @return The predicted yaw angle in hundredths of a degree.
+ */
+int32_t Gyroscope::predictAngle(uint16_t lead_time) {
+  return this->readAngle() + this->angular_velocity * lead_time / 1000;
+}
+
+/**
+ * @brief Reads the yaw angle rounded to full degrees.
+ *
+ * @return The current yaw angle in degrees as an int16_t value.
+ */
+int16_t Gyroscope::readYawAngle() {
+  int32_t angle = this->readAngle();
+  return (angle + (angle >= 0 ? 50 : -50)) / 100;
+}
+
+/**
+ * @brief Reads the temperature sensor of the die over I2C.
+ *
+ * The temperature is not part of the FIFO buffer, so it takes a transfer of its own and is
+ * meant to be measured at a low rate. The die runs a few degrees warmer than the air around
+ * the sensor.
+ *
+ * @return True if the temperature has been read, false otherwise.
+ */
+bool Gyroscope::measureTemperature() {
+  if (!this->enabled)
+    return false;
+
+  uint8_t data[2];
+  if (!this->readRegisters(MPU6050_TEMP_OUT_H, data, 2))
+    return false;
+
+  // 340 LSB per degree with an offset of 36.53 deg C, scaled to tenths of a degree.
+  int16_t raw_temperature = int16_t(uint16_t(data[0]) << 8 | data[1]);
+  this->temperature = (int32_t(raw_temperature) + 12420) / 34;
+  return true;
+}
+
+/**
+ * @brief Reads the last measured temperature of the die.
+ *
+ * @return The temperature in tenths of a degree Celsius, 0 before the first measurement.
+ */
+int16_t Gyroscope::readTemperature() {
+  return this->temperature;
+}
+
+/**
+ * @brief Retrieves the amount of overflows of the FIFO buffer.
+ *
+ * Every overflow loses up to half a second of samples, so the angle is no longer accurate.
+ *
+ * @return The amount of overflows since startup.
+ */
+uint16_t Gyroscope::getOverflows() {
+  return this->overflows;
+}
+
+/**
+ * @brief Retrieves the time at which the latest samples have been read from the FIFO buffer.
+ *
+ * The newest sample was taken at most one sample period before this time.
+ *
+ * @return The time of the last read with new samples in microseconds.
+ */
+unsigned long Gyroscope::readTimestamp() {
+  return this->sample_micros;
+}
+
+/**
+ * @brief Processes a single sample of the yaw rate.
+ *
+ * During the calibration, the sample is added to the bias. Afterwards, the bias is
+ * subtracted and the sample is integrated with 8 fractional bits.
+ *
+ * @param raw_rate The raw yaw rate as read from the sensor.
+ */
+void Gyroscope::integrate(int16_t raw_rate) {
+  if (!this->calibrated) {
+    this->calibration_sum += raw_rate;
+
+    if (++this->calibrated_samples >= this->calibration_samples) {
+      this->bias = (int64_t(this->calibration_sum) << 8) / this->calibrated_samples;
+      this->integrated_rate = 0;
+      this->angular_velocity = 0;
+      this->calibrated = true;
+    }
+    return;
+  }
+
+  this->integrated_rate += (int32_t(raw_rate) << 8) - this->bias;
+}
+
+/**
+ * @brief Writes a single register of the sensor.
+ *
+ * @param reg The address of the register.
+ * @param value The value to write.
+ * @return True if the sensor acknowledged the transfer, false otherwise.
+ */
+bool Gyroscope::writeRegister(uint8_t reg, uint8_t value) {
+  Wire.beginTransmission(MPU6050_ADDRESS);
+  Wire.write(reg);
+  Wire.write(value);
+  return Wire.endTransmission() == 0;
+}
+
+/**
+ * @brief Reads consecutive registers of the sensor in a single burst.
+ *
+ * @param reg The address of the first register.
+ * @param data The buffer to store the values in.
+ * @param length The amount of registers to read.
+ * @return True if all values have been received, false otherwise.
+ */
+bool Gyroscope::readRegisters(uint8_t reg, uint8_t *data, uint8_t length) {
+  Wire.beginTransmission(MPU6050_ADDRESS);
+  Wire.write(reg);
+  if (Wire.endTransmission(false) != 0)
+    return false;
+
+  if (Wire.requestFrom(uint8_t(MPU6050_ADDRESS), size_t(length)) != length)
+    return false;
+
+  for (uint8_t i = 0; i < length; i++) {
+    data[i] = Wire.read();
+  }
+
+  return true;
+}
+
+/**
+ * @brief Clears the FIFO buffer and enables it again.
+ */
+void Gyroscope::resetFifo() {
+  this->writeRegister(MPU6050_USER_CTRL, 0x04);
+  this->writeRegister(MPU6050_USER_CTRL, 0x40);
+}
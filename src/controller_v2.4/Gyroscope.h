@@ -1,60 +1,98 @@
 /**
  * @file Gyroscope.h
- * @brief Header file for the Gyroscope structure, interfacing with the MPU6050 sensor.
+ * @brief Header file for the Gyroscope class, estimating the yaw angle with the MPU6050 sensor.
  *
- * The Gyroscope structure encapsulates the functionality required to interact with the MPU6050 sensor.
- * It provides methods to initialize the sensor and read the yaw angle. The structure is designed to simplify
- * the process of integrating the MPU6050 gyroscope into robotics and automation projects, offering a high-level
- * interface for orientation detection and stabilization tasks.
+ * The Gyroscope class encapsulates the functionality required to interact with the MPU6050 sensor.
+ * It configures the sensor to sample the yaw rate at its native rate of 1 kHz into its FIFO buffer
+ * and reads the buffer in bursts over I2C. Every sample is integrated, so the yaw angle is resolved
+ * far more finely than the rate at which it is read. The bias of the sensor is calibrated at startup
+ * while the robot stands still or restored from a previous calibration, and a scale correction
+ * compensates the gain error of the sensor.
+ * Angles and angular velocities are provided as fixed-point values in hundredths of a degree.
+ * The temperature of the die of the sensor can be measured on demand, in tenths of a degree.
+ *
+ * The buffer is read from the main loop rather than from a timer interrupt. Wire waits for the
+ * interrupts of the I2C peripheral to complete a transfer, so a transfer started from an
+ * interrupt of the same or a higher priority never completes. The FIFO buffer holds the
+ * samples meanwhile, so no sample is lost while the loop is busy.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
  */
 
 #ifndef GYROSCOPE_H
 #define GYROSCOPE_H
 
-#include <sys/_stdint.h>
+#include <inttypes.h>
 #include <Wire.h>
-#include <MPU6050_light.h>
 
-// Create an instance of the MPU6050 sensor.
-MPU6050 mpu(Wire);
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
 
-/**
- * @struct Gyroscope
- * @brief Structure to manage the MPU6050 gyroscope sensor.
- *
- * The Gyroscope structure provides methods to initialize the MPU6050 sensor and read its yaw angle.
- * It handles the setup and configuration of the sensor and offers a simple interface for obtaining
- * orientation data.
- */
-struct Gyroscope {
-  /**
-   * @brief Initializes the MPU6050 sensor and configures its settings.
-   *
-   * Sets up the MPU6050 sensor for operation by initializing the I2C communication and configuring
-   * the sensor's filter coefficient for gyroscopic measurements. This method ensures the sensor
-   * is ready to provide accurate orientation data.
-   */
-  void begin() {
-    Wire.begin();
-
-    bool status = mpu.begin();
-    while (status != 0) {}
-    mpu.setFilterGyroCoef(1.00);
-  }
-
-  /**
-   * @brief Reads the current yaw angle from the MPU6050 sensor.
-   *
-   * Updates the sensor data and retrieves the yaw angle, which represents the rotation around
-   * the vertical axis. This method provides real-time orientation information that can be used
-   * for navigation and stabilization purposes.
-   *
-   * @return The current yaw angle in degrees as an int16_t value.
-   */
-  int16_t readYawAngle() {
-    mpu.update();
-    return mpu.getAngleZ();
-  }
+#define MPU6050_ADDRESS 0x68
+#define MPU6050_SMPLRT_DIV 0x19
+#define MPU6050_CONFIG 0x1A
+#define MPU6050_GYRO_CONFIG 0x1B
+#define MPU6050_FIFO_EN 0x23
+#define MPU6050_TEMP_OUT_H 0x41
+#define MPU6050_USER_CTRL 0x6A
+#define MPU6050_PWR_MGMT_1 0x6B
+#define MPU6050_FIFO_COUNT_H 0x72
+#define MPU6050_FIFO_R_W 0x74
+#define MPU6050_WHO_AM_I 0x75
+
+#define GYRO_SAMPLE_RATE 1000
+#define GYRO_LSB_PER_DPS_X10 655
+#define GYRO_BURST_SIZE 32
+#define GYRO_MAX_BURSTS 4
+#define GYRO_CALIBRATION_SAMPLES 1000
+#define GYRO_SCALE_UNITY 1000
+
+class Gyroscope {
+public:
+  Gyroscope();
+  ~Gyroscope();
+
+  bool begin();
+  void end();
+  void update();
+  void calibrate(uint16_t samples = GYRO_CALIBRATION_SAMPLES);
+  bool isCalibrated();
+  void setBias(int32_t bias);
+  int32_t getBias();
+  void setScale(uint16_t scale);
+  void resetAngle();
+  int32_t readAngle();
+  int32_t readAngularVelocity();
+  int32_t predictAngle(uint16_t lead_time);
+  int16_t readYawAngle();
+  bool measureTemperature();
+  int16_t readTemperature();
+  uint16_t getOverflows();
+  unsigned long readTimestamp();
+
+private:
+  void integrate(int16_t raw_rate);
+  bool writeRegister(uint8_t reg, uint8_t value);
+  bool readRegisters(uint8_t reg, uint8_t *data, uint8_t length);
+  void resetFifo();
+
+  bool enabled;
+  bool calibrated;
+  uint16_t calibration_samples;
+  uint16_t calibrated_samples;
+  int32_t calibration_sum;
+  int32_t bias;
+  uint16_t scale;
+  int64_t integrated_rate;
+  int32_t angular_velocity;
+  int16_t temperature;
+  uint16_t overflows;
+  unsigned long sample_micros;
 };
 
-#endif  // GYROSCOPE_H
\ No newline at end of file
+#endif  // GYROSCOPE_H
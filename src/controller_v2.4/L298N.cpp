@@ -16,7 +16,10 @@
  * @param backward_pin The pin number assigned to control the backward motion of the motor.
  */
 L298N::L298N(pin_size_t forward_pin, pin_size_t backward_pin)
-  : forwardPwm(forward_pin), backwardPwm(backward_pin) {}
+  : forwardPwm(forward_pin), backwardPwm(backward_pin), enabled(false), timer_running(false),
+    run_timer_locked(false), is_updating(false), setpoint_speed(0), profile_speed(0), voltage_scale(256),
+    last_duty(0), acceleration(MOTOR_DEFAULT_ACCELERATION), deceleration(MOTOR_DEFAULT_DECELERATION),
+    nominal_voltage(0), last_micros(0), run_millis(0) {}
 
 /**
  * @brief Destructor for the L298N class.
@@ -30,69 +33,69 @@ L298N::~L298N() {}
  * @brief Initializes the motor driver for operation.
  *
  * Sets up the PWM frequency for both forward and backward control pins and enables the motor
- * driver for use. The acceleration is set to a default value, and the motor driver is marked
- * as enabled.
+ * driver for use. The acceleration and deceleration are set to default values, and a free
+ * timer is started to advance the speed profile at MOTOR_PROFILE_RATE. If no timer is
+ * available, the profile is advanced by write() instead.
  */
 void L298N::begin() {
-  this->acceleration = 100;
-  forwardPwm.begin(float(33000.00), 0.00);
-  backwardPwm.begin(float(33000.00), 0.00);
+  this->acceleration = MOTOR_DEFAULT_ACCELERATION;
+  this->deceleration = MOTOR_DEFAULT_DECELERATION;
+  this->setpoint_speed = 0;
+  this->profile_speed = 0;
+  this->last_duty = 0;
+  forwardPwm.begin(uint32_t(MOTOR_PWM_PERIOD_COUNTS), uint32_t(0), true);
+  backwardPwm.begin(uint32_t(MOTOR_PWM_PERIOD_COUNTS), uint32_t(0), true);
   this->enabled = true;
+
+  uint8_t timer_type;
+  int8_t timer_channel = FspTimer::get_available_timer(timer_type);
+  this->timer_running = timer_channel >= 0
+                        && this->profileTimer.begin(TIMER_MODE_PERIODIC, timer_type, timer_channel,
+                                                    float(MOTOR_PROFILE_RATE), 0.0f, L298N::onTimer, this)
+                        && this->profileTimer.setup_overflow_irq()
+                        && this->profileTimer.open()
+                        && this->profileTimer.start();
 }
 
 /**
  * @brief Disables the motor driver.
  *
- * Ends the PWM signals on both control pins, effectively stopping the motor and marking the
- * driver as disabled. This method should be called when the motor is no longer needed to
- * ensure it does not continue to run.
+ * Stops the profile timer and ends the PWM signals on both control pins, effectively stopping
+ * the motor and marking the driver as disabled. This method should be called when the motor
+ * is no longer needed to ensure it does not continue to run.
  */
 void L298N::end() {
+  if (this->timer_running) {
+    this->profileTimer.stop();
+    this->profileTimer.end();
+    this->timer_running = false;
+  }
   forwardPwm.end();
   backwardPwm.end();
   this->enabled = false;
 }
 
 /**
- * @brief Sets the motor speed to a specified value.
+ * @brief Sets the target speed of the motor.
  *
- * Updates the motor's speed based on the desired input speed, ranging from -100 to 100. The
- * speed is adjusted gradually based on the set acceleration to provide a smooth transition.
- * Negative values reverse the motor's direction, while positive values move it forward.
+ * The speed ramps towards the target speed, ranging from -100 to 100, at the configured
+ * acceleration and deceleration. Negative values reverse the motor's direction, while
+ * positive values move it forward. The call returns right away, the profile is advanced by
+ * the timer.
  *
  * @param speed The target speed for the motor, where -100 is full reverse, 0 is stopped, and
  * 100 is full forward.
  */
-void L298N::write(float speed) {
+void L298N::write(int16_t speed) {
   if (!this->enabled)
     return;
 
-  static unsigned long last_micros;
-  uint16_t updating_interval = map(this->acceleration, 0, 100, MIN_UPDATING_INTERVAL, MAX_UPDATING_INTERVAL);
   this->setpoint_speed = constrain(speed, -100, 100);
 
-  // Adjust the current speed to the new setSetpoint speed
-  if (micros() - last_micros > updating_interval) {
-    last_micros = micros();
-
-    if (this->setpoint_speed > this->current_speed) {
-      this->current_speed++;
-      this->is_updating = true;
-    } else if (this->setpoint_speed < this->current_speed) {
-      this->current_speed--;
-      this->is_updating = true;
-    } else {
-      this->is_updating = false;
-    }
-  }
-
-  // Transfer the updated speed to the pwm pins
-  if (this->current_speed < 0) {
-    forwardPwm.pulse_perc(0);
-    backwardPwm.pulse_perc(abs(this->current_speed));
-  } else {
-    forwardPwm.pulse_perc(this->current_speed);
-    backwardPwm.pulse_perc(0);
+  // Advance the profile from here if no timer could be started.
+  if (!this->timer_running && micros() - this->last_micros >= 1000000 / MOTOR_PROFILE_RATE) {
+    this->last_micros = micros();
+    this->update();
   }
 }
 
@@ -100,17 +103,20 @@ void L298N::write(float speed) {
  * @brief Immediately stops the motor.
  *
  * Sets both the current and target speeds to zero and sends a corresponding PWM signal to
- * stop the motor instantly. This method is useful for emergency stops or when a quick response
- * is required.
+ * stop the motor instantly, bypassing the deceleration. This method is useful for emergency
+ * stops or when a quick response is required.
  */
 void L298N::stop() {
   if (!this->enabled)
     return;
 
-  this->current_speed = 0;
+  // Keep the timer from advancing the profile in between.
+  noInterrupts();
   this->setpoint_speed = 0;
-  forwardPwm.pulse_perc(this->current_speed);
-  backwardPwm.pulse_perc(this->current_speed);
+  this->profile_speed = 0;
+  this->is_updating = false;
+  this->transfer();
+  interrupts();
 }
 
 /**
@@ -123,33 +129,119 @@ void L298N::stop() {
  * @param duration The time in milliseconds for which the motor should run.
  * @param speed The speed at which the motor should operate.
  */
-void L298N::runFor(unsigned long duration, float speed) {
+void L298N::runFor(unsigned long duration, int16_t speed) {
   if (!this->enabled)
     return;
 
-  static unsigned long last_millis;
+  // The duration starts with the first call.
+  if (!this->run_timer_locked) {
+    this->run_millis = millis();
+    this->run_timer_locked = true;
+  }
 
   this->write(speed);
 
-  if (millis() - last_millis > duration) {
+  if (millis() - this->run_millis > duration) {
+    this->run_timer_locked = false;
     this->end();
   }
 }
 
 /**
- * @brief Sets the rate of change of the motor's speed.
+ * @brief Sets the maximum rate at which the motor speeds up.
  *
- * Defines how quickly the motor can change its speed, with a range from 0 (instantaneous
- * change) to 100 (slowest change). This allows for smooth acceleration and deceleration,
- * which can be crucial for applications that require precise speed control.
+ * Limits how quickly the magnitude of the speed may grow, from standstill or towards a higher
+ * speed in the same direction.
  *
- * @param acceleration The desired acceleration rate.
+ * @param acceleration The acceleration in percent per second, 0 for an instantaneous change.
  */
-void L298N::setAcceleration(uint8_t acceleration) {
+void L298N::setAcceleration(uint16_t acceleration) {
   if (!this->enabled)
     return;
 
-  this->acceleration = constrain(acceleration, 0, 100);
+  this->acceleration = acceleration;
+}
+
+/**
+ * @brief Sets the maximum rate at which the motor slows down.
+ *
+ * Limits how quickly the magnitude of the speed may shrink. A constant deceleration gives a
+ * repeatable braking distance. When reversing, the motor brakes to a standstill at this rate
+ * before it accelerates in the opposite direction.
+ *
+ * @param deceleration The deceleration in percent per second, 0 for an instantaneous change.
+ */
+void L298N::setDeceleration(uint16_t deceleration) {
+  if (!this->enabled)
+    return;
+
+  this->deceleration = deceleration;
+}
+
+/**
+ * @brief Sets the battery voltage at which the duty cycle equals the speed.
+ *
+ * @param voltage The nominal voltage in the unit of setSupplyVoltage(), 0 to disable the
+ * voltage compensation.
+ */
+void L298N::setNominalVoltage(uint8_t voltage) {
+  if (!this->enabled)
+    return;
+
+  this->nominal_voltage = voltage;
+  if (!voltage)
+    this->voltage_scale = 256;
+}
+
+/**
+ * @brief Updates the measured battery voltage to compensate the duty cycle.
+ *
+ * The duty cycle is scaled by the ratio of the nominal to the measured voltage, so the motor
+ * receives the same average voltage on a sagging battery. The scale is limited to the range
+ * from MOTOR_MIN_VOLTAGE_SCALE to MOTOR_MAX_VOLTAGE_SCALE in 1/256, so a faulty measurement
+ * cannot drive the motor at full power.
+ *
+ * @param voltage The measured voltage in the unit of setNominalVoltage().
+ */
+void L298N::setSupplyVoltage(uint8_t voltage) {
+  if (!this->enabled || !this->nominal_voltage || !voltage)
+    return;
+
+  uint16_t scale = uint16_t(this->nominal_voltage) * 256 / voltage;
+  this->voltage_scale = constrain(scale, MOTOR_MIN_VOLTAGE_SCALE, MOTOR_MAX_VOLTAGE_SCALE);
+}
+
+/**
+ * @brief Advances the speed profile by one step and transfers it to the PWM pins.
+ *
+ * Called by the timer at MOTOR_PROFILE_RATE. Speeding up is limited by the acceleration and
+ * slowing down by the deceleration, which results in a trapezoidal speed profile. The speed
+ * is kept in thousandths of a percent, so slow ramps advance on every step.
+ */
+void L298N::update() {
+  if (!this->enabled)
+    return;
+
+  int32_t setpoint = int32_t(this->setpoint_speed) * 1000;
+  int32_t speed = this->profile_speed;
+  bool braking = (speed > 0 && setpoint < speed) || (speed < 0 && setpoint > speed);
+  int32_t step = int32_t(braking ? this->deceleration : this->acceleration) * 1000 / MOTOR_PROFILE_RATE;
+  if (!step)
+    step = 200000;
+
+  if (braking) {
+    // Brake to a standstill first if the direction is reversed.
+    if (speed > 0) speed = max(speed - step, max(setpoint, int32_t(0)));
+    else speed = min(speed + step, min(setpoint, int32_t(0)));
+  } else if (setpoint > speed) {
+    speed = min(speed + step, setpoint);
+  } else if (setpoint < speed) {
+    speed = max(speed - step, setpoint);
+  }
+
+  this->is_updating = speed != setpoint;
+  this->profile_speed = speed;
+  this->transfer();
 }
 
 /**
@@ -171,8 +263,8 @@ bool L298N::isUpdating() {
 /**
  * @brief Retrieves the current operating speed of the motor.
  *
- * Returns the current speed at which the motor is running. This can be used to monitor
- * the motor's status or to make decisions based on its current speed.
+ * Returns the current speed of the profile at which the motor is running. This can be used
+ * to monitor the motor's status or to make decisions based on its current speed.
  *
  * @return The current speed of the motor, ranging from -100 to 100.
  */
@@ -180,5 +272,36 @@ int8_t L298N::read() {
   if (!this->enabled)
     return 0;
 
-  return this->current_speed;
+  return this->profile_speed / 1000;
+}
+
+/**
+ * @brief Forwards the interrupt of the profile timer to its motor driver.
+ *
+ * @param args The arguments of the timer callback, holding the motor driver as context.
+ */
+void L298N::onTimer(timer_callback_args_t *args) {
+  static_cast<L298N *>(const_cast<void *>(args->p_context))->update();
+}
+
+/**
+ * @brief Transfers the speed of the profile to the PWM pins.
+ *
+ * Applies the voltage compensation and only writes the duty cycle if it has changed, in steps
+ * of a tenth of a percent. The pulse width is set in counts of the timer, so the interrupt
+ * of the profile takes no floating-point instruction.
+ */
+void L298N::transfer() {
+  int16_t duty = constrain(int32_t(this->profile_speed) * this->voltage_scale / (256 * 100), -1000, 1000);
+  if (duty == this->last_duty)
+    return;
+  this->last_duty = duty;
+
+  if (duty < 0) {
+    forwardPwm.pulseWidth_raw(0);
+    backwardPwm.pulseWidth_raw(uint32_t(-duty) * MOTOR_PWM_PERIOD_COUNTS / 1000);
+  } else {
+    forwardPwm.pulseWidth_raw(uint32_t(duty) * MOTOR_PWM_PERIOD_COUNTS / 1000);
+    backwardPwm.pulseWidth_raw(0);
+  }
 }
\ No newline at end of file
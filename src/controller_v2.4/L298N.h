@@ -7,6 +7,12 @@
  * motor speed and direction, making it accessible for projects that require motor
  * actuation.
  *
+ * The speed follows a trapezoidal profile towards the written target speed, limited by a
+ * maximum acceleration and deceleration in percent per second. The profile is advanced by a
+ * hardware timer at MOTOR_PROFILE_RATE, so the motor keeps ramping at a constant rate even
+ * if the main loop stalls. Optionally, the duty cycle is scaled with the battery voltage,
+ * so the same speed results in the same motor voltage on a sagging battery.
+ *
  * @author Maximilian Kautzsch
  * @copyright Copyright (c) 2024 Maximilian Kautzsch
  * Licensed under MIT License.
@@ -25,6 +31,7 @@
 
 #if defined(ARDUINO_ARCH_RENESAS)
 #include "pwm.h"
+#include "FspTimer.h"
 #endif
 
 #ifdef EXTENDED_PIN_MODE
@@ -33,8 +40,12 @@ typedef uint32_t pin_size_t;
 typedef uint8_t pin_size_t;
 #endif
 
-#define MIN_UPDATING_INTERVAL 50000
-#define MAX_UPDATING_INTERVAL 100
+#define MOTOR_PROFILE_RATE 1000
+#define MOTOR_DEFAULT_ACCELERATION 400
+#define MOTOR_DEFAULT_DECELERATION 800
+#define MOTOR_MIN_VOLTAGE_SCALE 192
+#define MOTOR_MAX_VOLTAGE_SCALE 384
+#define MOTOR_PWM_PERIOD_COUNTS 1440  // Counts of the 48 MHz GPT clock per PWM period, about 33 kHz.
 
 class L298N {
 public:
@@ -43,21 +54,37 @@ public:
 
   void begin();
   void end();
-  void write(float speed);
+  void write(int16_t speed);
   void stop();
-  void runFor(unsigned long time, float speed);
-  void setAcceleration(uint8_t acceleration);
+  void runFor(unsigned long time, int16_t speed);
+  void setAcceleration(uint16_t acceleration);
+  void setDeceleration(uint16_t deceleration);
+  void setNominalVoltage(uint8_t voltage);
+  void setSupplyVoltage(uint8_t voltage);
+  void update();
   bool isUpdating();
   int8_t read();
 
 private:
+  static void onTimer(timer_callback_args_t *args);
+  void transfer();
+
   PwmOut forwardPwm;
   PwmOut backwardPwm;
+  FspTimer profileTimer;
   bool enabled;
-  bool is_updating;
-  int8_t current_speed;
-  int8_t setpoint_speed;
-  uint8_t acceleration;
+  bool timer_running;
+  bool run_timer_locked;
+  volatile bool is_updating;
+  volatile int8_t setpoint_speed;
+  volatile int32_t profile_speed;
+  volatile uint16_t voltage_scale;
+  int16_t last_duty;
+  uint16_t acceleration;
+  uint16_t deceleration;
+  uint8_t nominal_voltage;
+  unsigned long last_micros;
+  unsigned long run_millis;
 };
 
 #endif  // L298N_H
\ No newline at end of file
@@ -5,6 +5,12 @@
  * The MovingAverage class template computes a moving average of a sequence of values,
  * which is useful for smoothing out short-term fluctuations and highlighting longer-term
  * trends or cycles. This class is versatile and can be used with various data types.
+ *
+ * The size of the data window is fixed at compile time. Every instance keeps its own ring
+ * buffer, so the simple and the weighted moving average are updated in constant time with
+ * each new data point and without any heap allocation. The cumulative and the exponential
+ * average are kept as fixed-point numbers with MOVING_AVERAGE_FRAC_BITS fractional bits in the
+ * accumulator type, so no average takes a floating-point instruction.
  * 
  * @author Maximilian Kautzsch
  * @copyright Copyright (c) 2024 Maximilian Kautzsch
@@ -15,6 +21,7 @@
 #define MOVINGAVERAGE_H
 
 #include <sys/_stdint.h>
+#include "Fixed.h"
 
 #if defined(ARDUINO) && ARDUINO >= 100
 #include "Arduino.h"
@@ -22,6 +29,8 @@
 #include "WProgram.h"
 #endif
 
+#define MOVING_AVERAGE_FRAC_BITS 12
+
 enum AverageType {
   SMA = 1 << 0,
   CA = 1 << 1,
@@ -29,9 +38,13 @@ enum AverageType {
   EMA = 1 << 3
 };
 
-template<typename T, typename U>
+template<typename T, typename U, uint8_t WINDOW_SIZE, typename A = int32_t>
 class MovingAverage {
+  static_assert(WINDOW_SIZE > 0, "The window of a MovingAverage must hold at least one data point.");
+
 public:
+  typedef Fixed<MOVING_AVERAGE_FRAC_BITS, A> Average;
+
   MovingAverage();
   ~MovingAverage();
 
@@ -40,15 +53,23 @@ public:
   void add(T input);
   void print(uint8_t average_types);
   void print();
-  bool detectedPeak(T threshold, uint8_t consecutive_matches);
-  U readAverage(uint8_t window_size);
+  U readAverage();
   U readCumulativeAverage();
-  U readWeightedAverage(uint8_t window_size);
-  U readExponentialAverage(float smoothing_factor);
+  U readWeightedAverage();
+  U readExponentialAverage(Average smoothing_factor);
 
 private:
   bool enabled;
+  bool exponential_average_started;
   T input;
+  T window[WINDOW_SIZE];
+  uint8_t head;
+  uint8_t num_elements;
+  uint16_t num_cumulated_elements;
+  A sum;
+  A weighted_sum;
+  Average cumulated_average;
+  Average exponential_average;
   U simple_moving_average;
   U cumulative_average;
   U weighted_moving_average;
@@ -58,22 +79,30 @@ private:
 /**
  * @brief Constructs a new MovingAverage object.
  */
-template<typename T, typename U>
-MovingAverage<T, U>::MovingAverage() {}
+template<typename T, typename U, uint8_t WINDOW_SIZE, typename A>
+MovingAverage<T, U, WINDOW_SIZE, A>::MovingAverage() {}
 
 /**
  * @brief Destructs a constructed MovingAverage object.
  */
-template<typename T, typename U>
-MovingAverage<T, U>::~MovingAverage() {}
+template<typename T, typename U, uint8_t WINDOW_SIZE, typename A>
+MovingAverage<T, U, WINDOW_SIZE, A>::~MovingAverage() {}
 
 /**
  * @brief Initializes the MovingAverage object.
  *
- * Toggles the 'enabled' class attribtute to true.
+ * Toggles the 'enabled' class attribtute to true and empties the data window.
  */
-template<typename T, typename U>
-void MovingAverage<T, U>::begin() {
+template<typename T, typename U, uint8_t WINDOW_SIZE, typename A>
+void MovingAverage<T, U, WINDOW_SIZE, A>::begin() {
+  this->head = 0;
+  this->num_elements = 0;
+  this->num_cumulated_elements = 0;
+  this->sum = 0;
+  this->weighted_sum = 0;
+  this->cumulated_average = 0;
+  this->exponential_average = 0;
+  this->exponential_average_started = false;
   this->enabled = true;
 }
 
@@ -82,19 +111,44 @@ void MovingAverage<T, U>::begin() {
  *
  * Toggles the 'enabled' class attribtute to false.
  */
-template<typename T, typename U>
-void MovingAverage<T, U>::end() {
+template<typename T, typename U, uint8_t WINDOW_SIZE, typename A>
+void MovingAverage<T, U, WINDOW_SIZE, A>::end() {
   this->enabled = false;
 }
 
 /**
  * @brief Adds a new data point to the filter.
  *
+ * Stores the data point in the ring buffer and updates the window sums of the simple and
+ * the weighted moving average as well as the cumulative average. Once the window is full,
+ * the oldest data point is replaced. With the newest data point weighted by the amount of
+ * data points n, the weighted sum follows from the previous one as
+ * weighted_sum + n * input - sum, so no data point has to be shifted or re-weighted.
+ *
  * @param input The new data point that is being added to the filter.
  */
-template<typename T, typename U>
-void MovingAverage<T, U>::add(T input) {
+template<typename T, typename U, uint8_t WINDOW_SIZE, typename A>
+void MovingAverage<T, U, WINDOW_SIZE, A>::add(T input) {
   this->input = input;
+
+  if (!this->enabled)
+    return;
+
+  if (this->num_elements < WINDOW_SIZE) {
+    this->num_elements++;
+    this->weighted_sum += A(input) * this->num_elements;
+    this->sum += input;
+  } else {
+    this->weighted_sum += A(input) * WINDOW_SIZE - this->sum;
+    this->sum += A(input) - A(this->window[this->head]);
+  }
+
+  this->window[this->head] = input;
+  this->head = (this->head + 1) % WINDOW_SIZE;
+
+  if (this->num_cumulated_elements < UINT16_MAX)
+    this->num_cumulated_elements++;
+  this->cumulated_average += (Average(int(input)) - this->cumulated_average) / this->num_cumulated_elements;
 }
 
 /**
@@ -102,14 +156,14 @@ void MovingAverage<T, U>::add(T input) {
  *
  * Firstly, the raw data points are printed serially.
  * Then, the corresponding average values are printed through the serial monitor
- * based on the selected average types.
+ * based on the selected average types. Nothing is printed while the serial port is not open.
  *
  * @param average_types Bitmask representing the average types to print.
  */
-template<typename T, typename U>
-void MovingAverage<T, U>::print(uint8_t average_types) {
-  while (!Serial) {
-  }
+template<typename T, typename U, uint8_t WINDOW_SIZE, typename A>
+void MovingAverage<T, U, WINDOW_SIZE, A>::print(uint8_t average_types) {
+  if (!Serial)
+    return;
 
   Serial.print("Raw-Data:");
   Serial.print(this->input);
@@ -140,179 +194,92 @@ void MovingAverage<T, U>::print(uint8_t average_types) {
  * The raw data points as well as all of the calculated average filter outputs
  * are printed through the serial monitor.
  */
-template<typename T, typename U>
-void MovingAverage<T, U>::print() {
+template<typename T, typename U, uint8_t WINDOW_SIZE, typename A>
+void MovingAverage<T, U, WINDOW_SIZE, A>::print() {
   this->print(SMA | CA | WMA | EMA);
 }
 
 /**
- * @brief Filters out peaks from the data points.
+ * @brief Calculates the Simple Moving Average (SMA) of the data window.
  *
- * If the given input is greater or equal to a certain threshold value for a specified
- * amount in a row, then a data peak is retrieved.
+ * Divides the window sum, which is kept up to date by add(), by the amount of data points
+ * in the window. If the MovingAverage object is disabled or empty, returns 0.
  *
- * @param threshold The value the input data is compared to.
- * @param consecutive_matches The amount the data point must be greater or equal to the threshold
- * in a row, in order to filter out a peak.
- * @return True if a data peak has been detected, false otherwise.
- */
-template<typename T, typename U>
-bool MovingAverage<T, U>::detectedPeak(T threshold, uint8_t consecutive_matches) {
-  if (!this->enabled)
-    return 0;
-
-  static uint8_t matches;
-
-  if (this->input >= threshold) {
-    matches++;
-
-    if (matches >= consecutive_matches) {
-      matches = 0;
-      return true;
-    }
-  } else {
-    matches = 0;
-    return false;
-  }
-}
-
-/**
- * @brief Calculates the Simple Moving Average (SMA) for a given input.
- *
- * Calculates the SMA based on the provided input and window size.
- * If the MovingAverage object is disabled, returns 0.
- *
- * @param input The input data point to be processed.
- * @param window_size The size of the data window (amount of data points used for
- * one calculation).
  * @return The calculated Simple Moving Average (SMA).
  */
-template<typename T, typename U>
-U MovingAverage<T, U>::readAverage(uint8_t window_size) {
-  if (!this->enabled)
+template<typename T, typename U, uint8_t WINDOW_SIZE, typename A>
+U MovingAverage<T, U, WINDOW_SIZE, A>::readAverage() {
+  if (!this->enabled || !this->num_elements)
     return 0;
 
-  static uint8_t num_elements;
-  static U *window = new U[window_size];
-  static U sum;
-
-  if (num_elements < window_size) {
-    window[num_elements] = this->input;
-    sum += this->input;
-    num_elements++;
-  } else {
-    for (uint8_t i = 0; i < window_size - 1; i++) {
-      sum -= window[i];
-      window[i] = window[i + 1];
-      sum += window[i];
-    }
-    sum -= window[window_size - 1];
-    window[window_size - 1] = this->input;
-    sum += window[window_size - 1];
-  }
-
-  this->simple_moving_average = sum / num_elements;
+  this->simple_moving_average = U(this->sum / this->num_elements);
 
   return this->simple_moving_average;
 }
 
 /**
- * @brief Calculates the Cumulative Average (CA) for a given input.
+ * @brief Calculates the Cumulative Average (CA) of all data points.
  *
- * Calculates the CA based on the provided input.
- * Uses all of the data points up to the current datum.
- * If the MovingAverage object is disabled, returns 0.
+ * Uses all of the data points up to the current datum, rounded to the nearest unit. Each data
+ * point moves the average by its difference divided by the amount of data points, in steps of
+ * 2^-MOVING_AVERAGE_FRAC_BITS. If the MovingAverage object is disabled, returns 0.
  *
- * @param input The input data point to be processed.
  * @return The calculated Cumulative Average (CA).
  */
-template<typename T, typename U>
-U MovingAverage<T, U>::readCumulativeAverage() {
+template<typename T, typename U, uint8_t WINDOW_SIZE, typename A>
+U MovingAverage<T, U, WINDOW_SIZE, A>::readCumulativeAverage() {
   if (!this->enabled)
     return 0;
 
-  static uint16_t num_elements;
-  static float average;
-
-  if (num_elements <= 2) {
-    average += this->input;
-    num_elements++;
-    average /= num_elements;
-  } else {
-    num_elements++;
-    average = (this->input + average * (num_elements - 1)) / num_elements;
-  }
+  this->cumulative_average = U(this->cumulated_average.round());
 
-  this->cumulative_average = U(average);
   return this->cumulative_average;
 }
 
 /**
- * @brief Calculates the Weighted Moving Average (WMA) for a given input.
+ * @brief Calculates the Weighted Moving Average (WMA) of the data window.
  *
- * Calculates the WMA based on the provided input and window size.
- * Gives more weight_coefficient to recent values and lesser weight_coefficient to older values.
- * If the MovingAverage object is disabled, returns 0.
+ * Gives more weight_coefficient to recent values and lesser weight_coefficient to older values,
+ * with the newest data point weighted by n and the oldest by 1. The weighted sum is kept up to
+ * date by add(). If the MovingAverage object is disabled or empty, returns 0.
  *
- * @param input The input data point to be processed.
- * @param window_size The size of the data window (amount of data points used for
- * one calculation).
  * @return The calculated Weighted Moving Average (WMA).
  */
-template<typename T, typename U>
-U MovingAverage<T, U>::readWeightedAverage(uint8_t window_size) {
-  if (!this->enabled)
+template<typename T, typename U, uint8_t WINDOW_SIZE, typename A>
+U MovingAverage<T, U, WINDOW_SIZE, A>::readWeightedAverage() {
+  if (!this->enabled || !this->num_elements)
     return 0;
 
-  static uint8_t num_elements;
-  static U *window = new U[window_size];
-  static U sum;
-  uint8_t weight_coefficient;
-
-  if (num_elements < window_size) {
-    weight_coefficient = num_elements + 1;
-    window[num_elements] = this->input;
-    sum += this->input * weight_coefficient;
-    num_elements++;
-  } else {
-    for (uint8_t i = 0; i < window_size - 1; i++) {
-      weight_coefficient = i + 1;
-      sum -= window[i] * weight_coefficient;
-      window[i] = window[i + 1];
-      sum += window[i] * weight_coefficient;
-    }
-    weight_coefficient = window_size;
-    sum -= window[window_size - 1] * weight_coefficient;
-    window[window_size - 1] = this->input;
-    sum += this->input * weight_coefficient;
-  }
-
-  this->weighted_moving_average = 2 * sum / (num_elements * (num_elements + 1));
+  A weight_sum = A(this->num_elements) * (this->num_elements + 1) / 2;
+  this->weighted_moving_average = U(this->weighted_sum / weight_sum);
 
   return this->weighted_moving_average;
 }
 
 /**
- * @brief Calculates the Exponential Moving Average (EMA) for a given input.
+ * @brief Calculates the Exponential Moving Average (EMA) for the latest data point.
  *
- * Calculates the EMA based on the provided input and smoothing factor.
- * Apply different weights to current values and the previous average.
+ * Calculates the EMA based on the latest data point and smoothing factor.
+ * Apply different weights to current values and the previous average, and rounds the average
+ * to the nearest unit. The first data point initializes the average.
  * If the MovingAverage object is disabled, returns 0.
  *
- * @param input The input data point to be processed.
  * @param smoothing_factor In interval of [0; 1]. Applies more weight_coefficient to current
  * values, if > 0, or weighs previous average heavier, if < 0.
  * @return The calculated Exponential Moving Average (EMA).
  */
-template<typename T, typename U>
-U MovingAverage<T, U>::readExponentialAverage(float smoothing_factor) {
+template<typename T, typename U, uint8_t WINDOW_SIZE, typename A>
+U MovingAverage<T, U, WINDOW_SIZE, A>::readExponentialAverage(Average smoothing_factor) {
   if (!this->enabled)
     return 0;
 
-  static U average;
-
-  this->exponential_moving_average = smoothing_factor * (this->input) + (1 - smoothing_factor) * average;
-  average = this->exponential_moving_average;
+  if (!this->exponential_average_started) {
+    this->exponential_average = Average(int(this->input));
+    this->exponential_average_started = true;
+  } else {
+    this->exponential_average += (Average(int(this->input)) - this->exponential_average) * smoothing_factor;
+  }
+  this->exponential_moving_average = U(this->exponential_average.round());
 
   return this->exponential_moving_average;
 }
@@ -0,0 +1,256 @@
+/**
+ * @file PoseEstimator.cpp
+ * @brief Implementation of the PoseEstimator class.
+ */
+
+#include "PoseEstimator.h"
+
+/**
+ * @brief Constructs a PoseEstimator object.
+ *
+ * The speed gain and the deadband of the motor are preset with rough values and should be
+ * measured on the track with setSpeedGain() and setDeadband().
+ */
+PoseEstimator::PoseEstimator()
+  : enabled(false), has_timestamp(false), x(0), y(0), heading(0), section_heading(0), speed(0),
+    section_travel(0), x_variance(POSE_UNKNOWN_VARIANCE), y_variance(POSE_UNKNOWN_VARIANCE),
+    speed_gain(150.0), deadband(15), last_timestamp(0) {}
+
+/**
+ * @brief Destructs the PoseEstimator object.
+ */
+PoseEstimator::~PoseEstimator() {}
+
+/**
+ * @brief Starts the estimation at the start position of the robot.
+ *
+ * @param heading The setpoint heading of the first section in degrees.
+ * @param front_distance The distance to the wall ahead in centimeters, or 0 if unknown.
+ */
+void PoseEstimator::begin(int16_t heading, uint16_t front_distance) {
+  this->enabled = true;
+  this->has_timestamp = false;
+  this->heading = heading;
+  this->beginSection(heading);
+
+  if (front_distance && front_distance < POSE_MAX_SONAR_DISTANCE) {
+    this->x = POSE_SECTION_LENGTH - front_distance;
+    this->x_variance = POSE_SONAR_NOISE;
+  } else {
+    this->x_variance = POSE_UNKNOWN_VARIANCE;
+  }
+}
+
+/**
+ * @brief Stops the estimation.
+ */
+void PoseEstimator::end() {
+  this->enabled = false;
+}
+
+/**
+ * @brief Moves the estimation into the frame of the next section after a turn.
+ *
+ * The robot finishes a turn in the corner between both sections, so its position along the
+ * new section is only roughly known until the wall ahead has been measured. The distance to
+ * the left wall is unknown.
+ *
+ * @param heading The setpoint heading of the new section in degrees.
+ */
+void PoseEstimator::beginSection(int16_t heading) {
+  this->section_heading = heading;
+  this->section_travel = 0;
+  this->x = POSE_CORNER_POSITION;
+  this->x_variance = POSE_CORNER_VARIANCE;
+  this->y = 0;
+  this->y_variance = POSE_UNKNOWN_VARIANCE;
+}
+
+/**
+ * @brief Dead-reckons the position since the last update.
+ *
+ * The speed follows from the speed commanded to the motor, which is 0 within the deadband of
+ * the motor and proportional to the command beyond it. The position advances along the yaw
+ * angle relative to the section, and the uncertainty grows with the distance travelled.
+ *
+ * @param yaw_angle The yaw angle in hundredths of a degree.
+ * @param speed The speed of the motor, ranging from -100 to 100.
+ * @param timestamp The time of the update in milliseconds.
+ */
+void PoseEstimator::update(int32_t yaw_angle, int8_t speed, unsigned long timestamp) {
+  if (!this->enabled)
+    return;
+
+  this->heading = yaw_angle / 100.0;
+  this->speed = (abs(speed) > this->deadband) ? speed * this->speed_gain / 100.0 : 0.0;
+
+  if (this->has_timestamp) {
+    float distance = this->speed * (timestamp - this->last_timestamp) / 1000.0;
+    float alignment_error = radians(this->readAlignmentError());
+
+    // A positive yaw error turns the robot anticlockwise, towards the left wall.
+    this->x += distance * cos(alignment_error);
+    this->y -= distance * sin(alignment_error);
+    this->section_travel += abs(distance);
+
+    this->x_variance += POSE_PROCESS_NOISE * abs(distance);
+    this->y_variance += POSE_PROCESS_NOISE * abs(distance);
+    this->x_variance = min(this->x_variance, float(POSE_UNKNOWN_VARIANCE));
+    this->y_variance = min(this->y_variance, float(POSE_UNKNOWN_VARIANCE));
+  }
+
+  this->last_timestamp = timestamp;
+  this->has_timestamp = true;
+}
+
+/**
+ * @brief Corrects the position along the section with the distance to the wall ahead.
+ *
+ * Ignored while the robot is not aligned with the section, since the sonar would not hit the
+ * wall ahead at a right angle, and if the distance is out of the reliable range.
+ *
+ * @param distance The distance measured by the front sonar in centimeters.
+ */
+void PoseEstimator::correctFront(uint16_t distance) {
+  if (!this->enabled || !distance || distance >= POSE_MAX_SONAR_DISTANCE)
+    return;
+
+  float alignment_error = this->readAlignmentError();
+  if (abs(alignment_error) > POSE_MAX_ALIGNMENT_ERROR)
+    return;
+
+  this->correct(this->x, this->x_variance, POSE_SECTION_LENGTH - distance * cos(radians(alignment_error)));
+}
+
+/**
+ * @brief Corrects the distance to the left wall with the left sonar.
+ *
+ * Ignored under the same conditions as correctFront().
+ *
+ * @param distance The distance measured by the left sonar in centimeters.
+ */
+void PoseEstimator::correctLeft(uint16_t distance) {
+  if (!this->enabled || !distance || distance >= POSE_MAX_SONAR_DISTANCE)
+    return;
+
+  float alignment_error = this->readAlignmentError();
+  if (abs(alignment_error) > POSE_MAX_ALIGNMENT_ERROR)
+    return;
+
+  this->correct(this->y, this->y_variance, distance * cos(radians(alignment_error)));
+}
+
+/**
+ * @brief Sets the speed of the robot at full motor power.
+ *
+ * @param speed_gain The speed in centimeters per second at a motor speed of 100.
+ */
+void PoseEstimator::setSpeedGain(float speed_gain) {
+  this->speed_gain = speed_gain;
+}
+
+/**
+ * @brief Sets the motor speed below which the robot does not move.
+ *
+ * @param deadband The motor speed, ranging from 0 to 100.
+ */
+void PoseEstimator::setDeadband(uint8_t deadband) {
+  this->deadband = constrain(deadband, 0, 100);
+}
+
+/**
+ * @brief Retrieves the speed of the robot at full motor power.
+ *
+ * @return The speed in centimeters per second at a motor speed of 100.
+ */
+float PoseEstimator::getSpeedGain() {
+  return this->speed_gain;
+}
+
+/**
+ * @brief Reads the position along the current section.
+ *
+ * @return The distance from the wall behind the robot in centimeters.
+ */
+float PoseEstimator::readX() {
+  return this->x;
+}
+
+/**
+ * @brief Reads the lateral position within the current section.
+ *
+ * @return The distance to the left wall in centimeters.
+ */
+float PoseEstimator::readY() {
+  return this->y;
+}
+
+/**
+ * @brief Reads the heading of the robot.
+ *
+ * @return The yaw angle in degrees, positive anticlockwise.
+ */
+float PoseEstimator::readHeading() {
+  return this->heading;
+}
+
+/**
+ * @brief Reads the estimated speed of the robot.
+ *
+ * @return The speed in centimeters per second, negative when reversing.
+ */
+float PoseEstimator::readSpeed() {
+  return this->speed;
+}
+
+/**
+ * @brief Reads the distance travelled since the current section has begun.
+ *
+ * @return The travelled distance in centimeters, counting reversing as well.
+ */
+float PoseEstimator::readSectionTravel() {
+  return this->section_travel;
+}
+
+/**
+ * @brief Indicates whether the position along the section is known precisely.
+ *
+ * @return True if the standard deviation of x is below 10 cm, false otherwise.
+ */
+bool PoseEstimator::isLocalized() {
+  return this->x_variance < 100.0;
+}
+
+/**
+ * @brief Computes the yaw angle of the robot relative to the heading of the section.
+ *
+ * @return The alignment error in degrees, positive anticlockwise.
+ */
+float PoseEstimator::readAlignmentError() {
+  return this->heading - this->section_heading;
+}
+
+/**
+ * @brief Applies a one-dimensional Kalman update to a coordinate.
+ *
+ * Measurements that deviate from the estimate by more than three standard deviations and
+ * more than POSE_GATE centimeters are rejected as outliers.
+ *
+ * @param state The coordinate to correct.
+ * @param variance The variance of the coordinate.
+ * @param measurement The measured coordinate.
+ * @return True if the measurement has been accepted, false otherwise.
+ */
+bool PoseEstimator::correct(float &state, float &variance, float measurement) {
+  float innovation = measurement - state;
+  float innovation_variance = variance + POSE_SONAR_NOISE;
+
+  if (abs(innovation) > POSE_GATE && innovation * innovation > 9.0 * innovation_variance)
+    return false;
+
+  float gain = variance / innovation_variance;
+  state += gain * innovation;
+  variance *= 1.0 - gain;
+
+  return true;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file PoseEstimator.h
+ * @brief Header file for the PoseEstimator class, tracking the position of the robot per section.
+ *
+ * The PoseEstimator class estimates the pose of the robot within the current section of the
+ * track. The frame of a section is aligned with its setpoint heading: x runs along the section
+ * towards the wall ahead, y is the distance to the left wall. Between measurements, the position
+ * is dead-reckoned from the yaw angle of the gyroscope and the speed commanded to the motor. The
+ * front and left ultrasonic distances correct the position with a one-dimensional Kalman update
+ * per axis, and measurements far off the prediction, such as echoes from a pillar, are rejected.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef POSEESTIMATOR_H
+#define POSEESTIMATOR_H
+
+#include <inttypes.h>
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#define POSE_SECTION_LENGTH 300.0
+#define POSE_MAX_SONAR_DISTANCE 200
+#define POSE_MAX_ALIGNMENT_ERROR 15.0
+#define POSE_PROCESS_NOISE 1.0
+#define POSE_SONAR_NOISE 9.0
+#define POSE_GATE 40.0
+#define POSE_UNKNOWN_VARIANCE 10000.0
+#define POSE_CORNER_POSITION 50.0
+#define POSE_CORNER_VARIANCE 900.0
+
+class PoseEstimator {
+public:
+  PoseEstimator();
+  ~PoseEstimator();
+
+  void begin(int16_t heading, uint16_t front_distance);
+  void end();
+  void beginSection(int16_t heading);
+  void update(int32_t yaw_angle, int8_t speed, unsigned long timestamp);
+  void correctFront(uint16_t distance);
+  void correctLeft(uint16_t distance);
+  void setSpeedGain(float speed_gain);
+  void setDeadband(uint8_t deadband);
+  float getSpeedGain();
+  float readX();
+  float readY();
+  float readHeading();
+  float readSpeed();
+  float readSectionTravel();
+  bool isLocalized();
+
+private:
+  float readAlignmentError();
+  bool correct(float &state, float &variance, float measurement);
+
+  bool enabled;
+  bool has_timestamp;
+  float x;
+  float y;
+  float heading;
+  float section_heading;
+  float speed;
+  float section_travel;
+  float x_variance;
+  float y_variance;
+  float speed_gain;
+  uint8_t deadband;
+  unsigned long last_timestamp;
+};
+
+#endif  // POSEESTIMATOR_H
@@ -0,0 +1,265 @@
+/**
+ * @file Profiler.cpp
+ * @brief Implementation of the Profiler and ScopedTimer classes.
+ */
+
+#include "Profiler.h"
+
+ProfilerSection Profiler::sections[MAX_PROFILER_SECTIONS];
+uint8_t Profiler::num_sections;
+uint32_t Profiler::begin_cycles;
+uint32_t Profiler::ready_cycles;
+
+/**
+ * @brief Initializes the time base of the profiler.
+ *
+ * Enables the DWT cycle counter of the Cortex-M4, if available, and clears all statistics.
+ * Should be called first in the setup, so the time to ready covers the complete startup.
+ */
+void Profiler::begin() {
+#if defined(PROFILER_CYCLE_COUNTER)
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+  begin_cycles = readCycles();
+  ready_cycles = 0;
+  reset();
+}
+
+/**
+ * @brief Clears the statistics of all registered sections.
+ *
+ * The sections themselves stay registered.
+ */
+void Profiler::reset() {
+  for (uint8_t i = 0; i < num_sections; i++) {
+    clear(sections[i]);
+  }
+}
+
+/**
+ * @brief Registers a named section in the static table.
+ *
+ * Registering a name twice returns the section registered first.
+ *
+ * @param name The name of the section, which has to outlive the profiler.
+ * @return The index of the section, or MAX_PROFILER_SECTIONS if the table is full.
+ */
+uint8_t Profiler::registerSection(const char *name) {
+  for (uint8_t i = 0; i < num_sections; i++) {
+    if (strcmp(sections[i].name, name) == 0) {
+      return i;
+    }
+  }
+
+  if (num_sections >= MAX_PROFILER_SECTIONS)
+    return MAX_PROFILER_SECTIONS;
+
+  sections[num_sections].name = name;
+  clear(sections[num_sections]);
+  num_sections++;
+
+  return num_sections - 1;
+}
+
+/**
+ * @brief Adds a measured run time to the statistics of a section.
+ *
+ * @param section The index of the section.
+ * @param cycles The run time in cycles of the time base.
+ */
+void Profiler::record(uint8_t section, uint32_t cycles) {
+  if (section >= num_sections)
+    return;
+
+  ProfilerSection &entry = sections[section];
+  entry.count++;
+  entry.total_cycles += cycles;
+  entry.min_cycles = min(entry.min_cycles, cycles);
+  entry.max_cycles = max(entry.max_cycles, cycles);
+
+  uint32_t run_time = toMicros(cycles);
+  uint32_t bin_limit = PROFILER_HISTOGRAM_BASE;
+  uint8_t bin = 0;
+  while (bin < PROFILER_HISTOGRAM_BINS - 1 && run_time >= bin_limit) {
+    bin_limit <<= 1;
+    bin++;
+  }
+
+  if (entry.histogram[bin] < UINT16_MAX)
+    entry.histogram[bin]++;
+}
+
+/**
+ * @brief Reads the current value of the time base.
+ *
+ * @return The DWT cycle count if available, the microseconds since start-up otherwise.
+ */
+uint32_t Profiler::readCycles() {
+#if defined(PROFILER_CYCLE_COUNTER)
+  return DWT->CYCCNT;
+#else
+  return micros();
+#endif
+}
+
+/**
+ * @brief Records the time the startup has taken until the robot is ready.
+ *
+ * Only the first call is recorded. Unlike the statistics of the sections, the time to ready
+ * is not cleared by reset().
+ */
+void Profiler::markReady() {
+  if (!ready_cycles)
+    ready_cycles = max(readCycles() - begin_cycles, uint32_t(1));
+}
+
+/**
+ * @brief Reads the time the startup has taken until the robot is ready.
+ *
+ * @return The time to ready in microseconds, or 0 if the robot is not ready yet.
+ */
+uint32_t Profiler::readReadyTime() {
+  return toMicros(ready_cycles);
+}
+
+/**
+ * @brief Converts a run time from cycles of the time base to microseconds.
+ *
+ * @param cycles The run time in cycles of the time base.
+ * @return The run time in microseconds.
+ */
+uint32_t Profiler::toMicros(uint32_t cycles) {
+#if defined(PROFILER_CYCLE_COUNTER)
+  return cycles / (SystemCoreClock / 1000000);
+#else
+  return cycles;
+#endif
+}
+
+/**
+ * @brief Reads the frequency of the time base.
+ *
+ * @return The core clock in Hz if the DWT cycle counter is available, 1 MHz otherwise.
+ */
+uint32_t Profiler::readClockRate() {
+#if defined(PROFILER_CYCLE_COUNTER)
+  return SystemCoreClock;
+#else
+  return 1000000;
+#endif
+}
+
+/**
+ * @brief Retrieves the amount of registered sections.
+ *
+ * @return The amount of sections in the static table.
+ */
+uint8_t Profiler::getNumSections() {
+  return num_sections;
+}
+
+/**
+ * @brief Retrieves the statistics of a section.
+ *
+ * @param section The index of the section.
+ * @return The statistics of the section.
+ */
+const ProfilerSection &Profiler::getSection(uint8_t section) {
+  return sections[constrain(section, 0, MAX_PROFILER_SECTIONS - 1)];
+}
+
+/**
+ * @brief Determines the section with the longest run time measured so far.
+ *
+ * @return The index of the worst section, or MAX_PROFILER_SECTIONS if nothing was recorded.
+ */
+uint8_t Profiler::findWorstSection() {
+  uint8_t worst_section = MAX_PROFILER_SECTIONS;
+  uint32_t worst_cycles = 0;
+
+  for (uint8_t i = 0; i < num_sections; i++) {
+    if (sections[i].count && sections[i].max_cycles >= worst_cycles) {
+      worst_cycles = sections[i].max_cycles;
+      worst_section = i;
+    }
+  }
+
+  return worst_section;
+}
+
+/**
+ * @brief Prints the statistics of all sections as a comma-separated table.
+ *
+ * Each row holds the name, the amount of calls, the minimum, mean and maximum run time in
+ * microseconds and the counts of the histogram bins. The table is preceded by a row with the
+ * time to ready in microseconds.
+ *
+ * @param output The stream the table is printed to, such as Serial.
+ */
+void Profiler::dump(Print &output) {
+  output.print("ready_us,");
+  output.println(readReadyTime());
+
+  output.print("section,count,min_us,mean_us,max_us");
+  uint32_t bin_limit = PROFILER_HISTOGRAM_BASE;
+  for (uint8_t i = 0; i < PROFILER_HISTOGRAM_BINS; i++) {
+    output.print((i < PROFILER_HISTOGRAM_BINS - 1) ? ",lt" : ",ge");
+    output.print((i < PROFILER_HISTOGRAM_BINS - 1) ? bin_limit : bin_limit / 2);
+    bin_limit <<= 1;
+  }
+  output.println();
+
+  for (uint8_t i = 0; i < num_sections; i++) {
+    const ProfilerSection &section = sections[i];
+    uint32_t mean_cycles = section.count ? section.total_cycles / section.count : 0;
+
+    output.print(section.name);
+    output.print(",");
+    output.print(section.count);
+    output.print(",");
+    output.print(section.count ? toMicros(section.min_cycles) : 0);
+    output.print(",");
+    output.print(toMicros(mean_cycles));
+    output.print(",");
+    output.print(toMicros(section.max_cycles));
+    for (uint8_t j = 0; j < PROFILER_HISTOGRAM_BINS; j++) {
+      output.print(",");
+      output.print(section.histogram[j]);
+    }
+    output.println();
+  }
+}
+
+/**
+ * @brief Clears the statistics of a single section.
+ *
+ * @param section The section to clear.
+ */
+void Profiler::clear(ProfilerSection &section) {
+  section.count = 0;
+  section.min_cycles = UINT32_MAX;
+  section.max_cycles = 0;
+  section.total_cycles = 0;
+
+  for (uint8_t i = 0; i < PROFILER_HISTOGRAM_BINS; i++) {
+    section.histogram[i] = 0;
+  }
+}
+
+/**
+ * @brief Starts timing a section for the lifetime of the object.
+ *
+ * @param section The index of the section, as returned by Profiler::registerSection().
+ */
+ScopedTimer::ScopedTimer(uint8_t section)
+  : section(section), start_cycles(Profiler::readCycles()) {}
+
+/**
+ * @brief Stops timing and records the run time of the section.
+ */
+ScopedTimer::~ScopedTimer() {
+  Profiler::record(this->section, Profiler::readCycles() - this->start_cycles);
+}
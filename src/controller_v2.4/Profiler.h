@@ -0,0 +1,93 @@
+/**
+ * @file Profiler.h
+ * @brief Header file for the Profiler and ScopedTimer classes, measuring the run time of code sections.
+ *
+ * The Profiler class keeps a static table of named code sections. For each section it records
+ * the amount of calls, the minimum, maximum and mean run time and a histogram with logarithmic
+ * bins. Run times are taken from the DWT cycle counter of the Cortex-M4 if available and from
+ * micros() otherwise. A ScopedTimer measures the scope it lives in, and the PROFILE_SCOPE macro
+ * registers a section on first use and times the rest of the enclosing block. The time from the
+ * start of the profiler until the robot is ready is kept apart from the sections.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <inttypes.h>
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#if defined(ARDUINO_ARCH_RENESAS)
+#define PROFILER_CYCLE_COUNTER
+#endif
+
+#define MAX_PROFILER_SECTIONS 16
+#define PROFILER_HISTOGRAM_BINS 8
+#define PROFILER_HISTOGRAM_BASE 32
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) \
+  static const uint8_t PROFILE_CONCAT(profiler_section_, __LINE__) = Profiler::registerSection(name); \
+  ScopedTimer PROFILE_CONCAT(scoped_timer_, __LINE__)(PROFILE_CONCAT(profiler_section_, __LINE__))
+
+/**
+ * @struct ProfilerSection
+ * @brief Struct to hold the run time statistics of a named code section.
+ *
+ * Run times are stored in cycles of the time base. Bin i of the histogram counts the run
+ * times below PROFILER_HISTOGRAM_BASE * 2^i microseconds, the last bin all longer ones.
+ */
+struct ProfilerSection {
+  const char *name;
+  uint32_t count;
+  uint32_t min_cycles;
+  uint32_t max_cycles;
+  uint64_t total_cycles;
+  uint16_t histogram[PROFILER_HISTOGRAM_BINS];
+};
+
+class Profiler {
+public:
+  static void begin();
+  static void reset();
+  static uint8_t registerSection(const char *name);
+  static void record(uint8_t section, uint32_t cycles);
+  static void markReady();
+  static uint32_t readReadyTime();
+  static uint32_t readCycles();
+  static uint32_t toMicros(uint32_t cycles);
+  static uint32_t readClockRate();
+  static uint8_t getNumSections();
+  static const ProfilerSection &getSection(uint8_t section);
+  static uint8_t findWorstSection();
+  static void dump(Print &output);
+
+private:
+  static void clear(ProfilerSection &section);
+
+  static ProfilerSection sections[MAX_PROFILER_SECTIONS];
+  static uint8_t num_sections;
+  static uint32_t begin_cycles;
+  static uint32_t ready_cycles;
+};
+
+class ScopedTimer {
+public:
+  ScopedTimer(uint8_t section);
+  ~ScopedTimer();
+
+private:
+  uint8_t section;
+  uint32_t start_cycles;
+};
+
+#endif  // PROFILER_H
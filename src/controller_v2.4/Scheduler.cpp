@@ -0,0 +1,211 @@
+/**
+ * @file Scheduler.cpp
+ * @brief Implementation of the Scheduler class.
+ */
+
+#include "Scheduler.h"
+
+/**
+ * @brief Constructs a Scheduler object for a static task table.
+ *
+ * @param tasks The task table, which stays owned by the caller.
+ * @param num_tasks The amount of tasks in the table, of which at most SCHEDULER_MAX_TASKS
+ * are run.
+ */
+Scheduler::Scheduler(Task *tasks, uint8_t num_tasks)
+  : tasks(tasks), enabled(false), num_tasks(min(num_tasks, uint8_t(SCHEDULER_MAX_TASKS))) {}
+
+/**
+ * @brief Destructs the Scheduler object.
+ */
+Scheduler::~Scheduler() {}
+
+/**
+ * @brief Initializes the scheduler.
+ *
+ * Orders the task table by priority, clears the statistics and releases every task
+ * immediately, so each one runs once on the first passes.
+ */
+void Scheduler::begin() {
+  // Insertion sort, so tasks of equal priority keep the order of the table.
+  for (uint8_t i = 1; i < this->num_tasks; i++) {
+    Task task = this->tasks[i];
+    uint8_t j = i;
+
+    while (j > 0 && this->tasks[j - 1].priority > task.priority) {
+      this->tasks[j] = this->tasks[j - 1];
+      j--;
+    }
+    this->tasks[j] = task;
+  }
+
+  unsigned long now = micros();
+  for (uint8_t i = 0; i < this->num_tasks; i++) {
+    this->statistics[i].next_release = now;
+  }
+  this->resetStatistics();
+
+  this->enabled = true;
+}
+
+/**
+ * @brief Stops the scheduler.
+ *
+ * No task is executed until the scheduler is started again.
+ */
+void Scheduler::end() {
+  this->enabled = false;
+}
+
+/**
+ * @brief Executes a single pass of the scheduler.
+ *
+ * Runs the released periodic task with the highest priority whose budget ends before the
+ * next release of any task of higher priority, followed by all background tasks. Running
+ * at most one periodic task per pass keeps the time between two passes short, so a task
+ * of high priority is never stuck behind several tasks of lower priority.
+ */
+void Scheduler::run() {
+  if (!this->enabled)
+    return;
+
+  unsigned long now = micros();
+
+  for (uint8_t i = 0; i < this->num_tasks; i++) {
+    if (this->tasks[i].period && this->isReleased(i, now) && this->fitsBeforeHigherPriority(i, now)) {
+      this->execute(i, now);
+      break;
+    }
+  }
+
+  for (uint8_t i = 0; i < this->num_tasks; i++) {
+    if (!this->tasks[i].period) {
+      this->execute(i, micros());
+    }
+  }
+}
+
+/**
+ * @brief Clears the timing statistics of all tasks.
+ */
+void Scheduler::resetStatistics() {
+  for (uint8_t i = 0; i < this->num_tasks; i++) {
+    TaskStatistics &statistics = this->statistics[i];
+    statistics.last_start = 0;
+    statistics.measured_period = 0;
+    statistics.duration = 0;
+    statistics.max_duration = 0;
+    statistics.jitter = 0;
+    statistics.max_jitter = 0;
+    statistics.runs = 0;
+    statistics.overruns = 0;
+  }
+}
+
+/**
+ * @brief Retrieves the amount of tasks in the task table.
+ *
+ * @return The amount of tasks.
+ */
+uint8_t Scheduler::getNumTasks() {
+  return this->num_tasks;
+}
+
+/**
+ * @brief Retrieves a task of the task table.
+ *
+ * The index refers to the task table ordered by priority.
+ *
+ * @param index The position of the task in the ordered task table.
+ * @return The requested task.
+ */
+const Task &Scheduler::getTask(uint8_t index) {
+  return this->tasks[constrain(index, 0, this->num_tasks - 1)];
+}
+
+/**
+ * @brief Retrieves the timing statistics of a task.
+ *
+ * @param index The position of the task in the ordered task table.
+ * @return The statistics of the requested task.
+ */
+const TaskStatistics &Scheduler::getStatistics(uint8_t index) {
+  return this->statistics[constrain(index, 0, this->num_tasks - 1)];
+}
+
+/**
+ * @brief Checks whether the release time of a task has been reached.
+ *
+ * @param index The position of the task in the ordered task table.
+ * @param now The current time in microseconds.
+ * @return True if the task is due, false otherwise.
+ */
+bool Scheduler::isReleased(uint8_t index, unsigned long now) {
+  return long(now - this->statistics[index].next_release) >= 0;
+}
+
+/**
+ * @brief Checks whether a task would finish before any task of higher priority is released.
+ *
+ * A task of higher priority that is already released but has not run yet also holds the
+ * task back, so the released task of highest priority always runs first.
+ *
+ * @param index The position of the task in the ordered task table.
+ * @param now The current time in microseconds.
+ * @return True if the task may be executed, false otherwise.
+ */
+bool Scheduler::fitsBeforeHigherPriority(uint8_t index, unsigned long now) {
+  const Task &task = this->tasks[index];
+
+  for (uint8_t i = 0; i < index; i++) {
+    const Task &higher_task = this->tasks[i];
+
+    if (higher_task.period && higher_task.priority < task.priority
+        && long(this->statistics[i].next_release - now) < long(task.budget)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief Executes a task and updates its timing statistics.
+ *
+ * The next release follows the previous one by exactly one period, so the task runs at
+ * a fixed rate without drifting. If the task finishes after its next release, an overrun
+ * is counted and the missed releases are skipped instead of being made up in a burst.
+ *
+ * @param index The position of the task in the ordered task table.
+ * @param now The time in microseconds at which the task is started.
+ */
+void Scheduler::execute(uint8_t index, unsigned long now) {
+  const Task &task = this->tasks[index];
+  TaskStatistics &statistics = this->statistics[index];
+
+  if (statistics.runs) {
+    statistics.measured_period = now - statistics.last_start;
+  }
+  statistics.last_start = now;
+
+  if (task.period) {
+    statistics.jitter = now - statistics.next_release;
+    statistics.max_jitter = max(statistics.max_jitter, statistics.jitter);
+  }
+
+  task.callback();
+
+  unsigned long finish = micros();
+  statistics.duration = finish - now;
+  statistics.max_duration = max(statistics.max_duration, statistics.duration);
+  statistics.runs++;
+
+  if (task.period) {
+    statistics.next_release += task.period;
+
+    if (long(finish - statistics.next_release) >= 0) {
+      statistics.overruns++;
+      statistics.next_release += ((finish - statistics.next_release) / task.period + 1) * task.period;
+    }
+  }
+}
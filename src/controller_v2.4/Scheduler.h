@@ -0,0 +1,91 @@
+/**
+ * @file Scheduler.h
+ * @brief Header file for the Task structure and the Scheduler class, a cooperative scheduler.
+ *
+ * The Scheduler class runs the periodic work of the main loop from a static task table. Each
+ * task has a fixed period, a priority and a time budget. Releases advance by a fixed timestep,
+ * so the work does not drift, and a task is held back if it would not finish before a task of
+ * higher priority is released. The release jitter, the measured period and missed deadlines
+ * are recorded per task. The task table only holds the configuration of the tasks, their
+ * release times and statistics are kept by the scheduler for up to SCHEDULER_MAX_TASKS tasks.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <inttypes.h>
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#define SCHEDULER_MAX_TASKS 16
+
+/**
+ * @struct Task
+ * @brief Struct to describe a task of the scheduler in the task table.
+ *
+ * A period of 0 marks a background task, which runs on every pass of the scheduler.
+ * Priorities are ordered ascending, so 0 is the highest priority. The budget is the time a
+ * single run of the task is expected to take.
+ */
+struct Task {
+  const char *name;
+  void (*callback)();
+  unsigned long period;
+  uint8_t priority;
+  unsigned long budget;
+};
+
+/**
+ * @struct TaskStatistics
+ * @brief Struct to hold the next release and the timing statistics of a task.
+ */
+struct TaskStatistics {
+  unsigned long next_release;
+  unsigned long last_start;
+  unsigned long measured_period;
+  unsigned long duration;
+  unsigned long max_duration;
+  unsigned long jitter;
+  unsigned long max_jitter;
+  uint32_t runs;
+  uint16_t overruns;
+};
+
+class Scheduler {
+public:
+  Scheduler(Task *tasks, uint8_t num_tasks);
+  template<uint8_t NUM_TASKS>
+  Scheduler(Task (&tasks)[NUM_TASKS])
+    : Scheduler(tasks, NUM_TASKS) {
+    static_assert(NUM_TASKS <= SCHEDULER_MAX_TASKS, "The task table holds more tasks than the scheduler keeps statistics for.");
+  }
+  ~Scheduler();
+
+  void begin();
+  void end();
+  void run();
+  void resetStatistics();
+  uint8_t getNumTasks();
+  const Task &getTask(uint8_t index);
+  const TaskStatistics &getStatistics(uint8_t index);
+
+private:
+  bool isReleased(uint8_t index, unsigned long now);
+  bool fitsBeforeHigherPriority(uint8_t index, unsigned long now);
+  void execute(uint8_t index, unsigned long now);
+
+  Task *tasks;
+  TaskStatistics statistics[SCHEDULER_MAX_TASKS];
+  bool enabled;
+  uint8_t num_tasks;
+};
+
+#endif  // SCHEDULER_H
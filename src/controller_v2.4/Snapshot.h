@@ -0,0 +1,110 @@
+/**
+ * @file Snapshot.h
+ * @brief Header file for the Snapshot template class, sharing a value between an interrupt and the main loop.
+ *
+ * The Snapshot class template hands a value from a single writer to any amount of readers
+ * without disabling interrupts. The value is kept in two buffers behind a sequence counter,
+ * which is raised before and after each buffer is written. The counter is odd while the first
+ * buffer is written and even while the second one is, so the buffer it points a reader to is
+ * never the one being written. A reader retries if the counter has moved on during its copy,
+ * which only happens if an interrupt has written the value in between.
+ *
+ * Either side may run in interrupt context. A reader in an interrupt finds the writer it has
+ * interrupted halfway and copies the other buffer in a single pass, and a writer in an
+ * interrupt never waits for the reader it has interrupted. The Uno R4 has a single core, whose
+ * interrupts observe its memory accesses in program order, so the counter only needs
+ * compiler barriers to keep the accesses in that order.
+ *
+ * The value has to be trivially copyable, and the writes must not overlap, so there may only
+ * be one writer, or writers that cannot interrupt each other.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <inttypes.h>
+#include <type_traits>
+
+#define SNAPSHOT_BARRIER() __atomic_signal_fence(__ATOMIC_SEQ_CST)
+
+template<typename T>
+class Snapshot {
+  static_assert(std::is_trivially_copyable<T>::value, "A Snapshot is copied byte by byte.");
+
+public:
+  Snapshot();
+  Snapshot(const T &value);
+  ~Snapshot();
+
+  void write(const T &value);
+  T read() const;
+
+private:
+  volatile uint32_t sequence;
+  T buffers[2];
+};
+
+/**
+ * @brief Constructs a new Snapshot object holding a value-initialized value.
+ */
+template<typename T>
+Snapshot<T>::Snapshot()
+  : sequence(0), buffers{ T(), T() } {}
+
+/**
+ * @brief Constructs a new Snapshot object holding an initial value.
+ *
+ * @param value The initial value.
+ */
+template<typename T>
+Snapshot<T>::Snapshot(const T &value)
+  : sequence(0), buffers{ value, value } {}
+
+/**
+ * @brief Destructs a constructed Snapshot object.
+ */
+template<typename T>
+Snapshot<T>::~Snapshot() {}
+
+/**
+ * @brief Publishes a new value, one buffer after the other.
+ *
+ * @param value The new value.
+ */
+template<typename T>
+void Snapshot<T>::write(const T &value) {
+  this->sequence = this->sequence + 1;
+  SNAPSHOT_BARRIER();
+  this->buffers[0] = value;
+  SNAPSHOT_BARRIER();
+  this->sequence = this->sequence + 1;
+  SNAPSHOT_BARRIER();
+  this->buffers[1] = value;
+  SNAPSHOT_BARRIER();
+}
+
+/**
+ * @brief Copies the latest value that has been published in full.
+ *
+ * @return The copy of the value.
+ */
+template<typename T>
+T Snapshot<T>::read() const {
+  uint32_t sequence;
+  T value;
+
+  do {
+    sequence = this->sequence;
+    SNAPSHOT_BARRIER();
+    value = this->buffers[sequence & 1];
+    SNAPSHOT_BARRIER();
+  } while (sequence != this->sequence);
+
+  return value;
+}
+
+#endif  // SNAPSHOT_H
@@ -0,0 +1,170 @@
+/**
+ * @file SonarScheduler.cpp
+ * @brief Implementation of the SonarScheduler class.
+ */
+
+#include "SonarScheduler.h"
+
+/**
+ * @brief Constructs a SonarScheduler object for the three ultrasonic sensors.
+ *
+ * @param left The ultrasonic sensor facing the left wall.
+ * @param front The ultrasonic sensor facing the front wall.
+ * @param right The ultrasonic sensor facing the right wall.
+ */
+SonarScheduler::SonarScheduler(UltrasonicSensor &left, UltrasonicSensor &front, UltrasonicSensor &right)
+  : sonars{ &left, &front, &right } {}
+
+/**
+ * @brief Destructs the SonarScheduler object.
+ */
+SonarScheduler::~SonarScheduler() {}
+
+/**
+ * @brief Initializes the scheduler.
+ *
+ * Resets the stage sequence and the refresh rate measurement. The sensors themselves
+ * have to be started with their own begin() method.
+ */
+void SonarScheduler::begin() {
+  this->priority = SonarPriority::SIDES;
+  this->stage = 0;
+  this->sides_stage = false;
+  this->stage_millis = millis();
+  this->rate_millis = millis();
+
+  for (uint8_t i = 0; i < 3; i++) {
+    this->was_updating[i] = false;
+    this->measurements[i] = 0;
+    this->refresh_rates[i] = 0;
+  }
+
+  this->enabled = true;
+}
+
+/**
+ * @brief Stops the scheduler.
+ *
+ * No further measurements are started until the scheduler is enabled again.
+ */
+void SonarScheduler::end() {
+  this->enabled = false;
+}
+
+/**
+ * @brief Progresses the measurements and fires the next stage when it is due.
+ *
+ * Updates all sensors, counts their completed measurements and starts the next stage once
+ * every sensor of the current stage has finished and the stage interval has passed. The
+ * interval lets the echoes of the previous stage fade out before the next sensor fires.
+ * This method is meant to be called on every pass of the main loop.
+ */
+void SonarScheduler::update() {
+  if (!this->enabled)
+    return;
+
+  for (uint8_t i = 0; i < 3; i++) {
+    this->sonars[i]->update();
+
+    bool is_updating = this->sonars[i]->isUpdating();
+    if (this->was_updating[i] && !is_updating && this->measurements[i] < UINT8_MAX) {
+      this->measurements[i]++;
+    }
+    this->was_updating[i] = is_updating;
+  }
+
+  if (this->stageCompleted() && millis() - this->stage_millis >= SONAR_STAGE_INTERVAL) {
+    this->fireStage();
+  }
+
+  this->measureRefreshRates();
+}
+
+/**
+ * @brief Sets which sensors are fired more often.
+ *
+ * The new priority takes effect with the next stage, the running stage is not interrupted.
+ *
+ * @param priority The sensors that the current driving layer relies on.
+ */
+void SonarScheduler::setPriority(SonarPriority priority) {
+  if (!this->enabled)
+    return;
+
+  this->priority = priority;
+}
+
+/**
+ * @brief Retrieves the current firing priority.
+ *
+ * @return The sensors that are currently fired more often.
+ */
+SonarPriority SonarScheduler::getPriority() {
+  return this->priority;
+}
+
+/**
+ * @brief Retrieves the effective refresh rate of a sensor.
+ *
+ * The rate is the amount of completed measurements within the last measuring window,
+ * including measurements that ended with a timeout.
+ *
+ * @param sonar The sensor whose refresh rate is requested.
+ * @return The refresh rate in Hertz.
+ */
+uint8_t SonarScheduler::readRefreshRate(Sonar sonar) {
+  if (!this->enabled)
+    return 0;
+
+  return this->refresh_rates[uint8_t(sonar)];
+}
+
+/**
+ * @brief Checks whether every sensor of the current stage has finished its measurement.
+ *
+ * @return True if the next stage may be fired, false otherwise.
+ */
+bool SonarScheduler::stageCompleted() {
+  if (this->sides_stage) {
+    return !this->sonars[uint8_t(Sonar::LEFT)]->isUpdating() && !this->sonars[uint8_t(Sonar::RIGHT)]->isUpdating();
+  } else {
+    return !this->sonars[uint8_t(Sonar::FRONT)]->isUpdating();
+  }
+}
+
+/**
+ * @brief Fires the sensors of the next stage.
+ *
+ * Out of three stages, two belong to the prioritized sensors. The left and the right
+ * sensor face away from each other and are therefore always fired together.
+ */
+void SonarScheduler::fireStage() {
+  this->stage = (this->stage + 1) % 3;
+  this->stage_millis = millis();
+
+  bool prioritized_stage = (this->stage != 2);
+  this->sides_stage = (this->priority == SonarPriority::SIDES) ? prioritized_stage : !prioritized_stage;
+
+  if (this->sides_stage) {
+    this->sonars[uint8_t(Sonar::LEFT)]->startMeasurement();
+    this->sonars[uint8_t(Sonar::RIGHT)]->startMeasurement();
+  } else {
+    this->sonars[uint8_t(Sonar::FRONT)]->startMeasurement();
+  }
+}
+
+/**
+ * @brief Converts the counted measurements into refresh rates once per measuring window.
+ */
+void SonarScheduler::measureRefreshRates() {
+  unsigned long elapsed = millis() - this->rate_millis;
+
+  if (elapsed >= SONAR_RATE_WINDOW) {
+    this->rate_millis = millis();
+
+    for (uint8_t i = 0; i < 3; i++) {
+      this->refresh_rates[i] = (uint16_t(this->measurements[i]) * 1000) / elapsed;
+      this->measurements[i] = 0;
+    }
+  }
+}
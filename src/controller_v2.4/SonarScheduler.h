@@ -0,0 +1,82 @@
+/**
+ * @file SonarScheduler.h
+ * @brief Header file for the SonarScheduler class, firing the ultrasonic sensors in stages.
+ *
+ * The SonarScheduler class replaces the round-robin triggering of the ultrasonic sensors.
+ * Sensors whose beams do not overlap, the left and the right sonar, are fired together in
+ * one stage, while the front sonar gets a stage of its own. The order of the stages follows
+ * a priority, so the sensors that the current driving layer relies on are refreshed more
+ * often. The effective refresh rate of each sensor is measured and can be read back.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef SONARSCHEDULER_H
+#define SONARSCHEDULER_H
+
+#include <inttypes.h>
+#include "UltrasonicSensor.h"
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#define SONAR_STAGE_INTERVAL 25
+#define SONAR_RATE_WINDOW 1000
+
+/**
+ * @enum Sonar
+ * @brief Enumerates the ultrasonic sensors handled by the scheduler.
+ */
+enum class Sonar : uint8_t {
+  LEFT,
+  FRONT,
+  RIGHT
+};
+
+/**
+ * @enum SonarPriority
+ * @brief Enumerates which sensors are preferred when planning the firing stages.
+ *
+ * SIDES fires the side sensors in two out of three stages, FRONT fires the front sensor
+ * in two out of three stages.
+ */
+enum class SonarPriority : uint8_t {
+  SIDES,
+  FRONT
+};
+
+class SonarScheduler {
+public:
+  SonarScheduler(UltrasonicSensor &left, UltrasonicSensor &front, UltrasonicSensor &right);
+  ~SonarScheduler();
+
+  void begin();
+  void end();
+  void update();
+  void setPriority(SonarPriority priority);
+  SonarPriority getPriority();
+  uint8_t readRefreshRate(Sonar sonar);
+
+private:
+  bool stageCompleted();
+  void fireStage();
+  void measureRefreshRates();
+
+  UltrasonicSensor *sonars[3];
+  SonarPriority priority;
+  bool enabled;
+  bool sides_stage;
+  bool was_updating[3];
+  uint8_t stage;
+  uint8_t measurements[3];
+  uint8_t refresh_rates[3];
+  unsigned long stage_millis;
+  unsigned long rate_millis;
+};
+
+#endif  // SONARSCHEDULER_H
@@ -0,0 +1,402 @@
+/**
+ * @file StateMachine.h
+ * @brief Header file for the StateMachine template class, a table-driven hierarchical state machine.
+ *
+ * The StateMachine class template runs a hierarchy of states described by two static tables.
+ * The state table holds the parent of every state, the substate entered along with it, an
+ * optional timeout and the entry, update and exit actions. The transition table maps an event
+ * received in a state to a target state and an optional action. A state inherits the
+ * transitions of its ancestors unless it defines its own for the same event. Both tables are
+ * resolved into a lookup table by begin(), so an event is dispatched with a single access,
+ * however deep the hierarchy is.
+ *
+ * A transition exits the active states from the innermost one up to the closest ancestor that
+ * contains the target, runs its action, and enters the states down to the target and its
+ * initial substates. Transitions are external, so a state transitioning to itself is exited
+ * and entered again. Every state keeps the time it has been entered at, which replaces the
+ * timers of the states, and a state with a timeout dispatches its timeout event once it has
+ * been active for that long.
+ *
+ * The states and the events are enumerations counting from 0 and ending with NONE, which
+ * doubles as the amount of states or events.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef STATE_MACHINE_H
+#define STATE_MACHINE_H
+
+#include <inttypes.h>
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#define STATE_MACHINE_MAX_DEPTH 8
+#define STATE_MACHINE_NO_TRANSITION 0xFF
+
+template<typename S, typename E>
+class StateMachine {
+public:
+  static constexpr uint8_t NUM_STATES = uint8_t(S::NONE);
+  static constexpr uint8_t NUM_EVENTS = uint8_t(E::NONE);
+
+  /**
+   * @struct State
+   * @brief Struct to describe a state of the machine in the state table.
+   *
+   * The state table is indexed by the states, so every state has to be listed at its own
+   * position. Any of the actions may be a nullptr. The update action of a state runs before
+   * the ones of its substates and returns true if it has handled the cycle, in which case
+   * the substates are not updated.
+   */
+  struct State {
+    const char *name;
+    S parent;         // NONE for the root state.
+    S initial;        // Substate entered along with the state, NONE for a leaf.
+    uint16_t timeout;  // Time in ms after which the timeout event is dispatched, 0 for none.
+    E timeout_event;
+    void (*entry)();
+    bool (*update)();
+    void (*exit)();
+  };
+
+  /**
+   * @struct Transition
+   * @brief Struct to describe a transition of the machine in the transition table.
+   */
+  struct Transition {
+    S source;
+    E event;
+    S target;
+    void (*action)();
+  };
+
+  StateMachine(const State *states, const Transition *transitions, uint8_t num_transitions);
+  template<uint8_t NUM_TRANSITIONS>
+  StateMachine(const State (&states)[NUM_STATES], const Transition (&transitions)[NUM_TRANSITIONS])
+    : StateMachine(states, transitions, NUM_TRANSITIONS) {}
+  ~StateMachine();
+
+  void begin(S initial);
+  void end();
+  void update();
+  bool dispatch(E event);
+  bool isIn(S state);
+  S getState();
+  E getLastEvent();
+  const char *getName(S state);
+  unsigned long readElapsedTime();
+  unsigned long readElapsedTime(S state);
+
+private:
+  uint8_t findTransition(uint8_t state, uint8_t event);
+  uint8_t readParent(uint8_t state);
+  bool contains(uint8_t ancestor, uint8_t state);
+  void transition(const Transition &transition);
+  void enter(uint8_t state);
+
+  const State *states;
+  const Transition *transitions;
+  uint8_t num_transitions;
+  uint8_t lookup[NUM_STATES][NUM_EVENTS];
+  unsigned long entry_millis[NUM_STATES];
+  bool enabled;
+  bool transitioning;
+  bool changed;
+  uint8_t state;
+  E last_event;
+};
+
+/**
+ * @brief Constructs a new StateMachine object from its tables.
+ *
+ * @param states The state table, indexed by the states.
+ * @param transitions The transition table.
+ * @param num_transitions The amount of transitions.
+ */
+template<typename S, typename E>
+StateMachine<S, E>::StateMachine(const State *states, const Transition *transitions, uint8_t num_transitions)
+  : states(states), transitions(transitions), num_transitions(num_transitions), enabled(false),
+    transitioning(false), changed(false), state(NUM_STATES), last_event(E::NONE) {}
+
+/**
+ * @brief Destructs a constructed StateMachine object.
+ */
+template<typename S, typename E>
+StateMachine<S, E>::~StateMachine() {}
+
+/**
+ * @brief Resolves the transitions of every state and enters the initial state.
+ *
+ * The entry actions are run from the initial state down to its innermost initial substate.
+ *
+ * @param initial The state to start in, typically the root state.
+ */
+template<typename S, typename E>
+void StateMachine<S, E>::begin(S initial) {
+  for (uint8_t state = 0; state < NUM_STATES; state++) {
+    for (uint8_t event = 0; event < NUM_EVENTS; event++) {
+      uint8_t index = STATE_MACHINE_NO_TRANSITION;
+      for (uint8_t source = state; source < NUM_STATES && index == STATE_MACHINE_NO_TRANSITION; source = this->readParent(source)) {
+        index = this->findTransition(source, event);
+      }
+      this->lookup[state][event] = index;
+    }
+  }
+
+  this->enabled = true;
+  this->transitioning = true;
+  this->state = NUM_STATES;
+  this->last_event = E::NONE;
+  this->enter(uint8_t(initial));
+  this->transitioning = false;
+}
+
+/**
+ * @brief Stops the machine without running any exit action.
+ */
+template<typename S, typename E>
+void StateMachine<S, E>::end() {
+  this->enabled = false;
+}
+
+/**
+ * @brief Runs one cycle of the active states.
+ *
+ * The active states are visited from the outermost to the innermost one. A state whose
+ * timeout has passed dispatches its timeout event, otherwise its update action is run. The
+ * cycle ends early once it has been handled or a transition has been taken.
+ */
+template<typename S, typename E>
+void StateMachine<S, E>::update() {
+  if (!this->enabled)
+    return;
+
+  uint8_t path[STATE_MACHINE_MAX_DEPTH];
+  uint8_t depth = 0;
+  for (uint8_t state = this->state; state < NUM_STATES && depth < STATE_MACHINE_MAX_DEPTH; state = this->readParent(state)) {
+    path[depth++] = state;
+  }
+
+  unsigned long now = millis();
+  this->changed = false;
+  while (depth--) {
+    const State &active = this->states[path[depth]];
+    if (active.timeout && now - this->entry_millis[path[depth]] >= active.timeout) {
+      this->dispatch(active.timeout_event);
+    } else if (active.update && active.update()) {
+      return;
+    }
+
+    if (this->changed)
+      return;
+  }
+}
+
+/**
+ * @brief Dispatches an event to the active state.
+ *
+ * Events dispatched while a transition is being taken, such as from an entry action, are
+ * ignored.
+ *
+ * @param event The event.
+ * @return True if the event has caused a transition, false otherwise.
+ */
+template<typename S, typename E>
+bool StateMachine<S, E>::dispatch(E event) {
+  if (!this->enabled || this->transitioning)
+    return false;
+
+  uint8_t index = this->lookup[this->state][uint8_t(event)];
+  if (index == STATE_MACHINE_NO_TRANSITION)
+    return false;
+
+  this->last_event = event;
+  this->transition(this->transitions[index]);
+  return true;
+}
+
+/**
+ * @brief Checks whether a state is active, either as the innermost state or as one of its ancestors.
+ *
+ * @param state The state.
+ * @return True if the state is active, false otherwise.
+ */
+template<typename S, typename E>
+bool StateMachine<S, E>::isIn(S state) {
+  if (!this->enabled)
+    return false;
+
+  return this->state == uint8_t(state) || this->contains(uint8_t(state), this->state);
+}
+
+/**
+ * @brief Reads the innermost active state.
+ *
+ * @return The state, NONE before the machine has begun.
+ */
+template<typename S, typename E>
+S StateMachine<S, E>::getState() {
+  if (!this->enabled)
+    return S::NONE;
+
+  return S(this->state);
+}
+
+/**
+ * @brief Reads the event that has caused the last transition.
+ *
+ * @return The event, NONE if no transition has been taken since the machine has begun.
+ */
+template<typename S, typename E>
+E StateMachine<S, E>::getLastEvent() {
+  return this->last_event;
+}
+
+/**
+ * @brief Reads the name of a state, as given in the state table.
+ *
+ * @param state The state.
+ * @return The name of the state, an empty string for NONE.
+ */
+template<typename S, typename E>
+const char *StateMachine<S, E>::getName(S state) {
+  return (uint8_t(state) < NUM_STATES) ? this->states[uint8_t(state)].name : "";
+}
+
+/**
+ * @brief Reads the time spent in the innermost active state.
+ *
+ * @return The time in milliseconds.
+ */
+template<typename S, typename E>
+unsigned long StateMachine<S, E>::readElapsedTime() {
+  if (!this->enabled)
+    return 0;
+
+  return millis() - this->entry_millis[this->state];
+}
+
+/**
+ * @brief Reads the time spent in a state since it has been entered.
+ *
+ * @param state The state.
+ * @return The time in milliseconds, 0 if the state is not active.
+ */
+template<typename S, typename E>
+unsigned long StateMachine<S, E>::readElapsedTime(S state) {
+  if (!this->isIn(state))
+    return 0;
+
+  return millis() - this->entry_millis[uint8_t(state)];
+}
+
+/**
+ * @brief Searches the transition table for a transition defined by a state itself.
+ *
+ * @param state The index of the state.
+ * @param event The index of the event.
+ * @return The index of the transition, STATE_MACHINE_NO_TRANSITION if there is none.
+ */
+template<typename S, typename E>
+uint8_t StateMachine<S, E>::findTransition(uint8_t state, uint8_t event) {
+  for (uint8_t i = 0; i < this->num_transitions; i++) {
+    if (uint8_t(this->transitions[i].source) == state && uint8_t(this->transitions[i].event) == event)
+      return i;
+  }
+
+  return STATE_MACHINE_NO_TRANSITION;
+}
+
+/**
+ * @brief Reads the parent of a state.
+ *
+ * @param state The index of the state.
+ * @return The index of the parent, NUM_STATES for the root state.
+ */
+template<typename S, typename E>
+uint8_t StateMachine<S, E>::readParent(uint8_t state) {
+  return uint8_t(this->states[state].parent);
+}
+
+/**
+ * @brief Checks whether a state is nested within another one.
+ *
+ * @param ancestor The index of the enclosing state.
+ * @param state The index of the nested state.
+ * @return True if the ancestor is a parent of the state, or a parent of its parents.
+ */
+template<typename S, typename E>
+bool StateMachine<S, E>::contains(uint8_t ancestor, uint8_t state) {
+  if (state >= NUM_STATES)
+    return false;
+
+  for (uint8_t parent = this->readParent(state); parent < NUM_STATES; parent = this->readParent(parent)) {
+    if (parent == ancestor)
+      return true;
+  }
+
+  return false;
+}
+
+/**
+ * @brief Takes a transition from the innermost active state.
+ *
+ * @param transition The transition.
+ */
+template<typename S, typename E>
+void StateMachine<S, E>::transition(const Transition &transition) {
+  uint8_t target = uint8_t(transition.target);
+
+  this->transitioning = true;
+  this->changed = true;
+
+  // Exit the active states that do not contain the target, including the target itself.
+  while (this->state < NUM_STATES && !this->contains(this->state, target)) {
+    if (this->states[this->state].exit) this->states[this->state].exit();
+    this->state = this->readParent(this->state);
+  }
+
+  if (transition.action) transition.action();
+
+  this->enter(target);
+  this->transitioning = false;
+}
+
+/**
+ * @brief Enters the states below the innermost active state down to a target.
+ *
+ * Continues with the initial substates of the target until a leaf is active.
+ *
+ * @param target The index of the target, nested within the innermost active state.
+ */
+template<typename S, typename E>
+void StateMachine<S, E>::enter(uint8_t target) {
+  uint8_t path[STATE_MACHINE_MAX_DEPTH];
+  uint8_t depth = 0;
+  for (uint8_t state = target; state < NUM_STATES && state != this->state && depth < STATE_MACHINE_MAX_DEPTH; state = this->readParent(state)) {
+    path[depth++] = state;
+  }
+
+  unsigned long now = millis();
+  while (true) {
+    while (depth--) {
+      this->state = path[depth];
+      this->entry_millis[this->state] = now;
+      if (this->states[this->state].entry) this->states[this->state].entry();
+    }
+
+    uint8_t initial = uint8_t(this->states[this->state].initial);
+    if (initial >= NUM_STATES)
+      break;
+    path[0] = initial;
+    depth = 1;
+  }
+}
+
+#endif  // STATE_MACHINE_H
@@ -0,0 +1,193 @@
+/**
+ * @file SteeringServo.cpp
+ * @brief Implementation of the SteeringServo class.
+ */
+
+#include "SteeringServo.h"
+
+/**
+ * @brief Constructs a SteeringServo object on a pin with a GPT timer channel.
+ *
+ * The pulse range defaults to the one of the Servo library, so angles keep their meaning.
+ *
+ * @param pin The pin the signal line of the servo is connected to.
+ */
+SteeringServo::SteeringServo(pin_size_t pin)
+  : pwm(pin), enabled(false), timer_running(false), has_angle(false), setpoint_angle(0), angle(0),
+    update_rate(SERVO_DEFAULT_UPDATE_RATE), slew_rate(SERVO_DEFAULT_SLEW_RATE), min_pulse(SERVO_MIN_PULSE),
+    max_pulse(SERVO_MAX_PULSE), pulse_width(0), last_micros(0) {}
+
+/**
+ * @brief Destructs the SteeringServo object.
+ */
+SteeringServo::~SteeringServo() {}
+
+/**
+ * @brief Starts the PWM signal and the timer of the slew limiter.
+ *
+ * No pulse is sent until the first angle is written, which the servo then takes right away.
+ * If no free timer is available, the slew limiter is advanced by write() instead.
+ *
+ * @param update_rate The rate of the pulses in Hz, up to SERVO_MAX_UPDATE_RATE. Analog servos
+ * need 50 Hz, digital servos follow faster rates.
+ * @return True if the PWM signal has been started, false otherwise.
+ */
+bool SteeringServo::begin(uint16_t update_rate) {
+  this->update_rate = constrain(update_rate, uint16_t(1), uint16_t(SERVO_MAX_UPDATE_RATE));
+  this->has_angle = false;
+  this->pulse_width = 0;
+
+  if (!this->pwm.begin(uint32_t(1000000 / this->update_rate), uint32_t(0)))
+    return false;
+  this->enabled = true;
+
+  uint8_t timer_type;
+  int8_t timer_channel = FspTimer::get_available_timer(timer_type);
+  this->timer_running = timer_channel >= 0
+                        && this->slewTimer.begin(TIMER_MODE_PERIODIC, timer_type, timer_channel,
+                                                 float(this->update_rate), 0.0f, SteeringServo::onTimer, this)
+                        && this->slewTimer.setup_overflow_irq()
+                        && this->slewTimer.open()
+                        && this->slewTimer.start();
+
+  return true;
+}
+
+/**
+ * @brief Stops the timer and the PWM signal, which releases the servo.
+ */
+void SteeringServo::end() {
+  if (this->timer_running) {
+    this->slewTimer.stop();
+    this->slewTimer.end();
+    this->timer_running = false;
+  }
+  this->pwm.end();
+  this->enabled = false;
+}
+
+/**
+ * @brief Sets the angle the servo moves to.
+ *
+ * The servo moves towards the angle at the configured slew rate. The call returns right away,
+ * the slew limiter is advanced by the timer.
+ *
+ * @param angle The angle in degrees, ranging from 0 to 180, with fractions of a degree.
+ */
+void SteeringServo::write(ServoAngle angle) {
+  if (!this->enabled)
+    return;
+
+  int32_t setpoint = (constrain(angle, ServoAngle(0), ServoAngle(180)) * 100).round();
+
+  // Keep the timer from advancing the slew limiter in between.
+  noInterrupts();
+  this->setpoint_angle = setpoint;
+  if (!this->has_angle) {
+    this->angle = setpoint;
+    this->has_angle = true;
+    this->transfer();
+  }
+  interrupts();
+
+  // Advance the slew limiter from here if no timer could be started.
+  if (!this->timer_running && micros() - this->last_micros >= 1000000UL / this->update_rate) {
+    this->last_micros = micros();
+    this->update();
+  }
+}
+
+/**
+ * @brief Sets the maximum rate at which the servo turns.
+ *
+ * @param slew_rate The slew rate in degrees per second, 0 for an instantaneous change.
+ */
+void SteeringServo::setSlewRate(uint16_t slew_rate) {
+  if (!this->enabled)
+    return;
+
+  this->slew_rate = slew_rate;
+}
+
+/**
+ * @brief Sets the pulse widths that correspond to 0 and 180 degrees.
+ *
+ * @param min_pulse The pulse width at 0 degrees in microseconds.
+ * @param max_pulse The pulse width at 180 degrees in microseconds.
+ */
+void SteeringServo::setPulseRange(uint16_t min_pulse, uint16_t max_pulse) {
+  if (!this->enabled || min_pulse >= max_pulse)
+    return;
+
+  noInterrupts();
+  this->min_pulse = min_pulse;
+  this->max_pulse = max_pulse;
+  if (this->has_angle) this->transfer();
+  interrupts();
+}
+
+/**
+ * @brief Advances the slew limiter by one pulse and transfers the angle to the PWM signal.
+ *
+ * Called by the timer at the update rate, so the angle changes by at most the slew rate
+ * divided by the update rate per pulse.
+ */
+void SteeringServo::update() {
+  if (!this->enabled || !this->has_angle)
+    return;
+
+  int32_t setpoint = this->setpoint_angle;
+  int32_t step = int32_t(this->slew_rate) * 100 / this->update_rate;
+  if (!step)
+    step = 18000;
+
+  this->angle = constrain(setpoint, this->angle - step, this->angle + step);
+  this->transfer();
+}
+
+/**
+ * @brief Reads the angle the servo is moving through.
+ *
+ * @return The angle of the slew limiter in degrees, which lags behind the written angle.
+ */
+float SteeringServo::read() {
+  if (!this->enabled)
+    return 0;
+
+  return this->angle / 100.0f;
+}
+
+/**
+ * @brief Reads the width of the pulses that are currently sent.
+ *
+ * @return The pulse width in microseconds, or 0 before the first angle has been written.
+ */
+uint16_t SteeringServo::readPulseWidth() {
+  if (!this->enabled)
+    return 0;
+
+  return this->pulse_width;
+}
+
+/**
+ * @brief Forwards the interrupt of the slew timer to its servo.
+ *
+ * @param args The arguments of the timer callback, holding the servo as context.
+ */
+void SteeringServo::onTimer(timer_callback_args_t *args) {
+  static_cast<SteeringServo *>(const_cast<void *>(args->p_context))->update();
+}
+
+/**
+ * @brief Transfers the angle of the slew limiter to the PWM signal.
+ *
+ * Only writes the pulse width if it has changed, in steps of one microsecond.
+ */
+void SteeringServo::transfer() {
+  uint16_t pulse_width = this->min_pulse + (int32_t(this->angle) * (this->max_pulse - this->min_pulse) + 9000) / 18000;
+  if (pulse_width == this->pulse_width)
+    return;
+  this->pulse_width = pulse_width;
+
+  this->pwm.pulseWidth_us(pulse_width);
+}
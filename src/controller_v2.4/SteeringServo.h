@@ -0,0 +1,81 @@
+/**
+ * @file SteeringServo.h
+ * @brief Header file for the SteeringServo class, driving the steering servo with hardware PWM.
+ *
+ * The SteeringServo class generates the control pulses of the steering servo with a GPT timer of
+ * the RA4M1 instead of the Servo library. The pulse width is set in steps of one microsecond,
+ * which resolves about a tenth of a degree, and the update rate can be raised from the 50 Hz of
+ * analog servos up to SERVO_MAX_UPDATE_RATE for digital servos. A slew limiter moves the servo
+ * towards the written angle at a maximum rate in degrees per second, so small alternating
+ * corrections of the steering controllers are smoothed out instead of jerking the steering.
+ * The limiter is advanced by a hardware timer at the update rate, one step per pulse. Angles are
+ * written as ServoAngle fixed-point numbers, so whole degrees of the controllers are converted
+ * without a floating-point instruction.
+ *
+ * The pin of the servo has to be connected to a channel of a GPT timer.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef STEERINGSERVO_H
+#define STEERINGSERVO_H
+
+#include <inttypes.h>
+#include "Fixed.h"
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#if defined(ARDUINO_ARCH_RENESAS)
+#include "pwm.h"
+#include "FspTimer.h"
+#endif
+
+#define SERVO_DEFAULT_UPDATE_RATE 50
+#define SERVO_MAX_UPDATE_RATE 333
+#define SERVO_DEFAULT_SLEW_RATE 400
+#define SERVO_MIN_PULSE 544
+#define SERVO_MAX_PULSE 2400
+#define SERVO_ANGLE_BITS 8
+
+typedef Fixed<SERVO_ANGLE_BITS> ServoAngle;
+
+class SteeringServo {
+public:
+  SteeringServo(pin_size_t pin);
+  ~SteeringServo();
+
+  bool begin(uint16_t update_rate = SERVO_DEFAULT_UPDATE_RATE);
+  void end();
+  void write(ServoAngle angle);
+  void setSlewRate(uint16_t slew_rate);
+  void setPulseRange(uint16_t min_pulse, uint16_t max_pulse);
+  void update();
+  float read();
+  uint16_t readPulseWidth();
+
+private:
+  static void onTimer(timer_callback_args_t *args);
+  void transfer();
+
+  PwmOut pwm;
+  FspTimer slewTimer;
+  bool enabled;
+  bool timer_running;
+  bool has_angle;
+  volatile int32_t setpoint_angle;
+  volatile int32_t angle;
+  uint16_t update_rate;
+  uint16_t slew_rate;
+  uint16_t min_pulse;
+  uint16_t max_pulse;
+  uint16_t pulse_width;
+  unsigned long last_micros;
+};
+
+#endif  // STEERINGSERVO_H
@@ -0,0 +1,145 @@
+/**
+ * @file Storage.h
+ * @brief Header file for the Storage template class, persisting a record in the EEPROM.
+ *
+ * The Storage class template keeps one record of a fixed type in the EEPROM, which the Uno R4
+ * emulates in its data flash. The record is preceded by a header with a magic number, the
+ * version of the layout, the size of the record and a CRC-16 checksum over the record. A
+ * record is only loaded if all of them match, so an erased EEPROM, a record of an older
+ * firmware or a write interrupted by a power loss are all rejected instead of being used.
+ *
+ * A record is saved byte by byte and only the bytes that differ from the EEPROM are written,
+ * which keeps the wear of the data flash and the time spent writing low.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <inttypes.h>
+#include <EEPROM.h>
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "Telemetry.h"
+
+#define STORAGE_MAGIC 0x4B4D
+
+/**
+ * @struct StorageHeader
+ * @brief Struct to hold the header that precedes a record in the EEPROM.
+ */
+struct __attribute__((packed)) StorageHeader {
+  uint16_t magic;
+  uint8_t version;  // Version of the layout of the record, to be raised on every change.
+  uint16_t length;  // Size of the record in bytes.
+  uint16_t crc;
+};
+
+template<typename T>
+class Storage {
+public:
+  Storage(uint16_t address, uint8_t version);
+  ~Storage();
+
+  bool load(T &record);
+  void save(const T &record);
+  void erase();
+
+private:
+  void writeBytes(uint16_t address, const uint8_t *data, size_t length);
+
+  uint16_t address;
+  uint8_t version;
+};
+
+/**
+ * @brief Constructs a new Storage object.
+ *
+ * @param address The address of the header in the EEPROM.
+ * @param version The version of the layout of the record.
+ */
+template<typename T>
+Storage<T>::Storage(uint16_t address, uint8_t version)
+  : address(address), version(version) {}
+
+/**
+ * @brief Destructs a constructed Storage object.
+ */
+template<typename T>
+Storage<T>::~Storage() {}
+
+/**
+ * @brief Loads the record from the EEPROM.
+ *
+ * The record is left untouched if no valid record is stored.
+ *
+ * @param record The record to load into.
+ * @return True if a valid record has been loaded, false otherwise.
+ */
+template<typename T>
+bool Storage<T>::load(T &record) {
+  StorageHeader header;
+  EEPROM.get(this->address, header);
+
+  if (header.magic != STORAGE_MAGIC || header.version != this->version || header.length != sizeof(T))
+    return false;
+
+  T stored_record;
+  EEPROM.get(this->address + sizeof(StorageHeader), stored_record);
+
+  if (Telemetry::crc16(reinterpret_cast<const uint8_t *>(&stored_record), sizeof(T)) != header.crc)
+    return false;
+
+  record = stored_record;
+  return true;
+}
+
+/**
+ * @brief Saves the record to the EEPROM.
+ *
+ * The record is written before its header, so a power loss while saving leaves a checksum
+ * that does not match and the record is rejected on the next load.
+ *
+ * @param record The record to save.
+ */
+template<typename T>
+void Storage<T>::save(const T &record) {
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(&record);
+  StorageHeader header = { STORAGE_MAGIC, this->version, sizeof(T), Telemetry::crc16(data, sizeof(T)) };
+
+  this->writeBytes(this->address + sizeof(StorageHeader), data, sizeof(T));
+  this->writeBytes(this->address, reinterpret_cast<const uint8_t *>(&header), sizeof(StorageHeader));
+}
+
+/**
+ * @brief Invalidates the stored record, so the next load fails.
+ */
+template<typename T>
+void Storage<T>::erase() {
+  const uint16_t erased_magic = ~STORAGE_MAGIC;
+  this->writeBytes(this->address, reinterpret_cast<const uint8_t *>(&erased_magic), sizeof(erased_magic));
+}
+
+/**
+ * @brief Writes the bytes that differ from the content of the EEPROM.
+ *
+ * @param address The address of the first byte in the EEPROM.
+ * @param data The bytes to write.
+ * @param length The amount of bytes to write.
+ */
+template<typename T>
+void Storage<T>::writeBytes(uint16_t address, const uint8_t *data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    EEPROM.update(address + i, data[i]);
+  }
+}
+
+#endif  // STORAGE_H
@@ -0,0 +1,172 @@
+/**
+ * @file Telemetry.cpp
+ * @brief Implementation of the Telemetry class.
+ */
+
+#include "Telemetry.h"
+
+/**
+ * @brief Constructs a Telemetry object for a serial port.
+ *
+ * @param port The port the frames are written to, which has to be started by the caller.
+ */
+Telemetry::Telemetry(Print &port)
+  : port(port), enabled(false), head(0), tail(0), sequence(0), dropped_frames(0) {}
+
+/**
+ * @brief Destructs the Telemetry object.
+ */
+Telemetry::~Telemetry() {}
+
+/**
+ * @brief Starts the telemetry stream with an empty buffer.
+ */
+void Telemetry::begin() {
+  this->head = 0;
+  this->tail = 0;
+  this->sequence = 0;
+  this->dropped_frames = 0;
+  this->enabled = true;
+}
+
+/**
+ * @brief Stops the telemetry stream.
+ *
+ * Frames that are still queued are discarded.
+ */
+void Telemetry::end() {
+  this->head = this->tail;
+  this->enabled = false;
+}
+
+/**
+ * @brief Packs a payload into a frame and queues it for transmission.
+ *
+ * The frame is only queued as a whole. If the buffer does not have enough room left, the
+ * frame is dropped, so the host never receives a truncated frame.
+ *
+ * @param type The type of the payload, which tells the host how to decode it.
+ * @param payload The payload to send.
+ * @param length The size of the payload in bytes.
+ * @return True if the frame has been queued, false if it has been dropped.
+ */
+bool Telemetry::send(uint8_t type, const void *payload, uint8_t length) {
+  if (!this->enabled)
+    return false;
+
+  if (this->readFreeSpace() < TELEMETRY_HEADER_SIZE + length + TELEMETRY_CRC_SIZE) {
+    // Skip the sequence number as well, so the host notices the gap.
+    this->dropped_frames++;
+    this->sequence++;
+    return false;
+  }
+
+  const uint8_t header[TELEMETRY_HEADER_SIZE] = {
+    TELEMETRY_SYNC_1, TELEMETRY_SYNC_2, type, length, uint8_t(this->sequence), uint8_t(this->sequence >> 8)
+  };
+  const uint8_t *data = static_cast<const uint8_t *>(payload);
+
+  // The checksum covers everything but the sync bytes.
+  uint16_t crc = crc16(header + 2, TELEMETRY_HEADER_SIZE - 2);
+  crc = crc16(data, length, crc);
+
+  for (uint8_t i = 0; i < TELEMETRY_HEADER_SIZE; i++) {
+    this->push(header[i]);
+  }
+  for (uint8_t i = 0; i < length; i++) {
+    this->push(data[i]);
+  }
+  this->push(crc);
+  this->push(crc >> 8);
+
+  this->sequence++;
+  return true;
+}
+
+/**
+ * @brief Transfers queued bytes into the transmit buffer of the serial port.
+ *
+ * Only writes as many bytes as the port accepts without blocking. Meant to be called on
+ * every pass of the main loop.
+ */
+void Telemetry::flush() {
+  if (!this->enabled)
+    return;
+
+  int available = this->port.availableForWrite();
+
+  while (available > 0 && this->tail != this->head) {
+    // Write the contiguous part of the queue up to the end of the buffer in one go.
+    uint16_t end = (this->head > this->tail) ? this->head : TELEMETRY_BUFFER_SIZE;
+    uint16_t length = min(uint16_t(end - this->tail), uint16_t(available));
+
+    size_t written = this->port.write(this->buffer + this->tail, length);
+    if (!written)
+      break;
+
+    this->tail = (this->tail + written) % TELEMETRY_BUFFER_SIZE;
+    available -= written;
+  }
+}
+
+/**
+ * @brief Retrieves the sequence number of the next frame.
+ *
+ * @return The sequence number, which wraps around after 65535.
+ */
+uint16_t Telemetry::getSequence() {
+  return this->sequence;
+}
+
+/**
+ * @brief Retrieves the amount of frames dropped due to a full buffer.
+ *
+ * @return The amount of dropped frames since the stream was started.
+ */
+uint16_t Telemetry::getDroppedFrames() {
+  return this->dropped_frames;
+}
+
+/**
+ * @brief Calculates the CRC-16/CCITT-FALSE checksum of a block of data.
+ *
+ * Passing the result of a previous call as the initial value continues the checksum over
+ * several blocks.
+ *
+ * @param data The data to calculate the checksum of.
+ * @param length The size of the data in bytes.
+ * @param crc The initial value of the checksum.
+ * @return The checksum of the data.
+ */
+uint16_t Telemetry::crc16(const uint8_t *data, size_t length, uint16_t crc) {
+  for (size_t i = 0; i < length; i++) {
+    crc ^= uint16_t(data[i]) << 8;
+
+    for (uint8_t j = 0; j < 8; j++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+
+  return crc;
+}
+
+/**
+ * @brief Appends a single byte to the queue.
+ *
+ * @param byte The byte to append.
+ */
+void Telemetry::push(uint8_t byte) {
+  this->buffer[this->head] = byte;
+  this->head = (this->head + 1) % TELEMETRY_BUFFER_SIZE;
+}
+
+/**
+ * @brief Calculates the amount of bytes that can still be queued.
+ *
+ * One byte always stays unused to tell a full buffer from an empty one.
+ *
+ * @return The free space of the buffer in bytes.
+ */
+uint16_t Telemetry::readFreeSpace() {
+  return (this->tail + TELEMETRY_BUFFER_SIZE - this->head - 1) % TELEMETRY_BUFFER_SIZE;
+}
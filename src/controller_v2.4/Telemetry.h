@@ -0,0 +1,62 @@
+/**
+ * @file Telemetry.h
+ * @brief Header file for the Telemetry class, streaming binary frames without blocking.
+ *
+ * The Telemetry class packs a payload into a compact binary frame and queues it in a ring
+ * buffer. The buffer is drained into the serial port only as far as its transmit buffer has
+ * room, so sending a frame never blocks the control loop. If the ring buffer is full, the new
+ * frame is dropped and counted instead.
+ *
+ * Every frame is laid out as follows, with all multi-byte values in little endian:
+ * | sync (0xA5 0x5A) | type | length | sequence (2 bytes) | payload | CRC-16 (2 bytes) |
+ * The CRC-16/CCITT-FALSE checksum covers the type, the length, the sequence and the payload.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <inttypes.h>
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#define TELEMETRY_BUFFER_SIZE 512
+#define TELEMETRY_SYNC_1 0xA5
+#define TELEMETRY_SYNC_2 0x5A
+#define TELEMETRY_HEADER_SIZE 6
+#define TELEMETRY_CRC_SIZE 2
+
+class Telemetry {
+public:
+  Telemetry(Print &port);
+  ~Telemetry();
+
+  void begin();
+  void end();
+  bool send(uint8_t type, const void *payload, uint8_t length);
+  void flush();
+  uint16_t getSequence();
+  uint16_t getDroppedFrames();
+  static uint16_t crc16(const uint8_t *data, size_t length, uint16_t crc = 0xFFFF);
+
+private:
+  void push(uint8_t byte);
+  uint16_t readFreeSpace();
+
+  Print &port;
+  bool enabled;
+  uint8_t buffer[TELEMETRY_BUFFER_SIZE];
+  uint16_t head;
+  uint16_t tail;
+  uint16_t sequence;
+  uint16_t dropped_frames;
+};
+
+#endif  // TELEMETRY_H
@@ -0,0 +1,213 @@
+/**
+ * @file TrackMap.cpp
+ * @brief Implementation of the TrackMap class.
+ */
+
+#include "TrackMap.h"
+
+/**
+ * @brief Constructs a TrackMap object without any mapped section.
+ */
+TrackMap::TrackMap()
+  : enabled(false), restored(false), sections() {}
+
+/**
+ * @brief Destructs the TrackMap object.
+ */
+TrackMap::~TrackMap() {}
+
+/**
+ * @brief Clears the map and starts learning the track.
+ */
+void TrackMap::begin() {
+  for (uint8_t i = 0; i < TRACK_SECTIONS; i++) {
+    this->sections[i] = TrackSection();
+  }
+  this->enabled = true;
+  this->restored = false;
+}
+
+/**
+ * @brief Starts using a map learned in a previous race instead of learning the track.
+ *
+ * The restored sections are replayed from the first lap on and are never overwritten.
+ *
+ * @param sections The TRACK_SECTIONS sections of the previous map.
+ */
+void TrackMap::restore(const TrackSection *sections) {
+  for (uint8_t i = 0; i < TRACK_SECTIONS; i++) {
+    this->sections[i] = sections[i];
+  }
+  this->enabled = true;
+  this->restored = true;
+}
+
+/**
+ * @brief Stops using the map. All sections are reported as unmapped.
+ */
+void TrackMap::end() {
+  this->enabled = false;
+}
+
+/**
+ * @brief Starts a new section of the race.
+ *
+ * Sections passed for the first time completely are cleared, so they are learned from scratch.
+ *
+ * @param section The amount of sections completed since the start.
+ */
+void TrackMap::beginSection(uint8_t section) {
+  if (!this->isLearning(section))
+    return;
+
+  this->sections[section % TRACK_SECTIONS] = TrackSection();
+}
+
+/**
+ * @brief Records a pillar that has come into view.
+ *
+ * Ignored once the section has been learned or if it already holds TRACK_MAX_PILLARS pillars.
+ *
+ * @param section The amount of sections completed since the start.
+ * @param colour The colour of the pillar.
+ * @param position The position along the section in centimeters.
+ */
+void TrackMap::recordPillar(uint8_t section, Colour colour, uint16_t position) {
+  if (!this->isLearning(section))
+    return;
+
+  TrackSection &track_section = this->sections[section % TRACK_SECTIONS];
+  if (track_section.num_pillars >= TRACK_MAX_PILLARS)
+    return;
+
+  track_section.pillars[track_section.num_pillars++] = { colour, position };
+}
+
+/**
+ * @brief Records the parking lot of a section.
+ *
+ * @param section The amount of sections completed since the start.
+ * @param position The position along the section in centimeters.
+ */
+void TrackMap::recordParkingLot(uint8_t section, uint16_t position) {
+  if (!this->isLearning(section))
+    return;
+
+  TrackSection &track_section = this->sections[section % TRACK_SECTIONS];
+  track_section.parking_lot = true;
+  track_section.parking_position = position;
+}
+
+/**
+ * @brief Records the start of the turn at the end of a section and completes the section.
+ *
+ * @param section The amount of sections completed since the start.
+ * @param position The position along the section in centimeters.
+ */
+void TrackMap::recordCorner(uint8_t section, uint16_t position) {
+  if (!this->isLearning(section))
+    return;
+
+  TrackSection &track_section = this->sections[section % TRACK_SECTIONS];
+  track_section.corner_position = position;
+  track_section.mapped = section > 0;
+}
+
+/**
+ * @brief Indicates whether the layout of a section is known.
+ *
+ * @param section The amount of sections completed since the start.
+ * @return True if the section has been passed completely before, false otherwise.
+ */
+bool TrackMap::isMapped(uint8_t section) {
+  if (!this->enabled)
+    return false;
+
+  return this->sections[section % TRACK_SECTIONS].mapped;
+}
+
+/**
+ * @brief Indicates whether a section is known to contain no pillars.
+ *
+ * @param section The amount of sections completed since the start.
+ * @return True if the section is mapped and without pillars, false otherwise.
+ */
+bool TrackMap::isClear(uint8_t section) {
+  return this->isMapped(section) && !this->sections[section % TRACK_SECTIONS].num_pillars;
+}
+
+/**
+ * @brief Indicates whether a section is known to contain the parking lot.
+ *
+ * @param section The amount of sections completed since the start.
+ * @return True if the parking lot has been seen in the section, false otherwise.
+ */
+bool TrackMap::hasParkingLot(uint8_t section) {
+  return this->isMapped(section) && this->sections[section % TRACK_SECTIONS].parking_lot;
+}
+
+/**
+ * @brief Reads the position at which the turn at the end of a section starts.
+ *
+ * @param section The amount of sections completed since the start.
+ * @return The position along the section in centimeters, or 0 if the section is not mapped.
+ */
+uint16_t TrackMap::readCornerPosition(uint8_t section) {
+  if (!this->isMapped(section))
+    return 0;
+
+  return this->sections[section % TRACK_SECTIONS].corner_position;
+}
+
+/**
+ * @brief Finds the next pillar of a section that comes into view.
+ *
+ * @param section The amount of sections completed since the start.
+ * @param position The current position along the section in centimeters.
+ * @return The first pillar at or ahead of the position, or nullptr if there is none.
+ */
+const TrackPillar *TrackMap::findNextPillar(uint8_t section, uint16_t position) {
+  if (!this->isMapped(section))
+    return nullptr;
+
+  const TrackSection &track_section = this->sections[section % TRACK_SECTIONS];
+  for (uint8_t i = 0; i < track_section.num_pillars; i++) {
+    if (track_section.pillars[i].position >= position)
+      return &track_section.pillars[i];
+  }
+
+  return nullptr;
+}
+
+/**
+ * @brief Indicates whether the layout of every section is known.
+ *
+ * @return True if all sections are mapped, false otherwise.
+ */
+bool TrackMap::isComplete() {
+  for (uint8_t i = 0; i < TRACK_SECTIONS; i++) {
+    if (!this->isMapped(i))
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Retrieves the sections of the map, such as to store them for a later race.
+ *
+ * @return The TRACK_SECTIONS sections of the map.
+ */
+const TrackSection *TrackMap::getSections() {
+  return this->sections;
+}
+
+/**
+ * @brief Indicates whether a section is passed completely for the first time.
+ *
+ * @param section The amount of sections completed since the start.
+ * @return True while the section is learned, false once it is replayed or the map is restored.
+ */
+bool TrackMap::isLearning(uint8_t section) {
+  return this->enabled && !this->restored && section <= TRACK_SECTIONS;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file TrackMap.h
+ * @brief Header file for the TrackMap class, remembering the layout of the track over the laps.
+ *
+ * The TrackMap class stores a compact model of the four sections of the track: the position at
+ * which the turn into the next section starts, the pillars in the order they come into view, and
+ * the parking lot. Positions are given along the section in the frame of the pose estimator.
+ * Every section is learned on its first complete pass and replayed on the following laps, so the
+ * robot can steer towards the passing side before a pillar comes into view, turn at a known
+ * position and drive faster through sections without pillars.
+ *
+ * The robot starts in the middle of the first section, so the first pass only covers part of
+ * it. The first section is learned again on its second pass, which is the first complete one.
+ * A complete map can also be restored from a previous race, if the layout has not changed.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef TRACKMAP_H
+#define TRACKMAP_H
+
+#include <inttypes.h>
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "Config.h"
+
+#define TRACK_SECTIONS 4
+#define TRACK_MAX_PILLARS 2
+
+/**
+ * @struct TrackPillar
+ * @brief Struct to hold a pillar of a section.
+ */
+struct TrackPillar {
+  Colour colour;
+  uint16_t position;  // Position along the section at which the pillar has come into view.
+};
+
+/**
+ * @struct TrackSection
+ * @brief Struct to hold the layout of one section of the track.
+ */
+struct TrackSection {
+  bool mapped;               // The section has been passed completely.
+  bool parking_lot;          // The section contains the parking lot.
+  uint8_t num_pillars;       // Amount of pillars seen in the section.
+  uint16_t corner_position;  // Position along the section at which the turn has started.
+  uint16_t parking_position;
+  TrackPillar pillars[TRACK_MAX_PILLARS];
+};
+
+class TrackMap {
+public:
+  TrackMap();
+  ~TrackMap();
+
+  void begin();
+  void end();
+  void restore(const TrackSection *sections);
+  void beginSection(uint8_t section);
+  void recordPillar(uint8_t section, Colour colour, uint16_t position);
+  void recordParkingLot(uint8_t section, uint16_t position);
+  void recordCorner(uint8_t section, uint16_t position);
+  bool isMapped(uint8_t section);
+  bool isClear(uint8_t section);
+  bool hasParkingLot(uint8_t section);
+  uint16_t readCornerPosition(uint8_t section);
+  const TrackPillar *findNextPillar(uint8_t section, uint16_t position);
+  bool isComplete();
+  const TrackSection *getSections();
+
+private:
+  bool isLearning(uint8_t section);
+
+  bool enabled;
+  bool restored;
+  TrackSection sections[TRACK_SECTIONS];
+};
+
+#endif  // TRACKMAP_H
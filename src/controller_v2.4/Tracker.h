@@ -0,0 +1,285 @@
+/**
+ * @file Tracker.h
+ * @brief Header file for the Tracker structure, following pillars across camera frames.
+ *
+ * The Tracker structure associates the classified blocks of each camera frame with the pillars
+ * seen before. Every pillar is kept as a track with a stable ID, a filtered position and velocity
+ * and a confidence. Blocks are associated with the nearest predicted track of the same colour,
+ * so the order of the block list does not matter. A track survives a few frames without a
+ * matching block by following its prediction, which bridges short dropouts of the camera.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef TRACKER_H
+#define TRACKER_H
+
+#include <inttypes.h>
+#include "Camera.h"
+
+#define MAX_TRACKS 4
+#define TRACK_GATE 40
+#define TRACK_MAX_MISSES 2
+#define TRACK_TIMEOUT 200
+#define TRACK_CONFIDENCE_GAIN 25
+
+/**
+ * @struct Track
+ * @brief Struct to hold the state of a tracked pillar.
+ *
+ * Positions are given in pixels of the camera frame and velocities in pixels per second. The
+ * age counts the frames the pillar has been seen in, the misses count the frames in a row it
+ * has not been seen in. The confidence rises with every match and halves with every miss.
+ */
+struct Track {
+  uint8_t id;
+  Colour colour;
+  int16_t x;
+  int16_t y;
+  int16_t velocity_x;
+  int16_t velocity_y;
+  uint16_t width;
+  uint8_t height;
+  uint8_t age;
+  uint8_t misses;
+  uint8_t confidence;
+  unsigned long last_millis;
+};
+
+struct Tracker {
+  Track tracks[MAX_TRACKS];  // Active tracks, in no particular order.
+  uint8_t num_tracks;        // Amount of active tracks.
+  uint8_t next_id;           // ID given to the next new track, 0 is never used.
+
+  /**
+   * @brief Removes all tracks.
+   */
+  void reset() {
+    this->num_tracks = 0;
+    this->next_id = 1;
+  }
+
+  /**
+   * @brief Associates the blocks of a new camera frame with the tracks.
+   *
+   * Every track is predicted to the time of the frame and matched with the nearest block of
+   * the same colour within TRACK_GATE pixels. Tracks are matched in the order of their
+   * confidence, so an established pillar is never taken over by a new one. A matched track
+   * corrects its position and velocity with an alpha-beta filter, an unmatched one keeps
+   * its prediction and is removed after TRACK_MAX_MISSES frames. Blocks without a track
+   * start a new one.
+   *
+   * @param blocks The classified blocks of the frame.
+   * @param num_blocks The amount of blocks in the frame.
+   * @param timestamp The time in milliseconds at which the frame has been received.
+   */
+  void update(const CameraBlock *blocks, uint8_t num_blocks, unsigned long timestamp) {
+    bool matched_blocks[MAX_CAMERA_BLOCKS] = {};
+    bool matched_tracks[MAX_TRACKS] = {};
+    num_blocks = min(num_blocks, uint8_t(MAX_CAMERA_BLOCKS));
+
+    for (uint8_t n = 0; n < this->num_tracks; n++) {
+      // Pick the most confident track that has not been matched yet.
+      int8_t t = -1;
+      for (uint8_t i = 0; i < this->num_tracks; i++) {
+        if (!matched_tracks[i] && (t < 0 || this->tracks[i].confidence > this->tracks[t].confidence)) {
+          t = i;
+        }
+      }
+      matched_tracks[t] = true;
+
+      Track &track = this->tracks[t];
+      int16_t predicted_x = predictX(track, timestamp);
+      int16_t predicted_y = predictY(track, timestamp);
+
+      // Find the nearest block of the same colour within the gate.
+      int8_t nearest_block = -1;
+      uint16_t nearest_distance = TRACK_GATE + 1;
+      for (uint8_t i = 0; i < num_blocks; i++) {
+        if (matched_blocks[i] || blocks[i].colour != track.colour)
+          continue;
+
+        uint16_t distance = abs(blocks[i].x - predicted_x) + abs(blocks[i].y - predicted_y);
+        if (distance < nearest_distance) {
+          nearest_distance = distance;
+          nearest_block = i;
+        }
+      }
+
+      if (nearest_block >= 0) {
+        matched_blocks[nearest_block] = true;
+        correct(track, blocks[nearest_block], predicted_x, predicted_y, timestamp);
+      } else {
+        track.misses++;
+        track.confidence /= 2;
+      }
+    }
+
+    // Remove the tracks that have been missed for too long.
+    for (uint8_t i = 0; i < this->num_tracks;) {
+      if (this->tracks[i].misses > TRACK_MAX_MISSES) {
+        this->tracks[i] = this->tracks[--this->num_tracks];
+      } else {
+        i++;
+      }
+    }
+
+    // Start new tracks for the remaining blocks, the nearest first.
+    for (uint8_t i = 0; i < num_blocks && this->num_tracks < MAX_TRACKS; i++) {
+      if (!matched_blocks[i]) {
+        start(this->tracks[this->num_tracks++], blocks[i], timestamp);
+      }
+    }
+  }
+
+  /**
+   * @brief Removes the tracks that have not been matched for longer than TRACK_TIMEOUT.
+   *
+   * Misses are only counted on received frames. This covers the case that the camera stops
+   * delivering frames altogether.
+   *
+   * @param timestamp The current time in milliseconds.
+   */
+  void expire(unsigned long timestamp) {
+    for (uint8_t i = 0; i < this->num_tracks;) {
+      if (timestamp - this->tracks[i].last_millis > TRACK_TIMEOUT) {
+        this->tracks[i] = this->tracks[--this->num_tracks];
+      } else {
+        i++;
+      }
+    }
+  }
+
+  /**
+   * @brief Retrieves the amount of active tracks.
+   *
+   * @return The amount of tracks, at most MAX_TRACKS.
+   */
+  uint8_t getNumTracks() {
+    return this->num_tracks;
+  }
+
+  /**
+   * @brief Retrieves an active track.
+   *
+   * @param index The position of the track in the table.
+   * @return The requested track.
+   */
+  const Track &getTrack(uint8_t index) {
+    return this->tracks[constrain(index, 0, MAX_TRACKS - 1)];
+  }
+
+  /**
+   * @brief Finds the nearest tracked pillar, or the parking lot while it is unlocked.
+   *
+   * A pillar comes nearer the larger it appears, so the track with the largest area wins.
+   *
+   * @param magenta_unlocked Whether the parking lot is searched for instead of pillars.
+   * @return The nearest relevant track, or a null pointer if there is none.
+   */
+  const Track *findNearest(bool magenta_unlocked) {
+    const Track *nearest_track = nullptr;
+
+    for (uint8_t i = 0; i < this->num_tracks; i++) {
+      const Track &track = this->tracks[i];
+
+      if ((track.colour == Colour::MAGENTA) == magenta_unlocked
+          && (!nearest_track || area(track) > area(*nearest_track))) {
+        nearest_track = &track;
+      }
+    }
+
+    return nearest_track;
+  }
+
+  /**
+   * @brief Predicts the horizontal position of a track at a given time.
+   *
+   * @param track The track to predict.
+   * @param timestamp The time in milliseconds to predict the position for.
+   * @return The predicted X-coordinate, constrained to the camera frame.
+   */
+  int16_t predictX(const Track &track, unsigned long timestamp) {
+    int32_t x = track.x + int32_t(track.velocity_x) * int32_t(timestamp - track.last_millis) / 1000;
+    return constrain(x, 0, 315);
+  }
+
+  /**
+   * @brief Predicts the vertical position of a track at a given time.
+   *
+   * @param track The track to predict.
+   * @param timestamp The time in milliseconds to predict the position for.
+   * @return The predicted Y-coordinate, constrained to the camera frame.
+   */
+  int16_t predictY(const Track &track, unsigned long timestamp) {
+    int32_t y = track.y + int32_t(track.velocity_y) * int32_t(timestamp - track.last_millis) / 1000;
+    return constrain(y, 0, 207);
+  }
+
+  /**
+   * @brief Initializes a new track from a block.
+   *
+   * @param track The track to initialize.
+   * @param block The block the track starts from.
+   * @param timestamp The time in milliseconds at which the block has been seen.
+   */
+  void start(Track &track, const CameraBlock &block, unsigned long timestamp) {
+    track.id = this->next_id;
+    this->next_id = (this->next_id == UINT8_MAX) ? 1 : this->next_id + 1;
+
+    track.colour = block.colour;
+    track.x = block.x;
+    track.y = block.y;
+    track.velocity_x = 0;
+    track.velocity_y = 0;
+    track.width = block.width;
+    track.height = block.height;
+    track.age = 1;
+    track.misses = 0;
+    track.confidence = TRACK_CONFIDENCE_GAIN;
+    track.last_millis = timestamp;
+  }
+
+  /**
+   * @brief Corrects a track with a matched block, using an alpha-beta filter.
+   *
+   * The position follows half of the residual between the block and the prediction, the
+   * velocity a quarter of the residual per elapsed time.
+   *
+   * @param track The track to correct.
+   * @param block The block matched with the track.
+   * @param predicted_x The predicted X-coordinate of the track.
+   * @param predicted_y The predicted Y-coordinate of the track.
+   * @param timestamp The time in milliseconds at which the block has been seen.
+   */
+  void correct(Track &track, const CameraBlock &block, int16_t predicted_x, int16_t predicted_y, unsigned long timestamp) {
+    int16_t residual_x = block.x - predicted_x;
+    int16_t residual_y = block.y - predicted_y;
+    int32_t dt = max(int32_t(timestamp - track.last_millis), int32_t(1));
+
+    track.x = predicted_x + residual_x / 2;
+    track.y = predicted_y + residual_y / 2;
+    track.velocity_x = constrain(track.velocity_x + int32_t(residual_x) * 1000 / (4 * dt), INT16_MIN, INT16_MAX);
+    track.velocity_y = constrain(track.velocity_y + int32_t(residual_y) * 1000 / (4 * dt), INT16_MIN, INT16_MAX);
+    track.width = block.width;
+    track.height = block.height;
+    track.age = (track.age < UINT8_MAX) ? track.age + 1 : UINT8_MAX;
+    track.misses = 0;
+    track.confidence = min(track.confidence + TRACK_CONFIDENCE_GAIN, 100);
+    track.last_millis = timestamp;
+  }
+
+  /**
+   * @brief Calculates the area of a track, which grows as the pillar comes closer.
+   *
+   * @param track The track to measure.
+   * @return The area of the track in square pixels.
+   */
+  uint32_t area(const Track &track) {
+    return uint32_t(track.width) * track.height;
+  }
+};
+
+#endif  // TRACKER_H
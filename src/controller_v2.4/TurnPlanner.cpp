@@ -0,0 +1,184 @@
+/**
+ * @file TurnPlanner.cpp
+ * @brief Implementation of the TurnPlanner class.
+ */
+
+#include "TurnPlanner.h"
+
+/**
+ * @brief Constructs a TurnPlanner object.
+ *
+ * The speed gain and the deceleration should match the ones of the pose estimator and the
+ * motor, respectively.
+ */
+TurnPlanner::TurnPlanner()
+  : enabled(false), turn_reached(false), max_speed(0), target_speed(0), corner_speed(0),
+    steering_deflection(0), deceleration(800), speed_gain(150.0), turn_radius(PLANNER_TURN_RADIUS),
+    turn_distance(0) {}
+
+/**
+ * @brief Destructs the TurnPlanner object.
+ */
+TurnPlanner::~TurnPlanner() {}
+
+/**
+ * @brief Starts planning with the speed the robot drives on straights.
+ *
+ * @param max_speed The highest motor speed, ranging from 0 to 100.
+ */
+void TurnPlanner::begin(uint8_t max_speed) {
+  this->max_speed = constrain(max_speed, 0, 100);
+  this->target_speed = this->max_speed;
+  this->corner_speed = this->max_speed;
+  this->turn_reached = false;
+  this->enabled = true;
+}
+
+/**
+ * @brief Stops planning.
+ */
+void TurnPlanner::end() {
+  this->enabled = false;
+}
+
+/**
+ * @brief Sets the speed of the robot at full motor power.
+ *
+ * @param speed_gain The speed in centimeters per second at a motor speed of 100.
+ */
+void TurnPlanner::setSpeedGain(float speed_gain) {
+  this->speed_gain = speed_gain;
+}
+
+/**
+ * @brief Sets the rate at which the motor slows down.
+ *
+ * @param deceleration The deceleration of the motor in percent per second.
+ */
+void TurnPlanner::setDeceleration(uint16_t deceleration) {
+  this->deceleration = deceleration;
+}
+
+/**
+ * @brief Sets the radius of the arc the robot turns on.
+ *
+ * A larger radius allows a higher corner speed, but starts the turn earlier. The radius is
+ * never smaller than the one at full steering lock.
+ *
+ * @param turn_radius The radius in centimeters.
+ */
+void TurnPlanner::setTurnRadius(float turn_radius) {
+  this->turn_radius = turn_radius;
+}
+
+/**
+ * @brief Plans the turn from the current state of the robot.
+ *
+ * Computes the corner speed from the radius of the arc, the front distance at which the arc
+ * has to begin and the target speed on the braking curve towards the corner speed. A front
+ * distance of 0 is not a valid measurement and keeps the previous plan.
+ *
+ * @param front_distance The distance to the wall ahead in centimeters.
+ * @param speed The speed of the robot in centimeters per second.
+ * @param angular_velocity The yaw rate in hundredths of a degree per second.
+ */
+void TurnPlanner::update(uint16_t front_distance, float speed, int32_t angular_velocity) {
+  if (!this->enabled || !front_distance)
+    return;
+
+  float min_radius = PLANNER_WHEELBASE / tan(radians(PLANNER_MAX_DEFLECTION));
+  float radius = max(this->turn_radius, min_radius);
+  float max_speed = this->max_speed * this->speed_gain / 100.0;
+  float corner_speed = min(float(sqrt(PLANNER_LATERAL_ACCELERATION * radius)), max_speed);
+  speed = abs(speed);
+
+  // The robot travels on during the delay of the control loop and the servo.
+  this->turn_distance = radius + PLANNER_WALL_CLEARANCE + speed * PLANNER_LATENCY;
+  this->turn_reached = front_distance <= this->turn_distance;
+
+  // Highest speed from which the robot can still brake to the corner speed until the turn.
+  float braking_deceleration = this->deceleration * this->speed_gain / 100.0;
+  float braking_distance = front_distance - this->turn_distance;
+  float target_speed = corner_speed;
+  if (braking_distance > 0)
+    target_speed = sqrt(corner_speed * corner_speed + 2.0 * braking_deceleration * braking_distance);
+
+  this->corner_speed = this->toMotorSpeed(corner_speed);
+  this->target_speed = this->toMotorSpeed(min(target_speed, max_speed));
+
+  // Steer along the arc, faster or slower than its yaw rate if the robot under- or oversteers.
+  float arc_rate = degrees(speed / radius);
+  float deflection = degrees(atan(PLANNER_WHEELBASE / radius))
+                     + PLANNER_YAW_RATE_GAIN * (arc_rate - abs(angular_velocity) / 100.0);
+  this->steering_deflection = constrain(deflection, 0, PLANNER_MAX_DEFLECTION);
+}
+
+/**
+ * @brief Indicates whether the robot has reached the start of the turn.
+ *
+ * @return True if the front distance is within the turn distance, false otherwise.
+ */
+bool TurnPlanner::isTurnReached() {
+  if (!this->enabled)
+    return false;
+
+  return this->turn_reached;
+}
+
+/**
+ * @brief Reads the speed the robot should drive at on the straight.
+ *
+ * @return The motor speed, ranging from the corner speed to the maximum speed.
+ */
+uint8_t TurnPlanner::readTargetSpeed() {
+  if (!this->enabled)
+    return 0;
+
+  return this->target_speed;
+}
+
+/**
+ * @brief Reads the speed the robot should drive at along the arc.
+ *
+ * @return The motor speed, ranging from 0 to the maximum speed.
+ */
+uint8_t TurnPlanner::readCornerSpeed() {
+  if (!this->enabled)
+    return 0;
+
+  return this->corner_speed;
+}
+
+/**
+ * @brief Reads the steering deflection along the arc.
+ *
+ * @return The deflection of the servo from its straight position in degrees.
+ */
+uint8_t TurnPlanner::readSteeringDeflection() {
+  if (!this->enabled)
+    return 0;
+
+  return this->steering_deflection;
+}
+
+/**
+ * @brief Reads the front distance at which the turn starts.
+ *
+ * @return The distance to the wall ahead in centimeters.
+ */
+uint16_t TurnPlanner::readTurnDistance() {
+  if (!this->enabled)
+    return 0;
+
+  return this->turn_distance;
+}
+
+/**
+ * @brief Converts a speed into the corresponding motor speed.
+ *
+ * @param speed The speed in centimeters per second.
+ * @return The motor speed, ranging from 0 to 100.
+ */
+uint8_t TurnPlanner::toMotorSpeed(float speed) {
+  return constrain(lround(speed * 100.0 / this->speed_gain), 0, 100);
+}
@@ -0,0 +1,70 @@
+/**
+ * @file TurnPlanner.h
+ * @brief Header file for the TurnPlanner class, planning the entry of the robot into a turn.
+ *
+ * The TurnPlanner class decides when a turn starts, how fast the robot may enter it and how
+ * far the steering is deflected along the arc. The turn is planned as an arc of a fixed radius,
+ * which is driven at the highest speed that keeps the lateral acceleration within bounds. On
+ * the straight ahead, the target speed follows the braking curve towards the corner speed, so
+ * the robot brakes as late as its deceleration allows. The start of the turn moves further
+ * ahead the faster the robot drives, compensating the delay of the control loop and the servo.
+ * Along the arc, the steering is fed forward from a bicycle model and corrected by the error
+ * between the expected and the measured yaw rate.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef TURNPLANNER_H
+#define TURNPLANNER_H
+
+#include <inttypes.h>
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#define PLANNER_WHEELBASE 15.0
+#define PLANNER_MAX_DEFLECTION 44
+#define PLANNER_TURN_RADIUS 35.0
+#define PLANNER_WALL_CLEARANCE 15.0
+#define PLANNER_LATENCY 0.1
+#define PLANNER_LATERAL_ACCELERATION 250.0
+#define PLANNER_YAW_RATE_GAIN 0.1
+
+class TurnPlanner {
+public:
+  TurnPlanner();
+  ~TurnPlanner();
+
+  void begin(uint8_t max_speed);
+  void end();
+  void setSpeedGain(float speed_gain);
+  void setDeceleration(uint16_t deceleration);
+  void setTurnRadius(float turn_radius);
+  void update(uint16_t front_distance, float speed, int32_t angular_velocity);
+  bool isTurnReached();
+  uint8_t readTargetSpeed();
+  uint8_t readCornerSpeed();
+  uint8_t readSteeringDeflection();
+  uint16_t readTurnDistance();
+
+private:
+  uint8_t toMotorSpeed(float speed);
+
+  bool enabled;
+  bool turn_reached;
+  uint8_t max_speed;
+  uint8_t target_speed;
+  uint8_t corner_speed;
+  uint8_t steering_deflection;
+  uint16_t deceleration;
+  float speed_gain;
+  float turn_radius;
+  float turn_distance;
+};
+
+#endif  // TURNPLANNER_H
@@ -9,12 +9,20 @@
 /**
  * @brief Constructs an UltrasonicSensor object with a specified maximum distance.
  *
+ * The echo timeout is derived from the maximum distance at room temperature. The filter
+ * takes the median of SONAR_DEFAULT_MEDIAN_SIZE measurements without smoothing.
+ *
  * @param trigger_pin The pin connected to the trigger of the sensor.
  * @param echo_pin The pin connected to the echo of the sensor.
  * @param max_distance The maximum distance the sensor can measure.
  */
 UltrasonicSensor::UltrasonicSensor(pin_size_t trigger_pin, pin_size_t echo_pin, uint16_t max_distance)
-  : trigger_pin(trigger_pin), echo_pin(echo_pin), max_distance(max_distance) {}
+  : trigger_pin(trigger_pin), echo_pin(echo_pin), latest{ 0, 0, EchoStatus::NONE, 0, 0 }, reading(latest),
+    median_head(0), median_count(0), max_distance(max_distance)
+{
+  this->setTemperature(SONAR_ROOM_TEMPERATURE);
+  this->setFilter(SONAR_DEFAULT_MEDIAN_SIZE);
+}
 
 /**
  * @brief Constructs an UltrasonicSensor object with a default maximum distance.
@@ -33,16 +41,50 @@ UltrasonicSensor::~UltrasonicSensor() {}
 /**
  * @brief Initializes the sensor.
  *
- * Sets the pinMode for trigger and echo pins, and begins the filter.
+ * Sets the pinMode for trigger and echo pins, and begins the filter. The echo pulse is
+ * captured by a pin-change interrupt if the echo pin supports one, otherwise it is polled.
  */
 void UltrasonicSensor::begin()
+{
+  if (digitalPinToInterrupt(this->echo_pin) != NOT_AN_INTERRUPT)
+    this->begin(EchoCapture::INTERRUPT);
+  else
+    this->begin(EchoCapture::POLLING);
+}
+
+/**
+ * @brief Initializes the sensor with a specified echo capture mode.
+ *
+ * Sets the pinMode for trigger and echo pins, begins the filter with an empty median window
+ * and, for the interrupt capture mode, attaches the echo pin to the pin-change interrupt of
+ * this instance. Falls back to polling if the echo pin cannot raise an interrupt.
+ *
+ * @param capture_mode The way the echo pulse is timed.
+ */
+void UltrasonicSensor::begin(EchoCapture capture_mode)
 {
   pinMode(this->trigger_pin, OUTPUT);
   pinMode(this->echo_pin, INPUT);
   this->filter.begin();
-  this->enabled = true;
+  this->median_head = 0;
+  this->median_count = 0;
+  this->latest = { 0, 0, EchoStatus::NONE, 0, 0 };
+  this->reading.write(this->latest);
+  this->peak_count = 0;
   this->state = 0;
-  this->is_updating = 0;
+  this->is_updating = false;
+  this->peak_detector.reset();
+  this->echo_armed = false;
+  this->echo_started = false;
+
+  if (capture_mode == EchoCapture::INTERRUPT && digitalPinToInterrupt(this->echo_pin) == NOT_AN_INTERRUPT)
+    capture_mode = EchoCapture::POLLING;
+
+  this->capture_mode = capture_mode;
+  if (this->capture_mode == EchoCapture::INTERRUPT)
+    attachInterruptParam(digitalPinToInterrupt(this->echo_pin), UltrasonicSensor::echoInterrupt, CHANGE, this);
+
+  this->enabled = true;
 }
 
 /**
@@ -52,24 +94,32 @@ void UltrasonicSensor::begin()
  */
 void UltrasonicSensor::end()
 {
+  if (this->capture_mode == EchoCapture::INTERRUPT)
+    detachInterrupt(digitalPinToInterrupt(this->echo_pin));
+
   this->filter.end();
   this->enabled = false;
 }
 
 /**
- * @brief Updates the sensor measurements at room temperature.
+ * @brief Updates the sensor measurements.
  *
  * This method progresses through a state machine to update the distance measurement
  * from the ultrasonic sensor. It sends out an ultrasonic pulse and listens for its echo
- * to calculate the distance to an object.
+ * to calculate the distance to an object. In the interrupt capture mode the echo is timed
+ * by captureEcho(), so this method only triggers the pulse and handles the timeout.
+ * Both the interrupt and the polling path share the same timeout and conversion.
+ *
+ * A measurement ends with the maximum distance once the echo has not returned within the
+ * echo timeout. The module itself keeps its echo pin high for up to SONAR_MODULE_TIMEOUT
+ * after a miss and ignores triggers meanwhile, so the next pulse is held back until the
+ * pin has fallen.
  */
 void UltrasonicSensor::update()
 {
   if (!this->enabled)
       return;
 
-  static unsigned long last_micros;
-
   // Guard clause to exit if no update is in progress.
   if (!this->is_updating)
       return;
@@ -77,17 +127,23 @@ void UltrasonicSensor::update()
   // State machine for updating the sensor reading.
   switch (this->state)
   {
-  case 0: // State 0: Trigger the ultrasonic pulse.
+  case 0: // State 0: Trigger the ultrasonic pulse once the module is ready.
   {
-      last_micros = micros();
+      if (digitalRead(echo_pin) == HIGH && micros() - this->latest.timestamp < SONAR_MODULE_TIMEOUT)
+          break;
+
+      this->last_micros = micros();
       digitalWrite(trigger_pin, HIGH);
       this->state++;
   }
   break;
   case 1: // State 1: End the ultrasonic pulse after 15 microseconds.
   {
-      if (micros() > last_micros + 15)
+      if (micros() - this->last_micros > 15)
       {
+          // Arm the echo interrupt only once the trigger pulse is over.
+          this->echo_started = false;
+          this->echo_armed = (this->capture_mode == EchoCapture::INTERRUPT);
           digitalWrite(trigger_pin, LOW);
           this->state++;
       }
@@ -95,40 +151,186 @@ void UltrasonicSensor::update()
   break;
   case 2: // State 2: Wait for the echo or timeout.
   {
-      if (micros() > last_micros + 29310)
+      if (micros() - this->last_micros > SONAR_ECHO_DELAY + this->echo_timeout)
       {
-          this->distance = max_distance;
+          this->echo_armed = false;
+          if (!this->is_updating)
+              break;  // The echo has been captured right before the interrupt was disarmed.
+
+          this->filterMeasurement(this->max_distance, EchoStatus::MISSED);
           this->state = 0;
-          this->is_updating = false;
+          this->publish(micros());
       }
-      else
+      else if (digitalRead(echo_pin) == HIGH && !this->echo_started)
       {
-          if (digitalRead(echo_pin) == HIGH)
+          // An echo without a captured edge means that the pin cannot raise
+          // an interrupt, so the sensor falls back to polling.
+          if (this->capture_mode == EchoCapture::INTERRUPT)
           {
-              last_micros = micros();
-              this->state++;
+              this->echo_armed = false;
+              detachInterrupt(digitalPinToInterrupt(this->echo_pin));
+              this->capture_mode = EchoCapture::POLLING;
           }
+          this->last_micros = micros();
+          this->state++;
       }
   }
   break;
   case 3: // State 3: Calculate the distance based on the echo pulse width.
   {
-      unsigned long pulse_width = micros() - last_micros;
-      if (digitalRead(echo_pin) == LOW || pulse_width > 25000)
+      unsigned long pulse_width = micros() - this->last_micros;
+      if (digitalRead(echo_pin) == LOW || pulse_width > this->echo_timeout)
       {
-          pulse_width /= 2;
-          if (pulse_width < 12500)
-          {
-            this->distance = pulse_width / 29.1;
-          }
+          this->convert(pulse_width);
           this->state = 0;
-          this->is_updating = false;
+          this->publish(micros());
       }
   }
   break;
   }
 }
 
+/**
+ * @brief Forwards the pin-change interrupt of the echo pin to its sensor instance.
+ *
+ * @param sensor The UltrasonicSensor instance registered with the interrupt.
+ */
+void UltrasonicSensor::echoInterrupt(void *sensor)
+{
+  static_cast<UltrasonicSensor *>(sensor)->captureEcho();
+}
+
+/**
+ * @brief Timestamps the edges of the echo pulse from interrupt context.
+ *
+ * The rising edge stores the start time of the pulse, the falling edge converts the
+ * measured pulse width into a distance and completes the measurement. Edges outside
+ * of an armed measurement are ignored.
+ */
+void UltrasonicSensor::captureEcho()
+{
+  unsigned long now = micros();
+
+  if (!this->echo_armed)
+    return;
+
+  if (digitalRead(this->echo_pin) == HIGH)
+  {
+    this->echo_micros = now;
+    this->echo_started = true;
+  }
+  else if (this->echo_started)
+  {
+    this->convert(now - this->echo_micros);
+    this->echo_armed = false;
+    this->echo_started = false;
+    this->publish(now);
+  }
+}
+
+/**
+ * @brief Converts an echo pulse width into a distance at the set temperature.
+ *
+ * Pulses longer than the echo timeout have been reflected beyond the maximum distance,
+ * which is reported instead, like for a missing echo. The distance is computed in fixed
+ * point, so the conversion takes no floating-point instruction in interrupt context.
+ *
+ * @param pulse_width The width of the echo pulse in microseconds.
+ */
+void UltrasonicSensor::convert(unsigned long pulse_width)
+{
+  if (pulse_width > this->echo_timeout)
+  {
+    this->filterMeasurement(this->max_distance, EchoStatus::MISSED);
+    return;
+  }
+
+  uint16_t distance = (this->cm_per_microsecond * (pulse_width / 2)).toInt();
+  if (distance < SONAR_MIN_DISTANCE)
+    this->filterMeasurement(distance, EchoStatus::BLIND);
+  else
+    this->filterMeasurement(min(distance, this->max_distance), EchoStatus::VALID);
+}
+
+/**
+ * @brief Passes a measurement through the range gate, the median and the smoothing.
+ *
+ * Rejected measurements only update the raw distance and the status. The work per
+ * measurement is bounded by SONAR_MEDIAN_WINDOW, so the pipeline may run in interrupt
+ * context.
+ *
+ * @param raw_distance The converted distance in centimeters.
+ * @param status The outcome of the range gate.
+ */
+void UltrasonicSensor::filterMeasurement(uint16_t raw_distance, EchoStatus status)
+{
+  this->latest.raw_distance = raw_distance;
+  this->latest.status = status;
+  if (status == EchoStatus::BLIND)
+    return;
+
+  this->median_window[this->median_head] = raw_distance;
+  this->median_head = (this->median_head + 1) % this->median_size;
+  if (this->median_count < this->median_size)
+    this->median_count++;
+
+  uint16_t median = this->readMedian();
+  if (this->smoothing_factor > 0)
+  {
+    this->filter.add(median);
+    this->latest.distance = this->filter.readExponentialAverage(this->smoothing_factor);
+  }
+  else
+  {
+    this->latest.distance = median;
+  }
+}
+
+/**
+ * @brief Completes a measurement and publishes its reading.
+ *
+ * Called by the side that has completed the measurement, either the echo interrupt or
+ * update(), after the measurement has passed the filter pipeline. The reading is published
+ * before the measurement is marked as complete, so a sensor that is no longer updating
+ * always has its reading published.
+ *
+ * @param now The time the measurement has been completed at in microseconds.
+ */
+void UltrasonicSensor::publish(unsigned long now)
+{
+  this->latest.count++;
+  this->latest.timestamp = now;
+  this->reading.write(this->latest);
+  this->is_updating = false;
+}
+
+/**
+ * @brief Computes the median of the measurements in the median window.
+ *
+ * Sorts a copy of the window by insertion, which takes at most ten comparisons for the
+ * largest window. Of an even amount of measurements, such as while the window fills, the
+ * lower median is taken.
+ *
+ * @return The median distance in centimeters.
+ */
+uint16_t UltrasonicSensor::readMedian()
+{
+  uint16_t sorted[SONAR_MEDIAN_WINDOW];
+
+  for (uint8_t i = 0; i < this->median_count; i++)
+  {
+    uint16_t value = this->median_window[i];
+    uint8_t j = i;
+    for (; j > 0 && sorted[j - 1] > value; j--)
+    {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = value;
+  }
+
+  return sorted[(this->median_count - 1) / 2];
+}
+
 /**
  * @brief Initiates a new measurement cycle for the ultrasonic sensor.
  *
@@ -147,8 +349,80 @@ void UltrasonicSensor::startMeasurement()
   if (!this->enabled)
       return;
 
-  this->is_updating = true; // Flag the start of a measurement update.
-  this->state = 0;          // Reset the state to the initial value.
+  this->echo_armed = false;  // Ignore edges until the new pulse has been triggered.
+  this->state = 0;           // Reset the state to the initial value.
+  this->is_updating = true;  // Flag the start of a measurement update.
+}
+
+/**
+ * @brief Sets the temperature of the air the sound travels through.
+ *
+ * The speed of sound rises by 0.606 m/s per degree from 331.3 m/s at 0 deg C, which changes
+ * a distance by about 0.18% per degree. The conversion of the echo and the echo timeout are
+ * derived from it again, so a measurement in progress already uses the new speed.
+ *
+ * @param temperature The temperature in tenths of a degree Celsius, limited to the range
+ * from SONAR_MIN_TEMPERATURE to SONAR_MAX_TEMPERATURE.
+ */
+void UltrasonicSensor::setTemperature(int16_t temperature)
+{
+  this->temperature = constrain(temperature, SONAR_MIN_TEMPERATURE, SONAR_MAX_TEMPERATURE);
+
+  // Speed of sound in tenths of a meter per second, which are 1e-5 cm per microsecond.
+  int32_t speed = 3313 + int32_t(this->temperature) * 606 / 1000;
+  this->cm_per_microsecond = Fixed<16>(int(speed)) / 100000;
+  this->echo_timeout = uint64_t(this->max_distance) * 2 * 100000 / speed;
+}
+
+/**
+ * @brief Configures the filter pipeline of the sensor.
+ *
+ * A median of a single measurement passes every valid measurement through, a median of three
+ * removes single spikes at the cost of one measurement of delay on a step. Restarts the
+ * median window, so the filter has to fill again.
+ *
+ * @param median_size The amount of measurements the median is taken over, from 1 to
+ * SONAR_MEDIAN_WINDOW.
+ * @param smoothing_factor The weight of a new median in the exponential moving average,
+ * 0 to pass the median through unsmoothed.
+ */
+void UltrasonicSensor::setFilter(uint8_t median_size, Fixed<MOVING_AVERAGE_FRAC_BITS> smoothing_factor)
+{
+  this->median_size = constrain(median_size, 1, SONAR_MEDIAN_WINDOW);
+  this->smoothing_factor = smoothing_factor;
+  this->median_head = 0;
+  this->median_count = 0;
+  this->filter.begin();
+}
+
+/**
+ * @brief Retrieves the temperature the distances are converted at.
+ *
+ * @return The temperature in tenths of a degree Celsius.
+ */
+int16_t UltrasonicSensor::getTemperature()
+{
+  return this->temperature;
+}
+
+/**
+ * @brief Retrieves the maximum distance of the sensor, which is reported for a missing echo.
+ *
+ * @return The maximum distance in centimeters.
+ */
+uint16_t UltrasonicSensor::getMaxDistance()
+{
+  return this->max_distance;
+}
+
+/**
+ * @brief Retrieves the longest echo pulse the sensor waits for.
+ *
+ * @return The time the sound takes to the maximum distance and back in microseconds.
+ */
+unsigned long UltrasonicSensor::getEchoTimeout()
+{
+  return this->echo_timeout;
 }
 
 /**
@@ -164,31 +438,69 @@ bool UltrasonicSensor::isUpdating()
   return this->is_updating;
 }
 
+/**
+ * @brief Indicates how the echo pulse of the sensor is timed.
+ *
+ * @return EchoCapture::INTERRUPT if the echo edges are timestamped by a pin-change
+ * interrupt, EchoCapture::POLLING otherwise.
+ */
+EchoCapture UltrasonicSensor::readCaptureMode()
+{
+  return this->capture_mode;
+}
+
 /**
  * @brief Checks if a peak is detected by the sensor.
  *
- * Compares the current distance measurement to a threshold value to determine if a peak
- * (an object within a certain range) is detected. Requires a specified number of consecutive
- * matches to confirm the detection and avoid false positives.
+ * Compares the distance measurements to a threshold value to determine if a peak (a large
+ * distance, such as a gap in the wall) is detected. Every completed measurement is fed into
+ * the debouncer of this sensor once, so the peak needs SONAR_PEAK_MATCHES consecutive
+ * measurements to be confirmed, and it is only released again once the distance drops below
+ * the threshold minus the hysteresis for as many measurements.
  *
  * @param threshold_distance The threshold distance for peak detection.
- * @param consecutive_matches The number of consecutive matches required for peak detection.
+ * @param hysteresis The distance below the threshold that releases a detected peak.
  * @return True if a peak is detected, false otherwise.
  */
-bool UltrasonicSensor::detectedPeak(uint16_t threshold_distance, uint8_t consecutive_matches)
+bool UltrasonicSensor::detectedPeak(uint16_t threshold_distance, uint16_t hysteresis)
 {
   if (!this->enabled)
       return 0;
 
-  return filter.detectedPeak(threshold_distance, consecutive_matches);
+  SonarReading reading = this->reading.read();
+  if (reading.count != this->peak_count)
+  {
+      this->peak_count = reading.count;
+      uint16_t falling_threshold = (threshold_distance > hysteresis) ? threshold_distance - hysteresis : 0;
+      this->peak_detector.update(reading.distance, threshold_distance, falling_threshold);
+  }
+
+  return this->peak_detector.read();
 }
 
 /**
- * @brief Reads the distance from the sensor at room temperature.
+ * @brief Reads all fields of the latest completed measurement at once.
  *
- * Returns the most recent distance measurement obtained by the sensor. Assumes that the
- * measurement is taken at room temperature, which affects the speed of sound and thus the
- * distance calculation.
+ * Unlike separate calls of readDistance(), readMeasurementCount() and readTimestamp(), the
+ * fields cannot belong to different measurements if an echo is captured in between.
+ *
+ * @return The reading, an empty reading if the sensor is disabled.
+ */
+SonarReading UltrasonicSensor::readSnapshot()
+{
+  if (!this->enabled)
+      return { 0, 0, EchoStatus::NONE, 0, 0 };
+
+  return this->reading.read();
+}
+
+/**
+ * @brief Reads the filtered distance from the sensor.
+ *
+ * Returns the output of the filter pipeline over the most recent measurements obtained by
+ * the sensor, converted at the temperature set with setTemperature(), or at room temperature
+ * if none has been set. A missing echo only shows up as the maximum distance once it outnumbers
+ * the echoes in the median window.
  *
  * @return The distance in centimeters.
  */
@@ -197,5 +509,64 @@ uint16_t UltrasonicSensor::readDistance()
   if (!this->enabled)
       return 0;
 
-  return this->distance;
+  return this->reading.read().distance;
+}
+
+/**
+ * @brief Reads the distance of the latest measurement before the filter pipeline.
+ *
+ * @return The distance in centimeters, the maximum distance for a missing echo.
+ */
+uint16_t UltrasonicSensor::readRawDistance()
+{
+  if (!this->enabled)
+      return 0;
+
+  return this->reading.read().raw_distance;
+}
+
+/**
+ * @brief Reads the outcome of the range gate for the latest measurement.
+ *
+ * @return EchoStatus::VALID for an echo within the range, EchoStatus::BLIND for a rejected
+ * echo from within the blind zone, EchoStatus::MISSED without an echo and EchoStatus::NONE
+ * before the first measurement.
+ */
+EchoStatus UltrasonicSensor::readStatus()
+{
+  if (!this->enabled)
+      return EchoStatus::NONE;
+
+  return this->reading.read().status;
+}
+
+/**
+ * @brief Retrieves the amount of completed measurements.
+ *
+ * The count wraps around after 255 measurements. Comparing it with a previously read
+ * count tells whether readDistance() returns a new measurement.
+ *
+ * @return The amount of completed measurements, including timeouts.
+ */
+uint8_t UltrasonicSensor::readMeasurementCount()
+{
+  if (!this->enabled)
+      return 0;
+
+  return this->reading.read().count;
+}
+
+/**
+ * @brief Retrieves the time at which the last measurement has been completed.
+ *
+ * The age of the distance returned by readDistance() follows from this time.
+ *
+ * @return The time of the falling edge of the echo, or of the timeout, in microseconds.
+ */
+unsigned long UltrasonicSensor::readTimestamp()
+{
+  if (!this->enabled)
+      return 0;
+
+  return this->reading.read().timestamp;
 }
\ No newline at end of file
@@ -7,6 +7,21 @@
  * functionality to initiate distance measurements, process echo signals, and retrieve
  * distance readings. It encapsulates the timing and signal processing required to use
  * ultrasonic sensors effectively in a variety of applications.
+ *
+ * The echo is only waited for as long as the sound takes to travel to the maximum distance
+ * of the sensor and back, so a sensor with a short range reports a miss early. The speed of
+ * sound follows the temperature of the air, which can be set at any time and defaults to
+ * room temperature.
+ *
+ * Every measurement passes a filter pipeline before it is read. A range gate rejects echoes
+ * from within the blind zone of the sensor and marks missing echoes, a median of the last
+ * measurements removes single spikes such as a lost echo next to a wall, and an optional
+ * exponential moving average smooths the result. The size of the median and the smoothing
+ * factor are set per sensor, and the status of the latest echo can be read alongside.
+ *
+ * A completed measurement is published as a SonarReading through a Snapshot, in interrupt
+ * context for an interrupt-captured echo. The readings are therefore read without disabling
+ * interrupts, and readSnapshot() returns all fields of the same measurement.
  * 
  * @author Maximilian Kautzsch
  * @copyright Copyright (c) 2024 Maximilian Kautzsch
@@ -17,7 +32,10 @@
 #define ULTRASONICSENSOR_H
 
 #include <inttypes.h>
+#include "Fixed.h"
 #include "MovingAverage.h"
+#include "Debouncer.h"
+#include "Snapshot.h"
 
 #if defined(ARDUINO) && ARDUINO >= 100
 #include "Arduino.h"
@@ -31,6 +49,57 @@ typedef uint32_t pin_size_t;
 typedef uint8_t pin_size_t;
 #endif
 
+#define SONAR_FILTER_WINDOW 5
+#define SONAR_PEAK_MATCHES 2
+#define SONAR_MIN_DISTANCE 2          // Blind zone of the sensor in cm, closer echoes are rejected.
+#define SONAR_MEDIAN_WINDOW 5         // Largest amount of measurements the median is taken over.
+#define SONAR_DEFAULT_MEDIAN_SIZE 3
+#define SONAR_ECHO_DELAY 500          // Time from the trigger to the rising edge of the echo in us.
+#define SONAR_MODULE_TIMEOUT 38000    // Width of the echo pulse the module ends a miss with in us.
+#define SONAR_ROOM_TEMPERATURE 200    // Temperature assumed until another one is set, in 0.1 deg C.
+#define SONAR_MIN_TEMPERATURE -200
+#define SONAR_MAX_TEMPERATURE 600
+
+/**
+ * @enum EchoCapture
+ * @brief Enumerates the ways the echo pulse of the sensor can be timed.
+ *
+ * INTERRUPT timestamps both edges of the echo pulse from a pin-change interrupt, which makes
+ * the measurement independent of how often update() is called. POLLING samples the echo pin
+ * from update() and serves as a fallback for pins that cannot raise interrupts.
+ */
+enum class EchoCapture : uint8_t {
+  POLLING,
+  INTERRUPT
+};
+
+/**
+ * @enum EchoStatus
+ * @brief Enumerates the outcomes of the range gate for the latest measurement.
+ *
+ * VALID echoes lie within the range of the sensor. BLIND echoes have returned from within
+ * the blind zone and are rejected, so they do not reach the filtered distance. MISSED
+ * measurements have no echo within the range and enter the filter as the maximum distance.
+ */
+enum class EchoStatus : uint8_t {
+  NONE,
+  VALID,
+  BLIND,
+  MISSED
+};
+
+/**
+ * @struct SonarReading
+ * @brief Struct to hold the outcome of a completed measurement, published as one snapshot.
+ */
+struct SonarReading {
+  uint16_t distance;        // Output of the filter pipeline in cm.
+  uint16_t raw_distance;    // Distance before the filter pipeline in cm.
+  EchoStatus status;
+  uint8_t count;            // Amount of completed measurements, wrapping around after 255.
+  unsigned long timestamp;  // Time the measurement has been completed at in us.
+};
+
 class UltrasonicSensor {
 public:
   UltrasonicSensor(pin_size_t trigger_pin, pin_size_t echo_pin, uint16_t max_distance);
@@ -38,23 +107,57 @@ public:
   ~UltrasonicSensor();
 
   void begin();
+  void begin(EchoCapture capture_mode);
   void end();
   void update();
   void startMeasurement();
+  void setTemperature(int16_t temperature);
+  void setFilter(uint8_t median_size, Fixed<MOVING_AVERAGE_FRAC_BITS> smoothing_factor = 0);
+  int16_t getTemperature();
+  uint16_t getMaxDistance();
+  unsigned long getEchoTimeout();
   bool isUpdating();
-  bool detectedPeak(uint16_t threshold_distance, uint8_t consecutive_matches);
+  EchoCapture readCaptureMode();
+  bool detectedPeak(uint16_t threshold_distance, uint16_t hysteresis);
+  SonarReading readSnapshot();
   uint16_t readDistance();
+  uint16_t readRawDistance();
+  EchoStatus readStatus();
+  uint8_t readMeasurementCount();
+  unsigned long readTimestamp();
 
 private:
-  MovingAverage<uint16_t, uint16_t> filter;
+  static void echoInterrupt(void *sensor);
+  void captureEcho();
+  void convert(unsigned long pulse_width);
+  void filterMeasurement(uint16_t raw_distance, EchoStatus status);
+  void publish(unsigned long now);
+  uint16_t readMedian();
+
+  MovingAverage<uint16_t, uint16_t, SONAR_FILTER_WINDOW> filter;
+  Debouncer<SONAR_PEAK_MATCHES> peak_detector;
+  EchoCapture capture_mode;
   bool enabled;
-  bool is_updating;
+  volatile bool is_updating;
+  volatile bool echo_armed;
+  volatile bool echo_started;
+  uint8_t peak_count;
   pin_size_t trigger_pin;
   pin_size_t echo_pin;
   uint8_t state;
-  uint16_t distance;
-  uint16_t last_valid_distance;
+  SonarReading latest;  // Measurement being completed, only accessed by the side completing it.
+  Snapshot<SonarReading> reading;
+  uint16_t median_window[SONAR_MEDIAN_WINDOW];
+  uint8_t median_head;
+  uint8_t median_count;
+  uint8_t median_size;
+  Fixed<MOVING_AVERAGE_FRAC_BITS> smoothing_factor;
   uint16_t max_distance;
+  int16_t temperature;
+  Fixed<16> cm_per_microsecond;
+  unsigned long echo_timeout;
+  unsigned long last_micros;
+  volatile unsigned long echo_micros;
 };
 
 #endif  // ULTRASONICSENSOR_H
\ No newline at end of file
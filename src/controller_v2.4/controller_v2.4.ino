@@ -17,15 +17,29 @@
  */
 
 #include <math.h>
-#include <Servo.h>
 #include "UltrasonicSensor.h"
+#include "SonarScheduler.h"
+#include "Debouncer.h"
+#include "Scheduler.h"
+#include "PoseEstimator.h"
+#include "TurnPlanner.h"
+#include "BatteryGovernor.h"
+#include "TrackMap.h"
+#include "Profiler.h"
+#include "Telemetry.h"
+#include "Storage.h"
 #include "Gyroscope.h"
 #include "Config.h"
 #include "Button.h"
 #include "Display.h"
 #include "L298N.h"
+#include "SteeringServo.h"
 #include "Controlling.h"
 #include "Camera.h"
+#include "Tracker.h"
+#include "Fixed.h"
+#include "Benchmark.h"
+#include "StateMachine.h"
 
 ///==================================================
 /// @section    DEFINTIONS
@@ -50,19 +64,32 @@ struct Parameters {
   uint16_t distance_left;
   uint16_t distance_front;
   uint16_t distance_right;
-  uint16_t steering_angle;
+  ServoAngle steering_angle;
   uint16_t x_pos;
+  // Acquisition times of the samples in microseconds
+  unsigned long imu_micros;
+  unsigned long camera_micros;
+  unsigned long distance_left_micros;
+  unsigned long distance_front_micros;
+  unsigned long distance_right_micros;
 };
 
 /**
  * @struct Race
  * @brief Struct to group all race-specified global variables.
+ *
+ * Together with the active state of the race state machine, it holds the complete state of
+ * the race logic, so a run is restarted by clearing it.
  */
 struct Race {
   Direction direction;
   TurnMode turn_mode;
+  TurnDirection park_direction;
   bool enabled;
   bool turning;
+  bool parking_lot_detected;
+  bool track_map_stored;
+  uint8_t parking_lot_index;
   uint8_t sections;
   uint8_t laps;
   int16_t setpoint_yaw_angle;
@@ -78,33 +105,292 @@ struct Safety {
   bool obstacle_steering_blocked;
   bool first_obstacle_detected;
   bool magenta_unlocked;
-  bool obstacles_included;
-  bool parking_enabled;
 };
 
+/**
+ * @struct Boot
+ * @brief Struct to track the staged startup of the devices.
+ */
+struct Boot {
+  DeviceState gyro;
+  DeviceState camera;
+  DeviceState sonars;
+  bool completed;  // No device is pending anymore.
+  bool ready;      // All devices the race relies on are ready.
+  unsigned long start_millis;
+};
+
+/**
+ * @struct TelemetryFrame
+ * @brief Struct to pack the global state into the payload of a telemetry frame.
+ *
+ * All members have a fixed width and the struct is packed, so its layout does not depend on
+ * the compiler. The layout has to match the decoder in tools/telemetry.py.
+ */
+struct __attribute__((packed)) TelemetryFrame {
+  uint32_t timestamp;
+  // Parameters
+  uint8_t colour;
+  int8_t speed;
+  uint8_t voltage;
+  uint8_t y_pos;
+  uint8_t block_index;
+  int16_t angular_velocity;
+  int16_t yaw_angle;
+  uint16_t distance_left;
+  uint16_t distance_front;
+  uint16_t distance_right;
+  uint16_t steering_angle;  // In hundredths of a degree.
+  uint16_t x_pos;
+  // Race
+  uint8_t direction;
+  uint8_t turn_mode;
+  uint8_t race_flags;
+  uint8_t sections;
+  uint8_t laps;
+  int16_t setpoint_yaw_angle;
+  int16_t drift_correction;
+  // Safety
+  uint8_t safety_flags;
+  // Pose
+  int16_t pose_x;
+  int16_t pose_y;
+  // Race state machine
+  uint8_t race_state;
+  uint8_t race_event;   // Event of the last transition.
+  uint16_t state_time;  // Time in the active state in milliseconds, saturated at 65535.
+  // Effective refresh rates of the sonars in Hz
+  uint8_t sonar_rate_left;
+  uint8_t sonar_rate_front;
+  uint8_t sonar_rate_right;
+};
+
+/**
+ * @struct StoredState
+ * @brief Struct to hold the state that is kept in the EEPROM between races.
+ *
+ * Raise STORED_STATE_VERSION whenever the layout changes, so a record of an older firmware is
+ * rejected instead of being misread.
+ */
+struct __attribute__((packed)) StoredState {
+  int32_t gyro_bias;
+  Direction direction;
+  TrackSection track[TRACK_SECTIONS];
+};
+
+/**
+ * @struct LatencyFrame
+ * @brief Struct to pack the latencies of one control cycle into a telemetry frame.
+ *
+ * The age of a sample is the time from its acquisition to the start of the control cycle that
+ * acts on it. The latency of an actuator is the time from the start of the cycle to its
+ * command, 0 if the actuator has not been commanded by the cycle. All times are given in
+ * microseconds and saturate at 65535. The layout has to match the decoder in tools/telemetry.py.
+ */
+struct __attribute__((packed)) LatencyFrame {
+  uint32_t timestamp;  // Start of the control cycle in microseconds.
+  uint16_t imu_age;
+  uint16_t camera_age;
+  uint16_t distance_left_age;
+  uint16_t distance_front_age;
+  uint16_t distance_right_age;
+  uint16_t decision_time;  // Run time of the control cycle.
+  uint16_t servo_latency;
+  uint16_t motor_latency;
+};
+
+// Frame types of the telemetry stream
+const uint8_t TELEMETRY_STATE = 1;
+const uint8_t TELEMETRY_LATENCY = 2;
+
+// Layout version of the state stored in the EEPROM
+const uint8_t STORED_STATE_VERSION = 1;
+
+// Profile of the race, fixed at compile time unless the build lets the button select it at boot
+constexpr bool RACE_PROFILE_SELECTABLE = RaceType::RACE_PROFILE == RaceType::SELECTABLE;
+static RaceType race_type = RACE_PROFILE_SELECTABLE ? RaceType::QUALIFYING : RaceType::RACE_PROFILE;
+
 static Safety safety;
 static Race race;
+static Boot boot;
 static Parameters initial;
 static Parameters last;
 Parameters current;
+static StoredState stored;
+static bool stored_state_valid;
+static LatencyFrame trace;
+static bool trace_pending;
 
 ///ââââââââââââââââââââââââââââââââââââââââââââââââââ
 /// @subsection Objects
 ///ââââââââââââââââââââââââââââââââââââââââââââââââââ
 
+// Range of the sonars, which covers the length of a section for the stopping position in front
+// and the far wall behind a corner at the sides, see getDirection(). A missing echo is reported
+// as this distance once the sound could have returned from it.
+const uint16_t SONAR_RANGE = 300;
+
+// Voltages of the battery in the scale of the voltage measurement, about ten per volt on the
+// 2S pack. The speeds are tuned at the nominal voltage, a weak pack should be charged before
+// the next run and a critical one is close to browning out the supply of the controller.
+const uint8_t NOMINAL_VOLTAGE = 80;
+const uint8_t WEAK_VOLTAGE = 70;
+const uint8_t CRITICAL_VOLTAGE = 64;
+
 // Initialize the sensor and button objects
-UltrasonicSensor sonarLeft(Pins::TRIGGER_PIN_LEFT, Pins::ECHO_PIN_LEFT);
-UltrasonicSensor sonarFront(Pins::TRIGGER_PIN_FRONT, Pins::ECHO_PIN_FRONT);
-UltrasonicSensor sonarRight(Pins::TRIGGER_PIN_RIGHT, Pins::ECHO_PIN_RIGHT);
+UltrasonicSensor sonarLeft(Pins::TRIGGER_PIN_LEFT, Pins::ECHO_PIN_LEFT, SONAR_RANGE);
+UltrasonicSensor sonarFront(Pins::TRIGGER_PIN_FRONT, Pins::ECHO_PIN_FRONT, SONAR_RANGE);
+UltrasonicSensor sonarRight(Pins::TRIGGER_PIN_RIGHT, Pins::ECHO_PIN_RIGHT, SONAR_RANGE);
+SonarScheduler sonars(sonarLeft, sonarFront, sonarRight);
 L298N motor(Pins::MOTOR_FORWARD_PIN, Pins::MOTOR_BACKWARD_PIN);
 Button button(Pins::BUTTON_PIN);
-Servo servo;
+SteeringServo servo(Pins::SERVO_PIN);
 Camera camera;
+Tracker tracker;
+PoseEstimator pose;
+TurnPlanner planner;
+BatteryGovernor governor;
+TrackMap trackMap;
 Gyroscope gyro;
 Display display;
+Telemetry telemetry(Serial);
+Storage<StoredState> storage(0, STORED_STATE_VERSION);
+Benchmark benchmark;
+
+// Initialize the steering controllers. The wall controller cascades a wall distance loop,
+// which corrects the heading, with a heading loop, which outputs the steering angle.
+PIDController headingController(ControllerDirection::DIRECT);
+PIDController wallDistanceController(ControllerDirection::DIRECT);
+PIDController wallHeadingController(ControllerDirection::REVERSE);
+CascadeController wallController(wallDistanceController, wallHeadingController);
+
+// Gain schedules of the steering controllers over the speed, one row per turn mode.
+// Heading gains are degrees of steering per degree of heading error, wall gains are
+// degrees of heading correction per centimeter of distance error.
+const uint8_t NUM_SCHEDULED_GAINS = 3;
+const uint8_t MAX_DRIFT_CORRECTION = 20;
+const PIDGains HEADING_GAINS[][NUM_SCHEDULED_GAINS] = {
+  { { 40, 2.0, 0.5, 0.10 }, { 60, 1.5, 0.5, 0.15 }, { 90, 1.0, 0.3, 0.20 } },  // SHARP
+  { { 40, 1.8, 0.4, 0.10 }, { 60, 1.3, 0.4, 0.15 }, { 90, 0.9, 0.2, 0.20 } }   // SWIFT
+};
+const PIDGains WALL_GAINS[][NUM_SCHEDULED_GAINS] = {
+  { { 40, 1.0, 0.10, 0.0 }, { 60, 0.8, 0.10, 0.0 }, { 90, 0.5, 0.05, 0.0 } },  // SHARP
+  { { 40, 0.8, 0.10, 0.0 }, { 60, 0.6, 0.05, 0.0 }, { 90, 0.4, 0.05, 0.0 } }   // SWIFT
+};
 
-// Initialize the controller
-DoubleSetpointController controller(ControllerDirection::DIRECT);
+// Initialize the debouncers of the camera-based detections
+Debouncer<2> parkingLotDetector;
+
+// Show the profiler statistics instead of the sensor data on the display
+static bool profiler_view_enabled;
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection Tasks
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+// Task functions, defined in the METHODS section.
+void control();
+void updateImu();
+void updateCamera();
+void updateSonars();
+void compensateTemperature();
+void updateMotor();
+void showData();
+void flushDisplay();
+void profile();
+void sendTelemetry();
+void flushTelemetry();
+
+/**
+ * @brief Static task table of the cooperative scheduler.
+ *
+ * Periods and budgets are given in microseconds, priorities ascending from 0. The control
+ * task has the highest priority, so the display never delays it. Background tasks with a
+ * period of 0 run on every pass of the main loop.
+ */
+Task tasks[] = {
+  { "control", control, 1000000 / 20, 0, 2000 },
+  { "imu", updateImu, 1000000 / 100, 1, 3000 },
+  { "camera", updateCamera, 1000000 / 100, 2, 3000 },
+  { "telemetry", sendTelemetry, 1000000 / 100, 2, 200 },
+  { "temperature", compensateTemperature, 1000000, 3, 1000 },
+  { "display", showData, 1000000 / 5, 3, 1000 },
+  { "lcd", flushDisplay, 1000000 / 100, 3, 6000 },
+  { "profiler", profile, 1000000 / 20, 3, 1000 },
+  { "sonars", updateSonars, 0, 4, 0 },
+  { "motor", updateMotor, 0, 4, 0 },
+  { "serial", flushTelemetry, 0, 4, 0 }
+};
+
+Scheduler scheduler(tasks);
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection States
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+// State actions, defined in the METHODS section.
+void beginRun();
+bool updateDriving();
+bool driveStraight();
+void beginTurn();
+bool steerTurn();
+bool correctTurn();
+void endTurn();
+void completeTurn();
+bool approachParkingLot();
+void beginParkingTurn();
+bool steerParkingTurn();
+bool correctParkingTurn();
+void stop();
+void restartMotor();
+
+typedef StateMachine<RaceState, RaceEvent> RaceMachine;
+
+// Durations of the timed states in milliseconds
+const uint16_t REVERSE_DURATION = 4000;
+const uint16_t PARKING_APPROACH_DURATION = 1200;
+
+/**
+ * @brief Static state table of the race logic, indexed by the states.
+ *
+ * Each state names its parent, the substate entered along with it, its timeout with the event
+ * dispatched on it, and its entry, update and exit actions. The control task updates the
+ * active states from the outside in, so DRIVING takes the decisions of the upper layers
+ * before its substates navigate.
+ */
+const RaceMachine::State RACE_STATES[] = {
+  { "run", RaceState::NONE, RaceState::DRIVING, 0, RaceEvent::NONE, beginRun, nullptr, nullptr },
+  { "driving", RaceState::RUN, RaceState::STRAIGHT, 0, RaceEvent::NONE, nullptr, updateDriving, nullptr },
+  { "straight", RaceState::DRIVING, RaceState::NONE, 0, RaceEvent::NONE, nullptr, driveStraight, nullptr },
+  { "turn", RaceState::DRIVING, RaceState::TURNING, 0, RaceEvent::NONE, beginTurn, nullptr, endTurn },
+  { "turning", RaceState::TURN, RaceState::NONE, 0, RaceEvent::NONE, nullptr, steerTurn, nullptr },
+  { "correcting", RaceState::TURN, RaceState::NONE, REVERSE_DURATION, RaceEvent::TURN_COMPLETED, nullptr, correctTurn, nullptr },
+  { "parking", RaceState::RUN, RaceState::PARK_APPROACHING, 0, RaceEvent::NONE, nullptr, nullptr, nullptr },
+  { "park_approaching", RaceState::PARKING, RaceState::NONE, PARKING_APPROACH_DURATION, RaceEvent::CORNER_REACHED, nullptr, approachParkingLot, nullptr },
+  { "park_turning", RaceState::PARKING, RaceState::NONE, 0, RaceEvent::NONE, beginParkingTurn, steerParkingTurn, nullptr },
+  { "park_correcting", RaceState::PARKING, RaceState::NONE, REVERSE_DURATION, RaceEvent::TURN_COMPLETED, nullptr, correctParkingTurn, nullptr },
+  { "stopped", RaceState::RUN, RaceState::NONE, 0, RaceEvent::NONE, stop, nullptr, restartMotor }
+};
+
+/**
+ * @brief Static transition table of the race logic.
+ *
+ * A transition of a state is taken in all of its substates as well. The run is only restarted
+ * once the robot has stopped, so a press of the button cannot reset the race while it drives.
+ */
+const RaceMachine::Transition RACE_TRANSITIONS[] = {
+  { RaceState::STOPPED, RaceEvent::RESTART, RaceState::RUN, nullptr },
+  { RaceState::DRIVING, RaceEvent::FINISH_REACHED, RaceState::STOPPED, nullptr },
+  { RaceState::DRIVING, RaceEvent::PARKING_LOT_PASSED, RaceState::PARKING, nullptr },
+  { RaceState::STRAIGHT, RaceEvent::CORNER_REACHED, RaceState::TURN, nullptr },
+  { RaceState::TURNING, RaceEvent::CORRECTION_REQUIRED, RaceState::CORRECTING, nullptr },
+  { RaceState::TURN, RaceEvent::TURN_COMPLETED, RaceState::STRAIGHT, completeTurn },
+  { RaceState::PARK_APPROACHING, RaceEvent::CORNER_REACHED, RaceState::PARK_TURNING, nullptr },
+  { RaceState::PARK_TURNING, RaceEvent::CORRECTION_REQUIRED, RaceState::PARK_CORRECTING, nullptr },
+  { RaceState::PARKING, RaceEvent::TURN_COMPLETED, RaceState::STOPPED, nullptr }
+};
+
+RaceMachine raceMachine(RACE_STATES, RACE_TRANSITIONS);
 
 ///ââââââââââââââââââââââââââââââââââââââââââââââââââ
 /// @subsection Setup
@@ -118,36 +404,73 @@ DoubleSetpointController controller(ControllerDirection::DIRECT);
  * called once when the program starts.
  */
 void setup() {
+  // Init the profiler first, so the time to ready covers the complete startup.
+  Profiler::begin();
+  boot.start_millis = millis();
+
+  // In the benchmark mode, the robot only measures its control code, see runBenchmark().
+  if (Mode::BENCHMARK_MODE) {
+    Serial.begin(SERIAL_BAUD_RATE);
+    benchmark.begin(Serial, Profiler::readCycles, Profiler::readClockRate());
+    return;
+  }
+
   // Init communication protocols
-  Serial.begin(9600);
+  Serial.begin(SERIAL_BAUD_RATE);
+  telemetry.begin();
 
-  // Init sensors
-  gyro.begin();
+  // Init sensors. The gyroscope and the camera have to answer before they can be used, which
+  // is left to the stages of bootUp(), so a missing device cannot hold up the setup.
+  gyro.setScale(1007);
   sonarLeft.begin();
   sonarFront.begin();
   sonarRight.begin();
+  // The front sonar times the turns, so its echoes bypass the delay of the median and its spikes
+  // are gated by the pose estimator. The side sonars keep the median against false gaps and
+  // collision risks.
+  sonarFront.setFilter(1);
+  sonars.begin();
   camera.begin();
+  tracker.reset();
   button.begin();
+  loadStoredState();
   pinMode(Pins::RELAY_PIN, OUTPUT);
 
-  // Init actuators
+  // Init actuators, the motor speeds are tuned at the nominal voltage of the battery.
   motor.begin();
-  servo.attach(Pins::SERVO_PIN);
+  governor.begin(NOMINAL_VOLTAGE, WEAK_VOLTAGE, CRITICAL_VOLTAGE);
+  motor.setNominalVoltage(governor.getNominalVoltage());
+  current.voltage = map(analogRead(Pins::VOLTAGE_MEASUREMENT_PIN), 0, 1023, 0, 100);
+  governor.update(current.voltage);
+  servo.begin();
   servo.write(Constants::STRAIGHT);
 
-  // Init the lcd display
-  lcd.init();
-  lcd.backlight();
+  // Init the lcd display, which shows the status of the devices until the robot is ready
+  display.begin();
   display.bootup();
 
-  // Init controller
-  controller.begin();
-  controller.setHysteresis(1);
+  // Init the steering controllers around the straight position of the servo
+  initSteeringController(headingController);
+  initSteeringController(wallHeadingController);
+  wallDistanceController.begin();
+  wallDistanceController.setSampleTime(10);
+  wallDistanceController.setLimits(-MAX_DRIFT_CORRECTION, MAX_DRIFT_CORRECTION);
+  wallController.begin();
 
   // Init Race Parameters
-  safety.obstacles_included = Mode::OBSTACLES_INCLUDED;
-  safety.parking_enabled = Mode::PARKING_ENABLED;
   race.direction = Direction::NONE;
+  scheduleSteeringGains();
+
+  // Init the turn planner with the straight speed and the braking of the motor
+  planner.begin(Constants::STRAIGHT_SPEED);
+  planner.setSpeedGain(pose.getSpeedGain());
+  planner.setDeceleration(MOTOR_DEFAULT_DECELERATION);
+
+  // Init the track map, which is learned on the first lap
+  trackMap.begin();
+
+  // Init the scheduler last, so the first releases are not delayed by the setup.
+  scheduler.begin();
 }
 
 
@@ -161,15 +484,18 @@ void setup() {
  * Continuously performs essential tasks such as updating sensor readings,
  * displaying current data, and executing the robot's autonomous control algorithm.
  * This function ensures that the robot responds dynamically to real-time sensor
- * inputs and navigates effectively based on the implemented control logic.
+ * inputs and navigates effectively based on the implemented control logic. Every
+ * task runs from the task table of the scheduler at its own fixed period. In the benchmark
+ * mode, the robot stands still and only waits for the command to run the benchmark.
  */
 void loop() {
-  // Obtain and show the current measurement values on the display.
-  updateSensors();
-  showData();
+  if (Mode::BENCHMARK_MODE) {
+    runBenchmark();
+    return;
+  }
 
-  // The general algorithm of the robot's autonomous control system.
-  (safety.parking_enabled && safety.obstacles_included) ? parkingDemo() : drive();
+  PROFILE_SCOPE("loop");
+  scheduler.run();
 }
 
 
@@ -183,43 +509,71 @@ void loop() {
 ///ââââââââââââââââââââââââââââââââââââââââââââââââââ
 
 /**
- * @brief Executes the robot's autonomous control algorithm.
+ * @brief Runs the general algorithm of the robot's autonomous control system.
+ *
+ * Executed by the scheduler as the task of highest priority. Runs one cycle of the race state
+ * machine, which is started once the startup is complete and every device the race relies on
+ * is ready, so the robot does not move before. Whether the robot parks or stops at the end of
+ * the race depends on the enabled modes.
+ */
+void control() {
+  if (!bootUp())
+    return;
+
+  storeCalibration();
+  beginTrace();
+  raceMachine.update();
+  endTrace();
+}
+
+/**
+ * @brief Executes the upper layers of the robot's autonomous control algorithm.
  * 
- * Implements a multi-layered decision-making process to control the robot's movement during a race.
- * The function evaluates the current state, including laps completed, potential collisions, and
- * obstacles, and responds with appropriate actions such as stopping, parking, avoiding collisions,
- * steering, or turning. This hierarchical structure ensures the robot navigates efficiently and safely.
+ * Update action of the DRIVING state. Implements a multi-layered decision-making process to
+ * control the robot's movement during a race. The function evaluates the laps completed, the
+ * parking lot and potential collisions, and responds with stopping, parking or avoiding a
+ * collision. Otherwise the navigation is prepared and left to the active substate, which
+ * either follows the straight or turns.
  *
  * @note The algorithm unfolds in three layers:
  * 1 Parking maneuvers or stopping
  * 2 Collision avoidance
  * 3 Navigation (obstacle steering, gyro-based steering, turning)
+ *
+ * @return True if the cycle has been handled by an upper layer, false to navigate.
  */
-void drive() {
-  //âââââ PARAMETERS âââââ
-  const uint8_t FREQUENCY = 20;
-  //ââââââââââââââââââââââ
+bool updateDriving() {
+  bool parking = raceProfile().parking_enabled && raceProfile().obstacles_included;
+  bool finishing = !parking && getLaps() >= 3;
 
-  static unsigned long last_millis;
-
-  if (millis() - last_millis > (1000 / FREQUENCY)) {
-    last_millis = millis();
-
-    // LAYER 1
-    if (getLaps() >= 3) {
-      handleStop(safety.obstacles_included);
-    } else {
-      // LAYER 2
-      if (collisionRisk()) {
-        avoidCollision();
-      } else {
-        // LAYER 3
-        safety.obstacles_included ? handleTurns(TurnMode::SWIFT) : handleTurns(TurnMode::SHARP);
-      }
-    }
+  // Refresh the sonars that the current layer relies on more often.
+  sonars.setPriority((race.turning || finishing) ? SonarPriority::FRONT : SonarPriority::SIDES);
+
+  // LAYER 1
+  if (parking && parkingDemo())
+    return true;
+  if (finishing && reachedFinish()) {
+    raceMachine.dispatch(RaceEvent::FINISH_REACHED);
+    return true;
+  }
+
+  // LAYER 2: From the last lap on and while parking, the turns may block collision avoidance.
+  bool blockable = parking || finishing;
+  if (collisionRisk() && !(blockable && safety.collision_avoidance_blocked)) {
+    avoidCollision();
+    return true;
   }
 
-  motor.write(current.speed);
+  // LAYER 3: Adapt the steering to the turn mode and the speed of the last cycle.
+  scheduleSteeringGains();
+
+  // Preparing to initiate a turn based on detected track conditions and vehicle orientation.
+  if (getDirection()) restoreTrackMap();
+
+  // Plan the start of the turn and the braking from the front distance and the speed.
+  if (race.turn_mode == TurnMode::SHARP) planner.update(current.distance_front, pose.readSpeed(), gyro.readAngularVelocity());
+
+  return false;
 }
 
 
@@ -228,101 +582,91 @@ void drive() {
 ///ââââââââââââââââââââââââââââââââââââââââââââââââââ
 
 /**
- * @brief Handles the stopping behavior of the robot, considering obstacle presence.
- * 
- * This function manages the stopping process of the robot based on whether obstacles
- * are included in the race. It implements a three-layer decision-making process to
- * ensure safe and effective stopping or turning actions. The layers include checking
- * for stopping conditions, avoiding collisions, and handling turns.
- * 
- * @param obstacles_included A boolean flag indicating whether obstacles are included
- * in the race scenario.
+ * @brief Prepares a run of the race from the current pose of the robot.
+ *
+ * Entry action of the RUN state, which is entered once the startup is complete and again on
+ * every restart. Clears the race progress, the safety flags, the track map and the tracked
+ * pillars, and starts the yaw angle and the pose from the start position, so a restarted run
+ * behaves like the first one after powering up, only without the calibration.
+ */
+void beginRun() {
+  race = Race();
+  race.turn_mode = raceProfile().obstacles_included ? TurnMode::SWIFT : TurnMode::SHARP;
+  race.enabled = true;
+
+  safety.collision_avoidance_blocked = false;
+  safety.obstacle_steering_blocked = false;
+  safety.first_obstacle_detected = false;
+  safety.magenta_unlocked = false;
+
+  parkingLotDetector.reset();
+  tracker.reset();
+  trackMap.begin();
+  resetSteeringControllers();
+
+  // The start position is the origin of the yaw angle and of the first section.
+  gyro.resetAngle();
+  current.yaw_angle = gyro.readYawAngle();
+  if (current.distance_front && current.distance_front < sonarFront.getMaxDistance()) initial.distance_front = current.distance_front;
+  pose.begin(race.setpoint_yaw_angle, initial.distance_front);
+  governor.beginSection();
+
+  current.speed = 0;
+  current.steering_angle = Constants::STRAIGHT;
+  updateSteeringAngle();
+}
+
+/**
+ * @brief Checks whether the robot has returned to its start position after the last lap.
+ *
+ * With obstacles, the robot has to complete 12 sections and reach the start position along
+ * the last one. The estimated position rejects echoes from pillars, unlike the raw front
+ * distance. Without obstacles, the front distance the robot has started at is reached again.
+ *
+ * @return True if the robot should stop, false otherwise.
  */
-void handleStop(bool obstacles_included) {
-  switch (obstacles_included) {
+bool reachedFinish() {
+  switch (raceProfile().obstacles_included) {
     case true:
       {
-        //âââââ PARAMETERS âââââ
-        const uint16_t LAST_SECTION_DURATION = 3200;
-        //ââââââââââââââââââââââ
-
-        // Static variables for managing the stopping timer.
-        static bool stopping_timer_locked;
-        static unsigned long stopping_timer;
-
-        // Check if the robot has completed 12 sections and start the stopping timer.
-        if (getSections() >= 12 && !stopping_timer_locked) {
-          stopping_timer = millis();
-          stopping_timer_locked = true;
-        }
-
-        // Stop the robot if the front distance condition and timer criteria are met.
-        if (current.distance_front <= initial.distance_front + Constants::STOPPING_OFFSET
-            && stopping_timer_locked && millis() - stopping_timer > LAST_SECTION_DURATION) {
-          stop();
-        } else {
-          // LAYER 2: Collision avoidance layer.
-          if (collisionRisk() && !safety.collision_avoidance_blocked) {
-            avoidCollision();
-          } else {
-            // LAYER 3: Handle swift turns when obstacles are included.
-            handleTurns(TurnMode::SWIFT);
-          }
-        }
+        // Position along the last section at which the robot returns to its start position.
+        float stopping_position = POSE_SECTION_LENGTH - initial.distance_front - raceProfile().stopping_offset;
+        return getSections() >= 12 && pose.isLocalized() && pose.readX() >= stopping_position;
       }
-      break;
     case false:
       {
-        // Stop the robot if the front distance condition is met.
-        if (current.distance_front <= initial.distance_front + Constants::STOPPING_OFFSET) {
-          stop();
-        } else {
-          // LAYER 2: Collision avoidance layer.
-          if (collisionRisk() && !safety.collision_avoidance_blocked) {
-            avoidCollision();
-          } else {
-            // LAYER 3: Handle sharp turns when obstacles are not included.
-            handleTurns(TurnMode::SHARP);
-          }
-        }
+        return current.distance_front <= initial.distance_front + raceProfile().stopping_offset;
       }
-      break;
   }
-}
 
-// Global variables for managing the duration between turns.
-const uint16_t INTER_TURN_DURATION = 3000;
-static bool inter_turn_timer_locked = true;
-static long inter_turn_timer = -INTER_TURN_DURATION + 2000;
+  return false;
+}
 
 /**
- * @brief Manages the vehicle's turning behavior based on the specified turn mode.
+ * @brief Navigates the robot along the straight of a section.
  *
- * This function selects and executes the appropriate turning strategy according to the provided
- * turn mode. It allows the vehicle to adapt its turning behavior dynamically based on different
- * scenarios, such as sharp turns or swift turns for precise maneuvering.
+ * Update action of the STRAIGHT state. Follows the heading of the section, and with obstacles
+ * steers around the pillars in view or mapped ahead. Once the corner of the section is
+ * reached, the TURN state is entered, which steers from the next cycle on.
  *
- * @param turn_mode The mode that determines which turn handling strategy to execute. It can be
- * TurnMode::SHARP or TurnMode::SWIFT.
+ * @return True, the cycle has been handled.
  */
-void handleTurns(TurnMode turn_mode) {
-  // Preparing to initiate a turn based on detected track conditions and vehicle orientation.
-  getDirection();
-
-  switch (turn_mode) {
+bool driveStraight() {
+  switch (race.turn_mode) {
     case TurnMode::SHARP:
       {
-        //âââââ PARAMETERS âââââ
-        const uint8_t INITIATING_DISTANCE = 60;  // Distance at which the turning process is started.
-        //ââââââââââââââââââââââ
-
-        // Handles standard turning behavior.
-        if ((detectedGap() && current.distance_front <= INITIATING_DISTANCE) || race.turning) {
-          sharpTurn();
+        // Turn at the position learned on the first lap, or on the detection of the gap.
+        bool turn_reached = (trackMap.isMapped(race.sections) && pose.isLocalized())
+                              ? pose.readX() >= trackMap.readCornerPosition(race.sections)
+                              : detectedGap() && planner.isTurnReached();
+
+        if (turn_reached) {
+          trackMap.recordCorner(race.sections, pose.readX());
+          raceMachine.dispatch(RaceEvent::CORNER_REACHED);
         } else {
           maintainStraightPath(race.setpoint_yaw_angle - current.yaw_angle);
           if (abs(current.yaw_angle) >= 980) current.speed = 60;
-          else current.speed = Constants::DEFAULT_SPEED;
+          else current.speed = planner.readTargetSpeed();
         }
         updateSteeringAngle();
       }
@@ -330,303 +674,274 @@ void handleTurns(TurnMode turn_mode) {
     case TurnMode::SWIFT:
       {
         //âââââ PARAMETERS âââââ
-        const uint8_t INITIATING_MIN_DISTANCE = 0;
         const uint8_t INITIATING_MAX_DISTANCE = 60;
+        const uint8_t TURN_ENTRY_POSITION = 150;  // Position along the section from which turns are allowed.
+        const uint8_t PRE_POSITION_DISTANCE = 50;  // Distance before a mapped pillar to steer to its passing side.
+        const uint8_t PASSING_DISTANCE = 30;  // Distance to the wall on the passing side of a mapped pillar.
         //ââââââââââââââââââââââ
 
         // Sharp-turning specified variables for various conditions.
         int16_t angle_difference;
         bool distance_in_range = (current.distance_front <= INITIATING_MAX_DISTANCE) ? 1 : 0;
         bool angle_in_range = (abs(race.setpoint_yaw_angle - current.yaw_angle) <= 20) ? 1 : 0;
-        bool obstacles_detected = (current.colour == Colour::RED || current.colour == Colour::GREEN) ? 1 : 0;
-        bool inter_turn_timer_passed = (inter_turn_timer_locked && millis() - inter_turn_timer > INTER_TURN_DURATION) ? 1 : 0;
+        bool turn_zone_reached = (pose.readX() >= TURN_ENTRY_POSITION) ? 1 : 0;
         bool large_outer_distance = ((race.direction == Direction::ANTICLOCKWISE && current.distance_right >= 60) || (race.direction == Direction::CLOCKWISE && current.distance_left >= 60)) ? 1 : 0;
 
-        // Handles swift turning behavior for more precise maneuvers.
-        if ((detectedGap() && distance_in_range && angle_in_range && inter_turn_timer_passed) || race.turning) {
-          swiftTurn();
-        } else {
-          // If first obstacle has been detected, save its index to the initial index.
-          if (!safety.first_obstacle_detected && pixy.ccc.numBlocks) {
-            last.block_index = current.block_index;
-            safety.first_obstacle_detected = true;
-          }
+        // Turn at the position learned on the first lap, or on the detection of the gap.
+        bool turn_reached = (trackMap.isMapped(race.sections) && pose.isLocalized())
+                              ? pose.readX() >= trackMap.readCornerPosition(race.sections) && angle_in_range
+                              : detectedGap() && distance_in_range && angle_in_range && turn_zone_reached;
 
-          // If the index has changed, block obstacle steering.
-          if (current.block_index != last.block_index && safety.first_obstacle_detected) {
-            last.block_index = current.block_index;
-            safety.obstacle_steering_blocked = true;
-          }
+        if (turn_reached) {
+          trackMap.recordCorner(race.sections, pose.readX());
+          raceMachine.dispatch(RaceEvent::CORNER_REACHED);
+          break;
+        }
 
-          // If conditions are not met, maintain the current path and manage obstacles.
-          angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
-          if (safety.obstacles_included && pixy.ccc.numBlocks && !safety.obstacle_steering_blocked) {
-            safety.collision_avoidance_blocked = false;
-            obstacleSteering(current.x_pos, current.y_pos, current.colour);
-
-            current.speed = Constants::REDUCED_SPEED;
-          } else if (large_outer_distance) {
-            safety.collision_avoidance_blocked = false;
-            trackOuterWall(60);
-            current.speed = Constants::REDUCED_SPEED;
-          } else {
-            safety.collision_avoidance_blocked = false;
-            maintainStraightPath(angle_difference);
-            current.speed = Constants::REDUCED_SPEED;
-          }
+        // Speed up in sections known to be free of pillars.
+        uint8_t straight_speed = trackMap.isClear(race.sections) ? Constants::STRAIGHT_SPEED : Constants::REDUCED_SPEED;
+        const TrackPillar *next_pillar = trackMap.findNextPillar(race.sections, pose.readX());
+        bool pillar_ahead = next_pillar && pose.readX() + PRE_POSITION_DISTANCE >= next_pillar->position;
 
-          updateSteeringAngle();
+        // If first obstacle has been detected, save its index to the initial index.
+        if (!safety.first_obstacle_detected && tracker.getNumTracks()) {
+          last.block_index = current.block_index;
+          safety.first_obstacle_detected = true;
         }
+
+        // If the index has changed, block obstacle steering.
+        if (current.block_index != last.block_index && safety.first_obstacle_detected) {
+          last.block_index = current.block_index;
+          safety.obstacle_steering_blocked = true;
+        }
+
+        // Maintain the current path and manage obstacles.
+        angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
+        if (raceProfile().obstacles_included && tracker.getNumTracks() && !safety.obstacle_steering_blocked) {
+          safety.collision_avoidance_blocked = false;
+          obstacleSteering(current.x_pos, current.y_pos, current.colour);
+
+          current.speed = Constants::REDUCED_SPEED;
+        } else if (pillar_ahead) {
+          // Steer to the passing side of the mapped pillar before it comes into view.
+          safety.collision_avoidance_blocked = false;
+          if (next_pillar->colour == Colour::RED) trackRightWall(PASSING_DISTANCE);
+          else trackLeftWall(PASSING_DISTANCE);
+          current.speed = Constants::REDUCED_SPEED;
+        } else if (large_outer_distance) {
+          safety.collision_avoidance_blocked = false;
+          trackOuterWall(60);
+          current.speed = straight_speed;
+        } else {
+          safety.collision_avoidance_blocked = false;
+          maintainStraightPath(angle_difference);
+          current.speed = straight_speed;
+        }
+
+        updateSteeringAngle();
       }
       break;
   }
+
+  return true;
+}
+
+/**
+ * @brief Starts a turn into the next section.
+ *
+ * Entry action of the TURN state. Locks the turning process and turns the setpoint yaw angle
+ * by 90 degrees into the race direction.
+ */
+void beginTurn() {
+  race.turning = true;
+  safety.collision_avoidance_blocked = false;
+
+  if (race.direction == Direction::ANTICLOCKWISE) race.setpoint_yaw_angle += 90;
+  else if (race.direction == Direction::CLOCKWISE) race.setpoint_yaw_angle -= 90;
+}
+
+/**
+ * @brief Steers the robot through the corner.
+ *
+ * Update action of the TURNING state, which selects the turning strategy of the turn mode.
+ *
+ * @return True, the cycle has been handled.
+ */
+bool steerTurn() {
+  switch (race.turn_mode) {
+    case TurnMode::SHARP:
+      sharpTurn();
+      break;
+    case TurnMode::SWIFT:
+      swiftTurn();
+      break;
+  }
+
+  return true;
 }
 
 /**
  * @brief Manages the swift turning behavior of the robot.
  *
- * This function controls the turning process of the robot through a state machine approach,
- * ensuring rapid and efficient handling of turns based on the detected track conditions
- * and the vehicle's current orientation. It consists of four states: INITIATE, TURNING,
- * CORRECTING, and COMPLETE, to handle the entire turning process from start to finish.
+ * Steers the robot into the corner at full lock while the outer wall is close, and along the
+ * heading of the next section otherwise. Once the robot gets close to the heading or to the
+ * wall ahead, the rest of the turn is corrected in reverse by the CORRECTING state.
  */
 void swiftTurn() {
-  // Enum for handling different turning states.
-  enum class TurnState : const uint8_t {
-    INITIATE,    // Initial state where the turn is prepared based on track conditions.
-    TURNING,     // State where the robot is actively turning.
-    CORRECTING,  // State for fine-tuning the turn angle.
-    COMPLETE     // State indicating the turn has been completed.
-  };
-
   //âââââ PARAMETERS âââââ
   const uint8_t CORRECTING_ANGLE_DIFFERENCE = 55;
-  const uint16_t REVERSE_DURATION = 4000;
+  const uint16_t STALL_DURATION = 2500;  // Time in ms after which a turn stuck at the front wall is corrected.
+  const uint8_t TURN_LEAD_TIME = 80;     // Time in ms the heading is predicted ahead to end a state.
   //ââââââââââââââââââââââ
 
-  // Variables for maintaining the current state and other control parameters.
-  static TurnState turn_state;
-  static bool updated_setpoint_angle;
-  static bool turning_timer_locked;
   int16_t angle_difference;
-  static unsigned long turning_timer;
+  bool small_outer_distance;
 
-  switch (turn_state) {
-    case TurnState::INITIATE:
-      {
-        // Lock the turning process.
-        inter_turn_timer_locked = false;
-        race.turning = true;
-
-        // Calculate the angle difference between the setpoint and current yaw angle.
-        angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
+  // Specify when the distance to the outer restriction of the parcour is small.
+  if (race.direction == Direction::ANTICLOCKWISE && current.distance_right <= 50) small_outer_distance = true;
+  else if (race.direction == Direction::CLOCKWISE && current.distance_left <= 50) small_outer_distance = true;
+  else small_outer_distance = false;
 
-        // Calculate the angle difference between the setpoint and current yaw angle.
-        safety.collision_avoidance_blocked = false;
-
-        // Update the setpoint yaw angle based on the turning direction.
-        if (!updated_setpoint_angle) {
-          if (race.direction == Direction::ANTICLOCKWISE) race.setpoint_yaw_angle += 90;
-          else if (race.direction == Direction::CLOCKWISE) race.setpoint_yaw_angle -= 90;
-          updated_setpoint_angle = true;
-        }
-        angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
+  // Actively managing the turning process.
+  safety.collision_avoidance_blocked = true;  // Block collision avoidance during turn.
 
-        turn_state = TurnState::TURNING;  // Transition to TURNING state.
-      }
-      break;
-    case TurnState::TURNING:
-      {
-        bool small_outer_distance;
-
-        // Specify when the distance to the outer restriction of the parcour is small.
-        if (race.direction == Direction::ANTICLOCKWISE && current.distance_right <= 50) small_outer_distance = true;
-        else if (race.direction == Direction::CLOCKWISE && current.distance_left <= 50) small_outer_distance = true;
-        else small_outer_distance = false;
-
-        // Actively managing the turning process.
-        safety.collision_avoidance_blocked = true;  // Block collision avoidance during turn.
-
-        // Lock the turning timer if not already locked.
-        if (!turning_timer_locked) {
-          turning_timer = millis();
-          turning_timer_locked = true;
-        }
-
-        switch (small_outer_distance) {
-          case true:
-            {
-              // Calculate the angle difference between the setpoint and current yaw angle.
-              angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
-              if ((abs(angle_difference) <= CORRECTING_ANGLE_DIFFERENCE) || (turning_timer_locked && millis() - turning_timer > 2500) && current.distance_front <= 10) {
-                turn_state = TurnState::CORRECTING;  // Transition to CORRECTING state.
-              } else {
-                // Adjust steering angle based on the direction of the turn.
-                if (race.direction == Direction::ANTICLOCKWISE) {
-                  current.steering_angle = Constants::MAX_LEFT;
-                } else if (race.direction == Direction::CLOCKWISE) {
-                  current.steering_angle = Constants::MAX_RIGHT;
-                }
-              }
-            }
-            break;
-          case false:
-            {
-              // Transition to the turning if the front distance is less than or equal to 5cm.
-              if (current.distance_front <= 5) {
-                turn_state = TurnState::CORRECTING;  // Transition to CORRECTING state.
-              } else {
-                angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
-                if (race.direction == Direction::ANTICLOCKWISE) {
-                  maintainStraightPath(angle_difference - 90);
-                } else if (race.direction == Direction::CLOCKWISE) {
-                  maintainStraightPath(angle_difference + 90);
-                }
-              }
-            }
-            break;
-        }
-
-        current.speed = Constants::REDUCED_SPEED;  // Move the motor in reverse at reduced speed.
-        updateSteeringAngle();
-      }
-      break;
-    case TurnState::CORRECTING:
+  switch (small_outer_distance) {
+    case true:
       {
-        // Fine-tuning the turn angle to correct the robot's orientation.
-        static unsigned long reversing_timer;
-        static bool reversing_timer_locked;
-
-        // Boolean flag for reverse timer.
-        bool reverse_duration_passed = (reversing_timer_locked && millis() - reversing_timer > REVERSE_DURATION) ? 1 : 0;
-
-        safety.collision_avoidance_blocked = true;  // Unblock collision avoidance.
-
-        // Calculate the angle difference between the setpoint and current yaw angle.
-        angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
-
-        // Transition to COMPLETE state after reversing for the specified duration.
-        if (reverse_duration_passed || abs(angle_difference) <= 20) {
-          reversing_timer_locked = false;
-          turn_state = TurnState::COMPLETE;  // Transition to COMPLETE state.
+        // Calculate the angle difference between the setpoint and predicted yaw angle.
+        angle_difference = race.setpoint_yaw_angle - predictYawAngle(TURN_LEAD_TIME);
+        bool stalled = raceMachine.readElapsedTime(RaceState::TURNING) > STALL_DURATION && current.distance_front <= 10;
+        if (abs(angle_difference) <= CORRECTING_ANGLE_DIFFERENCE || stalled) {
+          raceMachine.dispatch(RaceEvent::CORRECTION_REQUIRED);
         } else {
-          // Lock the reversing timer if not already locked.
-          if (!reversing_timer_locked) {
-            reversing_timer = millis();
-            reversing_timer_locked = true;
+          // Adjust steering angle based on the direction of the turn.
+          if (race.direction == Direction::ANTICLOCKWISE) {
+            current.steering_angle = Constants::MAX_LEFT;
+          } else if (race.direction == Direction::CLOCKWISE) {
+            current.steering_angle = Constants::MAX_RIGHT;
           }
-
-          if (angle_difference >= -10 && angle_difference <= 10) current.steering_angle = 90;
-          if (angle_difference < -10 && angle_difference >= -40) current.steering_angle = 90;
-          if (angle_difference > 10 && angle_difference <= 40) current.steering_angle = 90;
-          if (angle_difference < -40) current.steering_angle = Constants::MAX_LEFT;
-          if (angle_difference > 40) current.steering_angle = Constants::MAX_RIGHT;
         }
-
-        current.speed = -Constants::REDUCED_SPEED - 10;  // Move the motor forward at reduced speed.
-        updateSteeringAngle();
       }
       break;
-    case TurnState::COMPLETE:
+    case false:
       {
-        // Finalizing the turn and preparing for the next turn.
-        if (!inter_turn_timer_locked) {
-          inter_turn_timer = millis();
-          inter_turn_timer_locked = true;
+        // Correct the turn once the front distance is less than or equal to 5cm.
+        if (current.distance_front <= 5) {
+          raceMachine.dispatch(RaceEvent::CORRECTION_REQUIRED);
+        } else {
+          angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
+          if (race.direction == Direction::ANTICLOCKWISE) {
+            maintainStraightPath(angle_difference - 90);
+          } else if (race.direction == Direction::CLOCKWISE) {
+            maintainStraightPath(angle_difference + 90);
+          }
         }
-        race.sections++;
-        turning_timer_locked = false;
-        updated_setpoint_angle = false;
-
-        // Unlock the turning process.
-        turn_state = TurnState::INITIATE;
-        safety.first_obstacle_detected = false;
-        safety.obstacle_steering_blocked = false;
-        race.turning = false;
       }
       break;
   }
+
+  current.speed = Constants::REDUCED_SPEED;  // Move the motor in reverse at reduced speed.
+  updateSteeringAngle();
 }
 
 /**
  * @brief Manages the default turning behavior of the robot.
  * 
- * This function controls the turning process of the robot through a state machine approach,
- * ensuring smooth and efficient handling of turns based on the detected track conditions
- * and the vehicle's current orientation. It consists of three states: INITIATE, TURNING,
- * and COMPLETE, to handle the entire turning process from start to finish.
+ * Steers the robot along the planned arc and hands over to the heading controller for the
+ * last degrees. The turn is completed on the predicted heading to avoid overshooting the
+ * setpoint.
  */
 void sharpTurn() {
-  // Enum for handling different turning states.
-  enum class TurnState : const uint8_t {
-    INITIATE,  // Initial state where the turn is prepared based on track conditions.
-    TURNING,   // State where the robot is actively turning.
-    COMPLETE   // State indicating the turn has been completed.
-  };
-
   //âââââ PARAMETERS âââââ
   const uint8_t COMPLETE_ANGLE_DIFFERENCE = 10;  // Angle difference indicating that the process is finished.
+  const uint8_t TURN_LEAD_TIME = 80;             // Time in ms the heading is predicted ahead to end the turn.
   //ââââââââââââââââââââââ
 
-  // Variables for maintaining the current state and other control parameters.
-  static TurnState turn_state;
-  static bool updated_setpoint_angle;
-  int16_t angle_difference;
+  // Slowly transition to complete state by maintaining a straight path
+  // when the angle difference gets smaller from time to time.
+  int16_t angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
+  if (abs(race.setpoint_yaw_angle - predictYawAngle(TURN_LEAD_TIME)) <= COMPLETE_ANGLE_DIFFERENCE) {
+    raceMachine.dispatch(RaceEvent::TURN_COMPLETED);
+  } else if (abs(angle_difference) <= COMPLETE_ANGLE_DIFFERENCE + 20) {
+    maintainStraightPath(angle_difference);
+  } else {
+    // Steer along the planned arc based on the direction of the turn.
+    if (race.direction == Direction::ANTICLOCKWISE) {
+      current.steering_angle = Constants::STRAIGHT - planner.readSteeringDeflection();
+    } else if (race.direction == Direction::CLOCKWISE) {
+      current.steering_angle = Constants::STRAIGHT + planner.readSteeringDeflection();
+    }
+  }
 
-  switch (turn_state) {
-    case TurnState::INITIATE:
-      {
-        // Lock the turning process.
-        race.turning = true;
-
-        // The default turning mode prioritizes gap detection and front distance.
-        if (!updated_setpoint_angle) {
-          if (race.direction == Direction::ANTICLOCKWISE) race.setpoint_yaw_angle += 90;
-          else if (race.direction == Direction::CLOCKWISE) race.setpoint_yaw_angle -= 90;
-          updated_setpoint_angle = true;
-        }
-        angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
+  if (abs(current.yaw_angle) >= 980) current.speed = 60;
+  else current.speed = planner.readCornerSpeed();
+  updateSteeringAngle();
+}
 
-        turn_state = TurnState::TURNING;  // Transition to TURNING state.
-      }
-      break;
-    case TurnState::TURNING:
-      {
-        // Slowly transition to complete state by maintaining a straight path
-        // when the angle difference gets smaller from time to time.
-        angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
-        if (abs(angle_difference) <= COMPLETE_ANGLE_DIFFERENCE) {
-          turn_state = TurnState::COMPLETE;  // Transition to COMPLETE state.
-        } else if (abs(angle_difference) <= COMPLETE_ANGLE_DIFFERENCE + 20) {
-          maintainStraightPath(angle_difference);
-        } else {
-          // Adjust steering angle based on the direction of the turn.
-          if (race.direction == Direction::ANTICLOCKWISE) {
-            current.steering_angle = Constants::MAX_LEFT;
-          } else if (race.direction == Direction::CLOCKWISE) {
-            current.steering_angle = Constants::MAX_RIGHT;
-          }
-        }
+/**
+ * @brief Corrects the heading at the end of a swift turn in reverse.
+ *
+ * Update action of the CORRECTING state. Reverses with the steering set against the
+ * remaining angle difference, until the predicted heading is close to the setpoint or the
+ * timeout of the state has passed.
+ *
+ * @return True, the cycle has been handled.
+ */
+bool correctTurn() {
+  //âââââ PARAMETERS âââââ
+  const uint8_t TURN_LEAD_TIME = 80;  // Time in ms the heading is predicted ahead to end a state.
+  //ââââââââââââââââââââââ
 
-        if (abs(current.yaw_angle) >= 980) current.speed = 60;
-        else current.speed = Constants::DEFAULT_SPEED;
-        updateSteeringAngle();
-      }
-      break;
-    case TurnState::COMPLETE:
-      {
-        current.steering_angle = 90;
-        updateSteeringAngle();
-        race.sections++;
-        updated_setpoint_angle = false;
+  safety.collision_avoidance_blocked = true;
 
-        // Unlock the turning process.
-        turn_state = TurnState::INITIATE;
-        race.turning = false;
-        return;
-      }
-      break;
+  // Calculate the angle difference between the setpoint and current yaw angle.
+  int16_t angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
+
+  if (abs(race.setpoint_yaw_angle - predictYawAngle(TURN_LEAD_TIME)) <= 20) {
+    raceMachine.dispatch(RaceEvent::TURN_COMPLETED);
+  } else {
+    if (angle_difference >= -10 && angle_difference <= 10) current.steering_angle = 90;
+    if (angle_difference < -10 && angle_difference >= -40) current.steering_angle = 90;
+    if (angle_difference > 10 && angle_difference <= 40) current.steering_angle = 90;
+    if (angle_difference < -40) current.steering_angle = Constants::MAX_LEFT;
+    if (angle_difference > 40) current.steering_angle = Constants::MAX_RIGHT;
+  }
+
+  current.speed = -Constants::REDUCED_SPEED - 10;  // Move the motor forward at reduced speed.
+  updateSteeringAngle();
+
+  return true;
+}
+
+/**
+ * @brief Unlocks the turning process.
+ *
+ * Exit action of the TURN state.
+ */
+void endTurn() {
+  race.turning = false;
+}
+
+/**
+ * @brief Finalizes the turn and prepares for the next one.
+ *
+ * Action of the transition from the TURN state to the STRAIGHT state. Moves the pose, the
+ * steering controllers and the track map into the new section. A sharp turn ends with the
+ * steering set straight.
+ */
+void completeTurn() {
+  if (race.turn_mode == TurnMode::SHARP) {
+    current.steering_angle = Constants::STRAIGHT;
+    updateSteeringAngle();
   }
+
+  pose.beginSection(race.setpoint_yaw_angle);
+  resetSteeringControllers();
+  race.sections++;
+  trackMap.beginSection(race.sections);
+  governor.beginSection();
+  safety.first_obstacle_detected = false;
+  safety.obstacle_steering_blocked = false;
 }
 
 
@@ -635,256 +950,477 @@ void sharpTurn() {
 ///ââââââââââââââââââââââââââââââââââââââââââââââââââ
 
 /**
- * @brief Captures initial measurement values to establish a baseline.
+ * @brief Brings up the devices in parallel stages, each with its own timeout.
+ *
+ * Executed by the control task until the startup is complete. Every call advances each pending
+ * device by one step without waiting for it: the gyroscope is probed until it answers and then
+ * calibrates, unless its stored bias is restored, the camera is pinged until it has booted, the
+ * sonars have to deliver their first echoes, and the relay is pulsed into its known state. A
+ * device that is not ready within its timeout is marked as failed, so the startup always comes
+ * to an end. The camera is only pinged and waited for if the race includes obstacles. In a
+ * build with a selectable profile, the startup lasts for at least PROFILE_SELECTION_DURATION,
+ * during which every press of the button advances to the next profile. Once every device is
+ * ready, the race state machine is started.
  *
- * Engages the IMU and front sonar to record the starting orientation and distance. This function
- * sets the initial conditions that future measurements will be compared against, ensuring accurate
- * relative readings throughout the robot's operation.
+ * @return True if the startup is complete and every device the race relies on is ready.
  */
-void initGyroscope() {
-  static bool is_initialized;
+bool bootUp() {
+  //âââââ PARAMETERS âââââ
+  const uint16_t GYRO_TIMEOUT = 3000;    // Includes the bias calibration of one second.
+  const uint16_t CAMERA_TIMEOUT = 4000;  // The camera takes about two seconds to boot.
+  const uint16_t SONAR_TIMEOUT = 500;
+  const uint16_t PROFILE_SELECTION_DURATION = 5000;
+  //ââââââââââââââââââââââ
 
-  if (!is_initialized) {
-    mpu.calcOffsets();
-    mpu.update();
-    initial.yaw_angle = mpu.getAngleZ();
-    is_initialized = true;
+  static bool gyro_found;
+
+  if (boot.completed)
+    return boot.ready;
+
+  unsigned long elapsed = millis() - boot.start_millis;
+
+  if (boot.gyro == DeviceState::PENDING) {
+    if (!gyro_found && gyro.begin()) {
+      gyro_found = true;
+      if (stored_state_valid) gyro.setBias(stored.gyro_bias);
+    }
+
+    if (gyro.isCalibrated()) {
+      boot.gyro = DeviceState::READY;
+    } else if (elapsed >= GYRO_TIMEOUT) {
+      boot.gyro = DeviceState::FAILED;
+    }
   }
+
+  bool relay_ready = initRelay();
+
+  // Select the profile by the amount of presses, and with it whether the camera is required.
+  if (RACE_PROFILE_SELECTABLE) race_type = RaceType(button.readCount() % NUM_RACE_PROFILES);
+  bool camera_required = raceProfile().obstacles_included;
+
+  if (camera_required && boot.camera == DeviceState::PENDING) {
+    if (camera.connect()) {
+      boot.camera = DeviceState::READY;
+    } else if (elapsed >= CAMERA_TIMEOUT) {
+      boot.camera = DeviceState::FAILED;
+    }
+  }
+
+  if (boot.sonars == DeviceState::PENDING) {
+    // A sonar without an echo reports its maximum distance, which no wall is away at the start.
+    bool left_valid = current.distance_left && current.distance_left < sonarLeft.getMaxDistance();
+    bool front_valid = current.distance_front && current.distance_front < sonarFront.getMaxDistance();
+    bool right_valid = current.distance_right && current.distance_right < sonarRight.getMaxDistance();
+    if (left_valid && front_valid && right_valid) {
+      boot.sonars = DeviceState::READY;
+    } else if (elapsed >= SONAR_TIMEOUT) {
+      boot.sonars = DeviceState::FAILED;
+    }
+  }
+
+  if (boot.gyro == DeviceState::PENDING || boot.sonars == DeviceState::PENDING || !relay_ready
+      || (camera_required && boot.camera == DeviceState::PENDING)
+      || (RACE_PROFILE_SELECTABLE && elapsed < PROFILE_SELECTION_DURATION))
+    return false;
+
+  boot.completed = true;
+  boot.ready = boot.gyro == DeviceState::READY && boot.sonars == DeviceState::READY
+               && (!camera_required || boot.camera == DeviceState::READY);
+  if (boot.ready) {
+    Profiler::markReady();
+    raceMachine.begin(RaceState::RUN);
+  }
+
+  return boot.ready;
 }
 
 /**
- * @brief Captures initial measurement values of the front sonar to establish a baseline.
+ * @brief Loads the state stored in the EEPROM by a previous race.
  *
- * Activates the front sonar to record the starting distance. This function sets the initial
- * condition for the front sonar that future measurements will be compared against, ensuring
- * accurate distance readings throughout the robot's operation.
+ * A valid gyroscope bias is restored by bootUp(), so the robot is ready to race without waiting
+ * for the calibration. Holding the button while the robot powers up erases the stored state and forces
+ * a new calibration, such as after the temperature has changed a lot.
  */
-void initSonars() {
-  static bool is_initialized;
+void loadStoredState() {
+  if (digitalRead(Pins::BUTTON_PIN) == LOW) {
+    storage.erase();
+    return;
+  }
 
-  if (!is_initialized && current.distance_front != 0 && current.distance_front != 400) {
-    initial.distance_front = current.distance_front;
-    is_initialized = true;
+  stored_state_valid = storage.load(stored);
+}
+
+/**
+ * @brief Stores the gyroscope bias once a fresh calibration has been completed.
+ *
+ * The track map of the previous race is kept. Only the bytes that have changed are written,
+ * so storing the bias does not hold up the first control cycle noticeably.
+ */
+void storeCalibration() {
+  static bool is_stored;
+
+  if (is_stored)
+    return;
+  is_stored = true;
+
+  if (stored_state_valid && stored.gyro_bias == gyro.getBias())
+    return;
+
+  if (!stored_state_valid) {
+    stored.direction = Direction::NONE;
+    memset(stored.track, 0, sizeof(stored.track));
   }
+
+  stored.gyro_bias = gyro.getBias();
+  storage.save(stored);
+  stored_state_valid = true;
+}
+
+/**
+ * @brief Restores the track map of the previous race once the race direction is known.
+ *
+ * Only used if enabled in the modes and if the previous map has been learned in the same
+ * direction, since the layout of the track is typically changed between the rounds.
+ */
+void restoreTrackMap() {
+  if (!Mode::PERSISTENT_TRACK_MAP || !stored_state_valid || stored.direction != race.direction)
+    return;
+
+  // The stored record is packed, so the sections are copied out to an aligned buffer first.
+  TrackSection sections[TRACK_SECTIONS];
+  memcpy(sections, stored.track, sizeof(sections));
+  trackMap.restore(sections);
+}
+
+/**
+ * @brief Stores the track map once the race has ended, if every section has been learned.
+ *
+ * The map is stored once per run, so the map learned after a restart is stored as well.
+ */
+void storeTrackMap() {
+  if (race.track_map_stored || !trackMap.isComplete())
+    return;
+  race.track_map_stored = true;
+
+  stored.gyro_bias = gyro.getBias();
+  stored.direction = race.direction;
+  memcpy(stored.track, trackMap.getSections(), sizeof(stored.track));
+  storage.save(stored);
+  stored_state_valid = true;
 }
 
 /**
  * @brief Initializes the relay to ensure it starts in a known state.
  *
- * This function sets the relay pin to HIGH and then LOW with a short delay in between, ensuring the relay
- * is correctly initialized. This initial setup is only performed once, as indicated by the static
- * is_initialized variable.
+ * This function sets the relay pin to HIGH and, on a later call once the pulse duration has
+ * passed, back to LOW, so the pulse does not block. This initial setup is only performed once,
+ * as indicated by the static is_initialized variable.
+ *
+ * @return True once the relay is initialized, false while the pulse is running.
  */
-void initRelay() {
+bool initRelay() {
+  //âââââ PARAMETERS âââââ
+  const uint8_t PULSE_DURATION = 100;
+  //ââââââââââââââââââââââ
+
   static bool is_initialized;
+  static bool is_pulsing;
+  static unsigned long pulse_millis;
 
   if (!is_initialized) {
-    digitalWrite(Pins::RELAY_PIN, HIGH);
-    delay(100);
-    digitalWrite(Pins::RELAY_PIN, LOW);
-    is_initialized = true;
+    if (!is_pulsing) {
+      digitalWrite(Pins::RELAY_PIN, HIGH);
+      pulse_millis = millis();
+      is_pulsing = true;
+    } else if (millis() - pulse_millis >= PULSE_DURATION) {
+      digitalWrite(Pins::RELAY_PIN, LOW);
+      is_initialized = true;
+    }
   }
+
+  return is_initialized;
 }
 
 /**
  * @brief Ceases all robot activities, transitioning to a safe, inactive state.
  *
- * Commands the robot to a full stop by setting the steering to a neutral position and powering down
- * the motor and servo. This function is critical for ensuring the robot's immediate cessation of
- * movement in response to external commands or internal conditions.
+ * Entry action of the STOPPED state. Commands the robot to a full stop by setting the steering
+ * to a neutral position and powering down the motor and servo. This function is critical for
+ * ensuring the robot's immediate cessation of movement in response to external commands or
+ * internal conditions.
  */
 void stop() {
   current.steering_angle = Constants::STRAIGHT;
   updateSteeringAngle();
   motor.end();
   race.enabled = false;
+  storeTrackMap();
+}
+
+/**
+ * @brief Powers the motor up again, once a stopped robot is restarted.
+ *
+ * Exit action of the STOPPED state, which undoes the shutdown of the motor by stop().
+ */
+void restartMotor() {
+  motor.begin();
+}
+
+/**
+ * @brief Drives on past the parking lot before turning into it.
+ *
+ * Update action of the PARK_APPROACHING state, which is left after the approach duration.
+ *
+ * @return True, the cycle has been handled.
+ */
+bool approachParkingLot() {
+  safety.collision_avoidance_blocked = false;
+
+  // Maintain the current path while the approach duration has not passed.
+  maintainStraightPath(race.setpoint_yaw_angle - current.yaw_angle);
+  current.speed = Constants::REDUCED_SPEED;
+  updateSteeringAngle();
+
+  return true;
+}
+
+/**
+ * @brief Turns the setpoint yaw angle towards the parking lot.
+ *
+ * Entry action of the PARK_TURNING state.
+ */
+void beginParkingTurn() {
+  if (race.park_direction == TurnDirection::LEFT) race.setpoint_yaw_angle += 90;
+  else if (race.park_direction == TurnDirection::RIGHT) race.setpoint_yaw_angle -= 90;
+}
+
+/**
+ * @brief Steers the robot into the parking lot at full lock.
+ *
+ * Update action of the PARK_TURNING state. Once the heading is close to the setpoint, the rest
+ * of the turn is corrected in reverse by the PARK_CORRECTING state.
+ *
+ * @return True, the cycle has been handled.
+ */
+bool steerParkingTurn() {
+  //âââââ PARAMETERS âââââ
+  const uint8_t CORRECTING_ANGLE_DIFFERENCE = 60;
+  //ââââââââââââââââââââââ
+
+  safety.collision_avoidance_blocked = true;  // Block collision avoidance during turn.
+
+  // Calculate the angle difference between the setpoint and current yaw angle.
+  int16_t angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
+  if (abs(angle_difference) <= CORRECTING_ANGLE_DIFFERENCE) {
+    raceMachine.dispatch(RaceEvent::CORRECTION_REQUIRED);
+  } else {
+    // Adjust steering angle based on the direction of the turn.
+    if (race.park_direction == TurnDirection::LEFT) {
+      current.steering_angle = Constants::MAX_LEFT;
+    } else if (race.park_direction == TurnDirection::RIGHT) {
+      current.steering_angle = Constants::MAX_RIGHT;
+    }
+    current.speed = Constants::REDUCED_SPEED;  // Move the motor in reverse at reduced speed.
+  }
+
+  updateSteeringAngle();
+
+  return true;
 }
 
 /**
- * @brief Manages the parking process of the robot.
+ * @brief Reverses into the parking lot with the steering set against the angle difference.
+ *
+ * Update action of the PARK_CORRECTING state, which stops the robot after the reverse duration.
+ *
+ * @return True, the cycle has been handled.
+ */
+bool correctParkingTurn() {
+  safety.collision_avoidance_blocked = true;
+
+  // Calculate the angle difference and adjust the steering angle accordingly.
+  int16_t angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
+  if (angle_difference >= -10 && angle_difference <= 10) current.steering_angle = 90;
+  if (angle_difference < -10 && angle_difference >= -20) current.steering_angle = 80;
+  if (angle_difference > 10 && angle_difference <= 20) current.steering_angle = 105;
+  if (angle_difference < -20) current.steering_angle = Constants::MAX_LEFT;
+  if (angle_difference > 20) current.steering_angle = Constants::MAX_RIGHT;
+
+  current.speed = -Constants::REDUCED_SPEED;  // Move the motor forward at reduced speed.
+  updateSteeringAngle();
+
+  return true;
+}
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection Sensor and Actuator Management
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+/**
+ * @brief Refreshes the orientation and the battery voltage of the robot.
  *
- * This function controls the parking process of the robot through a state machine approach,
- * ensuring precise handling of turns and movements based on the specified turn direction.
- * It consists of four states: INITIATE, TURNING, CORRECTING, and COMPLETE, to handle the entire
- * parking process from start to finish.
- *
- * @param turn_direction The direction in which the robot should turn to park (LEFT or RIGHT).
+ * Executed by the scheduler at a fixed rate. Integrates all samples the gyroscope has taken
+ * since the last run to update the yaw angle relative to the initial orientation and the
+ * angular velocity, and reads the voltage of the battery, both of which the robot relies on to
+ * make informed decisions about its internal state. The I2C bus cannot be used from an
+ * interrupt, so this task cannot move into one the way the echo capture of the sonars has.
+ * It runs apart from the control task instead, which only computes on the latest values.
  */
-void park(TurnDirection turn_direction) {
-  // Enum for handling different turning states.
-  enum class TurnState : const uint8_t {
-    INITIATE,    // Initial state where the turn is prepared based on track conditions.
-    TURNING,     // State where the robot is actively turning.
-    CORRECTING,  // State for fine-tuning the turn angle.
-    COMPLETE     // State indicating the turn has been completed.
-  };
-
-  // Constants for various parameters used in the function.
-  const uint8_t CORRECTING_ANGLE_DIFFERENCE = 60;
-  const uint16_t TURNING_DURATION = 3500;
-  const uint16_t REVERSE_DURATION = 4000;
-  const uint16_t INITIATION_DURATION = 1200;
-
-  // Static variables for maintaining the current state and other control parameters.
-  static TurnState turn_state;
-  static bool updated_setpoint_angle;
-  static bool initiating_timer_locked;
-  static bool turning_timer_locked;
-  int16_t angle_difference;
-  static unsigned long initiating_timer;
-  static unsigned long turning_timer;
-
-  // Boolean flag to check if the turning timer has passed the specified duration.
-  bool turning_timer_passed = (turning_timer_locked && millis() - turning_timer > TURNING_DURATION) ? 1 : 0;
-
-  switch (turn_state) {
-    case TurnState::INITIATE:
-      {
-        // Preparing to initiate a turn based on detected track conditions and vehicle orientation.
-        angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
+void updateImu() {
+  // Update the data stream of the gyroscope and the voltmeter.
+  {
+    PROFILE_SCOPE("gyro.update");
+    gyro.update();
+  }
+  current.imu_micros = gyro.readTimestamp();
+  current.yaw_angle = gyro.readYawAngle();
+  current.angular_velocity = gyro.readAngularVelocity() / 100;
 
-        safety.collision_avoidance_blocked = false;
+  // Dead-reckon the position within the section from the heading and the motor speed.
+  pose.update(gyro.readAngle(), motor.read(), millis());
 
-        // Lock the initiating timer if not already locked.
-        if (!initiating_timer_locked) {
-          initiating_timer = millis();
-          initiating_timer_locked = true;
-        }
+  // Compensate the duty cycle for the filtered voltage, so dips under load are not amplified.
+  current.voltage = map(analogRead(Pins::VOLTAGE_MEASUREMENT_PIN), 0, 1023, 0, 100);
+  governor.update(current.voltage);
+  motor.setSupplyVoltage(governor.readVoltage());
+}
 
-        // Transition to TURNING state after the initiating duration has passed.
-        if (initiating_timer_locked && millis() - initiating_timer > INITIATION_DURATION) {
-          // Update the setpoint yaw angle based on the turn direction.
-          if (!updated_setpoint_angle) {
-            if (turn_direction == TurnDirection::LEFT) race.setpoint_yaw_angle += 90;
-            else if (turn_direction == TurnDirection::RIGHT) race.setpoint_yaw_angle -= 90;
-            updated_setpoint_angle = true;
-          }
-          angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
+/**
+ * @brief Refreshes the retrieved data of the pixy camera.
+ *
+ * Executed by the scheduler faster than the frame rate of the camera, so a new frame is picked
+ * up soon after the camera has finished it. Polling never waits for the camera. The blocks of
+ * every new frame are handed to the tracker, and the data of the nearest tracked pillar is
+ * taken from its prediction, so it stays available through a few dropped frames. The block
+ * index holds the stable ID of the track. Skipped entirely if the race does not include
+ * obstacles.
+ */
+void updateCamera() {
+  if (!raceProfile().obstacles_included)
+    return;
 
-          turn_state = TurnState::TURNING;  // Transition to TURNING state.
-        } else {
-          // Maintain the current path if the initiating duration has not passed.
-          maintainStraightPath(angle_difference);
-          current.speed = Constants::REDUCED_SPEED;
-        }
+  bool new_frame;
+  {
+    PROFILE_SCOPE("getBlocks");
+    new_frame = camera.update();
+  }
 
-        updateSteeringAngle();
-      }
-      break;
-    case TurnState::TURNING:
-      {
-        safety.collision_avoidance_blocked = true;  // Block collision avoidance during turn.
+  unsigned long now = millis();
+  if (new_frame) {
+    current.camera_micros = micros();
+    tracker.update(camera.blocks, camera.getNumBlocks(), now);
+    mapTracks();
+  }
+  tracker.expire(now);
 
-        // Calculate the angle difference between the setpoint and current yaw angle.
-        angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
-        if (abs(angle_difference) <= CORRECTING_ANGLE_DIFFERENCE) {
-          turn_state = TurnState::CORRECTING;  // Transition to CORRECTING state.
-        } else {
-          // Adjust steering angle based on the direction of the turn.
-          if (turn_direction == TurnDirection::LEFT) {
-            current.steering_angle = Constants::MAX_LEFT;
-          } else if (turn_direction == TurnDirection::RIGHT) {
-            current.steering_angle = Constants::MAX_RIGHT;
-          }
-          current.speed = Constants::REDUCED_SPEED;  // Move the motor in reverse at reduced speed.
-        }
+  const Track *track = tracker.findNearest(safety.magenta_unlocked);
+  current.x_pos = track ? tracker.predictX(*track, now) : 0;
+  current.y_pos = track ? tracker.predictY(*track, now) : 0;
+  current.colour = track ? track->colour : Colour::NONE;
+  current.block_index = track ? track->id : 0;
 
-        updateSteeringAngle();
-      }
-      break;
-    case TurnState::CORRECTING:
-      {
-        static unsigned long reversing_timer;
-        static bool reversing_timer_locked;
+  // Debounce the parking lot over frames, a frame may be read by several control cycles.
+  if (new_frame && !parkingLotDetector.read())
+    parkingLotDetector.update(current.colour == Colour::MAGENTA);
+}
 
-        safety.collision_avoidance_blocked = true;  // Unblock collision avoidance.
+/**
+ * @brief Records newly confirmed pillars and the parking lot in the track map.
+ *
+ * A track is confirmed once it has been seen in a few frames, so a single misclassified block
+ * is not mapped. Tracks confirmed during a turn are not mapped, as they cannot be assigned to
+ * a section reliably.
+ */
+void mapTracks() {
+  //âââââ PARAMETERS âââââ
+  const uint8_t CONFIRMATION_FRAMES = 3;  // Frames a track has to be seen in to be mapped.
+  //ââââââââââââââââââââââ
 
-        // Transition to COMPLETE state after the reverse duration has passed.
-        if (reversing_timer_locked && millis() - reversing_timer > REVERSE_DURATION) {
-          reversing_timer_locked = false;
-          turn_state = TurnState::COMPLETE;  // Transition to COMPLETE state.
-        } else {
-          // Lock the reversing timer if not already locked.
-          if (!reversing_timer_locked) {
-            reversing_timer = millis();
-            reversing_timer_locked = true;
-          }
+  if (race.turning)
+    return;
 
-          // Calculate the angle difference and adjust the steering angle accordingly.
-          angle_difference = race.setpoint_yaw_angle - current.yaw_angle;
-          if (angle_difference >= -10 && angle_difference <= 10) current.steering_angle = 90;
-          if (angle_difference < -10 && angle_difference >= -20) current.steering_angle = 80;
-          if (angle_difference > 10 && angle_difference <= 20) current.steering_angle = 105;
-          if (angle_difference < -20) current.steering_angle = Constants::MAX_LEFT;
-          if (angle_difference > 20) current.steering_angle = Constants::MAX_RIGHT;
-        }
+  for (uint8_t i = 0; i < tracker.getNumTracks(); i++) {
+    const Track &track = tracker.getTrack(i);
+    if (track.age != CONFIRMATION_FRAMES)
+      continue;
 
-        current.speed = -Constants::REDUCED_SPEED;  // Move the motor forward at reduced speed.
-        updateSteeringAngle();
-      }
-      break;
-    case TurnState::COMPLETE:
-      {
-        // Finalizing the parking process.
-        updated_setpoint_angle = false;
-        stop();
-      }
-      break;
+    uint16_t position = max(pose.readX(), 0.0f);
+    if (track.colour == Colour::RED || track.colour == Colour::GREEN) {
+      trackMap.recordPillar(race.sections, track.colour, position);
+    } else if (track.colour == Colour::MAGENTA) {
+      trackMap.recordParkingLot(race.sections, position);
+    }
   }
 }
 
-
-///ââââââââââââââââââââââââââââââââââââââââââââââââââ
-/// @subsection Sensor and Actuator Management
-///ââââââââââââââââââââââââââââââââââââââââââââââââââ
-
 /**
- * @brief Periodically refreshes sensor data to provide an accurate environmental model.
+ * @brief Refreshes the incoming ultrasonic sensor data.
  *
- * Gathers and updates readings from the gyroscope, ultrasonic sensors, and voltage sensor at
- * regular intervals. This continuous refreshment of data is essential for the robot to make
- * informed decisions based on the latest information about its surroundings and internal state.
+ * Executed by the scheduler on every pass, so the staged firing of the sonars and the polled
+ * echo capture progress without delay. The echoes are captured by interrupts, which may
+ * complete a measurement at any time, so each sonar is read as one snapshot. The distance,
+ * its timestamp and the measurement count then always belong to the same measurement.
  */
-void updateSensors() {
-  const uint8_t IMU_FREQUENCY = 100;
-  const uint8_t CAMERA_FREQUENCY = 20;
-  static unsigned long last_millis_A;
-  static unsigned long last_millis_B;
-
-  // Initialize the gyroscope by measuring the yaw angle offset.
-  initGyroscope();
-
-  // Update the data stream of the gyroscope and the voltmeter.
-  if (millis() - last_millis_A > (1000 / IMU_FREQUENCY)) {
-    last_millis_A = millis();
-    current.yaw_angle = (gyro.readYawAngle() - initial.yaw_angle) * 1.007;
-    // current.yaw_angle = gyro.readYawAngle() - initial.yaw_angle;
-
-    current.voltage = map(analogRead(Pins::VOLTAGE_MEASUREMENT_PIN), 0, 1023, 0, 100);
+void updateSonars() {
+  // Refresh the incoming ultrasonic sensor data by firing the sonars in stages.
+  sonars.update();
+  const SonarReading left = sonarLeft.readSnapshot();
+  const SonarReading front = sonarFront.readSnapshot();
+  const SonarReading right = sonarRight.readSnapshot();
+  current.distance_left = left.distance;
+  current.distance_front = front.distance;
+  current.distance_right = right.distance;
+  current.distance_left_micros = left.timestamp;
+  current.distance_front_micros = front.timestamp;
+  current.distance_right_micros = right.timestamp;
+
+  // Correct the estimated position with every new measurement of the walls.
+  static uint8_t front_measurements;
+  static uint8_t left_measurements;
+  if (front.count != front_measurements) {
+    front_measurements = front.count;
+    pose.correctFront(current.distance_front);
   }
+  if (left.count != left_measurements) {
+    left_measurements = left.count;
+    pose.correctLeft(current.distance_left);
+  }
+}
 
-  // Update the retrieved data of the pixy camera.
-  if (safety.obstacles_included && millis() - last_millis_B > (1000 / CAMERA_FREQUENCY)) {
-    last_millis_B = millis();
+/**
+ * @brief Compensates the speed of sound of the sonars for the temperature of the air.
+ *
+ * Executed by the scheduler once per second, as the temperature of the hall changes slowly.
+ * The temperature of the air is estimated from the die of the gyroscope, which runs a little
+ * warmer than its surroundings. A sonar would be off by about 2 cm over 130 cm between a
+ * cold and a warm venue otherwise. Skipped if the compensation is disabled, so the sonars
+ * stay at room temperature.
+ */
+void compensateTemperature() {
+  //âââââ PARAMETERS âââââ
+  const int16_t DIE_TEMPERATURE_OFFSET = 30;  // Tenths of a degree the die is above the air.
+  //ââââââââââââââââââââââ
 
-    pixy.ccc.getBlocks();
-    current.x_pos = camera.readX(safety.magenta_unlocked);
-    current.y_pos = camera.readY(safety.magenta_unlocked);
-    current.colour = camera.readColour(safety.magenta_unlocked);
-    current.block_index = camera.readIndex(safety.magenta_unlocked);
-  }
+  if (!Mode::TEMPERATURE_COMPENSATION || !gyro.measureTemperature())
+    return;
 
-  // Refresh the incoming ultrasonic sensor data by cycling through each sonar.
-  cycleSonars();
-  sonarLeft.update();
-  sonarFront.update();
-  sonarRight.update();
-  current.distance_left = sonarLeft.readDistance();
-  current.distance_front = sonarFront.readDistance();
-  current.distance_right = sonarRight.readDistance();
+  int16_t temperature = gyro.readTemperature() - DIE_TEMPERATURE_OFFSET;
+  sonarLeft.setTemperature(temperature);
+  sonarFront.setTemperature(temperature);
+  sonarRight.setTemperature(temperature);
+}
 
-  // Measure the initial front distance of the robot.
-  initSonars();
+/**
+ * @brief Transfers the current speed to the motor.
+ *
+ * Executed by the scheduler on every pass. The motor ramps towards the speed set by the
+ * control task on its own timer, at the configured acceleration and deceleration. The speed
+ * is limited to what the battery can provide in the current section.
+ */
+void updateMotor() {
+  motor.write(governor.limitSpeed(current.speed));
+  traceMotor();
 }
 
 /**
@@ -898,10 +1434,27 @@ void updateSteeringAngle() {
   // Transfer the steering angle to the servo, if changed.
   if (current.steering_angle != last.steering_angle) {
     last.steering_angle = current.steering_angle;
+    PROFILE_SCOPE("servo.write");
     servo.write(current.steering_angle);
+    traceServo();
   }
 }
 
+/**
+ * @brief Predicts the yaw angle of the robot a short time ahead.
+ *
+ * Extrapolates the integrated yaw angle with the current angular velocity. Ending a turn on
+ * the predicted heading compensates the delay until the steering is straight again, so the
+ * robot does not overshoot the setpoint angle.
+ *
+ * @param lead_time The time to predict ahead in milliseconds.
+ * @return The predicted yaw angle in degrees.
+ */
+int16_t predictYawAngle(uint16_t lead_time) {
+  int32_t angle = gyro.predictAngle(lead_time);
+  return (angle + (angle >= 0 ? 50 : -50)) / 100;
+}
+
 
 ///ââââââââââââââââââââââââââââââââââââââââââââââââââ
 /// @subsection Navigation Control
@@ -957,14 +1510,14 @@ void maintainCentralPath() {
  * Actively monitors and adjusts the robot's steering to counteract any unwanted rotational
  * movement. This method is crucial for ensuring the robot's orientation remains consistent,
  * particularly during maneuvers that could cause it to deviate from its intended heading.
+ * A positive angle difference steers the robot to the left.
+ *
+ * @param angle_difference The difference between the setpoint and the current yaw angle (in degrees).
  */
 void maintainStraightPath(int16_t angle_difference) {
-  // Calculate and store the output of the control loop
-  if (angle_difference >= -2 && angle_difference <= 2) current.steering_angle = 90;
-  if (angle_difference < -2 && angle_difference >= -10) current.steering_angle = 105;
-  if (angle_difference > 2 && angle_difference <= 10) current.steering_angle = 80;
-  if (angle_difference < -10) current.steering_angle = 120;
-  if (angle_difference > 10) current.steering_angle = 60;
+  // Calculate and store the output of the control loop, with the fractions of a degree.
+  headingController.getOutput(angle_difference);
+  current.steering_angle = ServoAngle::fromRaw(headingController.readScaledOutput() * ServoAngle::ONE / PID_GAIN_SCALE);
 }
 
 /**
@@ -978,17 +1531,8 @@ void maintainStraightPath(int16_t angle_difference) {
  * @param setpoint_distance The target distance from the left wall (in centimeters).
  */
 void trackLeftWall(uint16_t setpoint_distance) {
-  // Check if the vehicle is within the acceptable range of the setpoint distance
-  if (current.distance_left >= setpoint_distance - 1 && current.distance_left <= setpoint_distance + 1) {
-    // If within range, keep the steering straight
-    current.steering_angle = Constants::STRAIGHT;
-  } else if (current.distance_left > setpoint_distance + 1) {
-    // If too far from the wall, steer left
-    current.steering_angle = 75;
-  } else if (current.distance_left < setpoint_distance - 1) {
-    // If too close to the wall, steer right
-    current.steering_angle = 110;
-  }
+  // Turn left if the vehicle is too far from the wall, and right if it is too close.
+  trackWall(ControllerDirection::REVERSE, setpoint_distance, current.distance_left);
 }
 
 /**
@@ -1000,18 +1544,82 @@ void trackLeftWall(uint16_t setpoint_distance) {
  *
  * @param setpoint_distance The desired distance to maintain from the right wall (in centimeters).
  */
-uint16_t trackRightWall(uint16_t setpoint_distance) {
-  // Evaluate if the vehicle's current distance from the right wall is within the setpoint range
-  if (current.distance_right >= setpoint_distance - 1 && current.distance_right <= setpoint_distance + 1) {
-    // Maintain a straight steering angle if within the target range
-    current.steering_angle = Constants::STRAIGHT;
-  } else if (current.distance_right > setpoint_distance + 1) {
-    // Steer right if the vehicle is too far from the right wall
-    current.steering_angle = 115;
-  } else if (current.distance_right < setpoint_distance - 1) {
-    // Steer left if the vehicle is too close to the right wall
-    current.steering_angle = 80;
+void trackRightWall(uint16_t setpoint_distance) {
+  // Turn right if the vehicle is too far from the wall, and left if it is too close.
+  trackWall(ControllerDirection::DIRECT, setpoint_distance, current.distance_right);
+}
+
+/**
+ * @brief Keeps a set distance from a wall with the cascaded wall controller.
+ *
+ * The outer loop turns the distance error into a heading correction around the setpoint yaw
+ * angle, which is stored as the drift correction of the race. The inner loop steers towards
+ * the corrected heading, so the robot approaches the setpoint distance at a bounded angle
+ * instead of steering towards the wall at full lock. Switching between the walls clears the
+ * history of the cascade.
+ *
+ * @param direction The direction of the outer loop, depending on the tracked wall.
+ * @param setpoint_distance The desired distance to the wall (in centimeters).
+ * @param distance The measured distance to the wall (in centimeters).
+ */
+void trackWall(ControllerDirection direction, uint16_t setpoint_distance, uint16_t distance) {
+  static ControllerDirection last_direction = ControllerDirection::DIRECT;
+  if (direction != last_direction) {
+    last_direction = direction;
+    wallDistanceController.setDirection(direction);
+    wallController.reset();
   }
+
+  wallController.setReference(race.setpoint_yaw_angle);
+  wallController.setSetpoint(setpoint_distance);
+  wallController.getOutput(distance, current.yaw_angle);
+  current.steering_angle = ServoAngle::fromRaw(wallController.readScaledOutput() * ServoAngle::ONE / PID_GAIN_SCALE);
+  race.drift_correction = wallController.getCorrection();
+}
+
+/**
+ * @brief Configures a PID controller to output steering angles.
+ *
+ * The straight position of the servo is fed forward, so the controller only computes the
+ * deflection from it, limited to the mechanical range of the steering. The controller is
+ * sampled faster than the control task runs, so it updates on every call. The gains are
+ * set by scheduleSteeringGains().
+ *
+ * @param controller The steering controller to configure.
+ */
+void initSteeringController(PIDController &controller) {
+  controller.begin();
+  controller.setSampleTime(10);
+  controller.setLimits(Constants::MAX_LEFT, Constants::MAX_RIGHT);
+  controller.setFeedForward(Constants::STRAIGHT);
+}
+
+/**
+ * @brief Schedules the gains of the steering controllers.
+ *
+ * The steering responds more strongly the faster the robot drives, so the gains are
+ * interpolated over the absolute speed from the table of the current turn mode. This keeps
+ * the loops stable on fast straights without making them sluggish at low speed.
+ */
+void scheduleSteeringGains() {
+  uint8_t mode = uint8_t(race.turn_mode);
+  int16_t speed = abs(current.speed);
+
+  headingController.schedule(HEADING_GAINS[mode], NUM_SCHEDULED_GAINS, speed);
+  wallHeadingController.schedule(HEADING_GAINS[mode], NUM_SCHEDULED_GAINS, speed);
+  wallDistanceController.schedule(WALL_GAINS[mode], NUM_SCHEDULED_GAINS, speed);
+}
+
+/**
+ * @brief Clears the history of all steering controllers.
+ *
+ * Called when a new section begins, since the heading error jumps with the new setpoint
+ * angle and the walls of the previous section are no longer relevant.
+ */
+void resetSteeringControllers() {
+  headingController.reset();
+  wallController.reset();
+  race.drift_correction = 0;
 }
 
 
@@ -1068,15 +1676,15 @@ void avoidCollision() {
  * to the y-position of the obstacle, scaled similarly.
  * This results in a steering angle that guides the robot around the obstacle.
  */
-void obstacleSteering(uint16_t x, uint8_t y, Colour colour) {
+void obstacleSteering(uint16_t x, uint8_t /* y */, Colour colour) {
   // Transfer a lowered speed to the motor to allow for precise maneuvering.
   current.speed = Constants::REDUCED_SPEED;
 
   // Define the proportional gain constant.
-  const float Kp = 0.40;  // Adjust this value based on your system's requirements.
+  constexpr Fixed<16> Kp = 0.40;  // Adjust this value based on your system's requirements.
 
   // Calculate the setpoint based on the colour of the obstacle.
-  float setpoint = 0.0;
+  int16_t setpoint = 0;
   if (colour == Colour::RED) {
     // setpoint = (y - 207) / -3.450;
     setpoint = 15;
@@ -1093,7 +1701,7 @@ void obstacleSteering(uint16_t x, uint8_t y, Colour colour) {
   int16_t error = x - setpoint;
 
   // Compute the control output using the P-Controller.
-  int16_t control_output = Kp * error;
+  int16_t control_output = (Kp * error).round();
 
   // Apply the control output to adjust the steering angle.
   // Ensure the steering angle remains within the valid range.
@@ -1105,6 +1713,19 @@ void obstacleSteering(uint16_t x, uint8_t y, Colour colour) {
 /// @subsection Race Progress Monitoring
 ///ââââââââââââââââââââââââââââââââââââââââââââââââââ
 
+/**
+ * @brief Retrieves the profile of the race the robot drives.
+ *
+ * In a build for a fixed race, the profile is a constant and every branch on it is resolved by
+ * the compiler, so the code of the features the race does not include is left out. Only a build
+ * with a selectable profile reads the race chosen at boot.
+ *
+ * @return The profile of the race.
+ */
+inline const RaceProfile &raceProfile() {
+  return RACE_PROFILES[uint8_t(RACE_PROFILE_SELECTABLE ? race_type : RaceType::RACE_PROFILE)];
+}
+
 /**
  * @brief Retrieves the number of sections completed by the vehicle.
  *
@@ -1136,28 +1757,23 @@ uint8_t getLaps() {
  *
  * This function checks the distances on either side of the vehicle to identify large gaps that
  * could signify an upcoming turn or an open area. It influences the vehicle's steering decisions
- * and is critical for successful navigation.
+ * and is critical for successful navigation. Each sonar debounces its own measurements, so a
+ * single outlier neither opens nor closes a gap.
  *
  * @return True if a large gap is detected, false otherwise.
  */
 bool detectedGap() {
+  //âââââ PARAMETERS âââââ
+  const uint8_t GAP_HYSTERESIS = 10;  // Distance below MAX_DISTANCE that closes a detected gap.
+  //ââââââââââââââââââââââ
+
   switch (race.direction) {
     case Direction::ANTICLOCKWISE:
-      {
-        if (current.distance_left >= Constants::MAX_DISTANCE) {
-          return true;
-        } else
-          return false;
-      }
-      break;
+      return sonarLeft.detectedPeak(raceProfile().max_distance, GAP_HYSTERESIS);
     case Direction::CLOCKWISE:
-      {
-        if (current.distance_right >= Constants::MAX_DISTANCE) {
-          return true;
-        } else
-          return false;
-      }
-      break;
+      return sonarRight.detectedPeak(raceProfile().max_distance, GAP_HYSTERESIS);
+    default:
+      return false;
   }
 }
 
@@ -1169,181 +1785,346 @@ bool detectedGap() {
  * for the vehicle's turning behavior.
  */
 bool getDirection() {
-  static bool direction_determined;
-
-  // Make sure that the direction is only determined once.
-  if (!direction_determined) {
-    if (current.distance_left >= 180 && current.distance_left != 400 && current.distance_left > current.distance_right) {
+  // Make sure that the direction is only determined once per run.
+  if (race.direction == Direction::NONE) {
+    if (current.distance_left >= 180 && current.distance_left < sonarLeft.getMaxDistance() && current.distance_left > current.distance_right) {
       race.direction = Direction::ANTICLOCKWISE;
-      direction_determined = true;
       return true;
-    } else if (current.distance_right >= 180 && current.distance_right != 400 && current.distance_right > current.distance_left) {
+    } else if (current.distance_right >= 180 && current.distance_right < sonarRight.getMaxDistance() && current.distance_right > current.distance_left) {
       race.direction = Direction::CLOCKWISE;
-      direction_determined = true;
       return true;
     }
-  } else {
-    return false;
   }
+
+  return false;
 }
 
 /**
  * @brief Determines if the robot has detected a parking lot based on color detection.
  * 
  * Checks the current detected color to determine if the robot is over a parking lot.
- * The function returns true if the detected color is magenta, indicating the presence of
- * a parking lot. Otherwise, it returns false.
+ * The function returns true once magenta has been detected in consecutive camera frames,
+ * indicating the presence of a parking lot, and keeps returning true from then on.
+ * Otherwise, it returns false. The detector is fed by updateCamera() once per new frame.
  * 
  * @return True if a magenta color is detected, indicating a parking lot; otherwise, false.
  */
 bool detectedParkingLot() {
-  static bool detected_parking_lot;
-
-  if (current.colour == Colour::MAGENTA)
-    detected_parking_lot = true;
-
-  return detected_parking_lot;
+  return parkingLotDetector.read();
 }
 
 
 ///ââââââââââââââââââââââââââââââââââââââââââââââââââ
-/// @subsection Sensor Data Processing
+/// @subsection Display and User Interface
 ///ââââââââââââââââââââââââââââââââââââââââââââââââââ
 
 /**
- * @brief Identifies significant, consecutive readings above a defined threshold.
- *
- * Analyzes input values to detect peaks, which are defined as consecutive readings above a
- * specified threshold. This detection is vital for interpreting sensor data that may influence
- * the robot's decision-making processes.
+ * @brief Visualizes sensor data on the LCD display for real-time monitoring.
  *
- * @param input The current input value to check.
- * @param threshold The value above which a peak is considered.
- * @param consecutive_matches The number of consecutive inputs needed to consider as a peak.
- * @return true if a peak is detected, false otherwise.
+ * Executed by the scheduler as the task of lowest priority, presenting the latest sensor
+ * readings in an easily interpretable format. Only the frame buffer of the display is
+ * written here, the transfer to the display is left to flushDisplay(). This function enhances the user's ability to monitor the robot's
+ * status and environmental interactions.
  */
-bool peak(uint16_t input, uint16_t threshold, uint8_t consecutive_matches) {
-  static uint8_t matches;
-
-  if (input >= threshold) {
-    if (matches < consecutive_matches)
-      matches++;
-
-    if (matches >= consecutive_matches)
-      return true;
-  } else {
-    matches = 0;
-    return false;
+void showData() {
+  // Show the status of the devices until the robot is ready.
+  if (!boot.ready) {
+    showBootStatus();
+    return;
   }
-}
 
-/**
- * @brief Cycles through sonar sensors to measure distances in a time-sliced manner.
- *
- * Orchestrates the timing of distance measurements from multiple sonar sensors to prevent
- * interference. This method ensures that each sensor can operate without conflict, providing
- * reliable distance data for navigation.
- */
-void cycleSonars() {
-  const uint8_t FREQUENCY = 30;
-  static uint8_t state;
-  static unsigned long last_millis;
+  // A weak battery is reported instead of the sensor data, before it browns out during a run.
+  const bool BATTERY_WARNING = governor.readState() != BatteryState::NORMAL;
+  const uint8_t LAYOUT_ID = profiler_view_enabled ? 3 : BATTERY_WARNING ? 4 : raceProfile().obstacles_included ? 2 : 1;
 
-  switch (state) {
+  // Print the display preset
+  display.preset(LAYOUT_ID);
+
+  // Update the data on the display
+  switch (LAYOUT_ID) {
     case 0:
       {
-        if (!sonarLeft.isUpdating()) {
-          sonarFront.startMeasurement();
-          if (millis() - last_millis > (1000) / FREQUENCY) {
-            last_millis = millis();
-            state++;
-          }
-        }
+        display.update(current.distance_left, 1, 0, 2, false);
+        display.update(current.distance_front, 5, 0, 2, false);
+        display.update(current.distance_right, 9, 0, 2, false);
+        display.update(current.yaw_angle, 12, 0, 4, false);
+        display.update(current.x_pos, 1, 1, 3, false);
+        display.update(current.y_pos, 6, 1, 3, false);
+        display.update(uint8_t(current.colour), 11, 1, 1, false);
+        display.update(current.voltage, 14, 1, 2, false);
       }
       break;
     case 1:
       {
-        if (!sonarFront.isUpdating()) {
-          sonarRight.startMeasurement();
-          if (millis() - last_millis > (1000) / FREQUENCY) {
-            last_millis = millis();
-            state++;
-          }
-        }
+        display.update(current.distance_left, 1, 0, 3, false);
+        display.update(current.distance_front, 6, 0, 3, false);
+        display.update(current.distance_right, 11, 0, 3, false);
+        display.update(current.yaw_angle, 1, 1, 4, true);
+        display.update(current.voltage, 11, 1, 2, false);
       }
       break;
     case 2:
       {
-        if (!sonarRight.isUpdating()) {
-          sonarLeft.startMeasurement();
-          if (millis() - last_millis > (1000) / FREQUENCY) {
-            last_millis = millis();
-            state = 0;
-          }
+        display.update(current.distance_left, 1, 0, 3, false);
+        display.update(current.distance_front, 6, 0, 3, false);
+        display.update(current.distance_right, 11, 0, 3, false);
+        display.update(current.yaw_angle, 1, 1, 4, false);
+        display.update(current.x_pos, 6, 1, 3, false);
+        display.update(current.y_pos, 11, 1, 3, false);
+      }
+      break;
+    case 3:
+      {
+        // Show the section with the longest run time measured so far.
+        uint8_t worst_section = Profiler::findWorstSection();
+        if (worst_section < Profiler::getNumSections()) {
+          const ProfilerSection &section = Profiler::getSection(worst_section);
+          uint32_t mean_cycles = section.total_cycles / section.count;
+          display.print(section.name, 0, 0, COLUMNS);
+          display.update(min(Profiler::toMicros(mean_cycles), uint32_t(9999)), 1, 1, 4, false);
+          display.update(min(Profiler::toMicros(section.max_cycles), uint32_t(9999)), 7, 1, 4, false);
         }
       }
       break;
+    case 4:
+      {
+        display.print((governor.readState() == BatteryState::CRITICAL) ? "BATTERY CRITICAL" : "BATTERY WEAK", 0, 0, COLUMNS);
+        display.update(governor.readVoltage(), 2, 1, 3, false);
+        display.update(governor.readSpeedLimit(), 11, 1, 3, false);
+      }
+      break;
   }
 }
 
+/**
+ * @brief Shows the state of every device on the display during the startup.
+ *
+ * The second row lists the gyroscope, the camera and the sonars, each marked as ready (OK),
+ * pending (..) or failed (NO). If the startup has ended without every required device being
+ * ready, the first row reports the failure. While the profile can still be selected, the first
+ * row shows the selected one instead.
+ */
+void showBootStatus() {
+  const char *STATE_LABELS[] = { "..", "OK", "NO" };
+
+  if (boot.completed) display.print("DEVICE FAILURE", 1, 0, 15);
+  else if (RACE_PROFILE_SELECTABLE) display.print(raceProfile().name, 1, 0, 15);
+  display.print("G:", 0, 1);
+  display.print(STATE_LABELS[uint8_t(boot.gyro)], 2, 1);
+  display.print("C:", 5, 1);
+  display.print(STATE_LABELS[uint8_t(boot.camera)], 7, 1);
+  display.print("S:", 10, 1);
+  display.print(STATE_LABELS[uint8_t(boot.sonars)], 12, 1);
+}
 
-///ââââââââââââââââââââââââââââââââââââââââââââââââââ
-/// @subsection Display and User Interface
-///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/**
+ * @brief Transfers the changed characters of the frame buffer to the display.
+ *
+ * Executed by the scheduler at a low priority. Writes only a few bytes per run, so the I2C
+ * bus is never occupied long enough to delay the next reading of the gyroscope.
+ */
+void flushDisplay() {
+  PROFILE_SCOPE("lcd");
+  display.flush();
+}
 
 /**
- * @brief Visualizes sensor data on the LCD display for real-time monitoring.
+ * @brief Provides access to the run time statistics of the profiler.
  *
- * Executes periodic updates to the LCD display, presenting the latest sensor readings in an
- * easily interpretable format. This function enhances the user's ability to monitor the robot's
- * status and environmental interactions.
+ * Executed by the scheduler at a low priority. Sending 'p' over the serial port dumps the
+ * statistics of all profiled sections as a table, sending 'r' clears them. Holding the button
+ * down toggles between the sensor data and the worst profiled section on the display, while a
+ * short press restarts a stopped run once the button is released, so the robot can be put back
+ * to the start without powering it down. A press that is already down when the first call
+ * happens, such as the one requesting a recalibration at power-up, is ignored until the button
+ * is released.
  */
-void showData() {
-  const uint8_t FREQUENCY = 5;
-  const uint8_t LAYOUT_ID = safety.obstacles_included ? 2 : 1;
-  static unsigned long last_millis;
-
-  if (millis() - last_millis > (1000 / FREQUENCY)) {
-    last_millis = millis();
-
-    // Print the display preset
-    display.preset(LAYOUT_ID);
-
-    // Update the data on the display
-    switch (LAYOUT_ID) {
-      case 0:
-        {
-          display.update(last.distance_left, current.distance_left, 1, 0, 2, false);
-          display.update(last.distance_front, current.distance_front, 5, 0, 2, false);
-          display.update(last.distance_right, current.distance_right, 9, 0, 2, false);
-          display.update(last.yaw_angle, current.yaw_angle, 12, 0, 4, false);
-          display.update(last.x_pos, current.y_pos, 1, 1, 3, false);
-          display.update(last.y_pos, current.y_pos, 6, 1, 3, false);
-          display.update(uint8_t(last.colour), uint8_t(current.colour), 11, 1, 1, false);
-          display.update(last.voltage, current.voltage, 14, 1, 2, false);
-        }
-        break;
-      case 1:
-        {
-          display.update(last.distance_left, current.distance_left, 1, 0, 3, false);
-          display.update(last.distance_front, current.distance_front, 6, 0, 3, false);
-          display.update(last.distance_right, current.distance_right, 11, 0, 3, false);
-          display.update(last.yaw_angle, current.yaw_angle, 1, 1, 4, true);
-          display.update(last.voltage, current.voltage, 11, 1, 2, false);
-        }
+void profile() {
+  //âââââ PARAMETERS âââââ
+  const uint16_t HOLD_DURATION = 1000;  // Time the button must be held to toggle the view.
+  //ââââââââââââââââââââââ
+
+  static bool pressed;
+  static bool hold_handled;
+  static bool armed;
+
+  // Handle the commands received over the serial port.
+  while (Serial.available()) {
+    switch (Serial.read()) {
+      case 'p':
+        Profiler::dump(Serial);
         break;
-      case 2:
-        {
-          display.update(last.distance_left, current.distance_left, 1, 0, 3, false);
-          display.update(last.distance_front, current.distance_front, 6, 0, 3, false);
-          display.update(last.distance_right, current.distance_right, 11, 0, 3, false);
-          display.update(last.yaw_angle, current.yaw_angle, 1, 1, 4, false);
-          display.update(last.x_pos, current.x_pos, 6, 1, 3, false);
-          display.update(last.y_pos, current.y_pos, 11, 1, 3, false);
-        }
+      case 'r':
+        Profiler::reset();
         break;
     }
   }
+
+  // Toggle the profiler view once per long press, restart the run on a short press.
+  bool down = button.isHeld(0);
+  if (!armed) {
+    armed = !down;
+    return;
+  }
+
+  if (button.isHeld(HOLD_DURATION)) {
+    if (!hold_handled) {
+      profiler_view_enabled = !profiler_view_enabled;
+      hold_handled = true;
+    }
+  } else if (!down) {
+    if (pressed && !hold_handled) raceMachine.dispatch(RaceEvent::RESTART);
+    hold_handled = false;
+  }
+  pressed = down;
+}
+
+/**
+ * @brief Runs the benchmark of the control code on request.
+ *
+ * Executed by the main loop in the benchmark mode instead of the scheduler, so nothing else
+ * competes for the processor. Sending 'b' over the serial port runs the whole suite and prints
+ * its table, which tools/bench/benchmark.py compares with a baseline.
+ */
+void runBenchmark() {
+  while (Serial.available()) {
+    if (Serial.read() == 'b') benchmark.run();
+  }
+}
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection Telemetry
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+/**
+ * @brief Queues a telemetry frame with the current state of the robot.
+ *
+ * Executed by the scheduler at the logging rate. Packs the current parameters, the race
+ * progress, the safety flags, the active state of the race state machine and the refresh
+ * rates of the sonars into a binary frame, which only takes a few microseconds since nothing
+ * is written to the serial port here.
+ */
+void sendTelemetry() {
+  TelemetryFrame frame;
+
+  frame.timestamp = millis();
+  frame.colour = uint8_t(current.colour);
+  frame.speed = current.speed;
+  frame.voltage = current.voltage;
+  frame.y_pos = current.y_pos;
+  frame.block_index = current.block_index;
+  frame.angular_velocity = current.angular_velocity;
+  frame.yaw_angle = current.yaw_angle;
+  frame.distance_left = current.distance_left;
+  frame.distance_front = current.distance_front;
+  frame.distance_right = current.distance_right;
+  frame.steering_angle = (current.steering_angle * 100).round();
+  frame.x_pos = current.x_pos;
+
+  frame.direction = uint8_t(race.direction);
+  frame.turn_mode = uint8_t(race.turn_mode);
+  frame.race_flags = race.enabled | race.turning << 1 | race.parking_lot_detected << 2;
+  frame.sections = race.sections;
+  frame.laps = race.laps;
+  frame.setpoint_yaw_angle = race.setpoint_yaw_angle;
+  frame.drift_correction = race.drift_correction;
+
+  frame.safety_flags = safety.collision_avoidance_blocked
+                       | safety.obstacle_steering_blocked << 1
+                       | safety.first_obstacle_detected << 2
+                       | safety.magenta_unlocked << 3
+                       | raceProfile().obstacles_included << 4
+                       | raceProfile().parking_enabled << 5;
+
+  frame.pose_x = pose.readX();
+  frame.pose_y = pose.readY();
+
+  frame.race_state = uint8_t(raceMachine.getState());
+  frame.race_event = uint8_t(raceMachine.getLastEvent());
+  frame.state_time = min(raceMachine.readElapsedTime(), 65535UL);
+
+  frame.sonar_rate_left = sonars.readRefreshRate(Sonar::LEFT);
+  frame.sonar_rate_front = sonars.readRefreshRate(Sonar::FRONT);
+  frame.sonar_rate_right = sonars.readRefreshRate(Sonar::RIGHT);
+
+  telemetry.send(TELEMETRY_STATE, &frame, sizeof(frame));
+}
+
+/**
+ * @brief Starts the latency trace of a control cycle.
+ *
+ * Stores the age of every sample the cycle acts on. The trace of the previous cycle is sent
+ * first if the motor has not been commanded since.
+ */
+void beginTrace() {
+  if (trace_pending) sendTrace();
+
+  unsigned long now = micros();
+  trace = LatencyFrame();
+  trace.timestamp = now;
+  trace.imu_age = traceInterval(current.imu_micros, now);
+  trace.camera_age = traceInterval(current.camera_micros, now);
+  trace.distance_left_age = traceInterval(current.distance_left_micros, now);
+  trace.distance_front_age = traceInterval(current.distance_front_micros, now);
+  trace.distance_right_age = traceInterval(current.distance_right_micros, now);
+  trace_pending = true;
+}
+
+/**
+ * @brief Completes the decision of the traced control cycle.
+ */
+void endTrace() {
+  trace.decision_time = max(traceInterval(trace.timestamp, micros()), uint16_t(1));
+}
+
+/**
+ * @brief Records the first command of the servo within the traced control cycle.
+ */
+void traceServo() {
+  if (trace_pending && !trace.decision_time && !trace.servo_latency) trace.servo_latency = max(traceInterval(trace.timestamp, micros()), uint16_t(1));
+}
+
+/**
+ * @brief Records the first command of the motor after the traced control cycle and sends it.
+ *
+ * The motor is commanded by its own task, so the latency includes the wait for that task.
+ */
+void traceMotor() {
+  if (!trace_pending || !trace.decision_time)
+    return;
+
+  trace.motor_latency = max(traceInterval(trace.timestamp, micros()), uint16_t(1));
+  sendTrace();
+}
+
+/**
+ * @brief Queues the latency trace as a telemetry frame.
+ */
+void sendTrace() {
+  telemetry.send(TELEMETRY_LATENCY, &trace, sizeof(trace));
+  trace_pending = false;
+}
+
+/**
+ * @brief Computes the time between two events of the latency trace.
+ *
+ * @param start The time of the first event in microseconds.
+ * @param end The time of the second event in microseconds.
+ * @return The time in between in microseconds, saturated at 65535.
+ */
+uint16_t traceInterval(unsigned long start, unsigned long end) {
+  return min(end - start, 65535UL);
+}
+
+/**
+ * @brief Drains the queued telemetry frames into the serial port.
+ *
+ * Executed by the scheduler on every pass. Only writes as much as fits into the transmit
+ * buffer of the serial port, so the main loop is never blocked by the stream.
+ */
+void flushTelemetry() {
+  telemetry.flush();
 }
 
 
@@ -1366,50 +2147,31 @@ void obstacleSteeringDemo() {
 /**
  * @brief Demonstrates the parking functionality of the robot.
  *
- * This function controls the parking process by first detecting a parking lot,
- * determining the direction to turn for parking, and then executing the parking maneuver.
- * It also handles collision avoidance and normal turning based on the current conditions.
- */
-void parkingDemo() {
-  // Static variables to maintain state across function calls.
-  static TurnDirection turn_direction;       // Direction to turn for parking.
-  static bool parking_lot_detected;          // Flag to indicate if a parking lot is detected.
-  static bool parking_direction_determined;  // Flag to indicate if parking direction is determined.
-  static uint8_t index;                      // Index of the detected parking lot block.
-
-  // LAYER 1: Check if the robot is ready to initiate parking.
-  if (race.sections >= 4) {
-    safety.magenta_unlocked = true;
-
-    if (!race.turning && current.colour == Colour::MAGENTA || parking_lot_detected) {
-      // Mark parking lot as detected.
-      parking_lot_detected = true;
-
-      // Determine the parking direction if not already determined.
-      if (!parking_direction_determined) {
-        if (current.x_pos < 157) turn_direction = TurnDirection::RIGHT;
-        else if (current.x_pos >= 157) turn_direction = TurnDirection::LEFT;
-        index = pixy.ccc.blocks[0].m_index;   // Store the index of the detected block.
-        parking_direction_determined = true;  // Mark parking direction as determined.
-      }
+ * Upper layer of the DRIVING state in the parking demonstration. From the fifth section on,
+ * the parking lot is looked out for, and the direction to park in is determined from its
+ * position in the frame once it has been detected. As soon as the robot has passed it, the
+ * PARKING state takes over. Until then, the robot keeps racing.
+ *
+ * @return True if the parking maneuver has been started, false otherwise.
+ */
+bool parkingDemo() {
+  if (race.sections < 4)
+    return false;
 
-      // LAYER 2: Handle parking or other tasks based on current conditions.
-      if (current.colour != Colour::MAGENTA || (current.colour == Colour::MAGENTA && index != pixy.ccc.blocks[0].m_index)) {
-        park(turn_direction);
-      } else if (collisionRisk() && !safety.collision_avoidance_blocked) {
-        avoidCollision();
-      } else {
-        // LAYER 3: Handle normal turning if no parking or collision risk.
-        safety.obstacles_included ? handleTurns(TurnMode::SWIFT) : handleTurns(TurnMode::SHARP);
-      }
-    }
-  } else {
-    // LAYER 2: Handle parking or other tasks based on current conditions.
-    if (collisionRisk() && !safety.collision_avoidance_blocked) {
-      avoidCollision();
-    } else {
-      // LAYER 3: Handle normal turning if no parking or collision risk.
-      safety.obstacles_included ? handleTurns(TurnMode::SWIFT) : handleTurns(TurnMode::SHARP);
-    }
+  safety.magenta_unlocked = true;
+
+  // Determine the parking direction once the parking lot has been detected.
+  if (!race.parking_lot_detected && !race.turning && detectedParkingLot()) {
+    race.parking_lot_detected = true;
+    race.park_direction = (current.x_pos < 157) ? TurnDirection::RIGHT : TurnDirection::LEFT;
+    race.parking_lot_index = current.block_index;  // Store the index of the detected block.
   }
+
+  // Park once the detected block of the parking lot has left the view.
+  if (race.parking_lot_detected && (current.colour != Colour::MAGENTA || race.parking_lot_index != current.block_index)) {
+    raceMachine.dispatch(RaceEvent::PARKING_LOT_PASSED);
+    return true;
+  }
+
+  return false;
 }
\ No newline at end of file
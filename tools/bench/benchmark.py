@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+"""Runs the benchmark of the control code and compares it with a baseline.
+
+The suite of src/controller_v2.4/Benchmark.h is either built and run on the host, against the
+simulated board of tools/sim, or read from the Uno R4. On the robot, the sketch has to be built
+with BENCHMARK_MODE in Config.h enabled. The suite is then started by sending 'b' over the
+serial port, and the table it prints can be read with --port, or from a capture with --input.
+
+The table is printed as CSV with the cycles and nanoseconds per call of every benchmark. With
+--baseline, two columns are added with the cycles of the baseline and the change in percent,
+and the script fails if any benchmark has become slower than the threshold. Tables of the host
+and of the target must not be compared with each other, their rows are in different units.
+
+Usage:
+    python3 benchmark.py --save host.csv
+    python3 benchmark.py --baseline host.csv --threshold 15
+    python3 benchmark.py --port /dev/ttyACM0 --baseline target.csv
+
+@author Maximilian Kautzsch
+@copyright Copyright (c) 2024 Maximilian Kautzsch
+Licensed under MIT License.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+SIM_DIR = os.path.join(BENCH_DIR, "..", "sim")
+SKETCH_DIR = os.path.join(BENCH_DIR, "..", "..", "src", "controller_v2.4")
+SOURCES = [
+    os.path.join(BENCH_DIR, "main.cpp"),
+    os.path.join(SKETCH_DIR, "Controlling.cpp"),
+    os.path.join(SIM_DIR, "board", "Board.cpp"),
+]
+
+sys.path.insert(0, SIM_DIR)
+sys.path.insert(0, os.path.join(BENCH_DIR, ".."))
+from simulate import CXX, CXXFLAGS  # noqa: E402
+from telemetry import read_baud_rate  # noqa: E402
+
+SERIAL_TIMEOUT = 2.0
+
+
+def build(build_dir):
+    """Builds the benchmark for the host and returns the path of the binary."""
+    binary = os.path.join(build_dir, "bench")
+    headers = [os.path.join(SKETCH_DIR, name) for name in os.listdir(SKETCH_DIR)]
+    headers += [os.path.join(SIM_DIR, "board", name) for name in os.listdir(os.path.join(SIM_DIR, "board"))]
+    newest = max(os.path.getmtime(path) for path in SOURCES + headers if os.path.isfile(path))
+    if os.path.isfile(binary) and os.path.getmtime(binary) >= newest:
+        return binary
+
+    os.makedirs(build_dir, exist_ok=True)
+    includes = ["-I" + os.path.join(SIM_DIR, "board"), "-I" + SKETCH_DIR]
+    result = subprocess.run([CXX] + CXXFLAGS + includes + SOURCES + ["-o", binary],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if result.returncode:
+        sys.exit("benchmark: failed to build\n{}".format(result.stdout))
+    return binary
+
+
+def read_port(port):
+    """Starts the suite on the robot and returns the lines of its table."""
+    try:
+        import serial
+    except ImportError:
+        sys.exit("benchmark: reading from the robot requires pyserial")
+
+    lines = []
+    with serial.Serial(port, read_baud_rate(), timeout=SERIAL_TIMEOUT) as connection:
+        time.sleep(SERIAL_TIMEOUT)
+        connection.reset_input_buffer()
+        connection.write(b"b")
+        while True:
+            line = connection.readline().decode("ascii", "replace").strip()
+            if not line:
+                break
+            lines.append(line)
+    return lines
+
+
+def parse(lines):
+    """Parses the table into the clock rate and a list of rows."""
+    clock_rate = None
+    rows = []
+    header = None
+    for line in lines:
+        fields = line.strip().split(",")
+        if fields[0] == "clock_hz":
+            clock_rate = int(fields[1])
+        elif fields[0] == "benchmark":
+            header = fields
+        elif header and len(fields) == len(header):
+            rows.append(dict(zip(header, fields)))
+    if clock_rate is None or not rows:
+        sys.exit("benchmark: no benchmark table found")
+    return clock_rate, rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    source = parser.add_mutually_exclusive_group()
+    source.add_argument("--input", help="table captured from the robot")
+    source.add_argument("--port", help="serial port of the robot running in the benchmark mode")
+    parser.add_argument("--baseline", help="table to compare with")
+    parser.add_argument("--threshold", type=float, default=10.0, help="tolerated slowdown in percent")
+    parser.add_argument("--save", help="file to store the table in, as a later baseline")
+    parser.add_argument("--build-dir", default=os.path.join(BENCH_DIR, "build"), help="directory of the build")
+    args = parser.parse_args()
+
+    if args.input:
+        with open(args.input, encoding="ascii", errors="replace") as file:
+            lines = file.read().splitlines()
+    elif args.port:
+        lines = read_port(args.port)
+    else:
+        binary = build(args.build_dir)
+        lines = subprocess.run([binary], stdout=subprocess.PIPE, text=True, check=True).stdout.splitlines()
+
+    clock_rate, rows = parse(lines)
+    if args.save:
+        with open(args.save, "w", encoding="ascii") as file:
+            file.write("clock_hz,{}\n".format(clock_rate))
+            file.write("benchmark,iterations,cycles_per_call,ns_per_call\n")
+            for row in rows:
+                file.write("{benchmark},{iterations},{cycles_per_call},{ns_per_call}\n".format(**row))
+
+    baseline = {}
+    if args.baseline:
+        with open(args.baseline, encoding="ascii") as file:
+            baseline_rate, baseline_rows = parse(file.read().splitlines())
+        if baseline_rate != clock_rate:
+            sys.exit("benchmark: the baseline was measured at {} Hz, not {} Hz".format(baseline_rate, clock_rate))
+        baseline = {row["benchmark"]: float(row["cycles_per_call"]) for row in baseline_rows}
+
+    print("clock_hz,{}".format(clock_rate))
+    print("benchmark,iterations,cycles_per_call,ns_per_call" + (",baseline_cycles,change_percent" if baseline else ""))
+    regressions = []
+    for row in rows:
+        line = "{benchmark},{iterations},{cycles_per_call},{ns_per_call}".format(**row)
+        if baseline:
+            reference = baseline.get(row["benchmark"])
+            if reference is None:
+                line += ",,"
+            else:
+                change = 100.0 * (float(row["cycles_per_call"]) - reference) / reference if reference else 0.0
+                line += ",{},{:.1f}".format(reference, change)
+                if change > args.threshold and row["benchmark"] != "loop":
+                    regressions.append(row["benchmark"])
+        print(line)
+
+    if regressions:
+        sys.exit("benchmark: slower than the baseline by more than {}%: {}".format(args.threshold, ", ".join(regressions)))
+
+
+if __name__ == "__main__":
+    main()
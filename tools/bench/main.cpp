@@ -0,0 +1,51 @@
+/**
+ * @file main.cpp
+ * @brief Runs the benchmark of the control code on the host.
+ *
+ * Builds the suite of Benchmark.h against the simulated board of tools/sim and prints its table
+ * to the standard output. The counter is the monotonic clock of the host in nanoseconds, so the
+ * cycles of the table are nanoseconds as well. Calls into the core, such as the micros() of the
+ * PID controller, are served by the simulated board and cost more than on the target.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "Board.h"
+#include "Benchmark.h"
+
+/**
+ * @class StandardOutput
+ * @brief Stream that prints to the standard output.
+ */
+class StandardOutput : public Print {
+public:
+  size_t write(uint8_t value) override {
+    return fputc(value, stdout) == EOF ? 0 : 1;
+  }
+};
+
+/**
+ * @brief Reads the monotonic clock of the host.
+ *
+ * @return The time in nanoseconds, wrapping around like the DWT cycle counter.
+ */
+static uint32_t readHostCycles() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return uint32_t(uint64_t(now.tv_sec) * 1000000000u + now.tv_nsec);
+}
+
+int main() {
+  StandardOutput output;
+  Benchmark benchmark;
+
+  Board::reset();
+  benchmark.begin(output, readHostCycles, 1000000000);
+  benchmark.run();
+
+  return 0;
+}
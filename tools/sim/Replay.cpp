@@ -0,0 +1,174 @@
+/**
+ * @file Replay.cpp
+ * @brief Implementation of the Replay class.
+ */
+
+#include <stdio.h>
+#include <string>
+#include <sstream>
+#include "Replay.h"
+
+// Colours of Config.h and their first signature in Camera.h.
+static const uint8_t SIGNATURES[] = { 0, 1, 2, 7 };
+
+/**
+ * @brief Constructs an empty Replay object.
+ */
+Replay::Replay()
+  : index(0) {}
+
+/**
+ * @brief Destructs the Replay object.
+ */
+Replay::~Replay() {}
+
+/**
+ * @brief Reads the state frames of a decoded telemetry log.
+ *
+ * Rows of other frame types are skipped. The columns are looked up by the names in the header
+ * row of the state frames, so logs of older firmware with fewer columns are read as well.
+ *
+ * @param path The path of the CSV file written by tools/telemetry.py.
+ * @return True if at least one state frame has been read, false otherwise.
+ */
+bool Replay::open(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file)
+    return false;
+
+  std::vector<std::string> columns;
+  char line[1024];
+
+  while (fgets(line, sizeof(line), file)) {
+    std::vector<std::string> cells;
+    std::stringstream row(line);
+    std::string cell;
+    while (std::getline(row, cell, ',')) {
+      while (!cell.empty() && (cell.back() == '\n' || cell.back() == '\r')) cell.pop_back();
+      cells.push_back(cell);
+    }
+
+    if (cells.size() > 2 && cells[0] == "type") {
+      columns = cells;
+      continue;
+    }
+    if (cells.empty() || cells[0] != "state" || columns.empty() || cells.size() != columns.size())
+      continue;
+
+    auto value = [&](const char *name) {
+      for (size_t i = 0; i < columns.size(); i++) {
+        if (columns[i] == name)
+          return atof(cells[i].c_str());
+      }
+      return 0.0;
+    };
+
+    ReplayFrame frame;
+    frame.timestamp = value("timestamp");
+    frame.yaw_angle = value("yaw_angle");
+    frame.distances[0] = value("distance_left");
+    frame.distances[1] = value("distance_front");
+    frame.distances[2] = value("distance_right");
+    frame.colour = value("colour");
+    frame.x_pos = value("x_pos");
+    frame.y_pos = value("y_pos");
+    frame.block_index = value("block_index");
+    frame.steering_angle = value("steering_angle") / 100.0;
+    frame.speed = value("speed");
+
+    // Frames are expected in the order of their time, a reset of the robot ends the log.
+    if (!this->frames.empty() && frame.timestamp < this->frames.back().timestamp)
+      break;
+    this->frames.push_back(frame);
+  }
+
+  fclose(file);
+  this->index = 0;
+  return !this->frames.empty();
+}
+
+/**
+ * @brief Indicates whether the log has been replayed completely.
+ *
+ * @param timestamp The time of the simulated clock in milliseconds.
+ * @return True if the time is past the last frame, false otherwise.
+ */
+bool Replay::isFinished(uint32_t timestamp) {
+  return this->frames.empty() || timestamp > this->frames.back().timestamp;
+}
+
+/**
+ * @brief Retrieves the time of the last frame of the log.
+ *
+ * @return The time in milliseconds.
+ */
+uint32_t Replay::getDuration() {
+  return this->frames.empty() ? 0 : this->frames.back().timestamp;
+}
+
+/**
+ * @brief Reads a logged distance at the time of the simulated clock.
+ *
+ * @param sonar The sonar, 0 for left, 1 for front and 2 for right.
+ * @param timestamp The time of the simulated clock in milliseconds.
+ * @return The distance in centimeters, 0 before the first frame.
+ */
+uint16_t Replay::readDistance(uint8_t sonar, uint32_t timestamp) {
+  const ReplayFrame *frame = this->find(timestamp);
+  return frame ? frame->distances[min(sonar, uint8_t(2))] : 0;
+}
+
+/**
+ * @brief Reads the yaw rate between the frames around the time of the simulated clock.
+ *
+ * @param timestamp The time of the simulated clock in milliseconds.
+ * @return The yaw rate in degrees per second, positive anticlockwise.
+ */
+float Replay::readYawRate(uint32_t timestamp) {
+  const ReplayFrame *frame = this->find(timestamp);
+  if (!frame || this->index + 1 >= this->frames.size())
+    return 0;
+
+  const ReplayFrame &next = this->frames[this->index + 1];
+  uint32_t interval = next.timestamp - frame->timestamp;
+  return interval ? (next.yaw_angle - frame->yaw_angle) * 1000.0f / interval : 0;
+}
+
+/**
+ * @brief Reads the pillar the robot has tracked at the time of the simulated clock.
+ *
+ * @param timestamp The time of the simulated clock in milliseconds.
+ * @param block The block to fill with the logged position and colour.
+ * @return True if a pillar has been logged, false otherwise.
+ */
+bool Replay::readBlock(uint32_t timestamp, Block &block) {
+  const ReplayFrame *frame = this->find(timestamp);
+  if (!frame || !frame->colour || frame->colour >= sizeof(SIGNATURES))
+    return false;
+
+  // The size of the block is not logged, it grows with the position in the image like the
+  // size of a pillar that comes closer.
+  uint16_t size = 4 + frame->y_pos / 4;
+  block = { SIGNATURES[frame->colour], frame->x_pos, frame->y_pos, size, uint16_t(2 * size), 0, frame->block_index, 255 };
+  return true;
+}
+
+/**
+ * @brief Finds the last frame at or before a time.
+ *
+ * The search continues from the last found frame, since the time only moves forward.
+ *
+ * @param timestamp The time of the simulated clock in milliseconds.
+ * @return The frame, or a null pointer before the first frame.
+ */
+const ReplayFrame *Replay::find(uint32_t timestamp) {
+  if (this->frames.empty() || timestamp < this->frames.front().timestamp)
+    return nullptr;
+
+  if (this->frames[this->index].timestamp > timestamp)
+    this->index = 0;
+  while (this->index + 1 < this->frames.size() && this->frames[this->index + 1].timestamp <= timestamp)
+    this->index++;
+
+  return &this->frames[this->index];
+}
@@ -0,0 +1,58 @@
+/**
+ * @file Replay.h
+ * @brief Header file for the Replay class, feeding the simulated sensors from a recorded log.
+ *
+ * The Replay class reads the state frames of a telemetry log, as decoded into CSV by
+ * tools/telemetry.py, and interpolates the sensor values between them at the time of the
+ * simulated clock. The distances of the sonars and the pillar seen by the camera are taken
+ * from the nearest preceding frame, the yaw rate is derived from the change of the logged yaw
+ * angle, so the integrated angle of the gyroscope follows the log. The logged steering angle
+ * and speed are kept to compare the decisions of the sketch with the recorded ones.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <vector>
+#include "Arduino.h"
+#include "Pixy2_Renesas.h"
+
+/**
+ * @struct ReplayFrame
+ * @brief Struct to hold the sensor values and decisions of one logged state frame.
+ */
+struct ReplayFrame {
+  uint32_t timestamp;     // Milliseconds since the power-up of the robot.
+  float yaw_angle;        // Degrees, positive anticlockwise.
+  uint16_t distances[3];  // Left, front and right distance in centimeters.
+  uint8_t colour;
+  uint16_t x_pos;
+  uint8_t y_pos;
+  uint8_t block_index;
+  float steering_angle;   // Degrees.
+  int8_t speed;
+};
+
+class Replay {
+public:
+  Replay();
+  ~Replay();
+
+  bool open(const char *path);
+  bool isFinished(uint32_t timestamp);
+  uint32_t getDuration();
+  uint16_t readDistance(uint8_t sonar, uint32_t timestamp);
+  float readYawRate(uint32_t timestamp);
+  bool readBlock(uint32_t timestamp, Block &block);
+  const ReplayFrame *find(uint32_t timestamp);
+
+private:
+  std::vector<ReplayFrame> frames;
+  size_t index;
+};
+
+#endif  // REPLAY_H
@@ -0,0 +1,967 @@
+/**
+ * @file World.cpp
+ * @brief Implementation of the World class and of the simulated devices.
+ */
+
+#include "World.h"
+#include "Config.h"
+
+// Geometry of the robot in centimeters, relative to the center of the rear axle.
+#define ROBOT_WHEELBASE 14.0f
+#define ROBOT_FRONT 20.0f
+#define ROBOT_REAR -5.0f
+#define ROBOT_HALF_WIDTH 8.0f
+#define FRONT_SONAR_MOUNT 17.0f  // Behind the bumper, so a wall in contact is outside its blind zone.
+#define CAMERA_MOUNT 18.0f
+#define CAMERA_HEIGHT 12.0f
+
+// Drive train and steering. The speed gain matches the one assumed by the PoseEstimator at
+// the nominal voltage of the battery, and scales with the voltage on the motor.
+#define MOTOR_SPEED_GAIN 1.5f
+#define MOTOR_NOMINAL_VOLTAGE 80.0f
+#define MOTOR_DEADBAND 15.0f
+#define MOTOR_TIME_CONSTANT 0.15f
+#define SERVO_RATE 600.0f
+#define SERVO_PULSE_MIN 544.0f
+#define SERVO_PULSE_MAX 2400.0f
+#define STEERING_RATIO 1.0f
+
+// HC-SR04 ultrasonic sensors.
+#define SONAR_MAX_RANGE 400.0f
+#define SONAR_BEAM_WIDTH 15.0f
+#define SONAR_BEAM_RAYS 5
+#define SONAR_MAX_INCIDENCE 40.0f
+#define SONAR_BURST_MICROS 460
+#define SONAR_MICROS_PER_CM 58.2f  // Round trip at 20 degrees.
+#define SONAR_NO_ECHO_MICROS 38000
+#define SONAR_DROPOUT_RATE 0.02f
+
+// MPU6050 at a range of 500 degrees per second.
+#define IMU_ADDRESS 0x68
+#define IMU_LSB_PER_DPS 65.5f
+#define IMU_SCALE_ERROR 1.007f
+#define IMU_BIAS 25
+#define IMU_FILTER_CONSTANT 3.6f  // Time constant of the low-pass filter at 44 Hz in milliseconds.
+#define IMU_STARTUP_MICROS 30000
+#define IMU_TEMPERATURE -4420  // Die at 23.5 degrees, 340 LSB per degree above 36.53 degrees.
+
+// Pixy2 with a field of view of 60 by 40 degrees.
+#define PIXY_WIDTH 316
+#define PIXY_HEIGHT 208
+#define PIXY_FIELD_OF_VIEW 60.0f
+#define PIXY_VERTICAL_FIELD_OF_VIEW 40.0f
+#define PIXY_MAX_RANGE 250.0f
+#define PIXY_BOOT_MICROS 2000000
+#define PIXY_FRAME_MICROS 16667
+#define PIXY_MISS_RATE 0.05f
+
+#define IDLE_TIMEOUT 500000
+#define WALL_CONTACT_MARGIN 1.0f  // Clearance the robot has to back off to before it leaves a wall.
+#define STUCK_TIMEOUT 5000000  // Time the robot may stall against a wall before the run is given up.
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection Geometry
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+static Vec add(Vec a, Vec b) {
+  return { a.x + b.x, a.y + b.y };
+}
+
+static Vec subtract(Vec a, Vec b) {
+  return { a.x - b.x, a.y - b.y };
+}
+
+static Vec scale(Vec a, float factor) {
+  return { a.x * factor, a.y * factor };
+}
+
+static float dot(Vec a, Vec b) {
+  return a.x * b.x + a.y * b.y;
+}
+
+static float cross(Vec a, Vec b) {
+  return a.x * b.y - a.y * b.x;
+}
+
+static float length(Vec a) {
+  return sqrtf(dot(a, a));
+}
+
+static Vec unit(float angle) {
+  return { cosf(angle), sinf(angle) };
+}
+
+static float wrapAngle(float angle) {
+  while (angle > PI) angle -= TWO_PI;
+  while (angle <= -PI) angle += TWO_PI;
+  return angle;
+}
+
+/**
+ * @brief Intersects a ray with a wall.
+ *
+ * @param origin The origin of the ray.
+ * @param direction The unit direction of the ray.
+ * @param wall The wall.
+ * @param incidence The angle between the ray and the normal of the wall in degrees.
+ * @return The distance to the intersection, or a negative value if the ray misses the wall.
+ */
+static float intersect(Vec origin, Vec direction, const Wall &wall, float &incidence) {
+  Vec edge = subtract(wall.b, wall.a);
+  float denominator = cross(direction, edge);
+  if (fabsf(denominator) < 1e-6f)
+    return -1;
+
+  Vec offset = subtract(wall.a, origin);
+  float distance = cross(offset, edge) / denominator;
+  float position = cross(offset, direction) / denominator;
+  if (distance < 0 || position < 0 || position > 1)
+    return -1;
+
+  incidence = degrees(acosf(fminf(fabsf(denominator) / length(edge), 1.0f)));
+  return distance;
+}
+
+/**
+ * @brief Measures the distance of a point to a wall.
+ *
+ * @param point The point.
+ * @param wall The wall.
+ * @return The distance in centimeters.
+ */
+static float distanceToWall(Vec point, const Wall &wall) {
+  Vec edge = subtract(wall.b, wall.a);
+  float position = constrain(dot(subtract(point, wall.a), edge) / dot(edge, edge), 0.0f, 1.0f);
+  return length(subtract(point, add(wall.a, scale(edge, position))));
+}
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection Sonar
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+/**
+ * @brief Attaches the sensor to its pins.
+ *
+ * @param world The world the sensor measures.
+ * @param trigger_pin The pin the sketch triggers the sensor on.
+ * @param echo_pin The pin the sensor returns the echo on.
+ * @param index The index of the sensor in a replayed log, 0 for left, 1 for front, 2 for right.
+ * @param mount The position of the sensor on the robot.
+ * @param angle The direction of the beam relative to the heading in degrees.
+ */
+void Sonar::begin(World *world, pin_size_t trigger_pin, pin_size_t echo_pin, uint8_t index, Vec mount, float angle) {
+  this->world = world;
+  this->trigger_pin = trigger_pin;
+  this->echo_pin = echo_pin;
+  this->index = index;
+  this->mount = mount;
+  this->angle = radians(angle);
+  this->trigger = LOW;
+  this->echoing = false;
+  Board::attachPin(trigger_pin, this);
+  Board::setInput(echo_pin, LOW);
+}
+
+/**
+ * @brief Starts a measurement on the falling edge of the trigger pulse.
+ *
+ * The distance is measured at the time of the trigger. Triggers during an echo are ignored,
+ * like by the HC-SR04.
+ *
+ * @param pin The pin that has been written.
+ * @param value The new level of the pin.
+ */
+void Sonar::onWrite(pin_size_t /* pin */, PinStatus value) {
+  PinStatus previous = this->trigger;
+  this->trigger = value;
+  if (previous != HIGH || value != LOW || this->echoing)
+    return;
+
+  float distance;
+  Replay *replay = this->world->getReplay();
+  if (replay) {
+    distance = replay->readDistance(this->index, Board::now() / 1000);
+    if (!distance || distance >= SONAR_MAX_RANGE)
+      distance = -1;
+  } else {
+    Vec origin = this->world->toField(this->mount);
+    distance = this->world->castRay(origin, this->world->readHeading() + this->angle, SONAR_MAX_RANGE, true);
+    if (distance >= 0 && this->world->isNoisy())
+      distance = this->world->chance(SONAR_DROPOUT_RATE) ? -1 : distance + this->world->noise(0.5f);
+  }
+
+  this->echoing = true;
+  this->echo_width = distance >= 0 ? uint32_t(distance * SONAR_MICROS_PER_CM) : SONAR_NO_ECHO_MICROS;
+  this->echo_micros = Board::now() + SONAR_BURST_MICROS;
+  Board::schedule(this->echo_micros, Sonar::onEchoStart, this, false);
+}
+
+/**
+ * @brief Raises the echo pin once the burst has been sent.
+ *
+ * @param sonar The sensor.
+ */
+void Sonar::onEchoStart(void *sonar) {
+  Sonar *self = static_cast<Sonar *>(sonar);
+  Board::setInput(self->echo_pin, HIGH);
+  Board::schedule(self->echo_micros + self->echo_width, Sonar::onEchoEnd, self, false);
+}
+
+/**
+ * @brief Lowers the echo pin once the echo has returned.
+ *
+ * @param sonar The sensor.
+ */
+void Sonar::onEchoEnd(void *sonar) {
+  Sonar *self = static_cast<Sonar *>(sonar);
+  Board::setInput(self->echo_pin, LOW);
+  self->echoing = false;
+}
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection Imu
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+/**
+ * @brief Attaches the sensor to the I2C bus in its state after power-up.
+ *
+ * @param world The world the sensor measures.
+ */
+void Imu::begin(World *world) {
+  this->world = world;
+  memset(this->registers, 0, sizeof(this->registers));
+  this->registers[0x75] = IMU_ADDRESS;
+  this->registers[0x6B] = 0x40;
+  this->registers[0x41] = uint16_t(IMU_TEMPERATURE) >> 8;
+  this->registers[0x42] = uint16_t(IMU_TEMPERATURE) & 0xFF;
+  this->pointer = 0;
+  this->fifo_head = 0;
+  this->fifo_count = 0;
+  this->filtered_rate = 0;
+  this->bias = world->isNoisy() ? int16_t(world->noise(40.0f)) : IMU_BIAS;
+  Board::attachI2c(IMU_ADDRESS, this);
+}
+
+/**
+ * @brief Receives a register address, followed by the values of consecutive registers.
+ *
+ * @param data The bytes written by the sketch.
+ * @param length The amount of bytes.
+ * @return True if the sensor acknowledges the transaction, false while it starts up.
+ */
+bool Imu::receive(const uint8_t *data, size_t length) {
+  if (Board::now() < IMU_STARTUP_MICROS)
+    return false;
+  if (!length)
+    return true;
+
+  this->pointer = data[0] & 0x7F;
+  for (size_t i = 1; i < length; i++) {
+    uint8_t reg = this->pointer;
+    this->registers[reg] = data[i];
+
+    // USER_CTRL resets the FIFO buffer, which clears its reset bit again.
+    if (reg == 0x6A && (data[i] & 0x04)) {
+      this->fifo_head = 0;
+      this->fifo_count = 0;
+      this->registers[reg] &= ~0x04;
+    }
+    if (reg != 0x74)
+      this->pointer = (this->pointer + 1) & 0x7F;
+  }
+  return true;
+}
+
+/**
+ * @brief Transmits the values of consecutive registers, starting at the register address.
+ *
+ * Reading the FIFO register pops the buffer instead of advancing the address.
+ *
+ * @param data The bytes to fill.
+ * @param length The amount of bytes requested.
+ * @return The amount of bytes transmitted.
+ */
+size_t Imu::transmit(uint8_t *data, size_t length) {
+  if (Board::now() < IMU_STARTUP_MICROS)
+    return 0;
+
+  for (size_t i = 0; i < length; i++) {
+    uint8_t reg = this->pointer;
+    if (reg == 0x72) {
+      data[i] = this->fifo_count >> 8;
+    } else if (reg == 0x73) {
+      data[i] = this->fifo_count & 0xFF;
+    } else if (reg == 0x74) {
+      if (this->fifo_count) {
+        data[i] = this->fifo[(this->fifo_head + 1024 - this->fifo_count) % 1024];
+        this->fifo_count--;
+      } else {
+        data[i] = 0;
+      }
+    } else {
+      data[i] = this->registers[reg];
+    }
+    if (reg != 0x74)
+      this->pointer = (this->pointer + 1) & 0x7F;
+  }
+  return length;
+}
+
+/**
+ * @brief Samples the yaw rate into the FIFO buffer.
+ *
+ * The rate passes the digital low-pass filter of the sensor, is scaled and offset by the
+ * errors of the sensor, and is written as a big-endian pair of bytes if the FIFO buffer is
+ * enabled for the z axis of the gyroscope. Samples are lost while the buffer is full.
+ *
+ * @param yaw_rate The yaw rate in degrees per second, positive anticlockwise.
+ */
+void Imu::sample(float yaw_rate) {
+  this->filtered_rate += (yaw_rate - this->filtered_rate) * (1.0f / (IMU_FILTER_CONSTANT + 1.0f));
+
+  bool fifo_enabled = (this->registers[0x6A] & 0x40) && (this->registers[0x23] & 0x10);
+  if (!fifo_enabled || this->fifo_count > 1022)
+    return;
+
+  float raw = this->filtered_rate * IMU_LSB_PER_DPS / IMU_SCALE_ERROR + this->bias;
+  if (this->world->isNoisy())
+    raw += this->world->noise(3.0f);
+  int16_t value = constrain(lroundf(raw), -32768L, 32767L);
+
+  this->fifo[this->fifo_head] = uint16_t(value) >> 8;
+  this->fifo[(this->fifo_head + 1) % 1024] = uint16_t(value) & 0xFF;
+  this->fifo_head = (this->fifo_head + 2) % 1024;
+  this->fifo_count += 2;
+}
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection PixyCamera
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+/**
+ * @brief Connects the camera to the Pixy2 library.
+ *
+ * @param world The world the camera looks at.
+ */
+void PixyCamera::begin(World *world) {
+  this->world = world;
+  this->last_frame = 0;
+  memset(this->ages, 0, sizeof(this->ages));
+  Board::attachCamera(this);
+}
+
+/**
+ * @brief Indicates whether the camera answers requests.
+ *
+ * @return True once the camera has booted, false otherwise.
+ */
+bool PixyCamera::isBooted() {
+  return Board::now() >= PIXY_BOOT_MICROS;
+}
+
+/**
+ * @brief Renders the blocks of a new frame.
+ *
+ * Every pillar within the field of view and the range of the camera that is not hidden behind
+ * a wall is projected onto the image, clipped to its borders. The index of a block is the one
+ * of its pillar, and its age counts the frames the pillar has been seen in a row.
+ *
+ * @param blocks The blocks to fill.
+ * @param num_blocks The amount of blocks filled.
+ * @param max_blocks The maximum amount of blocks.
+ * @return True if a new frame has been rendered, false if the current frame has been read.
+ */
+bool PixyCamera::readFrame(Block *blocks, uint8_t &num_blocks, uint8_t max_blocks) {
+  uint64_t frame = Board::now() / PIXY_FRAME_MICROS;
+  if (frame == this->last_frame)
+    return false;
+  this->last_frame = frame;
+
+  num_blocks = 0;
+  Replay *replay = this->world->getReplay();
+  if (replay) {
+    if (max_blocks && replay->readBlock(Board::now() / 1000, blocks[0]))
+      num_blocks = 1;
+    return true;
+  }
+
+  const float focal = (PIXY_WIDTH / 2) / tanf(radians(PIXY_FIELD_OF_VIEW / 2));
+  const float vertical_focal = (PIXY_HEIGHT / 2) / tanf(radians(PIXY_VERTICAL_FIELD_OF_VIEW / 2));
+  Vec camera = this->world->toField({ CAMERA_MOUNT, 0 });
+
+  uint8_t num_pillars;
+  const Pillar *pillars = this->world->getPillars(num_pillars);
+
+  for (uint8_t i = 0; i < num_pillars; i++) {
+    Vec offset = subtract(pillars[i].position, camera);
+    float distance = length(offset);
+    float bearing = wrapAngle(atan2f(offset.y, offset.x) - this->world->readHeading());
+
+    bool visible = distance < PIXY_MAX_RANGE && fabsf(bearing) < radians(PIXY_FIELD_OF_VIEW / 2)
+                   && this->world->castRay(camera, atan2f(offset.y, offset.x), distance, false) < 0;
+
+    float center = PIXY_WIDTH / 2 - focal * tanf(bearing);
+    float half_width = focal * WORLD_PILLAR_SIZE / 2 / distance;
+    float left = fmaxf(center - half_width, 0);
+    float right = fminf(center + half_width, PIXY_WIDTH - 1);
+    float top = fmaxf(PIXY_HEIGHT / 2 + vertical_focal * (CAMERA_HEIGHT - WORLD_PILLAR_HEIGHT) / distance, 0);
+    float bottom = fminf(PIXY_HEIGHT / 2 + vertical_focal * CAMERA_HEIGHT / distance, PIXY_HEIGHT - 1);
+
+    // The camera drops blocks that are too small and, with noise, misses a block now and then.
+    visible = visible && right - left >= 2 && bottom - top >= 2;
+    if (visible && this->world->isNoisy() && this->world->chance(PIXY_MISS_RATE))
+      visible = false;
+
+    if (!visible) {
+      this->ages[i] = 0;
+      continue;
+    }
+    this->ages[i] = min(this->ages[i] + 1, 255);
+
+    if (num_blocks >= max_blocks)
+      continue;
+
+    float jitter = this->world->isNoisy() ? this->world->noise(1.0f) : 0;
+    blocks[num_blocks++] = {
+      pillars[i].signature, uint16_t(constrain((left + right) / 2 + jitter, 0.0f, float(PIXY_WIDTH - 1))),
+      uint16_t((top + bottom) / 2), uint16_t(right - left + 1), uint16_t(bottom - top + 1), 0,
+      uint8_t(i + 1), this->ages[i]
+    };
+  }
+
+  return true;
+}
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection World
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+/**
+ * @brief Constructs the World object and lays out the track.
+ *
+ * The robot starts in the middle of the corridor at the bottom of the field, facing the
+ * driving direction, with a random offset along the section.
+ *
+ * @param options The layout of the track and the behaviour of the devices.
+ */
+World::World(const WorldOptions &options)
+  : options(options), num_walls(0), num_pillars(0), score(), random_state(options.seed * 2654435761u + 1),
+    heading(options.clockwise ? PI : 0), speed(0), servo_angle(Constants::STRAIGHT), yaw_rate(0),
+    blocked(false), start_side(0), swept_angle(0), idle_micros(0), contact_micros(0) {
+  this->options.corridor = constrain(this->options.corridor, 40.0f, 140.0f);
+  this->buildTrack();
+
+  float offset = (this->random() % 61) - 30.0f;
+  this->position = { WORLD_FIELD_SIZE / 2 + offset, this->options.corridor / 2 };
+  this->start = this->position;
+  this->start_angle = atan2f(this->position.y - WORLD_FIELD_SIZE / 2, this->position.x - WORLD_FIELD_SIZE / 2);
+  this->last_angle = this->start_angle;
+  this->last_side = this->start_side;
+
+  this->placePillars();
+  this->score.min_clearance = WORLD_FIELD_SIZE;
+}
+
+/**
+ * @brief Destructs the World object.
+ */
+World::~World() {}
+
+/**
+ * @brief Attaches the devices to the Board and starts the steps of the model.
+ */
+void World::begin() {
+  this->sonars[0].begin(this, Pins::TRIGGER_PIN_LEFT, Pins::ECHO_PIN_LEFT, 0, { 8, ROBOT_HALF_WIDTH }, 90);
+  this->sonars[1].begin(this, Pins::TRIGGER_PIN_FRONT, Pins::ECHO_PIN_FRONT, 1, { FRONT_SONAR_MOUNT, 0 }, 0);
+  this->sonars[2].begin(this, Pins::TRIGGER_PIN_RIGHT, Pins::ECHO_PIN_RIGHT, 2, { 8, -ROBOT_HALF_WIDTH }, -90);
+  this->imu.begin(this);
+  this->camera.begin(this);
+
+  // The voltage divider maps the battery voltage to the range of the analog input.
+  Board::setAnalog(Pins::VOLTAGE_MEASUREMENT_PIN, map(this->options.voltage, 0, 100, 0, 1023) + 1);
+  Board::setInput(Pins::BUTTON_PIN, HIGH);
+
+  Board::schedule(WORLD_STEP_MICROS, World::onStep, this, false);
+}
+
+/**
+ * @brief Indicates whether the run is over.
+ *
+ * @return True if the robot has crashed, has stopped for good or the log is replayed.
+ */
+bool World::isFinished() {
+  if (this->options.replay)
+    return this->options.replay->isFinished(Board::now() / 1000);
+  return this->score.crashed || this->score.stopped;
+}
+
+/**
+ * @brief Retrieves the score of the run.
+ *
+ * @return The score.
+ */
+const Score &World::getScore() {
+  if (!this->score.stopped && !this->score.crashed)
+    this->score.stop_micros = Board::now();
+  return this->score;
+}
+
+/**
+ * @brief Reads the position of the robot.
+ *
+ * @return The position of the center of the rear axle.
+ */
+Vec World::readPosition() {
+  return this->position;
+}
+
+/**
+ * @brief Reads the heading of the robot.
+ *
+ * @return The heading in radians, anticlockwise from the x axis.
+ */
+float World::readHeading() {
+  return this->heading;
+}
+
+/**
+ * @brief Reads the speed of the robot.
+ *
+ * @return The speed in centimeters per second.
+ */
+float World::readSpeed() {
+  return this->speed;
+}
+
+/**
+ * @brief Reads the angle the servo has turned to.
+ *
+ * @return The angle in degrees, 90 being straight.
+ */
+float World::readSteeringAngle() {
+  return this->servo_angle;
+}
+
+/**
+ * @brief Reads the duty cycle applied to the motor.
+ *
+ * @return The duty cycle in percent, negative when driving backward.
+ */
+float World::readMotorDuty() {
+  return Board::readDuty(Pins::MOTOR_FORWARD_PIN) - Board::readDuty(Pins::MOTOR_BACKWARD_PIN);
+}
+
+/**
+ * @brief Casts a ray through the field, like the beam of a sensor.
+ *
+ * Surfaces whose normal is tilted too far from the ray reflect the sound away from the sensor
+ * and are not seen, and neither is anything behind them. The beam is sampled by a few rays
+ * across its width.
+ *
+ * @param origin The origin of the ray.
+ * @param direction The direction of the ray in radians.
+ * @param max_range The range of the ray.
+ * @param include_pillars True if the ray is a beam of sound reflected by walls and pillars,
+ * false for a line of sight that is only blocked by walls.
+ * @return The distance to the nearest surface, or a negative value if there is none in range.
+ */
+float World::castRay(Vec origin, float direction, float max_range, bool include_pillars) {
+  float nearest = -1;
+  uint8_t num_rays = include_pillars ? SONAR_BEAM_RAYS : 1;
+
+  for (uint8_t ray = 0; ray < num_rays; ray++) {
+    float angle = direction;
+    if (num_rays > 1)
+      angle += radians(SONAR_BEAM_WIDTH) * (float(ray) / (num_rays - 1) - 0.5f);
+    Vec ray_direction = unit(angle);
+    float hit = -1;
+    float hit_incidence = 0;
+
+    auto test = [&](const Wall &wall) {
+      float incidence;
+      float distance = intersect(origin, ray_direction, wall, incidence);
+      if (distance < 0 || distance > max_range)
+        return;
+      if (hit < 0 || distance < hit) {
+        hit = distance;
+        hit_incidence = incidence;
+      }
+    };
+
+    for (uint8_t i = 0; i < this->num_walls; i++) test(this->walls[i]);
+
+    if (!include_pillars) {
+      nearest = hit;
+      continue;
+    }
+
+    for (uint8_t i = 0; i < this->num_pillars; i++) {
+      const float h = WORLD_PILLAR_SIZE / 2;
+      Vec p = this->pillars[i].position;
+      Wall faces[] = {
+        { { p.x - h, p.y - h }, { p.x + h, p.y - h } },
+        { { p.x + h, p.y - h }, { p.x + h, p.y + h } },
+        { { p.x + h, p.y + h }, { p.x - h, p.y + h } },
+        { { p.x - h, p.y + h }, { p.x - h, p.y - h } }
+      };
+      for (const Wall &face : faces) test(face);
+    }
+
+    // The first surface on the ray stops the sound, even if it reflects it away.
+    if (hit >= 0 && hit_incidence <= SONAR_MAX_INCIDENCE && (nearest < 0 || hit < nearest))
+      nearest = hit;
+  }
+
+  return nearest;
+}
+
+/**
+ * @brief Reads the yaw rate the gyroscope measures.
+ *
+ * @return The yaw rate in degrees per second, positive anticlockwise.
+ */
+float World::readYawRate() {
+  if (this->options.replay)
+    return this->options.replay->readYawRate(Board::now() / 1000);
+  return degrees(this->yaw_rate);
+}
+
+/**
+ * @brief Transforms a point on the robot onto the field.
+ *
+ * @param local The point relative to the rear axle, x to the front and y to the left.
+ * @return The point on the field.
+ */
+Vec World::toField(Vec local) {
+  Vec forward = unit(this->heading);
+  Vec left = { -forward.y, forward.x };
+  return add(this->position, add(scale(forward, local.x), scale(left, local.y)));
+}
+
+/**
+ * @brief Retrieves the pillars on the track.
+ *
+ * @param num_pillars The amount of pillars.
+ * @return The pillars.
+ */
+const Pillar *World::getPillars(uint8_t &num_pillars) {
+  num_pillars = this->num_pillars;
+  return this->pillars;
+}
+
+/**
+ * @brief Draws a normally distributed random value.
+ *
+ * @param deviation The standard deviation.
+ * @return The random value.
+ */
+float World::noise(float deviation) {
+  float u1 = (this->random() + 1.0f) / 4294967296.0f;
+  float u2 = this->random() / 4294967296.0f;
+  return deviation * sqrtf(-2.0f * logf(u1)) * cosf(TWO_PI * u2);
+}
+
+/**
+ * @brief Draws whether an event of the given probability happens.
+ *
+ * @param probability The probability of the event, ranging from 0 to 1.
+ * @return True if the event happens, false otherwise.
+ */
+bool World::chance(float probability) {
+  return this->random() < probability * 4294967295.0f;
+}
+
+/**
+ * @brief Indicates whether the sensors are noisy.
+ *
+ * @return True if noise is added to the sensors, false otherwise.
+ */
+bool World::isNoisy() {
+  return this->options.noise && !this->options.replay;
+}
+
+/**
+ * @brief Retrieves the log the sensors are fed from.
+ *
+ * @return The log, or a null pointer if the sensors measure the model.
+ */
+Replay *World::getReplay() {
+  return this->options.replay;
+}
+
+/**
+ * @brief Advances the model by one step and schedules the next one.
+ *
+ * @param world The world.
+ */
+void World::onStep(void *world) {
+  World *self = static_cast<World *>(world);
+  self->step();
+  Board::schedule(Board::now() + WORLD_STEP_MICROS, World::onStep, self, false);
+}
+
+/**
+ * @brief Advances the robot by one step of the kinematic bicycle model.
+ *
+ * The motor lags behind its duty cycle and does not move the robot within its deadband. Its
+ * speed is proportional to the voltage it receives, the duty cycle times the battery voltage.
+ * A servo without pulses holds its angle. The walls are solid, and a robot that runs into one
+ * stalls in front of it.
+ */
+void World::step() {
+  const float dt = WORLD_STEP_MICROS / 1000000.0f;
+
+  float duty = this->readMotorDuty();
+  float speed_gain = MOTOR_SPEED_GAIN * this->options.voltage / MOTOR_NOMINAL_VOLTAGE;
+  float target_speed = fabsf(duty) < MOTOR_DEADBAND ? 0 : duty * speed_gain;
+  this->speed += (target_speed - this->speed) * dt / MOTOR_TIME_CONSTANT;
+
+  uint32_t pulse_width = Board::readPulseWidth(Pins::SERVO_PIN);
+  if (pulse_width) {
+    float target_angle = constrain((pulse_width - SERVO_PULSE_MIN) * 180.0f / (SERVO_PULSE_MAX - SERVO_PULSE_MIN), 0.0f, 180.0f);
+    float step = SERVO_RATE * dt;
+    this->servo_angle = constrain(target_angle, this->servo_angle - step, this->servo_angle + step);
+  }
+
+  if (!this->options.replay) {
+    Vec position = this->position;
+    float heading = this->heading;
+    float wheel_angle = radians(Constants::STRAIGHT - this->servo_angle) * STEERING_RATIO;
+    this->yaw_rate = this->speed * tanf(wheel_angle) / ROBOT_WHEELBASE;
+    this->heading = wrapAngle(this->heading + this->yaw_rate * dt);
+    this->position = add(this->position, scale(unit(this->heading), this->speed * dt));
+
+    // A step that would move the body into a wall is not taken.
+    this->blocked = this->measureClearance() <= 0;
+    if (this->blocked) {
+      this->position = position;
+      this->heading = heading;
+      this->speed = 0;
+      this->yaw_rate = 0;
+    }
+    this->score.distance += fabsf(this->speed) * dt;
+    this->updateScore();
+  }
+
+  this->imu.sample(this->readYawRate());
+}
+
+/**
+ * @brief Lays out the outer walls and the walls of the island.
+ */
+void World::buildTrack() {
+  const float s = WORLD_FIELD_SIZE;
+  const float c = this->options.corridor;
+  Vec outer[] = { { 0, 0 }, { s, 0 }, { s, s }, { 0, s } };
+  Vec inner[] = { { c, c }, { s - c, c }, { s - c, s - c }, { c, s - c } };
+
+  for (uint8_t i = 0; i < 4; i++) {
+    this->walls[this->num_walls++] = { outer[i], outer[(i + 1) % 4] };
+    this->walls[this->num_walls++] = { inner[i], inner[(i + 1) % 4] };
+  }
+}
+
+/**
+ * @brief Places the pillars on the straight parts of the sections.
+ *
+ * Pillars stand on one of three positions along a section and on one of two lanes across the
+ * corridor, with a random colour. No two pillars of a section share a position along it, and
+ * none is placed where the robot stands at the start.
+ */
+void World::placePillars() {
+  const float s = WORLD_FIELD_SIZE;
+  const float c = this->options.corridor;
+  uint8_t per_side = min(this->options.pillars, uint8_t(2));
+
+  for (uint8_t side = 0; side < 4; side++) {
+    uint8_t first_slot = this->random() % 3;
+    for (uint8_t n = 0; n < per_side; n++) {
+      uint8_t slot = (first_slot + n + (n ? this->random() % 2 : 0)) % 3;
+      float u = c + (s - 2 * c) * (0.2f + 0.3f * slot);
+      float w = c * ((this->random() % 2) ? 0.35f : 0.65f);
+      if (side == this->start_side && fabsf(u - this->position.x) < ROBOT_FRONT - ROBOT_REAR + WORLD_PILLAR_SIZE)
+        continue;
+
+      // Points of a side in the frame of the bottom side rotate anticlockwise around the center.
+      Vec point = { u, w };
+      for (uint8_t r = 0; r < side; r++) point = { s - point.y, point.x };
+
+      Pillar &pillar = this->pillars[this->num_pillars++];
+      pillar.position = point;
+      pillar.signature = (this->random() % 2) ? 1 : 2;
+      pillar.side = side;
+      pillar.along = this->alongSide(point, side);
+      pillar.passed = side == this->start_side && this->alongSide(this->position, side) >= pillar.along;
+      pillar.hit = false;
+    }
+  }
+}
+
+/**
+ * @brief Tracks the progress of the robot around the island and checks the rules.
+ *
+ * A lap is the angle swept around the center of the field. A pillar is passed when the robot
+ * crosses it along its side, and it has to be on the right of a green pillar and on the left of
+ * a red pillar, seen in the driving direction. A contact with a wall lasts until the robot has
+ * backed off from it, and the robot crashes when it stays stalled against a wall for
+ * STUCK_TIMEOUT. It has stopped once the motor output has been switched off with the robot at
+ * rest.
+ */
+void World::updateScore() {
+  if (this->score.crashed || this->score.stopped)
+    return;
+
+  float angle = atan2f(this->position.y - WORLD_FIELD_SIZE / 2, this->position.x - WORLD_FIELD_SIZE / 2);
+  float swept = wrapAngle(angle - this->last_angle);
+  this->swept_angle += this->options.clockwise ? -swept : swept;
+  this->last_angle = angle;
+  this->score.laps = this->swept_angle / TWO_PI;
+  this->score.sections = max(0.0f, (this->swept_angle + HALF_PI / 2) / HALF_PI);
+
+  if (!this->score.start_micros && fabsf(this->speed) > 1)
+    this->score.start_micros = Board::now();
+
+  uint8_t side = this->findSide(this->position);
+  float along = this->alongSide(this->position, side);
+  Vec forward = unit(this->heading);
+
+  for (uint8_t i = 0; i < this->num_pillars; i++) {
+    Pillar &pillar = this->pillars[i];
+
+    // A pillar is passed again on the next lap, once the robot is across the island from it.
+    if (side == (pillar.side + 2) % 4) {
+      pillar.passed = false;
+    } else if (side == pillar.side && !pillar.passed && along >= pillar.along) {
+      pillar.passed = true;
+      bool pillar_on_left = cross(forward, subtract(pillar.position, this->position)) > 0;
+      bool red = pillar.signature == 1;
+      if (red != pillar_on_left)
+        this->score.wrong_side++;
+    }
+
+    // The pillar is hit if its center comes closer to the body than half of its size.
+    Vec offset = subtract(pillar.position, this->position);
+    float x = dot(offset, forward);
+    float y = cross(forward, offset);
+    float dx = fmaxf(fmaxf(ROBOT_REAR - x, x - ROBOT_FRONT), 0);
+    float dy = fmaxf(fabsf(y) - ROBOT_HALF_WIDTH, 0);
+    if (!pillar.hit && sqrtf(dx * dx + dy * dy) < WORLD_PILLAR_SIZE / 2) {
+      pillar.hit = true;
+      this->score.pillar_hits++;
+    }
+  }
+
+  if (this->blocked) {
+    if (!this->contact_micros) {
+      this->contact_micros = Board::now();
+      this->score.wall_contacts++;
+    }
+    this->score.min_clearance = 0;
+    if (Board::now() - this->contact_micros >= STUCK_TIMEOUT) {
+      this->score.crashed = true;
+      this->score.stop_micros = Board::now();
+      return;
+    }
+  } else {
+    if (this->measureClearance() > WALL_CONTACT_MARGIN)
+      this->contact_micros = 0;
+    this->score.min_clearance = fminf(this->score.min_clearance, this->measureClearance());
+  }
+
+  bool motor_off = !Board::isPwmRunning(Pins::MOTOR_FORWARD_PIN) && !Board::isPwmRunning(Pins::MOTOR_BACKWARD_PIN);
+  if (this->score.start_micros && motor_off && fabsf(this->speed) < 1) {
+    if (!this->idle_micros)
+      this->idle_micros = Board::now();
+    if (Board::now() - this->idle_micros >= IDLE_TIMEOUT) {
+      this->score.stopped = true;
+      this->score.stop_micros = Board::now();
+      if (side == this->start_side) {
+        Vec direction = unit(this->options.clockwise ? PI : 0);
+        this->score.stop_offset = dot(subtract(this->position, this->start), direction);
+      }
+    }
+  } else {
+    this->idle_micros = 0;
+  }
+}
+
+/**
+ * @brief Measures the clearance of the body of the robot to the walls.
+ *
+ * @return The smallest distance of a point on the outline of the body to a wall, 0 or less if
+ * a point is outside of the corridor.
+ */
+float World::measureClearance() {
+  const float s = WORLD_FIELD_SIZE;
+  const float c = this->options.corridor;
+  Vec outline[] = {
+    { ROBOT_FRONT, ROBOT_HALF_WIDTH }, { ROBOT_FRONT, 0 }, { ROBOT_FRONT, -ROBOT_HALF_WIDTH },
+    { 8, -ROBOT_HALF_WIDTH }, { ROBOT_REAR, -ROBOT_HALF_WIDTH }, { ROBOT_REAR, 0 },
+    { ROBOT_REAR, ROBOT_HALF_WIDTH }, { 8, ROBOT_HALF_WIDTH }
+  };
+
+  float clearance = s;
+  for (const Vec &local : outline) {
+    Vec point = this->toField(local);
+    bool outside = point.x <= 0 || point.y <= 0 || point.x >= s || point.y >= s
+                   || (point.x > c && point.x < s - c && point.y > c && point.y < s - c);
+    if (outside)
+      return 0;
+
+    for (uint8_t i = 0; i < this->num_walls; i++) {
+      clearance = fminf(clearance, distanceToWall(point, this->walls[i]));
+    }
+  }
+  return clearance;
+}
+
+/**
+ * @brief Finds the side of the field a position belongs to.
+ *
+ * The sides are split along the diagonals of the field, so every corner is shared by the two
+ * sides that meet in it.
+ *
+ * @param position The position on the field.
+ * @return The side, counted anticlockwise from 0 at the bottom.
+ */
+uint8_t World::findSide(Vec position) {
+  float angle = atan2f(position.y - WORLD_FIELD_SIZE / 2, position.x - WORLD_FIELD_SIZE / 2);
+  return uint8_t(floorf((angle + 3 * HALF_PI / 2) / HALF_PI) + 4) % 4;
+}
+
+/**
+ * @brief Measures the position along a side in the driving direction.
+ *
+ * @param position The position on the field.
+ * @param side The side of the field.
+ * @return The distance from the corner the robot enters the side at.
+ */
+float World::alongSide(Vec position, uint8_t side) {
+  const float s = WORLD_FIELD_SIZE;
+  float u;
+  switch (side) {
+    case 0: u = position.x; break;
+    case 1: u = position.y; break;
+    case 2: u = s - position.x; break;
+    default: u = s - position.y; break;
+  }
+  return this->options.clockwise ? s - u : u;
+}
+
+/**
+ * @brief Draws the next value of the xorshift generator.
+ *
+ * @return The random value.
+ */
+uint32_t World::random() {
+  uint32_t x = this->random_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return this->random_state = x;
+}
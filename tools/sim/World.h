@@ -0,0 +1,238 @@
+/**
+ * @file World.h
+ * @brief Header file for the World class, the kinematic model of the track and the robot.
+ *
+ * The World class simulates the field of the WRO Future Engineers challenge and the robot
+ * racing on it, and attaches the simulated devices to the Board. The field is a square of
+ * 300 cm with an inner island that leaves a corridor of configurable width, and pillars can be
+ * placed on the straight parts of the sections. The robot follows a kinematic bicycle model,
+ * driven by the duty cycle on the pins of the motor driver with a first-order lag and steered
+ * by the pulses of the servo, which turns at a limited rate. The walls are solid and stall the
+ * robot, like the real robot that relies on touching them in its corrections.
+ *
+ * The devices answer the sketch like their real counterparts:
+ * - The ultrasonic sensors answer a trigger pulse with an echo pulse whose width is the time
+ *   of flight to the nearest surface within their beam.
+ * - The MPU6050 fills its FIFO buffer with the yaw rate at 1 kHz, with a constant bias and the
+ *   scale error that the sketch corrects.
+ * - The Pixy2 boots in two seconds and delivers a frame of colour blocks every 16.7 ms, with
+ *   the pillars in its field of view projected onto the image.
+ *
+ * Instead of the model, the sensors can be fed from a recorded telemetry log, which replays a
+ * run of the real robot in open loop.
+ *
+ * The world keeps a score of the run: the laps and sections driven around the island, the
+ * pillars passed on the wrong side or hit, the contacts with and the closest approach to a
+ * wall, and the position at which the robot stops relative to its start.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef WORLD_H
+#define WORLD_H
+
+#include "Board.h"
+#include "Replay.h"
+
+#define WORLD_FIELD_SIZE 300.0f
+#define WORLD_STEP_MICROS 1000
+#define WORLD_MAX_WALLS 8
+#define WORLD_MAX_PILLARS 8
+#define WORLD_PILLAR_SIZE 5.0f
+#define WORLD_PILLAR_HEIGHT 10.0f
+#define WORLD_NUM_SONARS 3
+
+/**
+ * @struct Vec
+ * @brief Struct to hold a point or a direction on the field in centimeters.
+ */
+struct Vec {
+  float x;
+  float y;
+};
+
+/**
+ * @struct Wall
+ * @brief Struct to hold a wall as a segment between two points.
+ */
+struct Wall {
+  Vec a;
+  Vec b;
+};
+
+/**
+ * @struct Pillar
+ * @brief Struct to hold a pillar and whether the robot has passed it already.
+ */
+struct Pillar {
+  Vec position;
+  uint8_t signature;    // Signature of the colour in the Pixy2, 1 for red and 2 for green.
+  uint8_t side;         // Side of the field the pillar stands on, counted anticlockwise from the bottom.
+  float along;          // Position along the side in the driving direction.
+  bool passed;
+  bool hit;
+};
+
+/**
+ * @struct WorldOptions
+ * @brief Struct to hold the layout of the track and the behaviour of the devices.
+ */
+struct WorldOptions {
+  bool clockwise;
+  float corridor;        // Width of the corridor between the outer walls and the island.
+  uint8_t pillars;       // Pillars per section, 0 for the open challenge.
+  uint32_t seed;         // Seed of the layout of the pillars, the start pose and the noise.
+  bool noise;            // Adds noise and dropped echoes to the sensors.
+  uint8_t voltage;       // Battery voltage as read by the sketch, in its scale from 0 to 100.
+  Replay *replay;        // Recorded log the sensors are fed from, or a null pointer.
+};
+
+/**
+ * @struct Score
+ * @brief Struct to hold the outcome of a run.
+ */
+struct Score {
+  bool crashed;
+  bool stopped;
+  float laps;            // Laps driven around the island, with fractions.
+  uint8_t sections;      // Sections driven, counted when the robot enters the next side.
+  uint8_t wrong_side;    // Pillars passed on the wrong side.
+  uint8_t pillar_hits;
+  uint8_t wall_contacts;  // Times the body has run into a wall.
+  float min_clearance;   // Closest distance of the body of the robot to a wall.
+  float stop_offset;     // Distance from the start to the stop along the side, 0 if elsewhere.
+  float distance;        // Distance driven.
+  uint64_t start_micros; // Time the robot has started moving.
+  uint64_t stop_micros;  // Time the robot has stopped, or the end of the run.
+};
+
+class World;
+
+/**
+ * @class Sonar
+ * @brief Ultrasonic sensor on the robot that echoes the trigger pulses of the sketch.
+ */
+class Sonar : public PinDevice {
+public:
+  void begin(World *world, pin_size_t trigger_pin, pin_size_t echo_pin, uint8_t index, Vec mount, float angle);
+  void onWrite(pin_size_t pin, PinStatus value) override;
+
+private:
+  static void onEchoStart(void *sonar);
+  static void onEchoEnd(void *sonar);
+
+  World *world;
+  pin_size_t trigger_pin;
+  pin_size_t echo_pin;
+  uint8_t index;
+  Vec mount;              // Position relative to the rear axle, x to the front, y to the left.
+  float angle;            // Direction of the beam relative to the heading, positive to the left.
+  PinStatus trigger;
+  bool echoing;
+  uint64_t echo_micros;
+  uint32_t echo_width;
+  friend class World;
+};
+
+/**
+ * @class Imu
+ * @brief MPU6050 on the I2C bus that samples the yaw rate of the robot into its FIFO buffer.
+ */
+class Imu : public I2cDevice {
+public:
+  void begin(World *world);
+  bool receive(const uint8_t *data, size_t length) override;
+  size_t transmit(uint8_t *data, size_t length) override;
+  void sample(float yaw_rate);
+
+private:
+  World *world;
+  uint8_t registers[128];
+  uint8_t pointer;
+  uint8_t fifo[1024];
+  uint16_t fifo_head;
+  uint16_t fifo_count;
+  float filtered_rate;
+  int16_t bias;
+};
+
+/**
+ * @class PixyCamera
+ * @brief Pixy2 on the robot that projects the pillars in view onto colour blocks.
+ */
+class PixyCamera : public CameraDevice {
+public:
+  void begin(World *world);
+  bool isBooted() override;
+  bool readFrame(Block *blocks, uint8_t &num_blocks, uint8_t max_blocks) override;
+
+private:
+  World *world;
+  uint64_t last_frame;
+  uint8_t ages[WORLD_MAX_PILLARS];
+};
+
+class World {
+public:
+  World(const WorldOptions &options);
+  ~World();
+
+  void begin();
+  bool isFinished();
+  const Score &getScore();
+  Vec readPosition();
+  float readHeading();
+  float readSpeed();
+  float readSteeringAngle();
+  float readMotorDuty();
+
+  float castRay(Vec origin, float direction, float max_range, bool include_pillars);
+  float readYawRate();
+  Vec toField(Vec local);
+  const Pillar *getPillars(uint8_t &num_pillars);
+  float noise(float deviation);
+  bool chance(float probability);
+  bool isNoisy();
+  Replay *getReplay();
+
+private:
+  static void onStep(void *world);
+  void step();
+  void buildTrack();
+  void placePillars();
+  void updateScore();
+  float measureClearance();
+  uint8_t findSide(Vec position);
+  float alongSide(Vec position, uint8_t side);
+  uint32_t random();
+
+  WorldOptions options;
+  Wall walls[WORLD_MAX_WALLS];
+  uint8_t num_walls;
+  Pillar pillars[WORLD_MAX_PILLARS];
+  uint8_t num_pillars;
+  Sonar sonars[WORLD_NUM_SONARS];
+  Imu imu;
+  PixyCamera camera;
+  Score score;
+  uint32_t random_state;
+
+  Vec position;           // Position of the center of the rear axle.
+  float heading;          // Heading in radians, anticlockwise from the x axis.
+  float speed;            // Speed in centimeters per second.
+  float servo_angle;      // Angle the servo has turned to, in degrees.
+  float yaw_rate;         // Yaw rate in radians per second.
+  bool blocked;           // The last step has been stopped by a wall.
+  Vec start;
+  uint8_t start_side;
+  float start_angle;      // Angle of the start around the center of the field.
+  float swept_angle;      // Angle swept around the center of the field since the start.
+  float last_angle;
+  uint8_t last_side;
+  uint64_t idle_micros;   // Time the motor output has been switched off.
+  uint64_t contact_micros;  // Time the robot has run into the wall it is stalled against.
+};
+
+#endif  // WORLD_H
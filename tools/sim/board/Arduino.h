@@ -0,0 +1,205 @@
+/**
+ * @file Arduino.h
+ * @brief Host implementation of the Arduino core API for the simulator.
+ *
+ * Declares the part of the Arduino core of the Uno R4 that the sketch uses, so the control code
+ * builds natively on a PC without any change. Time does not pass on its own: the simulated
+ * clock of the Board advances by the cost of every call into the core and of every pass of the
+ * main loop, which makes every run deterministic and faster than real time. Pins, interrupts,
+ * timers and buses are routed to the devices of the simulated world.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t pin_size_t;
+typedef uint8_t byte;
+
+enum PinStatus {
+  LOW = 0,
+  HIGH = 1,
+  CHANGE = 2,
+  FALLING = 3,
+  RISING = 4
+};
+
+enum PinMode {
+  INPUT = 0,
+  OUTPUT = 1,
+  INPUT_PULLUP = 2,
+  INPUT_PULLDOWN = 3
+};
+
+#define NOT_AN_INTERRUPT -1
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+#define sq(x) ((x) * (x))
+
+// Mixed argument types are allowed, like in the Arduino core of the Uno R4.
+template<class T, class L>
+auto min(const T &a, const L &b) -> decltype((b < a) ? b : a) {
+  return (b < a) ? b : a;
+}
+
+template<class T, class L>
+auto max(const T &a, const L &b) -> decltype((b < a) ? b : a) {
+  return (a < b) ? b : a;
+}
+
+typedef void (*voidFuncPtr)(void);
+typedef void (*voidFuncPtrParam)(void *);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(pin_size_t pin, PinMode mode);
+void digitalWrite(pin_size_t pin, PinStatus value);
+PinStatus digitalRead(pin_size_t pin);
+int analogRead(pin_size_t pin);
+
+int digitalPinToInterrupt(pin_size_t pin);
+void attachInterrupt(pin_size_t interrupt, voidFuncPtr callback, PinStatus mode);
+void attachInterruptParam(pin_size_t interrupt, voidFuncPtrParam callback, PinStatus mode, void *param);
+void detachInterrupt(pin_size_t interrupt);
+void noInterrupts();
+void interrupts();
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+// The integer overloads of the core take the place of the macros of the pin enums.
+inline void digitalWrite(pin_size_t pin, int value) {
+  digitalWrite(pin, value ? HIGH : LOW);
+}
+
+inline void pinMode(pin_size_t pin, int mode) {
+  pinMode(pin, PinMode(mode));
+}
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+/**
+ * @class Print
+ * @brief Formats numbers and text into bytes, like the Print class of the Arduino core.
+ */
+class Print {
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t value) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  virtual int availableForWrite() {
+    return 0;
+  }
+
+  size_t write(const char *str) {
+    return str ? this->write(reinterpret_cast<const uint8_t *>(str), strlen(str)) : 0;
+  }
+
+  size_t print(const char *str);
+  size_t print(char value);
+  size_t print(unsigned char value, int base = DEC);
+  size_t print(int value, int base = DEC);
+  size_t print(unsigned int value, int base = DEC);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(long long value, int base = DEC);
+  size_t print(unsigned long long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+
+  size_t println();
+  template<typename T>
+  size_t println(T value) {
+    size_t n = this->print(value);
+    return n + this->println();
+  }
+  template<typename T>
+  size_t println(T value, int format) {
+    size_t n = this->print(value, format);
+    return n + this->println();
+  }
+
+private:
+  size_t printNumber(unsigned long long value, int base);
+};
+
+/**
+ * @class Stream
+ * @brief Adds reading to the Print class, like the Stream class of the Arduino core.
+ */
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() {
+    return -1;
+  }
+};
+
+/**
+ * @class HardwareSerial
+ * @brief Serial port of the simulated board, whose output is written to a file.
+ */
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud);
+  void end();
+  operator bool();
+
+  size_t write(uint8_t value) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  int availableForWrite() override;
+  int available() override;
+  int read() override;
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+/**
+ * @struct DWT_Type
+ * @brief Data watchpoint and trace unit, whose cycle counter follows the simulated clock.
+ */
+struct DWT_Type {
+  volatile uint32_t CTRL;
+  volatile uint32_t CYCCNT;
+};
+
+/**
+ * @struct CoreDebug_Type
+ * @brief Debug unit of the Cortex-M4, which enables the trace unit.
+ */
+struct CoreDebug_Type {
+  volatile uint32_t DEMCR;
+};
+
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+extern DWT_Type *const DWT;
+extern CoreDebug_Type *const CoreDebug;
+extern uint32_t SystemCoreClock;
+
+#endif  // ARDUINO_H
@@ -0,0 +1,1006 @@
+/**
+ * @file Board.cpp
+ * @brief Implementation of the Board and of the host Arduino core and libraries.
+ */
+
+#include "Board.h"
+#include "pwm.h"
+#include "FspTimer.h"
+#include "Wire.h"
+#include "EEPROM.h"
+#include "LiquidCrystal_I2C.h"
+
+/**
+ * @struct Event
+ * @brief Struct to hold an event that falls due at a time of the simulated clock.
+ */
+struct Event {
+  uint64_t time;
+  uint32_t order;  // Keeps events of the same time in the order they were scheduled.
+  BoardEvent event;
+  void *context;
+  bool in_interrupt;
+};
+
+/**
+ * @struct Pin
+ * @brief Struct to hold the state of a pin of the board.
+ */
+struct Pin {
+  PinMode mode;
+  PinStatus input;
+  PinStatus output;
+  int analog;
+  PinDevice *device;
+  voidFuncPtrParam isr;
+  void *isr_param;
+  PinStatus isr_mode;
+  bool isr_pending;
+  bool pwm_running;
+  float duty;
+  uint32_t pulse_width;
+};
+
+/**
+ * @struct I2cAttachment
+ * @brief Struct to hold a device attached to an address of the I2C bus.
+ */
+struct I2cAttachment {
+  uint8_t address;
+  I2cDevice *device;
+};
+
+static uint64_t clock_micros;
+static uint32_t event_order;
+static Event events[BOARD_MAX_EVENTS];
+static uint8_t num_events;
+static Pin pins[BOARD_NUM_PINS];
+static I2cAttachment i2c_devices[BOARD_MAX_I2C_DEVICES];
+static uint8_t num_i2c_devices;
+static CameraDevice *camera;
+static FILE *serial_output;
+static bool interrupts_enabled = true;
+static bool in_interrupt;
+static bool dispatching;
+
+static DWT_Type dwt;
+static CoreDebug_Type core_debug;
+DWT_Type *const DWT = &dwt;
+CoreDebug_Type *const CoreDebug = &core_debug;
+uint32_t SystemCoreClock = BOARD_CORE_CLOCK;
+
+HardwareSerial Serial;
+TwoWire Wire;
+EEPROMClass EEPROM;
+LiquidCrystal_I2C *LiquidCrystal_I2C::instance;
+
+// Pins of the Uno R4 that can raise an interrupt on a change of their level.
+static const pin_size_t INTERRUPT_PINS[] = { 0, 1, 2, 3, 8, 12, 13, 15, 16, 17, 18, 19 };
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection Board
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+/**
+ * @brief Sets the clock to a new time and lets the cycle counter follow it.
+ *
+ * @param time The new time in microseconds.
+ */
+static void setClock(uint64_t time) {
+  if (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)
+    DWT->CYCCNT += uint32_t((time - clock_micros) * (SystemCoreClock / 1000000));
+  clock_micros = time;
+}
+
+/**
+ * @brief Raises the interrupt of a pin, if its change matches the mode of the interrupt.
+ *
+ * @param pin The pin that has changed.
+ */
+static void raisePinInterrupt(pin_size_t pin) {
+  Pin &state = pins[pin];
+  state.isr_pending = false;
+
+  in_interrupt = true;
+  state.isr(state.isr_param);
+  in_interrupt = false;
+}
+
+/**
+ * @brief Raises the pending pin interrupts.
+ */
+static void raisePendingInterrupts() {
+  for (pin_size_t pin = 0; pin < BOARD_NUM_PINS; pin++) {
+    if (pins[pin].isr_pending && pins[pin].isr)
+      raisePinInterrupt(pin);
+  }
+}
+
+/**
+ * @brief Raises all events that are due at the given time, in the order of their time.
+ *
+ * Events in interrupt context stay queued while interrupts are disabled.
+ *
+ * @param until The time up to which events are raised.
+ */
+static void dispatch(uint64_t until) {
+  dispatching = true;
+
+  while (true) {
+    int8_t next = -1;
+    for (uint8_t i = 0; i < num_events; i++) {
+      const Event &event = events[i];
+      if (event.time > until || (event.in_interrupt && !interrupts_enabled))
+        continue;
+      if (next < 0 || event.time < events[next].time
+          || (event.time == events[next].time && event.order < events[next].order))
+        next = i;
+    }
+    if (next < 0)
+      break;
+
+    Event event = events[next];
+    events[next] = events[--num_events];
+
+    if (event.time > clock_micros)
+      setClock(event.time);
+
+    in_interrupt = event.in_interrupt;
+    event.event(event.context);
+    in_interrupt = false;
+  }
+
+  if (until > clock_micros)
+    setClock(until);
+
+  dispatching = false;
+}
+
+/**
+ * @brief Resets the clock, the pins, the buses and the EEPROM to their state at power-up.
+ */
+void Board::reset() {
+  clock_micros = 0;
+  event_order = 0;
+  num_events = 0;
+  num_i2c_devices = 0;
+  camera = nullptr;
+  interrupts_enabled = true;
+  in_interrupt = false;
+  dispatching = false;
+  dwt = {};
+  core_debug = {};
+
+  for (pin_size_t pin = 0; pin < BOARD_NUM_PINS; pin++) {
+    pins[pin] = {};
+    pins[pin].input = HIGH;
+  }
+
+  memset(EEPROM.memory, 0xFF, sizeof(EEPROM.memory));
+}
+
+/**
+ * @brief Reads the time of the simulated clock.
+ *
+ * @return The time since power-up in microseconds.
+ */
+uint64_t Board::now() {
+  return clock_micros;
+}
+
+/**
+ * @brief Lets the given time pass and raises the events that fall due in between.
+ *
+ * Time spent by events themselves is not accounted, so an interrupt takes no time.
+ *
+ * @param us The time to pass in microseconds.
+ */
+void Board::advance(uint32_t us) {
+  if (dispatching) {
+    return;
+  }
+
+  dispatch(clock_micros + us);
+}
+
+/**
+ * @brief Schedules an event at a time of the simulated clock.
+ *
+ * @param time The time the event falls due, in microseconds since power-up.
+ * @param event The function to call.
+ * @param context The argument of the function.
+ * @param in_interrupt True if the event is raised in interrupt context, false otherwise.
+ */
+void Board::schedule(uint64_t time, BoardEvent event, void *context, bool in_interrupt) {
+  if (num_events >= BOARD_MAX_EVENTS) {
+    fprintf(stderr, "board: event queue overflow\n");
+    abort();
+  }
+
+  events[num_events++] = { time, event_order++, event, context, in_interrupt };
+}
+
+/**
+ * @brief Indicates whether the caller runs in interrupt context.
+ *
+ * @return True within an interrupt, false otherwise.
+ */
+bool Board::isInInterrupt() {
+  return in_interrupt;
+}
+
+/**
+ * @brief Drives the level of an input pin from a device.
+ *
+ * An attached interrupt is raised right away if its mode matches the change, or as soon as
+ * interrupts are enabled again.
+ *
+ * @param pin The pin to drive.
+ * @param value The new level.
+ */
+void Board::setInput(pin_size_t pin, PinStatus value) {
+  if (pin >= BOARD_NUM_PINS)
+    return;
+
+  Pin &state = pins[pin];
+  if (state.input == value)
+    return;
+  state.input = value;
+
+  if (!state.isr)
+    return;
+
+  bool matches = state.isr_mode == CHANGE || (state.isr_mode == RISING && value == HIGH)
+                 || (state.isr_mode == FALLING && value == LOW) || state.isr_mode == value;
+  if (!matches)
+    return;
+
+  state.isr_pending = true;
+  if (interrupts_enabled && !in_interrupt)
+    raisePinInterrupt(pin);
+}
+
+/**
+ * @brief Sets the value an analog pin reads.
+ *
+ * @param pin The pin to set.
+ * @param value The value of the analog to digital converter, ranging from 0 to 1023.
+ */
+void Board::setAnalog(pin_size_t pin, int value) {
+  if (pin < BOARD_NUM_PINS)
+    pins[pin].analog = constrain(value, 0, 1023);
+}
+
+/**
+ * @brief Reads the level the sketch drives an output pin to.
+ *
+ * @param pin The pin to read.
+ * @return The level of the pin.
+ */
+PinStatus Board::readOutput(pin_size_t pin) {
+  return pin < BOARD_NUM_PINS ? pins[pin].output : LOW;
+}
+
+/**
+ * @brief Attaches a device that is notified of every write to an output pin.
+ *
+ * @param pin The pin to watch.
+ * @param device The device to notify.
+ */
+void Board::attachPin(pin_size_t pin, PinDevice *device) {
+  if (pin < BOARD_NUM_PINS)
+    pins[pin].device = device;
+}
+
+/**
+ * @brief Reads the duty cycle of the PWM signal on a pin.
+ *
+ * @param pin The pin to read.
+ * @return The duty cycle in percent, 0 if no signal is generated.
+ */
+float Board::readDuty(pin_size_t pin) {
+  return (pin < BOARD_NUM_PINS && pins[pin].pwm_running) ? pins[pin].duty : 0.0f;
+}
+
+/**
+ * @brief Reads the pulse width of the PWM signal on a pin.
+ *
+ * @param pin The pin to read.
+ * @return The pulse width in microseconds, 0 if no signal is generated.
+ */
+uint32_t Board::readPulseWidth(pin_size_t pin) {
+  return (pin < BOARD_NUM_PINS && pins[pin].pwm_running) ? pins[pin].pulse_width : 0;
+}
+
+/**
+ * @brief Indicates whether a PWM signal is generated on a pin.
+ *
+ * @param pin The pin to check.
+ * @return True if a signal is generated, false otherwise.
+ */
+bool Board::isPwmRunning(pin_size_t pin) {
+  return pin < BOARD_NUM_PINS && pins[pin].pwm_running;
+}
+
+/**
+ * @brief Publishes the PWM signal generated on a pin.
+ *
+ * @param pin The pin of the signal.
+ * @param running True if the signal is generated, false otherwise.
+ * @param duty The duty cycle in percent.
+ * @param pulse_width The pulse width in microseconds.
+ */
+void Board::setPwm(pin_size_t pin, bool running, float duty, uint32_t pulse_width) {
+  if (pin >= BOARD_NUM_PINS)
+    return;
+
+  pins[pin].pwm_running = running;
+  pins[pin].duty = duty;
+  pins[pin].pulse_width = pulse_width;
+}
+
+/**
+ * @brief Attaches a device to an address of the I2C bus.
+ *
+ * @param address The 7-bit address of the device.
+ * @param device The device.
+ */
+void Board::attachI2c(uint8_t address, I2cDevice *device) {
+  if (num_i2c_devices < BOARD_MAX_I2C_DEVICES)
+    i2c_devices[num_i2c_devices++] = { address, device };
+}
+
+/**
+ * @brief Finds the device attached to an address of the I2C bus.
+ *
+ * @param address The 7-bit address of the device.
+ * @return The device, or a null pointer if no device answers to the address.
+ */
+I2cDevice *Board::findI2c(uint8_t address) {
+  for (uint8_t i = 0; i < num_i2c_devices; i++) {
+    if (i2c_devices[i].address == address)
+      return i2c_devices[i].device;
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Attaches the camera behind the Pixy2 library.
+ *
+ * @param device The camera.
+ */
+void Board::attachCamera(CameraDevice *device) {
+  camera = device;
+}
+
+/**
+ * @brief Finds the camera behind the Pixy2 library.
+ *
+ * @return The camera, or a null pointer if none is connected.
+ */
+CameraDevice *Board::findCamera() {
+  return camera;
+}
+
+/**
+ * @brief Sets the file the serial port writes to.
+ *
+ * @param file The file, or a null pointer to discard the output.
+ */
+void Board::setSerialOutput(FILE *file) {
+  serial_output = file;
+}
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection Core
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+unsigned long millis() {
+  Board::advance(BOARD_CLOCK_COST);
+  return (unsigned long)(Board::now() / 1000);
+}
+
+unsigned long micros() {
+  Board::advance(BOARD_CLOCK_COST);
+  return (unsigned long)Board::now();
+}
+
+void delay(unsigned long ms) {
+  Board::advance(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  Board::advance(us);
+}
+
+void pinMode(pin_size_t pin, PinMode mode) {
+  if (pin >= BOARD_NUM_PINS)
+    return;
+
+  pins[pin].mode = mode;
+  if (mode == INPUT_PULLDOWN)
+    pins[pin].input = LOW;
+}
+
+void digitalWrite(pin_size_t pin, PinStatus value) {
+  Board::advance(BOARD_PIN_COST);
+  if (pin >= BOARD_NUM_PINS)
+    return;
+
+  pins[pin].output = value;
+  if (pins[pin].device)
+    pins[pin].device->onWrite(pin, value);
+}
+
+PinStatus digitalRead(pin_size_t pin) {
+  Board::advance(BOARD_PIN_COST);
+  if (pin >= BOARD_NUM_PINS)
+    return LOW;
+
+  return pins[pin].mode == OUTPUT ? pins[pin].output : pins[pin].input;
+}
+
+int analogRead(pin_size_t pin) {
+  Board::advance(BOARD_ANALOG_COST);
+  return pin < BOARD_NUM_PINS ? pins[pin].analog : 0;
+}
+
+int digitalPinToInterrupt(pin_size_t pin) {
+  for (pin_size_t interrupt_pin : INTERRUPT_PINS) {
+    if (interrupt_pin == pin)
+      return pin;
+  }
+  return NOT_AN_INTERRUPT;
+}
+
+static void callWithoutParam(void *callback) {
+  reinterpret_cast<voidFuncPtr>(callback)();
+}
+
+void attachInterrupt(pin_size_t interrupt, voidFuncPtr callback, PinStatus mode) {
+  attachInterruptParam(interrupt, callWithoutParam, mode, reinterpret_cast<void *>(callback));
+}
+
+void attachInterruptParam(pin_size_t interrupt, voidFuncPtrParam callback, PinStatus mode, void *param) {
+  if (interrupt >= BOARD_NUM_PINS)
+    return;
+
+  pins[interrupt].isr = callback;
+  pins[interrupt].isr_param = param;
+  pins[interrupt].isr_mode = mode;
+  pins[interrupt].isr_pending = false;
+}
+
+void detachInterrupt(pin_size_t interrupt) {
+  if (interrupt >= BOARD_NUM_PINS)
+    return;
+
+  pins[interrupt].isr = nullptr;
+  pins[interrupt].isr_pending = false;
+}
+
+void noInterrupts() {
+  interrupts_enabled = false;
+}
+
+void interrupts() {
+  if (interrupts_enabled)
+    return;
+  interrupts_enabled = true;
+
+  if (in_interrupt || dispatching)
+    return;
+
+  raisePendingInterrupts();
+  dispatch(clock_micros);
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection Print and Serial
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    if (!this->write(*buffer++))
+      break;
+    n++;
+  }
+  return n;
+}
+
+size_t Print::print(const char *str) {
+  return this->write(str);
+}
+
+size_t Print::print(char value) {
+  return this->write(uint8_t(value));
+}
+
+size_t Print::print(unsigned char value, int base) {
+  return this->print((unsigned long)value, base);
+}
+
+size_t Print::print(int value, int base) {
+  return this->print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+  return this->print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base) {
+  return this->print((long long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  return this->printNumber(value, base);
+}
+
+size_t Print::print(long long value, int base) {
+  if (base == DEC && value < 0) {
+    size_t n = this->print('-');
+    return n + this->printNumber((unsigned long long)(-(value + 1)) + 1, base);
+  }
+  return this->printNumber((unsigned long long)value, base);
+}
+
+size_t Print::print(unsigned long long value, int base) {
+  return this->printNumber(value, base);
+}
+
+size_t Print::print(double value, int digits) {
+  if (isnan(value))
+    return this->print("nan");
+  if (isinf(value))
+    return this->print("inf");
+
+  char buffer[48];
+  int length = snprintf(buffer, sizeof(buffer), "%.*f", constrain(digits, 0, 16), value);
+  return this->write(reinterpret_cast<const uint8_t *>(buffer), size_t(constrain(length, 0, int(sizeof(buffer) - 1))));
+}
+
+size_t Print::println() {
+  return this->write("\r\n");
+}
+
+size_t Print::printNumber(unsigned long long value, int base) {
+  char buffer[8 * sizeof(value) + 1];
+  char *str = &buffer[sizeof(buffer) - 1];
+  *str = '\0';
+
+  if (base < 2)
+    base = 10;
+
+  do {
+    char digit = value % base;
+    value /= base;
+    *--str = digit < 10 ? digit + '0' : digit + 'A' - 10;
+  } while (value);
+
+  return this->write(str);
+}
+
+void HardwareSerial::begin(unsigned long /* baud */) {}
+
+void HardwareSerial::end() {}
+
+HardwareSerial::operator bool() {
+  return true;
+}
+
+size_t HardwareSerial::write(uint8_t value) {
+  return this->write(&value, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  Board::advance(size * BOARD_SERIAL_BYTE_COST);
+  if (serial_output)
+    fwrite(buffer, 1, size, serial_output);
+  return size;
+}
+
+int HardwareSerial::availableForWrite() {
+  return 256;
+}
+
+int HardwareSerial::available() {
+  return 0;
+}
+
+int HardwareSerial::read() {
+  return -1;
+}
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection PwmOut
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+PwmOut::PwmOut(int pin)
+  : pin(pin), period(0) {}
+
+PwmOut::~PwmOut() {}
+
+bool PwmOut::begin(float freq_hz, float duty_perc) {
+  if (freq_hz <= 0)
+    return false;
+
+  this->period = 1000000.0f / freq_hz;
+  Board::setPwm(this->pin, true, duty_perc, uint32_t(this->period * duty_perc / 100.0f));
+  return true;
+}
+
+bool PwmOut::begin(uint32_t period_usec, uint32_t pulse_usec, bool raw, int /* sd */) {
+  if (!period_usec)
+    return false;
+
+  float scale = raw ? 1.0f / PWM_CLOCK_MHZ : 1.0f;
+  this->period = period_usec * scale;
+  Board::setPwm(this->pin, true, 100.0f * pulse_usec / period_usec, uint32_t(pulse_usec * scale));
+  return true;
+}
+
+void PwmOut::end() {
+  Board::setPwm(this->pin, false, 0, 0);
+}
+
+bool PwmOut::pulse_perc(float duty_perc) {
+  duty_perc = constrain(duty_perc, 0.0f, 100.0f);
+  Board::setPwm(this->pin, true, duty_perc, uint32_t(this->period * duty_perc / 100.0f));
+  return true;
+}
+
+bool PwmOut::pulseWidth_us(uint32_t pulse_usec) {
+  pulse_usec = min(pulse_usec, uint32_t(this->period));
+  Board::setPwm(this->pin, true, 100.0f * pulse_usec / this->period, pulse_usec);
+  return true;
+}
+
+bool PwmOut::pulseWidth_raw(uint32_t pulse_counts) {
+  float pulse_usec = fminf(float(pulse_counts) / PWM_CLOCK_MHZ, this->period);
+  Board::setPwm(this->pin, true, 100.0f * pulse_usec / this->period, uint32_t(pulse_usec));
+  return true;
+}
+
+bool PwmOut::period_us(uint32_t period_usec) {
+  if (!period_usec)
+    return false;
+
+  this->period = period_usec;
+  return true;
+}
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection FspTimer
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+static uint8_t used_timers;
+
+FspTimer::FspTimer()
+  : callback(nullptr), context(nullptr), period(0), next_micros(0), running(false) {}
+
+FspTimer::~FspTimer() {}
+
+/**
+ * @brief Reserves one of the free GPT channels.
+ *
+ * The PWM signals of the sketch are generated without timers on the host, so every channel
+ * that is not used by another FspTimer is free.
+ */
+int8_t FspTimer::get_available_timer(uint8_t &type, bool /* force */) {
+  if (used_timers >= 8)
+    return -1;
+
+  type = GPT_TIMER;
+  return used_timers++;
+}
+
+static void onTimerEvent(void *timer) {
+  static_cast<FspTimer *>(timer)->tick();
+}
+
+bool FspTimer::begin(timer_mode_t mode, uint8_t /* type */, uint8_t /* channel */, float freq_hz, float /* duty_perc */,
+                     GPTimerCbk_f callback, void *context) {
+  if (mode != TIMER_MODE_PERIODIC || freq_hz <= 0)
+    return false;
+
+  this->callback = callback;
+  this->context = context;
+  this->period = max(uint32_t(1000000.0f / freq_hz + 0.5f), uint32_t(1));
+  return true;
+}
+
+bool FspTimer::setup_overflow_irq(uint8_t /* priority */, GPTimerCbk_f isr) {
+  if (isr)
+    this->callback = isr;
+  return this->callback != nullptr;
+}
+
+bool FspTimer::open() {
+  return this->period != 0;
+}
+
+bool FspTimer::start() {
+  if (this->running)
+    return true;
+
+  this->running = true;
+  this->next_micros = Board::now() + this->period;
+  Board::schedule(this->next_micros, onTimerEvent, this, true);
+  return true;
+}
+
+bool FspTimer::stop() {
+  this->running = false;
+  return true;
+}
+
+void FspTimer::end() {
+  this->running = false;
+  this->callback = nullptr;
+}
+
+/**
+ * @brief Raises the callback of the timer and schedules the next period.
+ *
+ * An overflow that is raised late, because interrupts were disabled, does not shift the
+ * following periods.
+ */
+void FspTimer::tick() {
+  if (!this->running || Board::now() < this->next_micros)
+    return;
+
+  timer_callback_args_t args = { TIMER_EVENT_CYCLE_END, this->context };
+  if (this->callback)
+    this->callback(&args);
+
+  this->next_micros += this->period;
+  Board::schedule(this->next_micros, onTimerEvent, this, true);
+}
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection Wire
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+TwoWire::TwoWire()
+  : address(0), tx_length(0), rx_length(0), rx_index(0), frequency(100000) {}
+
+/**
+ * @brief Advances the clock by the time the given amount of bytes takes on the bus.
+ *
+ * @param frequency The clock of the bus in Hz.
+ * @param bytes The amount of bytes, including the address.
+ */
+static void chargeBus(uint32_t frequency, size_t bytes) {
+  Board::advance(uint32_t(bytes * 9 * 1000000ULL / frequency));
+}
+
+void TwoWire::begin() {}
+
+void TwoWire::end() {}
+
+void TwoWire::setClock(uint32_t frequency) {
+  if (frequency)
+    this->frequency = frequency;
+}
+
+uint32_t TwoWire::getClock() {
+  return this->frequency;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  this->address = address;
+  this->tx_length = 0;
+}
+
+uint8_t TwoWire::endTransmission(bool /* stop_bit */) {
+  I2cDevice *device = Board::findI2c(this->address);
+  chargeBus(this->frequency, device ? this->tx_length + 1 : 1);
+
+  if (!device)
+    return 2;
+  return device->receive(this->tx_buffer, this->tx_length) ? 0 : 3;
+}
+
+size_t TwoWire::requestFrom(uint8_t address, size_t quantity, bool /* stop_bit */) {
+  this->rx_index = 0;
+  this->rx_length = 0;
+
+  I2cDevice *device = Board::findI2c(address);
+  if (!device) {
+    chargeBus(this->frequency, 1);
+    return 0;
+  }
+
+  this->rx_length = device->transmit(this->rx_buffer, min(quantity, size_t(WIRE_BUFFER_SIZE)));
+  chargeBus(this->frequency, this->rx_length + 1);
+  return this->rx_length;
+}
+
+size_t TwoWire::write(uint8_t value) {
+  if (this->tx_length >= WIRE_BUFFER_SIZE)
+    return 0;
+
+  this->tx_buffer[this->tx_length++] = value;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (n < size && this->write(buffer[n])) n++;
+  return n;
+}
+
+int TwoWire::available() {
+  return this->rx_length - this->rx_index;
+}
+
+int TwoWire::read() {
+  return this->rx_index < this->rx_length ? this->rx_buffer[this->rx_index++] : -1;
+}
+
+int TwoWire::peek() {
+  return this->rx_index < this->rx_length ? this->rx_buffer[this->rx_index] : -1;
+}
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection EEPROM
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+uint8_t EEPROMClass::read(int address) {
+  return (address >= 0 && address < EEPROM_SIZE) ? this->memory[address] : 0xFF;
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  if (address >= 0 && address < EEPROM_SIZE)
+    this->memory[address] = value;
+}
+
+void EEPROMClass::update(int address, uint8_t value) {
+  if (this->read(address) != value)
+    this->write(address, value);
+}
+
+uint16_t EEPROMClass::length() {
+  return EEPROM_SIZE;
+}
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection LiquidCrystal_I2C
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t /* address */, uint8_t columns, uint8_t rows)
+  : columns(min(columns, uint8_t(LCD_MAX_COLUMNS))), rows(min(rows, uint8_t(LCD_MAX_ROWS))), column(0), row(0) {
+  instance = this;
+  this->clear();
+}
+
+void LiquidCrystal_I2C::init() {
+  this->clear();
+}
+
+void LiquidCrystal_I2C::begin(uint8_t /* columns */, uint8_t /* rows */) {
+  this->clear();
+}
+
+void LiquidCrystal_I2C::clear() {
+  for (uint8_t y = 0; y < LCD_MAX_ROWS; y++) {
+    memset(this->text[y], ' ', LCD_MAX_COLUMNS);
+    this->text[y][this->columns] = '\0';
+  }
+  this->column = 0;
+  this->row = 0;
+}
+
+void LiquidCrystal_I2C::home() {
+  this->setCursor(0, 0);
+}
+
+void LiquidCrystal_I2C::backlight() {}
+
+void LiquidCrystal_I2C::noBacklight() {}
+
+void LiquidCrystal_I2C::setCursor(uint8_t column, uint8_t row) {
+  chargeBus(Wire.getClock(), BOARD_LCD_BYTES_PER_CHAR);
+  this->column = column;
+  this->row = min(row, uint8_t(this->rows - 1));
+}
+
+size_t LiquidCrystal_I2C::write(uint8_t value) {
+  chargeBus(Wire.getClock(), BOARD_LCD_BYTES_PER_CHAR);
+  if (this->column < this->columns)
+    this->text[this->row][this->column] = (value >= 0x20 && value < 0x7F) ? value : '?';
+  this->column++;
+  return 1;
+}
+
+/**
+ * @brief Reads the characters shown in a row of the display.
+ *
+ * @param row The row to read.
+ * @return The characters of the row.
+ */
+const char *LiquidCrystal_I2C::readRow(uint8_t row) {
+  return this->text[min(row, uint8_t(this->rows - 1))];
+}
+
+
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+/// @subsection Pixy2
+///ââââââââââââââââââââââââââââââââââââââââââââââââââ
+
+int8_t Link2::open(uint32_t /* arg */) {
+  return PIXY_RESULT_OK;
+}
+
+void Link2::close() {}
+
+CCC2::CCC2()
+  : blocks(frame), numBlocks(0) {}
+
+int8_t CCC2::getBlocks(bool wait, uint8_t sigmap, uint8_t max_blocks) {
+  Board::advance(BOARD_SPI_TRANSFER_COST);
+
+  CameraDevice *device = Board::findCamera();
+  if (!device || !device->isBooted())
+    return PIXY_RESULT_ERROR;
+
+  uint8_t num_blocks = 0;
+  while (!device->readFrame(this->frame, num_blocks, min(max_blocks, uint8_t(CCC_MAX_BLOCKS)))) {
+    if (!wait)
+      return PIXY_RESULT_BUSY;
+    Board::advance(1000);
+  }
+
+  // Only the blocks of the requested signatures are returned.
+  this->numBlocks = 0;
+  for (uint8_t i = 0; i < num_blocks; i++) {
+    if (this->frame[i].m_signature <= 7 && !(sigmap & (1 << (this->frame[i].m_signature - 1))))
+      continue;
+    this->frame[this->numBlocks++] = this->frame[i];
+  }
+  Board::advance(this->numBlocks * BOARD_SPI_TRANSFER_COST / 4);
+
+  return this->numBlocks;
+}
+
+int8_t Pixy2::init(uint32_t arg) {
+  this->m_link.open(arg);
+  return this->getVersion();
+}
+
+int8_t Pixy2::getVersion() {
+  Board::advance(BOARD_SPI_TRANSFER_COST);
+
+  CameraDevice *device = Board::findCamera();
+  return (device && device->isBooted()) ? PIXY_RESULT_OK : PIXY_RESULT_ERROR;
+}
+
+int8_t Pixy2::getResolution() {
+  Board::advance(BOARD_SPI_TRANSFER_COST);
+  this->frameWidth = 316;
+  this->frameHeight = 208;
+  return PIXY_RESULT_OK;
+}
+
+int8_t Pixy2::setLED(uint8_t /* r */, uint8_t /* g */, uint8_t /* b */) {
+  Board::advance(BOARD_SPI_TRANSFER_COST);
+  return PIXY_RESULT_OK;
+}
+
+int8_t Pixy2::setLamp(uint8_t /* upper */, uint8_t /* lower */) {
+  Board::advance(BOARD_SPI_TRANSFER_COST);
+  return PIXY_RESULT_OK;
+}
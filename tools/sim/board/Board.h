@@ -0,0 +1,102 @@
+/**
+ * @file Board.h
+ * @brief Header file for the Board, the simulated Uno R4 the sketch runs on.
+ *
+ * The Board holds the simulated clock and connects the Arduino core of the host to the devices
+ * of the simulated world. Time only passes when the Board is told so: the calls into the core
+ * and the buses cost a fixed amount of microseconds each, delays skip ahead, and the simulator
+ * charges every pass of the main loop. Whenever the clock advances, the events that fall due in
+ * between are raised in the order of their time, with the clock set to the time of each event:
+ * pin changes of the inputs, the periodic timers and the steps of the world. Events that are
+ * raised in interrupt context are held back while interrupts are disabled and raised as soon as
+ * they are enabled again, like pending interrupts.
+ *
+ * Devices attach to the pins, the I2C addresses and the camera port. The outputs of the sketch,
+ * such as the duty cycles of the motor and the pulses of the servo, are read back by pin.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdio.h>
+#include "Arduino.h"
+#include "Pixy2_Renesas.h"
+
+#define BOARD_NUM_PINS 22
+#define BOARD_CORE_CLOCK 48000000
+#define BOARD_MAX_EVENTS 64
+#define BOARD_MAX_I2C_DEVICES 4
+
+// Costs of the calls into the core in microseconds, rough estimates for the Uno R4. The bytes
+// on the I2C bus take the time of nine bits at the clock of the bus.
+#define BOARD_CLOCK_COST 1
+#define BOARD_PIN_COST 1
+#define BOARD_ANALOG_COST 20
+#define BOARD_SERIAL_BYTE_COST 1
+#define BOARD_LCD_BYTES_PER_CHAR 12
+#define BOARD_SPI_TRANSFER_COST 60
+
+typedef void (*BoardEvent)(void *context);
+
+/**
+ * @class PinDevice
+ * @brief Interface of a device that watches an output pin of the sketch.
+ */
+class PinDevice {
+public:
+  virtual ~PinDevice() {}
+  virtual void onWrite(pin_size_t pin, PinStatus value) = 0;
+};
+
+/**
+ * @class I2cDevice
+ * @brief Interface of a device on the I2C bus.
+ */
+class I2cDevice {
+public:
+  virtual ~I2cDevice() {}
+  virtual bool receive(const uint8_t *data, size_t length) = 0;
+  virtual size_t transmit(uint8_t *data, size_t length) = 0;
+};
+
+/**
+ * @class CameraDevice
+ * @brief Interface of the camera behind the Pixy2 library.
+ */
+class CameraDevice {
+public:
+  virtual ~CameraDevice() {}
+  virtual bool isBooted() = 0;
+  virtual bool readFrame(Block *blocks, uint8_t &num_blocks, uint8_t max_blocks) = 0;
+};
+
+namespace Board {
+  void reset();
+
+  uint64_t now();
+  void advance(uint32_t us);
+  void schedule(uint64_t time, BoardEvent event, void *context, bool in_interrupt);
+  bool isInInterrupt();
+
+  void setInput(pin_size_t pin, PinStatus value);
+  void setAnalog(pin_size_t pin, int value);
+  PinStatus readOutput(pin_size_t pin);
+  void attachPin(pin_size_t pin, PinDevice *device);
+  float readDuty(pin_size_t pin);
+  uint32_t readPulseWidth(pin_size_t pin);
+  bool isPwmRunning(pin_size_t pin);
+  void setPwm(pin_size_t pin, bool running, float duty, uint32_t pulse_width);
+
+  void attachI2c(uint8_t address, I2cDevice *device);
+  I2cDevice *findI2c(uint8_t address);
+  void attachCamera(CameraDevice *device);
+  CameraDevice *findCamera();
+
+  void setSerialOutput(FILE *file);
+}
+
+#endif  // BOARD_H
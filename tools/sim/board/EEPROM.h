@@ -0,0 +1,46 @@
+/**
+ * @file EEPROM.h
+ * @brief Host implementation of the EEPROM library for the simulator.
+ *
+ * The emulated EEPROM of the Uno R4 is held in memory, erased to 0xFF at the start of a run,
+ * and can be loaded from and saved to a file by the simulator across runs.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include "Arduino.h"
+
+#define EEPROM_SIZE 8192
+
+class EEPROMClass {
+public:
+  uint8_t read(int address);
+  void write(int address, uint8_t value);
+  void update(int address, uint8_t value);
+  uint16_t length();
+
+  template<typename T>
+  T &get(int address, T &value) {
+    uint8_t *data = reinterpret_cast<uint8_t *>(&value);
+    for (size_t i = 0; i < sizeof(T); i++) data[i] = this->read(address + i);
+    return value;
+  }
+
+  template<typename T>
+  const T &put(int address, const T &value) {
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(&value);
+    for (size_t i = 0; i < sizeof(T); i++) this->update(address + i, data[i]);
+    return value;
+  }
+
+  uint8_t memory[EEPROM_SIZE];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif  // EEPROM_H
@@ -0,0 +1,63 @@
+/**
+ * @file FspTimer.h
+ * @brief Host implementation of the FspTimer class of the Uno R4 core for the simulator.
+ *
+ * A started periodic timer raises its callback from the simulated clock of the Board at its
+ * rate, in interrupt context, so the callback is held back while interrupts are disabled.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef FSPTIMER_H
+#define FSPTIMER_H
+
+#include "Arduino.h"
+
+#define GPT_TIMER 0
+#define AGT_TIMER 1
+
+enum timer_mode_t {
+  TIMER_MODE_PERIODIC,
+  TIMER_MODE_ONE_SHOT,
+  TIMER_MODE_PWM
+};
+
+enum timer_event_t {
+  TIMER_EVENT_CYCLE_END
+};
+
+struct timer_callback_args_t {
+  timer_event_t event;
+  void const *p_context;
+};
+
+typedef void (*GPTimerCbk_f)(timer_callback_args_t *);
+
+class FspTimer {
+public:
+  FspTimer();
+  ~FspTimer();
+
+  static int8_t get_available_timer(uint8_t &type, bool force = false);
+
+  bool begin(timer_mode_t mode, uint8_t type, uint8_t channel, float freq_hz, float duty_perc,
+             GPTimerCbk_f callback = nullptr, void *context = nullptr);
+  bool setup_overflow_irq(uint8_t priority = 12, GPTimerCbk_f isr = nullptr);
+  bool open();
+  bool start();
+  bool stop();
+  void end();
+
+  void tick();
+
+private:
+  GPTimerCbk_f callback;
+  void *context;
+  uint32_t period;
+  uint64_t next_micros;
+  bool running;
+};
+
+#endif  // FSPTIMER_H
@@ -0,0 +1,48 @@
+/**
+ * @file LiquidCrystal_I2C.h
+ * @brief Host implementation of the LiquidCrystal_I2C library for the simulator.
+ *
+ * The characters are kept in a buffer of the size of the display, which the simulator prints
+ * at the end of a run. Every command advances the simulated clock by the time it takes on the
+ * I2C bus of the real display.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef LIQUIDCRYSTAL_I2C_H
+#define LIQUIDCRYSTAL_I2C_H
+
+#include "Arduino.h"
+
+#define LCD_MAX_COLUMNS 20
+#define LCD_MAX_ROWS 4
+
+class LiquidCrystal_I2C : public Print {
+public:
+  LiquidCrystal_I2C(uint8_t address, uint8_t columns, uint8_t rows);
+
+  void init();
+  void begin(uint8_t columns, uint8_t rows);
+  void clear();
+  void home();
+  void backlight();
+  void noBacklight();
+  void setCursor(uint8_t column, uint8_t row);
+  size_t write(uint8_t value) override;
+  using Print::write;
+
+  const char *readRow(uint8_t row);
+
+  static LiquidCrystal_I2C *instance;
+
+private:
+  uint8_t columns;
+  uint8_t rows;
+  uint8_t column;
+  uint8_t row;
+  char text[LCD_MAX_ROWS][LCD_MAX_COLUMNS + 1];
+};
+
+#endif  // LIQUIDCRYSTAL_I2C_H
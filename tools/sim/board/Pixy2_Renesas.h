@@ -0,0 +1,73 @@
+/**
+ * @file Pixy2_Renesas.h
+ * @brief Host implementation of the Pixy2 library for the simulator.
+ *
+ * Only the colour connected components are implemented. The blocks of each frame are taken
+ * from the camera device that is attached to the Board, which renders them from the simulated
+ * world or from a recorded log at the frame rate of the Pixy2.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef PIXY2_RENESAS_H
+#define PIXY2_RENESAS_H
+
+#include "Arduino.h"
+
+#define PIXY_RESULT_OK 0
+#define PIXY_RESULT_ERROR -1
+#define PIXY_RESULT_BUSY -2
+#define PIXY_RESULT_CHECKSUM_ERROR -3
+#define PIXY_RESULT_TIMEOUT -4
+
+#define PIXY_DEFAULT_ARGVAL 0x80000000
+#define CCC_SIG_ALL 0xff
+#define CCC_MAX_BLOCKS 16
+
+struct Block {
+  uint16_t m_signature;
+  uint16_t m_x;
+  uint16_t m_y;
+  uint16_t m_width;
+  uint16_t m_height;
+  int16_t m_angle;
+  uint8_t m_index;
+  uint8_t m_age;
+};
+
+class Link2 {
+public:
+  int8_t open(uint32_t arg);
+  void close();
+};
+
+class CCC2 {
+public:
+  CCC2();
+
+  int8_t getBlocks(bool wait = true, uint8_t sigmap = CCC_SIG_ALL, uint8_t max_blocks = 0xff);
+
+  Block *blocks;
+  int8_t numBlocks;
+
+private:
+  Block frame[CCC_MAX_BLOCKS];
+};
+
+class Pixy2 {
+public:
+  int8_t init(uint32_t arg = PIXY_DEFAULT_ARGVAL);
+  int8_t getVersion();
+  int8_t getResolution();
+  int8_t setLED(uint8_t r, uint8_t g, uint8_t b);
+  int8_t setLamp(uint8_t upper, uint8_t lower);
+
+  CCC2 ccc;
+  Link2 m_link;
+  uint16_t frameWidth;
+  uint16_t frameHeight;
+};
+
+#endif  // PIXY2_RENESAS_H
@@ -0,0 +1,52 @@
+/**
+ * @file Wire.h
+ * @brief Host implementation of the Wire library for the simulator.
+ *
+ * Transactions are routed to the device that is attached to their address on the Board, and
+ * the simulated clock advances by the time the bytes take on a bus at 400 kHz. A transaction
+ * to an address without a device is not acknowledged.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef WIRE_H
+#define WIRE_H
+
+#include "Arduino.h"
+
+#define WIRE_BUFFER_SIZE 256
+
+class TwoWire : public Stream {
+public:
+  TwoWire();
+
+  void begin();
+  void end();
+  void setClock(uint32_t frequency);
+  uint32_t getClock();
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool stop_bit = true);
+  size_t requestFrom(uint8_t address, size_t quantity, bool stop_bit = true);
+
+  size_t write(uint8_t value) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  int available() override;
+  int read() override;
+  int peek() override;
+  using Print::write;
+
+private:
+  uint8_t address;
+  uint8_t tx_buffer[WIRE_BUFFER_SIZE];
+  size_t tx_length;
+  uint8_t rx_buffer[WIRE_BUFFER_SIZE];
+  size_t rx_length;
+  size_t rx_index;
+  uint32_t frequency;
+};
+
+extern TwoWire Wire;
+
+#endif  // WIRE_H
@@ -0,0 +1,2 @@
+// Part of the Arduino core API, declared by Arduino.h on the host.
+#include "../Arduino.h"
@@ -0,0 +1 @@
+// Exception numbers of the RA4M1, not needed by the host build.
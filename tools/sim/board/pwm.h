@@ -0,0 +1,39 @@
+/**
+ * @file pwm.h
+ * @brief Host implementation of the PwmOut class of the Uno R4 core for the simulator.
+ *
+ * A PwmOut object publishes its duty cycle and pulse width on its pin of the Board, where the
+ * motor and the steering servo of the simulated world pick them up. Raw periods and pulse
+ * widths are given in counts of the GPT clock, at PWM_CLOCK_MHZ.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#ifndef PWM_H
+#define PWM_H
+
+#include "Arduino.h"
+
+#define PWM_CLOCK_MHZ 48
+
+class PwmOut {
+public:
+  PwmOut(int pin);
+  ~PwmOut();
+
+  bool begin(float freq_hz, float duty_perc);
+  bool begin(uint32_t period_usec, uint32_t pulse_usec, bool raw = false, int sd = 0);
+  void end();
+  bool pulse_perc(float duty_perc);
+  bool pulseWidth_us(uint32_t pulse_usec);
+  bool pulseWidth_raw(uint32_t pulse_counts);
+  bool period_us(uint32_t period_usec);
+
+private:
+  pin_size_t pin;
+  float period;  // Period in microseconds.
+};
+
+#endif  // PWM_H
@@ -0,0 +1,2 @@
+// Fixed width integer types of newlib, provided by <stdint.h> on the host.
+#include <stdint.h>
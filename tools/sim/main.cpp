@@ -0,0 +1,219 @@
+/**
+ * @file main.cpp
+ * @brief Runs the sketch on the simulated board against the world model or a recorded log.
+ *
+ * Calls setup() once and loop() until the robot has stopped, has crashed, the log has been
+ * replayed or the simulated time is up, and prints the score of the run as one line of
+ * key=value pairs, followed by the text shown on the display. Every pass of the main loop
+ * costs SIM_LOOP_MICROS on top of the calls it makes into the core.
+ *
+ * Usage:
+ *     sim [--duration 180] [--clockwise] [--corridor 100] [--pillars 1] [--seed 1] [--noise]
+ *         [--voltage 80] [--replay log.csv] [--telemetry raw.bin] [--trace trace.csv]
+ *         [--eeprom eeprom.bin]
+ *
+ * The telemetry stream written by the sketch is stored with --telemetry, so it can be decoded
+ * by tools/telemetry.py like a recording of the real robot. The trace holds the pose of the
+ * robot and the outputs to its actuators every 10 ms. The EEPROM is loaded from and saved to
+ * the file given with --eeprom, so a stored calibration and track map carry over between runs.
+ *
+ * @author Maximilian Kautzsch
+ * @copyright Copyright (c) 2024 Maximilian Kautzsch
+ * Licensed under MIT License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "Board.h"
+#include "EEPROM.h"
+#include "LiquidCrystal_I2C.h"
+#include "World.h"
+#include "Config.h"
+
+#define SIM_LOOP_MICROS 10
+#define SIM_TRACE_MICROS 10000
+
+// Defined by the sketch.
+void setup();
+void loop();
+
+/**
+ * @struct Options
+ * @brief Struct to hold the options of a run.
+ */
+struct Options {
+  float duration;
+  const char *replay;
+  const char *telemetry;
+  const char *trace;
+  const char *eeprom;
+};
+
+/**
+ * @brief Prints the usage and exits.
+ *
+ * @param program The name of the program.
+ */
+static void usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s [--duration S] [--clockwise] [--corridor CM] [--pillars N] [--seed N] [--noise]\n"
+          "       [--voltage V] [--replay LOG.csv] [--telemetry RAW.bin] [--trace TRACE.csv] [--eeprom FILE]\n",
+          program);
+  exit(2);
+}
+
+/**
+ * @brief Converts the pulse width of the servo into the commanded angle.
+ *
+ * @return The angle in degrees, 0 before the first pulse.
+ */
+static float readCommandedAngle() {
+  uint32_t pulse_width = Board::readPulseWidth(Pins::SERVO_PIN);
+  return pulse_width ? (pulse_width - 544.0f) * 180.0f / (2400.0f - 544.0f) : 0;
+}
+
+int main(int argc, char **argv) {
+  Options options = { 180, nullptr, nullptr, nullptr, nullptr };
+  WorldOptions world_options = { false, 100, 1, 1, false, 80, nullptr };
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (!strcmp(arg, "--clockwise")) {
+      world_options.clockwise = true;
+    } else if (!strcmp(arg, "--noise")) {
+      world_options.noise = true;
+    } else if (!strcmp(arg, "--duration") && has_value) {
+      options.duration = atof(argv[++i]);
+    } else if (!strcmp(arg, "--corridor") && has_value) {
+      world_options.corridor = atof(argv[++i]);
+    } else if (!strcmp(arg, "--pillars") && has_value) {
+      world_options.pillars = atoi(argv[++i]);
+    } else if (!strcmp(arg, "--seed") && has_value) {
+      world_options.seed = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(arg, "--voltage") && has_value) {
+      int voltage = atoi(argv[++i]);  // constrain() evaluates its argument more than once.
+      world_options.voltage = constrain(voltage, 0, 100);
+    } else if (!strcmp(arg, "--replay") && has_value) {
+      options.replay = argv[++i];
+    } else if (!strcmp(arg, "--telemetry") && has_value) {
+      options.telemetry = argv[++i];
+    } else if (!strcmp(arg, "--trace") && has_value) {
+      options.trace = argv[++i];
+    } else if (!strcmp(arg, "--eeprom") && has_value) {
+      options.eeprom = argv[++i];
+    } else {
+      usage(argv[0]);
+    }
+  }
+
+  Board::reset();
+
+  Replay replay;
+  if (options.replay) {
+    if (!replay.open(options.replay)) {
+      fprintf(stderr, "sim: no state frames in %s\n", options.replay);
+      return 1;
+    }
+    world_options.replay = &replay;
+    options.duration = replay.getDuration() / 1000.0f + 1;
+  }
+
+  FILE *telemetry = options.telemetry ? fopen(options.telemetry, "wb") : nullptr;
+  FILE *trace = options.trace ? fopen(options.trace, "w") : nullptr;
+  Board::setSerialOutput(telemetry);
+
+  if (options.eeprom) {
+    FILE *file = fopen(options.eeprom, "rb");
+    if (file) {
+      size_t size = fread(EEPROM.memory, 1, sizeof(EEPROM.memory), file);
+      fclose(file);
+      if (size != sizeof(EEPROM.memory))
+        memset(EEPROM.memory, 0xFF, sizeof(EEPROM.memory));
+    }
+  }
+
+  if (trace) {
+    fprintf(trace, options.replay ? "time,logged_steering_angle,steering_angle,logged_speed,motor_duty\n"
+                                  : "time,x,y,heading,speed,steering_angle,motor_duty\n");
+  }
+
+  World world(world_options);
+  world.begin();
+
+  clock_t started = clock();
+  uint64_t end_micros = uint64_t(options.duration * 1000000.0f);
+  uint64_t next_trace = 0;
+  double steering_error = 0;
+  double speed_error = 0;
+  uint32_t compared_frames = 0;
+
+  setup();
+  while (!world.isFinished() && Board::now() < end_micros) {
+    loop();
+    Board::advance(SIM_LOOP_MICROS);
+
+    if (Board::now() < next_trace)
+      continue;
+    next_trace += SIM_TRACE_MICROS;
+
+    if (options.replay) {
+      const ReplayFrame *frame = replay.find(Board::now() / 1000);
+      if (!frame)
+        continue;
+
+      // Speeds are compared in the units of the motor, which equal the duty cycle in percent.
+      float steering_angle = readCommandedAngle();
+      float duty = world.readMotorDuty();
+      steering_error += fabsf(steering_angle - frame->steering_angle);
+      speed_error += fabsf(duty - frame->speed);
+      compared_frames++;
+      if (trace) {
+        fprintf(trace, "%.2f,%.2f,%.2f,%d,%.1f\n", Board::now() / 1000000.0, frame->steering_angle,
+                steering_angle, frame->speed, duty);
+      }
+    } else if (trace) {
+      Vec position = world.readPosition();
+      fprintf(trace, "%.2f,%.1f,%.1f,%.1f,%.1f,%.2f,%.1f\n", Board::now() / 1000000.0, position.x, position.y,
+              degrees(world.readHeading()), world.readSpeed(), world.readSteeringAngle(), world.readMotorDuty());
+    }
+  }
+
+  double real_time = double(clock() - started) / CLOCKS_PER_SEC;
+  double sim_time = Board::now() / 1000000.0;
+  const Score &score = world.getScore();
+
+  if (options.replay) {
+    printf("result=replayed time=%.2f frames=%u steering_error=%.2f speed_error=%.2f", sim_time,
+           compared_frames, compared_frames ? steering_error / compared_frames : 0.0,
+           compared_frames ? speed_error / compared_frames : 0.0);
+  } else {
+    const char *result = score.crashed ? "crashed" : score.stopped ? "stopped" : "timeout";
+    double race_time = score.start_micros ? (score.stop_micros - score.start_micros) / 1000000.0 : 0.0;
+    printf("result=%s time=%.2f laps=%.2f sections=%u wrong_side=%u pillar_hits=%u wall_contacts=%u "
+           "min_clearance=%.1f stop_offset=%.1f distance=%.0f",
+           result, race_time, score.laps, score.sections, score.wrong_side, score.pillar_hits,
+           score.wall_contacts, score.min_clearance, score.stop_offset, score.distance);
+  }
+  printf(" speedup=%.0f\n", real_time > 0 ? sim_time / real_time : 0.0);
+
+  if (LiquidCrystal_I2C::instance) {
+    printf("display=\"%s|%s\"\n", LiquidCrystal_I2C::instance->readRow(0), LiquidCrystal_I2C::instance->readRow(1));
+  }
+
+  if (options.eeprom) {
+    FILE *file = fopen(options.eeprom, "wb");
+    if (file) {
+      fwrite(EEPROM.memory, 1, sizeof(EEPROM.memory), file);
+      fclose(file);
+    }
+  }
+  if (telemetry)
+    fclose(telemetry);
+  if (trace)
+    fclose(trace);
+
+  return 0;
+}
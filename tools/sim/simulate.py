@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+"""Builds the sketch for the host simulator, runs it and sweeps its parameters.
+
+The sketch is compiled natively with g++ against the simulated board in tools/sim/board, which
+implements the Arduino core and the libraries the sketch uses, so the control code is built
+without any change. Like the Arduino builder, the prototypes of the functions of the sketch are
+generated in front of their first definition.
+
+Constants of the sketch can be overridden for a build with --set, and swept with --sweep, which
+runs every combination of the given values on every seed, in parallel. A constant is either an
+enumerator, such as STRAIGHT_SPEED in Config.h, or a macro of a header, such as RACE_PROFILE. Every combination is built
+once into its own directory below the build directory and reused by later runs. The results of
+a sweep are printed as CSV, one row per run.
+
+Options after -- are passed on to the simulator, see tools/sim/main.cpp.
+
+Usage:
+    python3 simulate.py [-- --pillars 2 --noise --telemetry raw.bin]
+    python3 simulate.py --set RACE_PROFILE=QUALIFYING -- --pillars 0
+    python3 simulate.py --sweep STRAIGHT_SPEED=70,75,80 --sweep MIN_DISTANCE=10,15 --seeds 50 > sweep.csv
+    python3 simulate.py -- --replay log.csv --trace replay.csv
+
+@author Maximilian Kautzsch
+@copyright Copyright (c) 2024 Maximilian Kautzsch
+Licensed under MIT License.
+"""
+
+import argparse
+import concurrent.futures
+import hashlib
+import itertools
+import os
+import re
+import shlex
+import shutil
+import subprocess
+import sys
+
+SIM_DIR = os.path.dirname(os.path.abspath(__file__))
+SKETCH_DIR = os.path.join(SIM_DIR, "..", "..", "src", "controller_v2.4")
+SKETCH = "controller_v2.4.ino"
+SIM_SOURCES = ["main.cpp", "World.cpp", "Replay.cpp", os.path.join("board", "Board.cpp")]
+
+CXX = os.environ.get("CXX", "g++")
+CXXFLAGS = [
+    "-std=gnu++17", "-O2", "-Wall", "-Wextra",
+    "-DARDUINO=10819", "-DARDUINO_ARCH_RENESAS", "-DARDUINO_UNOR4_MINIMA",
+]
+
+# Definitions of functions at the top level of the sketch, whose prototypes are generated.
+FUNCTION = re.compile(
+    r"^((?:template\s*<[^>]*>\s*)?(?:static\s+|inline\s+)*[A-Za-z_][\w:<>,\*&]*(?:\s+[\w:<>,\*&]+)*?"
+    r"\s+[\*&]?([A-Za-z_]\w*)\s*\([^;{}]*\))\s*\{",
+    re.M,
+)
+KEYWORDS = re.compile(r"^(struct|class|enum|union|namespace|if|else|switch|while|for|return)\b")
+
+
+def generate_sketch(source):
+    """Turns the sketch into C++ by declaring its functions in front of the first one."""
+    prototypes = []
+    first = None
+    for match in FUNCTION.finditer(source):
+        signature = match.group(1)
+        if KEYWORDS.match(signature):
+            continue
+        if first is None:
+            first = match.start()
+        # Default arguments stay with the definition, they may only be given once.
+        prototype = re.sub(r"\s*=\s*[^,)]+", "", signature) + ";"
+        if prototype not in prototypes:
+            prototypes.append(prototype)
+
+    if first is None:
+        return '#include "Arduino.h"\n#line 1 "{}"\n{}'.format(SKETCH, source)
+
+    line = source.count("\n", 0, first) + 1
+    return '#include "Arduino.h"\n#line 1 "{0}"\n{1}\n{2}\n#line {3} "{0}"\n{4}'.format(
+        SKETCH, source[:first], "\n".join(prototypes), line, source[first:]
+    )
+
+
+def apply_overrides(directory, overrides):
+    """Replaces the values of enumerators and macros in the headers of the sketch."""
+    for name, value in overrides:
+        patterns = [
+            (re.compile(r"^(\s*{}\s*=\s*)[^,\n/]+".format(name), re.M), r"\g<1>{}".format(value)),
+            (re.compile(r"^(#define\s+{}\s+)\S+".format(name), re.M), r"\g<1>{}".format(value)),
+        ]
+        found = False
+        for header in sorted(os.listdir(directory)):
+            if not header.endswith(".h"):
+                continue
+            path = os.path.join(directory, header)
+            with open(path, encoding="utf-8", newline="") as file:
+                text = file.read()
+            for pattern, replacement in patterns:
+                text, count = pattern.subn(replacement, text, count=1)
+                if count:
+                    found = True
+                    with open(path, "w", encoding="utf-8", newline="") as file:
+                        file.write(text)
+                    break
+            if found:
+                break
+        if not found:
+            sys.exit("simulate: no constant {} in the headers of the sketch".format(name))
+
+
+def build(overrides, build_root):
+    """Builds the simulator for a set of overrides and returns the path of the binary."""
+    key = hashlib.sha1(repr(sorted(overrides)).encode()).hexdigest()[:12]
+    directory = os.path.join(build_root, key)
+    sketch_dir = os.path.join(directory, "sketch")
+    binary = os.path.join(directory, "sim")
+
+    sources = [os.path.join(SKETCH_DIR, name) for name in os.listdir(SKETCH_DIR)]
+    sources += [os.path.join(SIM_DIR, name) for name in SIM_SOURCES]
+    sources += [os.path.join(SIM_DIR, "board", name) for name in os.listdir(os.path.join(SIM_DIR, "board"))
+                if os.path.isfile(os.path.join(SIM_DIR, "board", name))]
+    sources += [os.path.abspath(__file__)]
+    newest = max(os.path.getmtime(path) for path in sources if os.path.isfile(path))
+    if os.path.isfile(binary) and os.path.getmtime(binary) >= newest:
+        return binary
+
+    shutil.rmtree(sketch_dir, ignore_errors=True)
+    os.makedirs(sketch_dir)
+    for name in os.listdir(SKETCH_DIR):
+        if name.endswith((".h", ".cpp")):
+            shutil.copy(os.path.join(SKETCH_DIR, name), sketch_dir)
+    apply_overrides(sketch_dir, overrides)
+
+    with open(os.path.join(SKETCH_DIR, SKETCH), encoding="utf-8") as file:
+        sketch = generate_sketch(file.read())
+    with open(os.path.join(sketch_dir, "sketch.cpp"), "w", encoding="utf-8") as file:
+        file.write(sketch)
+
+    units = [os.path.join(sketch_dir, name) for name in sorted(os.listdir(sketch_dir)) if name.endswith(".cpp")]
+    units += [os.path.join(SIM_DIR, name) for name in SIM_SOURCES]
+    includes = ["-I" + os.path.join(SIM_DIR, "board"), "-I" + sketch_dir, "-I" + SIM_DIR]
+
+    def compile_unit(unit):
+        name = os.path.relpath(unit, SIM_DIR) if unit.startswith(SIM_DIR + os.sep) else os.path.basename(unit)
+        obj = os.path.join(directory, name.replace(os.sep, "_") + ".o")
+        result = subprocess.run([CXX] + CXXFLAGS + includes + ["-c", unit, "-o", obj],
+                                stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+        if result.returncode:
+            sys.exit("simulate: failed to compile {}\n{}".format(unit, result.stdout))
+        if result.stdout:
+            sys.stderr.write(result.stdout)
+        return obj
+
+    with concurrent.futures.ThreadPoolExecutor(max_workers=os.cpu_count()) as pool:
+        objects = list(pool.map(compile_unit, units))
+
+    result = subprocess.run([CXX] + objects + ["-o", binary], stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if result.returncode:
+        sys.exit("simulate: failed to link\n{}".format(result.stdout))
+    return binary
+
+
+def run(binary, arguments):
+    """Runs the simulator and parses the key=value pairs of its score."""
+    result = subprocess.run([binary] + arguments, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+    if result.returncode:
+        raise RuntimeError("simulator failed: {}".format(result.stderr.strip()))
+    score = {}
+    for token in shlex.split(result.stdout):
+        key, _, value = token.partition("=")
+        score[key] = value
+    return score
+
+
+def parse_assignment(text):
+    name, separator, value = text.partition("=")
+    if not separator or not name:
+        raise argparse.ArgumentTypeError("expected NAME=VALUE, got {}".format(text))
+    return name, value
+
+
+def main():
+    argv = sys.argv[1:]
+    passed = []
+    if "--" in argv:
+        passed = argv[argv.index("--") + 1:]
+        argv = argv[:argv.index("--")]
+
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--set", type=parse_assignment, action="append", default=[],
+                        help="override a constant of the sketch, NAME=VALUE")
+    parser.add_argument("--sweep", type=parse_assignment, action="append", default=[],
+                        help="sweep a constant of the sketch, NAME=V1,V2,...")
+    parser.add_argument("--seeds", type=int, default=1, help="amount of seeds to run every combination on")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count(), help="amount of runs in parallel")
+    parser.add_argument("--build-dir", default=os.path.join(SIM_DIR, "build"), help="directory of the builds")
+    args = parser.parse_args(argv)
+
+    if "--seed" in passed and (args.sweep or args.seeds > 1):
+        sys.exit("simulate: the seeds of a sweep are set by --seeds")
+
+    names = [name for name, _ in args.sweep]
+    combinations = list(itertools.product(*[values.split(",") for _, values in args.sweep]))
+
+    if not args.sweep and args.seeds == 1:
+        binary = build(args.set, args.build_dir)
+        sys.exit(subprocess.call([binary] + passed))
+
+    binaries = {}
+    for combination in combinations:
+        binaries[combination] = build(args.set + list(zip(names, combination)), args.build_dir)
+
+    runs = [(combination, seed) for combination in combinations for seed in range(1, args.seeds + 1)]
+    with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = [pool.submit(run, binaries[combination], passed + ["--seed", str(seed)]) for combination, seed in runs]
+
+        header = None
+        for (combination, seed), future in zip(runs, futures):
+            score = future.result()
+            fields = [key for key in score if key not in ("display", "speedup")]
+            if header is None:
+                header = fields
+                print(",".join(names + ["seed"] + header))
+            print(",".join(list(combination) + [str(seed)] + [score.get(key, "") for key in header]))
+            sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
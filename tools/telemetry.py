@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+"""Decoder for the binary telemetry stream of the controller.
+
+Reads frames from a serial port or a recorded file and prints them as CSV. Each frame is laid
+out as documented in src/controller_v2.4/Telemetry.h:
+
+    | 0xA5 0x5A | type | length | sequence (u16) | payload | CRC-16/CCITT-FALSE (u16) |
+
+Bytes outside of valid frames, such as the text of a profiler dump, are passed to stderr, so
+both can share the same serial port. Gaps in the sequence numbers are reported as lost frames,
+and the time the robot took for every section of the track is reported at the end, as well as the
+mean and maximum of every stage of the latency traces of the control cycles. The serial port is
+opened at the SERIAL_BAUD_RATE of Config.h unless --baud is given.
+
+Usage:
+    python3 telemetry.py /dev/ttyACM0 [--baud 1000000] [--record raw.bin] > log.csv
+    python3 telemetry.py raw.bin > log.csv
+
+@author Maximilian Kautzsch
+@copyright Copyright (c) 2024 Maximilian Kautzsch
+Licensed under MIT License.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+SYNC = b"\xa5\x5a"
+HEADER_SIZE = 6
+CRC_SIZE = 2
+CONFIG = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src", "controller_v2.4", "Config.h")
+
+# Payload layouts per frame type, matching the packed structs of the sketch. The steering
+# angle is sent in hundredths of a degree, the race state and event as the values of the
+# RaceState and RaceEvent enumerations of Config.h.
+FRAME_TYPES = {
+    1: (
+        "state",
+        struct.Struct("<IBbBBBhhHHHHHBBBBBhhBhhBBHBBB"),
+        [
+            "timestamp", "colour", "speed", "voltage", "y_pos", "block_index",
+            "angular_velocity", "yaw_angle", "distance_left", "distance_front",
+            "distance_right", "steering_angle", "x_pos", "direction", "turn_mode",
+            "race_flags", "sections", "laps", "setpoint_yaw_angle", "drift_correction",
+            "safety_flags", "pose_x", "pose_y", "race_state", "race_event", "state_time",
+            "sonar_rate_left", "sonar_rate_front", "sonar_rate_right",
+        ],
+    ),
+    2: (
+        "latency",
+        struct.Struct("<IHHHHHHHH"),
+        [
+            "timestamp", "imu_age", "camera_age", "distance_left_age", "distance_front_age",
+            "distance_right_age", "decision_time", "servo_latency", "motor_latency",
+        ],
+    ),
+}
+
+
+def crc16(data, crc=0xFFFF):
+    """Calculates the CRC-16/CCITT-FALSE checksum, as done by Telemetry::crc16()."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+class Decoder:
+    """Splits a byte stream into frames and validates their checksums."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.last_sequence = None
+        self.lost_frames = 0
+        self.corrupt_frames = 0
+
+    def feed(self, data):
+        """Adds received bytes and yields every complete frame as (type, sequence, payload)."""
+        self.buffer += data
+
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                # Keep a trailing first sync byte, the second one may still be on its way.
+                keep = 1 if self.buffer[-1:] == SYNC[:1] else 0
+                self.skip(len(self.buffer) - keep)
+                return
+            self.skip(start)
+
+            if len(self.buffer) < HEADER_SIZE:
+                return
+            frame_type, length, sequence = struct.unpack_from("<BBH", self.buffer, 2)
+            size = HEADER_SIZE + length + CRC_SIZE
+            if len(self.buffer) < size:
+                return
+
+            (crc,) = struct.unpack_from("<H", self.buffer, HEADER_SIZE + length)
+            if crc16(self.buffer[2:HEADER_SIZE + length]) != crc:
+                # Not a frame after all, resynchronize on the next sync bytes.
+                self.corrupt_frames += 1
+                self.skip(1)
+                continue
+
+            payload = bytes(self.buffer[HEADER_SIZE:HEADER_SIZE + length])
+            del self.buffer[:size]
+
+            if self.last_sequence is not None:
+                self.lost_frames += (sequence - self.last_sequence - 1) & 0xFFFF
+            self.last_sequence = sequence
+
+            yield frame_type, sequence, payload
+
+    def skip(self, count):
+        """Passes bytes that do not belong to a frame to stderr."""
+        if count > 0:
+            sys.stderr.write(self.buffer[:count].decode("ascii", errors="replace"))
+            del self.buffer[:count]
+
+
+def read_baud_rate():
+    """Reads the baud rate the sketch opens its serial port at from Config.h."""
+    with open(CONFIG, encoding="utf-8") as file:
+        match = re.search(r"^#define SERIAL_BAUD_RATE (\d+)", file.read(), re.M)
+    if not match:
+        sys.exit("telemetry: no SERIAL_BAUD_RATE in {}".format(CONFIG))
+    return int(match.group(1))
+
+
+def open_source(args):
+    """Opens the serial port or the recorded file to read from."""
+    if os.path.isfile(args.source):
+        return open(args.source, "rb")
+
+    import serial  # pyserial, only needed for live capture
+
+    return serial.Serial(args.source, args.baud, timeout=0.1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="serial port or recorded file")
+    parser.add_argument("--baud", type=int, default=read_baud_rate(), help="baud rate of the serial port")
+    parser.add_argument("--record", help="file to store the raw stream in for a later replay")
+    args = parser.parse_args()
+
+    source = open_source(args)
+    record = open(args.record, "wb") if args.record else None
+    decoder = Decoder()
+    printed_header = set()
+    section_times = []
+    section_start = None
+    latencies = {}
+
+    try:
+        while True:
+            data = source.read(4096)
+            if not data:
+                if isinstance(source, serial_type()):
+                    continue
+                break
+            if record:
+                record.write(data)
+
+            for frame_type, sequence, payload in decoder.feed(data):
+                if frame_type not in FRAME_TYPES:
+                    continue
+                name, layout, fields = FRAME_TYPES[frame_type]
+                if len(payload) != layout.size:
+                    decoder.corrupt_frames += 1
+                    continue
+                if frame_type not in printed_header:
+                    print(",".join(["type", "sequence"] + fields))
+                    printed_header.add(frame_type)
+                values = layout.unpack(payload)
+                print(",".join([name, str(sequence)] + [str(value) for value in values]))
+
+                if name == "state":
+                    state = dict(zip(fields, values))
+                    if section_start is not None and state["sections"] != section_start[0]:
+                        section_times.append(state["timestamp"] - section_start[1])
+                    if section_start is None or state["sections"] != section_start[0]:
+                        section_start = (state["sections"], state["timestamp"])
+                elif name == "latency":
+                    # Actuators that have not been commanded in a cycle report a latency of 0.
+                    for field, value in zip(fields[1:], values[1:]):
+                        if value:
+                            latencies.setdefault(field, []).append(value)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if record:
+            record.close()
+        sys.stderr.write(
+            "\nlost frames: {}, corrupt frames: {}\n".format(decoder.lost_frames, decoder.corrupt_frames)
+        )
+        if section_times:
+            sys.stderr.write(
+                "section times (ms): {}, mean: {:.0f}\n".format(
+                    " ".join(str(time) for time in section_times), sum(section_times) / len(section_times)
+                )
+            )
+        for field, values in latencies.items():
+            sys.stderr.write(
+                "{} (us): mean {:.0f}, max {}\n".format(field, sum(values) / len(values), max(values))
+            )
+
+
+def serial_type():
+    """Returns the class of a serial port, or a dummy if pyserial is not installed."""
+    try:
+        import serial
+
+        return serial.Serial
+    except ImportError:
+        return type(None)
+
+
+if __name__ == "__main__":
+    main()